@@ -258,7 +258,21 @@ enum class ColOperation {
 enum class ExtraOperation { EX_DO_NOTHING, EX_COND_PUSH, EX_UNKNOWN };
 
 // pack data format, stored on disk so only append new ones at the end.
-enum class PackFmt : char { DEFAULT, PPM1, PPM2, RANGECODE, LZ4, LOOKUP, NOCOMPRESS, TRIE, ZLIB };
+enum class PackFmt : char {
+  DEFAULT,
+  PPM1,
+  PPM2,
+  RANGECODE,
+  LZ4,
+  LOOKUP,
+  NOCOMPRESS,
+  TRIE,
+  ZLIB,
+  FOR_BITPACK,
+  DELTA_BITPACK,
+  ZSTD,
+  INT_LZ4  // LZ4 integer codec; LZ4 alone keeps meaning the string pack compression
+};
 
 // data source
 enum class LoadSource {
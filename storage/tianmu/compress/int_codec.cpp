@@ -0,0 +1,279 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include "compress/int_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "lz4.h"
+#include "zstd.h"
+
+namespace Tianmu {
+namespace compress {
+
+namespace {
+
+constexpr uint kBlock = 128;   // values per bit-packed block
+constexpr uint kPadding = 8;   // tail slack, lets every bit read be a single unaligned 64-bit load
+constexpr int kZstdLevel = 3;  // decompression speed hardly depends on the level
+
+inline uint BitWidth(uint64_t v) { return v == 0 ? 0 : 64 - __builtin_clzll(v); }
+
+// 'buf' must be zeroed in advance, bits are only ORed in
+inline void WriteBits(unsigned char *buf, uint64_t bitpos, uint width, uint64_t v) {
+  unsigned char *p = buf + (bitpos >> 3);
+  uint shift = bitpos & 7;
+  uint64_t word;
+  std::memcpy(&word, p, sizeof(word));
+  word |= v << shift;
+  std::memcpy(p, &word, sizeof(word));
+  if (shift + width > 64)
+    p[8] |= static_cast<unsigned char>(v >> (64 - shift));
+}
+
+inline uint64_t ReadBits(const unsigned char *buf, uint64_t bitpos, uint width) {
+  const unsigned char *p = buf + (bitpos >> 3);
+  uint shift = bitpos & 7;
+  uint64_t word;
+  std::memcpy(&word, p, sizeof(word));
+  uint64_t v = word >> shift;
+  if (shift + width > 64)
+    v |= uint64_t(p[8]) << (64 - shift);
+  return width == 64 ? v : v & ((uint64_t(1) << width) - 1);
+}
+
+template <class T>
+inline void PutT(char *&p, T v) {
+  std::memcpy(p, &v, sizeof(T));
+  p += sizeof(T);
+}
+
+template <class T>
+inline T GetT(const char *&p) {
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  p += sizeof(T);
+  return v;
+}
+
+// Packs 'cnt' values of 'vals' minus 'ref' with the smallest sufficient width.
+// All arithmetic is modulo 2^64 and truncated to T when decoding.
+char *PackBlock(char *p, const uint64_t *vals, uint cnt, uint64_t ref) {
+  uint64_t all = 0;
+  for (uint i = 0; i < cnt; i++) all |= vals[i] - ref;
+  uint width = BitWidth(all);
+  *p++ = static_cast<char>(width);
+  size_t bytes = (size_t(cnt) * width + 7) / 8;
+  std::memset(p, 0, bytes + kPadding);
+  auto *out = reinterpret_cast<unsigned char *>(p);
+  for (uint i = 0; i < cnt; i++) WriteBits(out, uint64_t(i) * width, width, vals[i] - ref);
+  return p + bytes;
+}
+
+// Returns nullptr on malformed input.
+const char *UnpackBlock(const char *p, const char *end, uint64_t *vals, uint cnt, uint64_t ref) {
+  if (p >= end)
+    return nullptr;
+  uint width = static_cast<unsigned char>(*p++);
+  if (width > 64)
+    return nullptr;
+  size_t bytes = (size_t(cnt) * width + 7) / 8;
+  if (p + bytes > end)  // 'end' is followed by kPadding readable bytes
+    return nullptr;
+  auto *in = reinterpret_cast<const unsigned char *>(p);
+  if (width == 0) {
+    std::fill(vals, vals + cnt, ref);
+  } else if (width <= 56) {
+    // a value never straddles more than 8 bytes: one load, shift and mask
+    const uint64_t mask = (uint64_t(1) << width) - 1;
+    for (uint i = 0, bitpos = 0; i < cnt; i++, bitpos += width) {
+      uint64_t word;
+      std::memcpy(&word, in + (bitpos >> 3), sizeof(word));
+      vals[i] = ref + ((word >> (bitpos & 7)) & mask);
+    }
+  } else {
+    for (uint i = 0; i < cnt; i++) vals[i] = ref + ReadBits(in, uint64_t(i) * width, width);
+  }
+  return p + bytes;
+}
+
+template <class T>
+CprsErr ForCompress(char *dest, uint &len, const T *src, uint nrec, bool delta) {
+  if (len < IntCodec<T>::Bound(delta ? IntCodecType::DELTA_BITPACK : IntCodecType::FOR_BITPACK, nrec))
+    return CprsErr::CPRS_ERR_BUF;
+  uint64_t vals[kBlock];
+  char *p = dest;
+  for (uint start = 0; start < nrec; start += kBlock) {
+    uint cnt = std::min(kBlock, nrec - start);
+    uint64_t ref;
+    if (!delta) {
+      ref = src[start];
+      for (uint i = 0; i < cnt; i++) {
+        vals[i] = src[start + i];
+        ref = std::min(ref, vals[i]);
+      }
+      PutT<T>(p, static_cast<T>(ref));
+    } else {
+      // signed deltas, so that descending runs pack as well as ascending ones
+      PutT<T>(p, src[start]);
+      int64_t min_delta = 0;
+      for (uint i = 1; i < cnt; i++) {
+        vals[i - 1] = uint64_t(src[start + i]) - uint64_t(src[start + i - 1]);
+        min_delta = (i == 1) ? int64_t(vals[0]) : std::min(min_delta, int64_t(vals[i - 1]));
+      }
+      ref = static_cast<uint64_t>(min_delta);
+      PutT<uint64_t>(p, ref);
+      cnt = cnt - 1;
+    }
+    p = PackBlock(p, vals, cnt, ref);
+  }
+  std::memset(p, 0, kPadding);
+  len = static_cast<uint>(p - dest) + kPadding;
+  return CprsErr::CPRS_SUCCESS;
+}
+
+template <class T>
+CprsErr ForDecompress(T *dest, const char *src, uint len, uint nrec, bool delta) {
+  if (len < kPadding)
+    return CprsErr::CPRS_ERR_COR;
+  const char *p = src;
+  const char *end = src + len - kPadding;
+  uint64_t vals[kBlock];
+  for (uint start = 0; start < nrec; start += kBlock) {
+    uint cnt = std::min(kBlock, nrec - start);
+    size_t header = delta ? sizeof(T) + sizeof(uint64_t) : sizeof(T);
+    if (p + header > end)
+      return CprsErr::CPRS_ERR_COR;
+    if (!delta) {
+      uint64_t ref = GetT<T>(p);
+      p = UnpackBlock(p, end, vals, cnt, ref);
+      if (!p)
+        return CprsErr::CPRS_ERR_COR;
+      for (uint i = 0; i < cnt; i++) dest[start + i] = static_cast<T>(vals[i]);
+    } else {
+      uint64_t prev = GetT<T>(p);
+      uint64_t ref = GetT<uint64_t>(p);
+      p = UnpackBlock(p, end, vals, cnt - 1, ref);
+      if (!p)
+        return CprsErr::CPRS_ERR_COR;
+      dest[start] = static_cast<T>(prev);
+      for (uint i = 1; i < cnt; i++) {
+        prev += vals[i - 1];
+        dest[start + i] = static_cast<T>(prev);
+      }
+    }
+  }
+  return CprsErr::CPRS_SUCCESS;
+}
+
+}  // namespace
+
+const char *IntCodecName(IntCodecType type) {
+  switch (type) {
+    case IntCodecType::RANGE_CODE:
+      return "rangecode";
+    case IntCodecType::FOR_BITPACK:
+      return "bitpack";
+    case IntCodecType::DELTA_BITPACK:
+      return "delta";
+    case IntCodecType::ZSTD:
+      return "zstd";
+    case IntCodecType::LZ4:
+      return "lz4";
+  }
+  return "unknown";
+}
+
+template <class T>
+uint IntCodec<T>::Bound(IntCodecType type, uint nrec) {
+  size_t raw = size_t(nrec) * sizeof(T);
+  switch (type) {
+    case IntCodecType::FOR_BITPACK:
+    case IntCodecType::DELTA_BITPACK:
+      // per block: width byte and two references at most; values at full width,
+      // plus one bit for deltas, which are signed
+      return static_cast<uint>(raw + nrec / 8 + 1 + (nrec / kBlock + 1) * (1 + sizeof(T) + sizeof(uint64_t)) +
+                               2 * kPadding);
+    case IntCodecType::ZSTD:
+      return static_cast<uint>(ZSTD_compressBound(raw));
+    case IntCodecType::LZ4:
+      return static_cast<uint>(LZ4_compressBound(static_cast<int>(raw)));
+    default:
+      return static_cast<uint>(raw + 20);
+  }
+}
+
+template <class T>
+CprsErr IntCodec<T>::Compress(char *dest, uint &len, const T *src, uint nrec) const {
+  switch (type_) {
+    case IntCodecType::FOR_BITPACK:
+      return ForCompress<T>(dest, len, src, nrec, false);
+    case IntCodecType::DELTA_BITPACK:
+      return ForCompress<T>(dest, len, src, nrec, true);
+    case IntCodecType::ZSTD: {
+      size_t res = ZSTD_compress(dest, len, src, size_t(nrec) * sizeof(T), kZstdLevel);
+      if (ZSTD_isError(res))
+        return CprsErr::CPRS_ERR_BUF;
+      len = static_cast<uint>(res);
+      return CprsErr::CPRS_SUCCESS;
+    }
+    case IntCodecType::LZ4: {
+      int res = LZ4_compress_default(reinterpret_cast<const char *>(src), dest, static_cast<int>(nrec * sizeof(T)),
+                                     static_cast<int>(len));
+      if (res <= 0)
+        return CprsErr::CPRS_ERR_BUF;
+      len = static_cast<uint>(res);
+      return CprsErr::CPRS_SUCCESS;
+    }
+    default:
+      return CprsErr::CPRS_ERR_PAR;
+  }
+}
+
+template <class T>
+CprsErr IntCodec<T>::Decompress(T *dest, const char *src, uint len, uint nrec) const {
+  switch (type_) {
+    case IntCodecType::FOR_BITPACK:
+      return ForDecompress<T>(dest, src, len, nrec, false);
+    case IntCodecType::DELTA_BITPACK:
+      return ForDecompress<T>(dest, src, len, nrec, true);
+    case IntCodecType::ZSTD: {
+      size_t res = ZSTD_decompress(dest, size_t(nrec) * sizeof(T), src, len);
+      if (ZSTD_isError(res) || res != size_t(nrec) * sizeof(T))
+        return CprsErr::CPRS_ERR_COR;
+      return CprsErr::CPRS_SUCCESS;
+    }
+    case IntCodecType::LZ4: {
+      int res = LZ4_decompress_safe(src, reinterpret_cast<char *>(dest), static_cast<int>(len),
+                                    static_cast<int>(nrec * sizeof(T)));
+      if (res < 0 || static_cast<size_t>(res) != size_t(nrec) * sizeof(T))
+        return CprsErr::CPRS_ERR_COR;
+      return CprsErr::CPRS_SUCCESS;
+    }
+    default:
+      return CprsErr::CPRS_ERR_PAR;
+  }
+}
+
+template class IntCodec<unsigned char>;
+template class IntCodec<unsigned short>;
+template class IntCodec<unsigned int>;
+template class IntCodec<uint64_t>;
+
+}  // namespace compress
+}  // namespace Tianmu
@@ -0,0 +1,66 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_COMPRESS_INT_CODEC_H_
+#define TIANMU_COMPRESS_INT_CODEC_H_
+#pragma once
+
+#include <cstdint>
+
+#include "compress/defs.h"
+
+namespace Tianmu {
+namespace compress {
+
+// Codec of the data part of an integer pack. The value is persisted in the DPN,
+// so existing entries must never be renumbered. RANGE_CODE (0, the value found
+// in packs written before codecs were selectable) means NumCompressor.
+enum class IntCodecType : uint8_t {
+  RANGE_CODE = 0,
+  FOR_BITPACK = 1,    // frame of reference + bit packing, per block of 128 values
+  DELTA_BITPACK = 2,  // deltas to the previous value, then as FOR_BITPACK
+  ZSTD = 3,
+  LZ4 = 4,
+};
+
+const char *IntCodecName(IntCodecType type);
+
+// Fast-decompressing alternatives to NumCompressor for unsigned 1/2/4/8-byte
+// values. Unlike NumCompressor, these keep no state and may be shared.
+template <class T>
+class IntCodec final {
+ public:
+  explicit IntCodec(IntCodecType type) : type_(type) {}
+
+  // upper bound of the compressed size of 'nrec' values, in bytes
+  static uint Bound(IntCodecType type, uint nrec);
+
+  // 'len' - length of 'dest' in BYTES, at least Bound(); upon exit contains
+  // the actual size of compressed data
+  CprsErr Compress(char *dest, uint &len, const T *src, uint nrec) const;
+
+  // 'len' - the value of 'len' returned from Compress()
+  // 'dest' must be able to hold at least 'nrec' elements of type T
+  CprsErr Decompress(T *dest, const char *src, uint len, uint nrec) const;
+
+ private:
+  IntCodecType type_;
+};
+
+}  // namespace compress
+}  // namespace Tianmu
+
+#endif  // TIANMU_COMPRESS_INT_CODEC_H_
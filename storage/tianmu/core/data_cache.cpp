@@ -17,13 +17,30 @@
 
 #include "data_cache.h"
 
+#include <thread>
+
+#include "system/configuration.h"
 #include "vc/tianmu_attr.h"
 
 namespace Tianmu {
 namespace core {
+DataCache::DataCache() {
+  unsigned n = tianmu_sysvar_data_cache_shards;
+  if (n == 0) {
+    // default to the next power of two above the number of cores, so that
+    // concurrent scans rarely meet on the same shard
+    n = 1;
+    while (n < std::thread::hardware_concurrency() * 2 && n < kMaxShards) n <<= 1;
+  }
+  m_num_shards = std::min(n, kMaxShards);
+  m_shards = std::make_unique<Shard[]>(m_num_shards);
+}
+
 void DataCache::ReleaseAll() {
-  _packs.clear();
-  _ftrees.clear();
+  for (unsigned i = 0; i < m_num_shards; i++) {
+    m_shards[i]._packs.clear();
+    m_shards[i]._ftrees.clear();
+  }
 }
 
 // release all data for table id
@@ -36,19 +53,22 @@ void DataCache::ReleasePacks(int table) {
   std::vector<TraceableObjectPtr> packs_removed;
   {
     std::scoped_lock m_locking_guard(mm::TraceableObject::GetLockingMutex());
-    std::scoped_lock lock(m_cache_mutex);
-    auto it = _packs.begin();
-    while (it != _packs.end()) {
-      if (pc_table(it->first) == table) {
-        auto tmp = it++;
-        std::shared_ptr<Pack> pack = std::static_pointer_cast<Pack>(tmp->second);
-        pack->Lock();
-        pack->SetOwner(0);
-        _packs.erase(tmp);
-        packs_removed.push_back(pack);
-        m_objectsReleased++;
-      } else
-        it++;
+    for (unsigned i = 0; i < m_num_shards; i++) {
+      Shard &s = m_shards[i];
+      std::scoped_lock lock(s.m_shard_mutex);
+      auto it = s._packs.begin();
+      while (it != s._packs.end()) {
+        if (pc_table(it->first) == table) {
+          auto tmp = it++;
+          std::shared_ptr<Pack> pack = std::static_pointer_cast<Pack>(tmp->second);
+          pack->Lock();
+          pack->SetOwner(0);
+          s._packs.erase(tmp);
+          packs_removed.push_back(pack);
+          s.m_objectsReleased++;
+        } else
+          it++;
+      }
     }
   }
 }
@@ -57,60 +77,53 @@ void DataCache::ReleaseFTrees(int table) {
   std::vector<TraceableObjectPtr> to_remove;
   {
     std::scoped_lock m_locking_guard(mm::TraceableObject::GetLockingMutex());
-    std::scoped_lock lock(m_cache_mutex);
-    auto it = _ftrees.begin();
-    while (it != _ftrees.end()) {
-      if (it->first[0] == table) {
-        auto tmp = it++;
-        auto sp = tmp->second;
-        sp->Lock();
-        sp->SetOwner(0);
-        _ftrees.erase(tmp);
-        to_remove.push_back(sp);
-        m_objectsReleased++;
-      } else
-        it++;
+    for (unsigned i = 0; i < m_num_shards; i++) {
+      Shard &s = m_shards[i];
+      std::scoped_lock lock(s.m_shard_mutex);
+      auto it = s._ftrees.begin();
+      while (it != s._ftrees.end()) {
+        if (it->first[0] == table) {
+          auto tmp = it++;
+          auto sp = tmp->second;
+          sp->Lock();
+          sp->SetOwner(0);
+          s._ftrees.erase(tmp);
+          to_remove.push_back(sp);
+          s.m_objectsReleased++;
+        } else
+          it++;
+      }
     }
   }
 }
 
 template <>
-DataCache::PackContainer &DataCache::cache() {
+DataCache::PackContainer &DataCache::Shard::cache() {
   return (_packs);
 }
 
 template <>
-DataCache::PackContainer const &DataCache::cache() const {
-  return (_packs);
-}
-
-template <>
-DataCache::FTreeContainer &DataCache::cache() {
-  return (_ftrees);
-}
-
-template <>
-DataCache::FTreeContainer const &DataCache::cache() const {
+DataCache::FTreeContainer &DataCache::Shard::cache() {
   return (_ftrees);
 }
 
 template <>
-DataCache::IOPackReqSet &DataCache::waitIO() {
+DataCache::IOPackReqSet &DataCache::Shard::waitIO() {
   return (_packPendingIO);
 }
 
 template <>
-DataCache::IOFTreeReqSet &DataCache::waitIO() {
+DataCache::IOFTreeReqSet &DataCache::Shard::waitIO() {
   return (_ftreePendingIO);
 }
 
 template <>
-std::condition_variable_any &DataCache::condition<PackCoordinate>() {
+std::condition_variable_any &DataCache::Shard::condition<PackCoordinate>() {
   return (_packWaitIO);
 }
 
 template <>
-std::condition_variable_any &DataCache::condition<FTreeCoordinate>() {
+std::condition_variable_any &DataCache::Shard::condition<FTreeCoordinate>() {
   return (_ftreeWaitIO);
 }
 }  // namespace core
@@ -24,12 +24,18 @@
 #include <unordered_set>
 #include <utility>
 
+#include "core/query_profile.h"
 #include "data/pack.h"
 
 namespace Tianmu {
 namespace core {
 using TraceableObjectPtr = std::shared_ptr<mm::TraceableObject>;
 
+// The cache is partitioned into independently locked shards. A coordinate always
+// maps to the same shard, so lookups, pending-IO tracking and statistics of
+// different packs do not serialize on one mutex. Lock order is: the memory
+// manager mutex (mm::TraceableObject::GetLockingMutex()) first, then a shard
+// mutex; a shard mutex is never held while acquiring the memory manager mutex.
 class DataCache final {
  private:
   using PackContainer = std::unordered_map<PackCoordinate, TraceableObjectPtr, PackCoordinate>;
@@ -38,41 +44,101 @@ class DataCache final {
   using FTreeContainer = std::unordered_map<FTreeCoordinate, TraceableObjectPtr, FTreeCoordinate>;
   using IOFTreeReqSet = std::unordered_set<FTreeCoordinate, FTreeCoordinate>;
 
-  PackContainer _packs;
-  FTreeContainer _ftrees;
+  struct Shard {
+    PackContainer _packs;
+    FTreeContainer _ftrees;
 
-  int64_t m_cacheHits = 0;
-  int64_t m_cacheMisses = 0;
-  int64_t m_objectsReleased = 0;
+    IOPackReqSet _packPendingIO;
+    IOFTreeReqSet _ftreePendingIO;
 
-  IOPackReqSet _packPendingIO;
-  IOFTreeReqSet _ftreePendingIO;
+    std::condition_variable_any _packWaitIO;
+    std::condition_variable_any _ftreeWaitIO;
 
-  std::condition_variable_any _packWaitIO;
-  std::condition_variable_any _ftreeWaitIO;
+    int64_t m_cacheHits = 0;
+    int64_t m_cacheMisses = 0;
+    int64_t m_objectsReleased = 0;
+    int64_t m_readWait = 0;
+    int64_t m_falseWakeup = 0;
+    int64_t m_readWaitInProgress = 0;
+    int64_t m_packLoads = 0;
+    int64_t m_packLoadInProgress = 0;
+    int64_t m_loadErrors = 0;
+    int64_t m_reDecompress = 0;
+    int64_t m_prefetchLoads = 0;
+    int64_t m_prefetchHits = 0;
+    int64_t m_prefetchWasted = 0;
 
-  int64_t m_readWait = 0;
-  int64_t m_falseWakeup = 0;
-  int64_t m_readWaitInProgress = 0;
-  int64_t m_packLoads = 0;
-  int64_t m_packLoadInProgress = 0;
-  int64_t m_loadErrors = 0;
-  int64_t m_reDecompress = 0;
+    std::recursive_mutex m_shard_mutex;
 
-  std::recursive_mutex m_cache_mutex;
+    template <typename T>
+    std::unordered_map<T, TraceableObjectPtr, T> &cache();
+
+    template <typename T>
+    std::unordered_set<T, T> &waitIO();
+
+    template <typename T>
+    std::condition_variable_any &condition();
+  };
+
+  static constexpr unsigned kMaxShards = 1024;
+
+  std::unique_ptr<Shard[]> m_shards;
+  unsigned m_num_shards;
+
+  template <typename T>
+  Shard &shard(T const &coord_) {
+    // the coordinate hash keeps neighbouring packs apart only in the low bits,
+    // mix it so that consecutive packs of one column land on different shards
+    uint64_t h = coord_.hash();
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return m_shards[h % m_num_shards];
+  }
+
+  Shard &shard_of(TraceableObjectPtr const &obj) {
+    return shard(static_cast<Pack *>(obj.get())->GetPackCoordinate());
+  }
+
+  int64_t sum(int64_t Shard::*counter) const {
+    int64_t total = 0;
+    for (unsigned i = 0; i < m_num_shards; i++) total += m_shards[i].*counter;
+    return total;
+  }
+
+  // Lock and start tracking a pack found in a shard. The shard mutex has already
+  // been released, so the memory manager may have dropped the pack meanwhile;
+  // in that case the caller has to look it up again.
+  bool PinPack(TraceableObjectPtr const &obj) {
+    std::scoped_lock m_locking_guard(mm::TraceableObject::GetLockingMutex());
+    if (obj->GetOwner() != this)
+      return false;
+    if (obj->IsPrefetchUnused()) {
+      ++shard_of(obj).m_prefetchHits;
+      obj->clearPrefetchUnused();
+    }
+    obj->Lock();
+    obj->TrackAccess();
+    return true;
+  }
 
  public:
-  int64_t getReadWait() { return m_readWait; }
-  int64_t getReadWaitInProgress() { return m_readWaitInProgress; }
-  int64_t getFalseWakeup() { return m_falseWakeup; }
-  int64_t getPackLoads() { return m_packLoads; }
-  int64_t getPackLoadInProgress() { return m_packLoadInProgress; }
-  int64_t getLoadErrors() { return m_loadErrors; }
-  int64_t getReDecompress() { return m_reDecompress; }
-  int64_t getCacheHits() { return m_cacheHits; }
-  int64_t getCacheMisses() { return m_cacheMisses; }
-  int64_t getReleased() { return m_objectsReleased; }
-  DataCache() = default;
+  int64_t getReadWait() { return sum(&Shard::m_readWait); }
+  int64_t getReadWaitInProgress() { return sum(&Shard::m_readWaitInProgress); }
+  int64_t getFalseWakeup() { return sum(&Shard::m_falseWakeup); }
+  int64_t getPackLoads() { return sum(&Shard::m_packLoads); }
+  int64_t getPackLoadInProgress() { return sum(&Shard::m_packLoadInProgress); }
+  int64_t getLoadErrors() { return sum(&Shard::m_loadErrors); }
+  int64_t getReDecompress() { return sum(&Shard::m_reDecompress); }
+  int64_t getCacheHits() { return sum(&Shard::m_cacheHits); }
+  int64_t getCacheMisses() { return sum(&Shard::m_cacheMisses); }
+  int64_t getReleased() { return sum(&Shard::m_objectsReleased); }
+  int64_t getPrefetchLoads() { return sum(&Shard::m_prefetchLoads); }
+  int64_t getPrefetchHits() { return sum(&Shard::m_prefetchHits); }
+  int64_t getPrefetchWasted() { return sum(&Shard::m_prefetchWasted); }
+  unsigned getShards() const { return m_num_shards; }
+
+  DataCache();
   ~DataCache() = default;
 
   void ReleaseAll();
@@ -80,12 +146,13 @@ class DataCache final {
   template <typename T>
   void PutObject(T const &coord_, TraceableObjectPtr p) {
     TraceableObjectPtr old;
+    Shard &s(shard(coord_));
     {
       std::scoped_lock m_locking_guard(mm::TraceableObject::GetLockingMutex());
-      std::scoped_lock lock(m_cache_mutex);
+      std::scoped_lock lock(s.m_shard_mutex);
 
       p->SetOwner(this);
-      auto &c(cache<T>());
+      auto &c(s.cache<T>());
       auto result = c.insert(std::make_pair(coord_, p));
       if (!result.second && result.first->second != p) {
         old = result.first->second;  // old object must be physically deleted
@@ -95,10 +162,6 @@ class DataCache final {
       }
       if constexpr (T::ID == COORD_TYPE::PACK) {
         p->TrackAccess();
-        // int objnum = c.size();
-        // TIANMU_LOG(LogCtl_Level::DEBUG, "PutObject packs objnum %d
-        // (table:%d,pack:%d,clounm:%d)", objnum,pc_table(coord_),
-        // pc_dp(coord_), pc_column(coord_));
       }
     }
   }
@@ -110,167 +173,214 @@ class DataCache final {
   template <typename T>
   void DropObject(T const &coord_) {
     TraceableObjectPtr removed;
+    Shard &s(shard(coord_));
     {
       std::scoped_lock m_locking_guard(mm::TraceableObject::GetLockingMutex());
-      std::scoped_lock lock(m_cache_mutex);
-      auto &c(cache<T>());
+      std::scoped_lock lock(s.m_shard_mutex);
+      auto &c(s.cache<T>());
       auto it = c.find(coord_);
       if (it != c.end()) {
-        // if (T::ID == COORD_TYPE::PACK) {
-        // int objnum = c.size();
-        // TIANMU_LOG(LogCtl_Level::DEBUG, "DropObject packs objnum %d
-        // (table:%d,pack:%d,clounm:%d)", objnum,pc_table(coord_),
-        // pc_dp(coord_), pc_column(coord_));
-        //}
         removed = it->second;
         if constexpr (T::ID == COORD_TYPE::PACK) {
+          if (removed->IsPrefetchUnused())
+            ++s.m_prefetchWasted;
           removed->Lock();
         }
         removed->SetOwner(nullptr);
         c.erase(it);
-        ++m_objectsReleased;
+        ++s.m_objectsReleased;
       }
     }
   }
 
+  // called by the memory manager with mm::TraceableObject::GetLockingMutex() held
   template <typename T>
   void DropObjectByMM(T const &coord_) {
     TraceableObjectPtr removed;
+    Shard &s(shard(coord_));
     {
-      std::scoped_lock lock(m_cache_mutex);
-      auto &c(cache<T>());
+      std::scoped_lock lock(s.m_shard_mutex);
+      auto &c(s.cache<T>());
 
       auto it = c.find(coord_);
       if (it != c.end()) {
         removed = it->second;
+        if (removed->IsPrefetchUnused())
+          ++s.m_prefetchWasted;
         removed->SetOwner(nullptr);
         c.erase(it);
-        ++m_objectsReleased;
+        ++s.m_objectsReleased;
       }
     }
   }
 
+  // Read-ahead of a pack that a scan is about to reach. Nothing is done if the
+  // pack is already cached or being loaded. The loaded pack is left unlocked
+  // and marked as prefetched, so the memory manager may still evict it; a later
+  // GetOrFetchObject() finds it in the cache and counts a prefetch hit.
+  template <typename T, typename V>
+  void PrefetchObject(PackCoordinate const &coord_, V *fetcher_) {
+    Shard &s(shard(coord_));
+    auto &c(s.cache<PackCoordinate>());
+    auto &w(s.waitIO<PackCoordinate>());
+    auto &cond(s.condition<PackCoordinate>());
+    {
+      std::scoped_lock lock(s.m_shard_mutex);
+      if (c.find(coord_) != c.end() || w.find(coord_) != w.end())
+        return;
+      w.insert(coord_);
+      s.m_packLoadInProgress++;
+    }
+
+    std::shared_ptr<T> obj;
+    try {
+      obj = fetcher_->Fetch(coord_);
+    } catch (...) {
+      {
+        std::scoped_lock lock(s.m_shard_mutex);
+        s.m_loadErrors++;
+        s.m_packLoadInProgress--;
+        w.erase(coord_);
+      }
+      cond.notify_all();
+      throw;
+    }
+
+    obj->SetOwner(this);
+    obj->m_preUnused = true;
+    {
+      std::scoped_lock lock(s.m_shard_mutex);
+      s.m_prefetchLoads++;
+      s.m_packLoadInProgress--;
+      c.insert(std::make_pair(coord_, obj));
+      w.erase(coord_);
+    }
+    cond.notify_all();
+    obj->TrackAccess();
+    obj->Unlock();
+  }
+
   template <typename T, typename U>
   std::shared_ptr<T> GetLockedObject(U const &coord_) {
-    std::scoped_lock m_locking_guard(mm::TraceableObject::GetLockingMutex());
-    std::scoped_lock lock(m_cache_mutex);
-
-    auto &c(cache<U>());
-    auto it = c.find(coord_);
-    if (it == c.end())
-      //++ m_cacheMisses;
-      return nullptr;
-
-    //++ m_cacheHits;
-    auto sp = std::static_pointer_cast<T>(it->second);
-    sp->Lock();
-    if constexpr (U::ID == COORD_TYPE::PACK)
-      sp->TrackAccess();
-    return sp;
+    Shard &s(shard(coord_));
+    for (;;) {
+      TraceableObjectPtr found;
+      {
+        std::scoped_lock lock(s.m_shard_mutex);
+        auto &c(s.cache<U>());
+        auto it = c.find(coord_);
+        if (it == c.end())
+          return nullptr;
+        found = it->second;
+      }
+      if constexpr (U::ID == COORD_TYPE::PACK) {
+        if (!PinPack(found))
+          continue;
+      } else {
+        std::scoped_lock m_locking_guard(mm::TraceableObject::GetLockingMutex());
+        found->Lock();
+      }
+      return std::static_pointer_cast<T>(found);
+    }
   }
 
   template <typename T, typename U, typename V>
   std::shared_ptr<T> GetOrFetchObject(U const &coord_, V *fetcher_) {
-    auto &c(cache<U>());
-    auto &w(waitIO<U>());
-    auto &cond(condition<U>());
-    bool waited = false;
-    /* a scope for mutex lock */
-    {
-      /* Lock is acquired inside */
-      std::unique_lock<std::recursive_mutex> m_obj_guard(mm::TraceableObject::GetLockingMutex());
-
-      std::scoped_lock lock(m_cache_mutex);
-
-      auto it = c.find(coord_);
+    Shard &s(shard(coord_));
+    auto &c(s.cache<U>());
+    auto &w(s.waitIO<U>());
+    auto &cond(s.condition<U>());
+    bool first_lookup = true;
+
+    for (;;) {
+      TraceableObjectPtr found;
+      /* a scope for mutex lock */
+      {
+        std::unique_lock<std::recursive_mutex> lock(s.m_shard_mutex);
+
+        auto it = c.find(coord_);
+        if (it == c.end()) {
+          if constexpr (U::ID == COORD_TYPE::PACK)
+            if (first_lookup) {
+              s.m_cacheMisses++;
+              QueryProfile::Count(QueryProfile::Counter::CACHE_MISSES);
+            }
+          bool waited = false;
+          auto rit = w.find(coord_);
+          while (rit != w.end()) {
+            s.m_readWaitInProgress++;
+            if (waited)
+              s.m_falseWakeup++;
+            else
+              s.m_readWait++;
+
+            cond.wait(lock);
+
+            waited = true;
+            s.m_readWaitInProgress--;
+            rit = w.find(coord_);
+          }
+          // if the object is still missing, it has been loaded, used, unlocked
+          // and pushed out of memory before we got to it after waiting
+          it = c.find(coord_);
+        } else if constexpr (U::ID == COORD_TYPE::PACK) {
+          if (first_lookup) {
+            ++s.m_cacheHits;
+            QueryProfile::Count(QueryProfile::Counter::CACHE_HITS);
+          }
+        }
 
-      if (it != c.end()) {
-        if constexpr (U::ID == COORD_TYPE::PACK) {
-          it->second->Lock();
-          ++m_cacheHits;
-          it->second->TrackAccess();
+        if (it == c.end()) {
+          w.insert(coord_);
+          s.m_packLoadInProgress++;
+          break;
         }
-        return std::static_pointer_cast<T>(it->second);
+        found = it->second;
       }
+      first_lookup = false;
 
-      {
-        if constexpr (U::ID == COORD_TYPE::PACK)
-          m_cacheMisses++;
-        auto rit = w.find(coord_);
-        while (rit != w.end()) {
-          m_readWaitInProgress++;
-          if (waited)
-            m_falseWakeup++;
-          else
-            m_readWait++;
-
-          m_cache_mutex.unlock();
-          cond.wait(m_obj_guard);
-          m_cache_mutex.lock();
-
-          waited = true;
-          m_readWaitInProgress--;
-          rit = w.find(coord_);
-        }
-        it = c.find(coord_);
-        if (it != c.end()) {
-          if constexpr (U::ID == COORD_TYPE::PACK) {
-            it->second->Lock();
-            it->second->TrackAccess();
-          }
-          return std::static_pointer_cast<T>(it->second);
-        }
-        // mm::TraceableObject::GetLockingMutex().Unlock();
-        // if we get here the obj has been loaded, used, unlocked
-        // and pushed out of memory before we should get to it after
-        // waiting
+      if constexpr (U::ID == COORD_TYPE::PACK) {
+        if (!PinPack(found))
+          continue;
       }
-      w.insert(coord_);
-      m_packLoadInProgress++;
+      return std::static_pointer_cast<T>(found);
     }
 
     std::shared_ptr<T> obj;
     try {
       obj = fetcher_->Fetch(coord_);
     } catch (...) {
-      std::scoped_lock m_obj_guard(mm::TraceableObject::GetLockingMutex());
-      std::scoped_lock lock(m_cache_mutex);
-      m_loadErrors++;
-      m_packLoadInProgress--;
-      w.erase(coord_);
+      {
+        std::scoped_lock lock(s.m_shard_mutex);
+        s.m_loadErrors++;
+        s.m_packLoadInProgress--;
+        w.erase(coord_);
+      }
       cond.notify_all();
       throw;
     }
 
+    obj->SetOwner(this);
     {
-      obj->SetOwner(this);
-      std::scoped_lock m_obj_guard(mm::TraceableObject::GetLockingMutex());
-      std::scoped_lock lock(m_cache_mutex);
+      std::scoped_lock lock(s.m_shard_mutex);
       if constexpr (U::ID == COORD_TYPE::PACK) {
-        m_packLoads++;
-        obj->TrackAccess();
+        s.m_packLoads++;
       }
-      m_packLoadInProgress--;
+      s.m_packLoadInProgress--;
       DEBUG_ASSERT(c.find(coord_) == c.end());
       c.insert(std::make_pair(coord_, obj));
       w.erase(coord_);
     }
     cond.notify_all();
+    // a freshly fetched object is locked, so the memory manager cannot drop it
+    // before it gets tracked
+    if constexpr (U::ID == COORD_TYPE::PACK) {
+      obj->TrackAccess();
+      QueryProfile::Count(QueryProfile::Counter::BYTES_DECOMPRESSED, obj->CompressedBytes());
+    }
 
     return obj;
   }
-
-  template <typename T>
-  std::unordered_map<T, TraceableObjectPtr, T> &cache();
-
-  template <typename T>
-  std::unordered_set<T, T> &waitIO();
-
-  template <typename T>
-  std::condition_variable_any &condition();
-
-  template <typename T>
-  std::unordered_map<T, TraceableObjectPtr, T> const &cache() const;
 };
 }  // namespace core
 }  // namespace Tianmu
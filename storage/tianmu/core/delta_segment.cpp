@@ -0,0 +1,217 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include "core/delta_segment.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/assert.h"
+#include "core/delta_record_head.h"
+#include "vc/tianmu_attr_typeinfo.h"
+
+namespace Tianmu {
+namespace core {
+
+DeltaSegment::DeltaSegment(const std::vector<common::ColumnType> &types, uint8_t pss) : pss_(pss) {
+  for (auto type : types) str_cols_.push_back(ATI::IsStringType(type));
+}
+
+DeltaSegment::~DeltaSegment() { Clear(); }
+
+bool DeltaSegment::Reserve(size_t bytes, size_t limit) {
+  std::shared_lock<std::shared_mutex> guard(mtx_);
+  if (SizeAllocated() + reserved_.fetch_add(bytes) + bytes > limit) {
+    reserved_.fetch_sub(bytes);
+    return false;
+  }
+  return true;
+}
+
+bool DeltaSegment::GrowRows(Block &block, size_t rows, size_t limit) {
+  size_t new_rows = std::max<size_t>(block.rows, 16);
+  while (new_rows < rows) new_rows *= 2;
+  new_rows = std::min<size_t>(new_rows, size_t(1) << pss_);
+
+  size_t added = new_rows - block.rows;
+  size_t row_bytes = 1;
+  for (uint col = 0; col < str_cols_.size(); col++)
+    row_bytes += sizeof(int64_t) + 1 + (str_cols_[col] ? sizeof(uint32_t) : 0);
+  if (SizeAllocated() + added * row_bytes > limit)
+    return false;
+
+  try {
+    block.valid = static_cast<uint8_t *>(rc_realloc(block.valid, new_rows, mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+    for (uint col = 0; col < str_cols_.size(); col++) {
+      auto &c = block.columns[col];
+      c.values = static_cast<int64_t *>(
+          rc_realloc(c.values, new_rows * sizeof(int64_t), mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+      c.nulls = static_cast<uint8_t *>(rc_realloc(c.nulls, new_rows, mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+      if (str_cols_[col])
+        c.lens = static_cast<uint32_t *>(
+            rc_realloc(c.lens, new_rows * sizeof(uint32_t), mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+    }
+  } catch (common::OutOfMemoryException &) {
+    // arrays grown so far are kept, the block just stays at its old capacity
+    return false;
+  }
+
+  std::memset(block.valid + block.rows, 0, added);
+  for (auto &c : block.columns) std::memset(c.nulls + block.rows, 1, added);
+  block.rows = new_rows;
+  return true;
+}
+
+bool DeltaSegment::GrowArena(Column &c, size_t size, size_t limit) {
+  size_t new_size = std::max<size_t>(c.arena_size, 4_KB);
+  while (new_size < size) new_size *= 2;
+  if (SizeAllocated() + new_size - c.arena_size > limit)
+    return false;
+  try {
+    c.arena = static_cast<char *>(rc_realloc(c.arena, new_size, mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+  } catch (common::OutOfMemoryException &) {
+    return false;
+  }
+  c.arena_size = new_size;
+  return true;
+}
+
+bool DeltaSegment::Append(uint64_t row_id, const char *record, size_t limit) {
+  DeltaRecordHeadForInsert head;
+  const char *ptr = head.recordDecode(record);
+  if (head.is_deleted_ == DELTA_RECORD_DELETE || head.field_count_ != str_cols_.size())
+    return false;
+
+  std::unique_lock<std::shared_mutex> guard(mtx_);
+  // the merge may have taken the row from the store before the transaction ended
+  if (row_id < released_)
+    return false;
+  auto &block = blocks_[row_id >> pss_];
+  bool created = !block;
+  if (created)
+    block = std::make_unique<Block>(str_cols_.size());
+  auto fail = [&]() {
+    if (created) {
+      FreeBlock(*block);
+      blocks_.erase(row_id >> pss_);
+    }
+    return false;
+  };
+  // row ids are handed out before the records arrive, so a later row may come first
+  size_t slot = row_id & ((uint64_t(1) << pss_) - 1);
+  if (slot >= block->rows && !GrowRows(*block, slot + 1, limit))
+    return fail();
+  for (uint col = 0; col < str_cols_.size(); col++) {
+    auto &c = block->columns[col];
+    if (str_cols_[col] && !head.null_mask_[col] && c.arena_used + head.field_len_[col] > c.arena_size &&
+        !GrowArena(c, c.arena_used + head.field_len_[col], limit))
+      return fail();
+  }
+
+  for (uint col = 0; col < str_cols_.size(); col++) {
+    auto &c = block->columns[col];
+    c.nulls[slot] = head.null_mask_[col];
+    if (c.nulls[slot])
+      continue;
+    if (str_cols_[col]) {
+      uint32_t len = head.field_len_[col];
+      c.values[slot] = c.arena_used;
+      c.lens[slot] = len;
+      if (len > 0)
+        std::memcpy(c.arena + c.arena_used, ptr, len);
+      c.arena_used += len;
+      ptr += len;
+    } else {
+      std::memcpy(&c.values[slot], ptr, sizeof(int64_t));
+      ptr += sizeof(int64_t);
+    }
+  }
+  block->valid[slot] = 1;
+  return true;
+}
+
+void DeltaSegment::Invalidate(uint64_t row_id) {
+  std::unique_lock<std::shared_mutex> guard(mtx_);
+  auto it = blocks_.find(row_id >> pss_);
+  size_t slot = row_id & ((uint64_t(1) << pss_) - 1);
+  // the values stay, a merge which has already seen the row may still copy them
+  if (it != blocks_.end() && slot < it->second->rows)
+    it->second->valid[slot] = 0;
+}
+
+bool DeltaSegment::Contains(uint64_t row_id) const {
+  std::shared_lock<std::shared_mutex> guard(mtx_);
+  auto block = FindBlock(row_id);
+  size_t slot = row_id & ((uint64_t(1) << pss_) - 1);
+  return block && slot < block->rows && block->valid[slot];
+}
+
+void DeltaSegment::CopyTo(uint64_t row_id, uint count, uint col, loader::ValueCache &vc) const {
+  std::shared_lock<std::shared_mutex> guard(mtx_);
+  auto block = FindBlock(row_id);
+  size_t slot = row_id & ((uint64_t(1) << pss_) - 1);
+  ASSERT(block && slot + count <= block->rows, "rows not in delta segment");
+  auto &c = block->columns[col];
+  bool is_str = str_cols_[col];
+  for (size_t i = slot; i < slot + count; i++) {
+    if (c.nulls[i]) {
+      vc.ExpectedNull(true);
+    } else {
+      size_t len = is_str ? c.lens[i] : sizeof(int64_t);
+      auto buf = vc.Prepare(len);
+      if (buf == nullptr)
+        throw std::bad_alloc();
+      std::memcpy(buf, is_str ? c.arena + c.values[i] : reinterpret_cast<const char *>(&c.values[i]), len);
+      vc.ExpectedSize(len);
+    }
+    vc.Commit();
+  }
+}
+
+void DeltaSegment::FreeBlock(Block &block) {
+  dealloc(block.valid);
+  for (auto &c : block.columns) {
+    dealloc(c.values);
+    dealloc(c.lens);
+    dealloc(c.nulls);
+    dealloc(c.arena);
+  }
+}
+
+void DeltaSegment::Release(uint64_t row_id) {
+  std::unique_lock<std::shared_mutex> guard(mtx_);
+  released_ = std::max(released_, row_id);
+  for (auto it = blocks_.begin(); it != blocks_.end() && ((it->first + 1) << pss_) <= row_id;) {
+    FreeBlock(*it->second);
+    it = blocks_.erase(it);
+  }
+}
+
+void DeltaSegment::Clear() {
+  std::unique_lock<std::shared_mutex> guard(mtx_);
+  for (auto &it : blocks_) FreeBlock(*it.second);
+  blocks_.clear();
+  released_ = 0;
+}
+
+const DeltaSegment::Block *DeltaSegment::FindBlock(uint64_t row_id) const {
+  auto it = blocks_.find(row_id >> pss_);
+  return it == blocks_.end() ? nullptr : it->second.get();
+}
+
+}  // namespace core
+}  // namespace Tianmu
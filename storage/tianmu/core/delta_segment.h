@@ -0,0 +1,132 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_CORE_DELTA_SEGMENT_H_
+#define TIANMU_CORE_DELTA_SEGMENT_H_
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+#include "common/common_definitions.h"
+#include "loader/value_cache.h"
+#include "mm/traceable_object.h"
+
+namespace Tianmu {
+namespace core {
+
+// Columnar, append-only copy of the committed insert records of a DeltaTable.
+// Rows are kept in blocks of one pack each: numeric columns as arrays of
+// 64-bit values and string columns as a byte arena, following the layout of
+// the insert record, which is given by the column type (a LOOKUP column is
+// stored as its string). The records in RocksDB remain the durable log; the
+// segment is rebuilt from them on startup and only spares merges and point
+// reads the decoding of rows. A row updated or deleted in the delta is
+// invalidated and read from RocksDB again.
+class DeltaSegment final : public mm::TraceableObject {
+ public:
+  DeltaSegment(const std::vector<common::ColumnType> &types, uint8_t pss);
+  DeltaSegment(const DeltaSegment &) = delete;
+  DeltaSegment &operator=(const DeltaSegment &) = delete;
+  ~DeltaSegment();
+
+  mm::TO_TYPE TraceableType() const override { return mm::TO_TYPE::TO_TEMPORARY; }
+
+  // Decodes an insert record into the columns. Returns false (and keeps
+  // nothing) if the record does not fit the layout, the row has already
+  // been released or the memory would exceed 'limit' bytes.
+  bool Append(uint64_t row_id, const char *record, size_t limit);
+  void Invalidate(uint64_t row_id);
+  bool Contains(uint64_t row_id) const;
+
+  // Records of uncommitted inserts are held by their transaction until it
+  // ends; the reservation keeps them within the same limit.
+  bool Reserve(size_t bytes, size_t limit);
+  void Unreserve(size_t bytes) { reserved_.fetch_sub(bytes); }
+
+  // Calls f(col, ptr, len) for all columns of a row, ptr is nullptr for
+  // nulls, otherwise the value in the encoding of the insert record.
+  // Returns false if the row is not in the segment.
+  template <typename F>
+  bool ReadRow(uint64_t row_id, F &&f) const;
+
+  // Appends the values of 'count' rows of column 'col' starting at 'row_id'
+  // to 'vc'. All the rows must be in one block and have been Contains().
+  void CopyTo(uint64_t row_id, uint count, uint col, loader::ValueCache &vc) const;
+
+  // Drops the blocks holding only rows below 'row_id', the rows below it
+  // are merged and never appended again.
+  void Release(uint64_t row_id);
+  void Clear();
+
+  size_t NumOfCols() const { return str_cols_.size(); }
+  uint64_t BlockEnd(uint64_t row_id) const { return ((row_id >> pss_) + 1) << pss_; }
+
+ private:
+  struct Column {
+    int64_t *values = nullptr;  // numeric: the value, string: offset in 'arena'
+    uint32_t *lens = nullptr;   // string only
+    uint8_t *nulls = nullptr;
+    char *arena = nullptr;  // string only
+    size_t arena_used = 0;
+    size_t arena_size = 0;
+  };
+  struct Block {
+    explicit Block(size_t cols) : columns(cols) {}
+    uint8_t *valid = nullptr;  // rows holding an unmodified insert
+    size_t rows = 0;           // capacity of the row arrays
+    std::vector<Column> columns;
+  };
+
+  const Block *FindBlock(uint64_t row_id) const;
+  bool GrowRows(Block &block, size_t rows, size_t limit);
+  bool GrowArena(Column &c, size_t size, size_t limit);
+  void FreeBlock(Block &block);
+
+  std::vector<bool> str_cols_;  // columns stored as strings in the insert record
+  const uint8_t pss_;
+  mutable std::shared_mutex mtx_;
+  std::map<uint64_t, std::unique_ptr<Block>> blocks_;  // by row_id >> pss_
+  uint64_t released_ = 0;                               // rows below are merged
+  std::atomic<size_t> reserved_{0};
+};
+
+template <typename F>
+bool DeltaSegment::ReadRow(uint64_t row_id, F &&f) const {
+  std::shared_lock<std::shared_mutex> guard(mtx_);
+  auto block = FindBlock(row_id);
+  size_t slot = row_id & ((uint64_t(1) << pss_) - 1);
+  if (!block || slot >= block->rows || !block->valid[slot])
+    return false;
+  for (uint col = 0; col < str_cols_.size(); col++) {
+    auto &c = block->columns[col];
+    if (c.nulls[slot])
+      f(col, nullptr, 0);
+    else if (str_cols_[col])
+      f(col, c.arena + c.values[slot], c.lens[slot]);
+    else
+      f(col, reinterpret_cast<const char *>(&c.values[slot]), uint32_t(sizeof(int64_t)));
+  }
+  return true;
+}
+
+}  // namespace core
+}  // namespace Tianmu
+
+#endif  // TIANMU_CORE_DELTA_SEGMENT_H_
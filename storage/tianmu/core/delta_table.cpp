@@ -94,6 +94,17 @@ void DeltaTable::FillRowByRowid(Transaction *tx, TABLE *table, int64_t obj) {
   index::be_store_uint64(key + key_pos, obj);
   key_pos += sizeof(uint64_t);
 
+  if (segment_ && segment_->ReadRow(obj, [table](uint col, const char *ptr, uint32_t len) {
+        Field *field = table->field[col];
+        if (ptr == nullptr) {
+          field->set_null();
+          return;
+        }
+        field->set_notnull();
+        core::Engine::StrToFiled(ptr, field, len);
+      }))
+    return;
+
   std::string delta_record;
   rocksdb::Status status = kv_trans.GetData(cf_handle_, {(char *)key, key_pos}, &delta_record);
   if (!status.ok()) {
@@ -120,7 +131,13 @@ common::ErrorCode DeltaTable::DropDeltaTable(const std::string &table_name) {
   return store->KVDelDeltaMeta(normalized_name);
 }
 
-void DeltaTable::Init(uint64_t base_row_num) {
+void DeltaTable::Init(uint64_t base_row_num, const std::vector<common::ColumnType> &types, uint8_t pss) {
+  if (!segment_)
+    segment_ = std::make_shared<DeltaSegment>(types, pss);
+  else
+    segment_->Clear();
+  size_t segment_limit = size_t(tianmu_sysvar_delta_segment_size) << 20;
+
   index::KVTransaction kv_trans;
   uchar entry_key[sizeof(uint32_t)];
 
@@ -139,6 +156,9 @@ void DeltaTable::Init(uint64_t base_row_num) {
     auto type = *reinterpret_cast<RecordType *>(const_cast<char *>(iter->value().data()));
     if (type == RecordType::kInsert) {
       row_id.fetch_add(1);
+      // rebuild the columnar copy from the durable records
+      segment_->Append(index::be_to_uint64(reinterpret_cast<const uchar *>(iter->key().data()) + sizeof(uint32_t)),
+                       iter->value().data(), segment_limit);
     }
 
     // load_id
@@ -164,11 +184,20 @@ void DeltaTable::AddInsertRecord(Transaction *tx, uint64_t row_id, std::unique_p
     throw common::Exception("Error,kv_trans.PutData failed,date size: " + std::to_string(size) +
                             " date:" + std::string(buf.get()));
   }
+  size_t segment_limit = size_t(tianmu_sysvar_delta_segment_size) << 20;
+  if (segment_ && segment_->Reserve(size, segment_limit)) {
+    // other sessions may read the segment, so the row is added only once it is committed
+    std::shared_ptr<char[]> record(buf.release());
+    auto segment = segment_;  // the table may be dropped before the transaction ends
+    tx->AddEndAction([segment, row_id, record, size, segment_limit](bool committed) {
+      segment->Unreserve(size);
+      if (committed)
+        segment->Append(row_id, record.get(), segment_limit);
+    });
+  }
   tx->AddInsertRowNum();
   if (tx->GetInsertRowNum() >= tianmu_sysvar_insert_write_batch_size) {
-    kv_trans.Commit();
-    kv_trans.ResetWriteBatch();
-    kv_trans.Acquiresnapshot();
+    tx->CommitKVBatch();  // the rows of the batch go to the segment with it
     tx->ResetInsertRowNum();
   }
   load_id.fetch_add(1);
@@ -192,6 +221,16 @@ void DeltaTable::AddRecord(Transaction *tx, uint64_t row_id, std::unique_ptr<cha
     throw common::Exception("Error,kv_trans.PutData failed,date size: " + std::to_string(size) +
                             " date:" + std::string(buf.get()));
   }
+  // the merged record is read from RocksDB from now on, also if this
+  // transaction has inserted the row itself
+  if (segment_) {
+    segment_->Invalidate(row_id);
+    auto segment = segment_;
+    tx->AddEndAction([segment, row_id](bool committed) {
+      if (committed)
+        segment->Invalidate(row_id);
+    });
+  }
   load_id.fetch_add(1);
   stat.write_cnt.fetch_add(1);
   stat.write_bytes.fetch_add(size);
@@ -212,6 +251,8 @@ void DeltaTable::Truncate(Transaction *tx) {
     tx->KVTrans().SingleDeleteData(cf_handle_, iter->key());
     iter->Next();
   }
+  if (segment_)
+    segment_->Clear();
   row_id.store(0);
   load_id.store(0);
   merge_id.store(0);
@@ -22,6 +22,7 @@
 
 #include "common/exception.h"
 #include "core/delta_record_head.h"
+#include "core/delta_segment.h"
 #include "index/kv_store.h"
 #include "rocksdb/db.h"
 #include "rocksdb/iterator.h"
@@ -43,11 +44,12 @@ class DeltaTable {
                                                       const std::string &cf_prefix);
   static common::ErrorCode DropDeltaTable(const std::string &table_name);
 
-  void Init(uint64_t base_row_num);
+  void Init(uint64_t base_row_num, const std::vector<common::ColumnType> &types, uint8_t pss);
   std::string FullName() { return fullname_; }
   [[nodiscard]] uint32_t GetDeltaTableID() const { return delta_tid_; }
   uint64_t CountRecords() { return load_id.load() - merge_id.load(); }
   rocksdb::ColumnFamilyHandle *GetCFHandle() { return cf_handle_; }
+  DeltaSegment *Segment() const { return segment_.get(); }
   common::ErrorCode Rename(const std::string &to);
   bool ExistDeleteRow(Transaction *tx, int64_t obj);
   void FillRowByRowid(Transaction *tx, TABLE *table, int64_t obj);
@@ -72,6 +74,7 @@ class DeltaTable {
   std::string fullname_;
   uint32_t delta_tid_ = 0;
   rocksdb::ColumnFamilyHandle *cf_handle_ = nullptr;
+  std::shared_ptr<DeltaSegment> segment_;  // shared with the end actions of transactions
 };
 
 class DeltaIterator {
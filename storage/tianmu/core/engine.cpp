@@ -153,6 +153,39 @@ static int has_pack(const LEX_STRING &comment) {
   return ret;
 }
 
+// integer codec named by a "CODEC: <name>;" option of a table or column comment
+static common::PackFmt has_codec(const std::string &comment) {
+  std::vector<std::string> options;
+  boost::split(options, boost::to_upper_copy(comment), boost::is_any_of(";"));
+  for (auto &opt : options) {
+    auto val_pos = opt.find(':');
+    if (val_pos == std::string::npos || boost::trim_copy(opt.substr(0, val_pos)) != "CODEC")
+      continue;
+
+    auto val = boost::trim_copy(opt.substr(val_pos + 1));
+    if (val == "BITPACK")
+      return common::PackFmt::FOR_BITPACK;
+    if (val == "DELTA_BITPACK")
+      return common::PackFmt::DELTA_BITPACK;
+    if (val == "ZSTD")
+      return common::PackFmt::ZSTD;
+    if (val == "LZ4")
+      return common::PackFmt::INT_LZ4;
+    if (val == "RANGECODE")
+      return common::PackFmt::RANGECODE;
+    throw common::SyntaxException("Unknown integer codec: " + val);
+  }
+  return common::PackFmt::DEFAULT;
+}
+
+// a CODEC option of a column that is not stored in integer packs, it is ignored with a warning
+static void ignore_codec(const Field &field, common::PackFmt &fmt) {
+  std::string s = "CODEC can only be declared on numeric and date/time columns. Ignored on column ";
+  s = s + (field.table ? std::string(field.table->s->table_name.str) + "." : "") + field.field_name;
+  push_warning(current_thd, Sql_condition::SL_WARNING, WARN_OPTION_IGNORED, s.c_str());
+  fmt = common::PackFmt::DEFAULT;
+}
+
 static std::string has_mem_name(const LEX_STRING &comment) {
   std::string name = "";
   std::string str(comment.str, comment.length);
@@ -529,6 +562,10 @@ char *Engine::FiledToStr(char *ptr, Field *field, DeltaRecordHead *deltaRecord,
 }
 
 const char *Engine::StrToFiled(const char *ptr, Field *field, DeltaRecordHead *deltaRecord, int col_num) {
+  return StrToFiled(ptr, field, deltaRecord->field_len_[col_num]);
+}
+
+const char *Engine::StrToFiled(const char *ptr, Field *field, uint32_t len) {
   switch (field->type()) {
     case MYSQL_TYPE_TINY:
     case MYSQL_TYPE_SHORT:
@@ -598,7 +635,7 @@ const char *Engine::StrToFiled(const char *ptr, Field *field, DeltaRecordHead *d
     case MYSQL_TYPE_TINY_BLOB:
     case MYSQL_TYPE_MEDIUM_BLOB:
     case MYSQL_TYPE_LONG_BLOB: {
-      uint32_t str_len = deltaRecord->field_len_[col_num];
+      uint32_t str_len = len;
       auto buf = std::make_unique<char[]>(str_len);
       std::memcpy(buf.get(), ptr, str_len);
       ptr += str_len;
@@ -810,9 +847,14 @@ std::shared_ptr<TableOption> Engine::GetTableOption(const std::string &table, TA
 
   opt->pss = power;
 
+  auto codec = has_codec(std::string(form->s->comment.str, form->s->comment.length));
   for (uint i = 0; i < form->s->fields; ++i) {
     Field *f = form->field[i];
     opt->atis.push_back(Engine::GetAttrTypeInfo(*f));
+    auto &ati = opt->atis.back();
+    if (codec != common::PackFmt::DEFAULT && ati.Fmt() == common::PackFmt::DEFAULT &&
+        ati.GetPackType() == common::PackType::INT)
+      ati.SetFmt(codec);
   }
 
   opt->path = table + common::TIANMU_EXT;
@@ -835,8 +877,11 @@ AttributeTypeInfo Engine::GetAttrTypeInfo(const Field &field) {
   auto str = boost::to_upper_copy(std::string(field.comment.str, field.comment.length));
   bool filter = (str.find("FILTER") != std::string::npos);
 
-  auto fmt = common::PackFmt::DEFAULT;
-  if (str.find("LOOKUP") != std::string::npos) {
+  auto fmt = has_codec(str);
+  bool codec = (fmt != common::PackFmt::DEFAULT);
+  if (codec) {
+    // an explicit integer codec, the keywords below are not looked at
+  } else if (str.find("LOOKUP") != std::string::npos) {
     if (field.type() == MYSQL_TYPE_STRING || field.type() == MYSQL_TYPE_VARCHAR)
       fmt = common::PackFmt::LOOKUP;
     else {
@@ -878,6 +923,8 @@ AttributeTypeInfo Engine::GetAttrTypeInfo(const Field &field) {
       return AttributeTypeInfo(common::ColumnType::TIME, notnull, 0, 0, false, DTCollation(), fmt, filter);
     case MYSQL_TYPE_STRING:
     case MYSQL_TYPE_VARCHAR: {
+      if (codec)
+        ignore_codec(field, fmt);
       if (field.field_length > FIELD_MAXLENGTH)
         throw common::UnsupportedDataTypeException("Length of STRING or VARCHAR exceeds 65535 bytes.");
       // Trie column only supports String/VARCHAR column and it
@@ -922,6 +969,8 @@ AttributeTypeInfo Engine::GetAttrTypeInfo(const Field &field) {
       throw common::UnsupportedDataTypeException("Precision must be less than or equal to 18.");
     }
     case MYSQL_TYPE_BLOB:
+      if (codec)
+        ignore_codec(field, fmt);
       if (const Field_str *fstr = dynamic_cast<const Field_str *>(&field)) {
         if (const Field_blob *fblo = dynamic_cast<const Field_blob *>(fstr)) {
           if (fblo->charset() != &my_charset_bin) {  // TINYTEXT, MEDIUMTEXT, TEXT, LONGTEXT
@@ -2363,8 +2412,10 @@ void Engine::AddTableDelta(TABLE *form, std::shared_ptr<TableShare> share) {
     auto table_path = share->Path();
     if (m_table_deltas.find(table_path) == m_table_deltas.end()) {
       m_table_deltas[table_path] = DeltaTable::CreateDeltaTable(share, has_mem_name(form->s->comment));
-      uint64 base_row_num = share->GetSnapshot()->NumOfObj();
-      m_table_deltas[table_path]->Init(base_row_num);
+      auto snapshot = share->GetSnapshot();
+      std::vector<common::ColumnType> types;
+      for (uint i = 0; i < snapshot->NumOfAttrs(); i++) types.push_back(snapshot->GetAttr(i)->TypeName());
+      m_table_deltas[table_path]->Init(snapshot->NumOfObj(), types, share->PackSizeShift());
       return;
     }
     return;
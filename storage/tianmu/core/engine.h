@@ -179,6 +179,8 @@ class Engine final {
   static fs::path GetNextDataDir();
 
   static const char *StrToFiled(const char *ptr, Field *field, DeltaRecordHead *deltaRecord, int col_num);
+  // 'len' - length of the encoded value, only used by string fields
+  static const char *StrToFiled(const char *ptr, Field *field, uint32_t len);
   static char *FiledToStr(char *ptr, Field *field, DeltaRecordHead *deltaRecord, int col_num, THD *thd);
 
   void setExtra(ha_extra_function extra) { extra_info = extra; }
@@ -333,6 +335,10 @@ class ResultSender {
 
   virtual void Init(TempTable *t);
   virtual void SendRecord(std::vector<std::unique_ptr<types::TianmuDataType>> &record);
+  // Send all rows of a materialized table, converting the values column by
+  // column in batches of tianmu_result_batch_rows. Return false if some
+  // column needs the per-row conversion (nothing is sent then).
+  virtual bool SendBatched(TempTable *t);
 };
 
 class ResultExportSender final : public ResultSender {
@@ -345,6 +351,7 @@ class ResultExportSender final : public ResultSender {
  protected:
   void Init(TempTable *t) override;
   void SendRecord(std::vector<std::unique_ptr<types::TianmuDataType>> &record) override;
+  bool SendBatched(TempTable *t [[maybe_unused]]) override { return false; }  // rows go to the exporter
 
   exporter::select_tianmu_export *export_res_;
   std::unique_ptr<exporter::DataExporter> tianmu_data_exp_;
@@ -26,6 +26,7 @@
 
 #include "core/engine.h"
 #include "core/query.h"
+#include "core/query_profile.h"
 #include "core/transaction.h"
 #include "exporter/export2file.h"
 #include "util/log_ctl.h"
@@ -493,27 +494,41 @@ QueryRouteTo Engine::Execute(THD *thd, LEX *lex, Query_result *result_output, SE
               : new ResultSender(selects_list->master_unit()->thd, result_output, selects_list->item_list));
     }
 
-    TempTable *result = query.Preexecute(cqu, sender.get());
-    ASSERT(result != nullptr, "Query execution returned no result object");
-    if (query.IsRoughQuery())
-      result->RoughMaterialize(false, sender.get());
-    else
-      result->Materialize(false, sender.get());
-
-    sender->Finalize(result);
-
-    if (rct) {
-      // in this case if this is an insert to TianmuTable from select based on the
-      // same table TianmuTable object for this table can't be deleted in TempTable
-      // destructor It will be deleted in RefreshTables method that will be
-      // called on commit
-      result->RemoveFromManagedList(rct.get());
-      query.RemoveFromManagedList(rct);
-      rct.reset();
+    if (tianmu_session_query_profile(thd))
+      current_txn_->StartProfile();
+    {
+      QueryProfile::Scope profile_query("query");
+      TempTable *result = query.Preexecute(cqu, sender.get());
+      ASSERT(result != nullptr, "Query execution returned no result object");
+      if (query.IsRoughQuery())
+        result->RoughMaterialize(false, sender.get());
+      else
+        result->Materialize(false, sender.get());
+
+      {
+        QueryProfile::Scope profile_send("send", result->NumOfObj());
+        sender->Finalize(result);
+        profile_send.SetRowsOut(sender->SentRows());
+      }
+      profile_query.SetRowsOut(sender->SentRows());
+
+      if (rct) {
+
+        // in this case if this is an insert to TianmuTable from select based on the
+        // same table TianmuTable object for this table can't be deleted in TempTable
+        // destructor It will be deleted in RefreshTables method that will be
+        // called on commit
+        result->RemoveFromManagedList(rct.get());
+        query.RemoveFromManagedList(rct);
+        rct.reset();
+      }
     }
     sender.reset();
+    if (auto profile = current_txn_->TakeProfile())
+      profile->Report(thd, thd->thread_id(), thd->query().str);
 
   } catch (...) {
+    current_txn_->TakeProfile();
     bool with_error = false;
     if (sender) {
       if (sender->SentRows() > 0) {
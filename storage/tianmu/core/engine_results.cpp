@@ -376,9 +376,165 @@ void ResultSender::SendRecord(std::vector<std::unique_ptr<types::TianmuDataType>
   res->send_data(fields);
 }
 
+namespace {
+// A column of ResultSender::SendBatched(): numbers are read for the whole
+// batch and stored by a function specialized for the field type, strings are
+// converted row by row.
+struct BatchColumn {
+  Field *field = nullptr;
+  TempTable::Attr *attr = nullptr;
+  void (*store)(Field *f, int64_t v) = nullptr;  // nullptr for strings
+  bool real = false;                             // values are doubles, stored bitwise
+  std::vector<int64_t> values;
+};
+
+void StoreTiny(Field *f, int64_t v) { f->ptr[0] = (uchar)v; }
+void StoreShort(Field *f, int64_t v) { int2store(f->ptr, (uint16)v); }
+void StoreInt24(Field *f, int64_t v) { int3store(f->ptr, (uint32)v); }
+void StoreLong(Field *f, int64_t v) { int4store(f->ptr, (uint32)v); }
+void StoreLongLong(Field *f, int64_t v) { int8store(f->ptr, (ulonglong)v); }
+void StoreFloat(Field *f, int64_t v) { float4store(f->ptr, (float)common::double_int_t(v).d); }
+void StoreDouble(Field *f, int64_t v) { float8store(f->ptr, common::double_int_t(v).d); }
+
+// The same conversions as Engine::ConvertToField() does for these types.
+bool PrepareBatchColumn(BatchColumn &col) {
+  common::ColumnType attr_type = col.attr->TypeName();
+  enum_field_types field_type = col.field->type();
+  if (attr_type == common::ColumnType::INT || attr_type == common::ColumnType::MEDIUMINT ||
+      attr_type == common::ColumnType::SMALLINT || attr_type == common::ColumnType::BYTEINT ||
+      (attr_type == common::ColumnType::BIGINT && col.attr->Type().GetScale() == 0)) {
+    switch (field_type) {
+      case MYSQL_TYPE_TINY:
+        col.store = StoreTiny;
+        break;
+      case MYSQL_TYPE_SHORT:
+        col.store = StoreShort;
+        break;
+      case MYSQL_TYPE_INT24:
+        col.store = StoreInt24;
+        break;
+      case MYSQL_TYPE_LONG:
+        col.store = StoreLong;
+        break;
+      case MYSQL_TYPE_LONGLONG:
+        col.store = StoreLongLong;
+        break;
+      default:
+        return false;
+    }
+  } else if (ATI::IsRealType(attr_type)) {
+    if (field_type == MYSQL_TYPE_FLOAT)
+      col.store = StoreFloat;
+    else if (field_type == MYSQL_TYPE_DOUBLE)
+      col.store = StoreDouble;
+    else
+      return false;
+    col.real = true;
+  } else if (attr_type == common::ColumnType::STRING || attr_type == common::ColumnType::VARCHAR) {
+    if (field_type != MYSQL_TYPE_VARCHAR && field_type != MYSQL_TYPE_STRING)
+      return false;
+  } else {
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+bool ResultSender::SendBatched(TempTable *t) {
+  std::vector<BatchColumn> cols;
+  uint col_id = 0;
+  Item *item;
+  List_iterator_fast<Item> li(fields);
+  while ((item = li++)) {
+    switch (item->type()) {
+      case Item::DEFAULT_VALUE_ITEM:
+      case Item::FIELD_ITEM:
+        if (buf_lens[col_id] != 0) {
+          auto &col = cols.emplace_back();
+          col.field = ((Item_field *)item)->result_field;
+          col.attr = t->GetDisplayableAttrP(col_id);
+          if (col.attr == nullptr || col.attr->buffer == nullptr || !PrepareBatchColumn(col))
+            return false;
+        }
+        break;
+      case Item::SUM_FUNC_ITEM:
+      case Item::REF_ITEM:
+        return false;
+      default:  // const items, nothing to convert
+        break;
+    }
+    col_id++;
+  }
+
+  int64_t row = 0;
+  int64_t rows = t->NumOfObj();
+  thd->current_found_rows += rows;
+  thd->update_previous_found_rows();
+  if (offset && *offset > 0) {
+    row = std::min(*offset, rows);
+    *offset -= row;
+  }
+  if (limit) {
+    int64_t to_send = std::min(*limit, rows - row);
+    *limit -= to_send;
+    rows = row + to_send;
+  }
+
+  for (auto &col : cols) {
+    bitmap_set_bit(col.field->table->write_set, col.field->field_index);
+    if (col.store)
+      col.values.resize(tianmu_sysvar_result_batch_rows);
+  }
+  int64_t real_null = common::double_int_t(NULL_VALUE_D).i;
+  types::BString str;
+  while (row < rows) {
+    if (current_txn_->Killed())
+      throw common::KilledException();
+    size_t batch = std::min<int64_t>(rows - row, tianmu_sysvar_result_batch_rows);
+    for (auto &col : cols)
+      if (col.store)
+        col.attr->GetValuesInt64(row, batch, col.values.data());
+
+    for (size_t i = 0; i < batch; i++, row++) {
+      for (auto &col : cols) {
+        Field *f = col.field;
+        bool is_null;
+        if (col.store) {
+          int64_t v = col.values[i];
+          is_null = (col.real ? v == real_null : v == common::NULL_VALUE_64);
+          if (is_null) {
+            std::memset(f->ptr, 0, f->pack_length());
+            f->set_null();
+          } else {
+            f->set_notnull();
+            col.store(f, v);
+          }
+        } else {
+          col.attr->GetValueString(str, row);
+          is_null = Engine::ConvertToField(f, str, nullptr);
+        }
+        SetFieldState(f, is_null);
+      }
+      res->send_data(fields);
+      rows_sent++;
+    }
+  }
+  return true;
+}
+
 void ResultSender::Send(TempTable *t) {
   DEBUG_ASSERT(t->IsMaterialized());
   t->CreateDisplayableAttrP();
+  if (t->NumOfObj() > 0 && tianmu_sysvar_result_batch_rows > 0) {
+    if (!is_initialized) {
+      Init(t);
+      is_initialized = true;
+    }
+    if (SendBatched(t)) {
+      t->SetIsSent();
+      return;
+    }
+  }
   TempTable::RecordIterator iter = t->begin();
   TempTable::RecordIterator iter_end = t->end();
   for (; iter != iter_end; ++iter) {
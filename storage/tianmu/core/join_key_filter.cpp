@@ -0,0 +1,118 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include "core/join_key_filter.h"
+
+namespace Tianmu {
+namespace core {
+namespace {
+const int kBloomBitsPerKey = 8;
+const size_t kMaxBloomWords = size_t(1) << 22;  // 32 MB
+
+uint64_t Mix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+}  // namespace
+
+JoinKeyFilter::JoinKeyFilter(size_t key_width, int64_t expected_keys)
+    : key_width_(key_width), exact_(key_width <= kMaxExactWidth) {
+  if (exact_) {
+    words_ = ((size_t(1) << (8 * key_width_)) + 63) / 64;
+    summary_words_ = (words_ + 63) / 64;
+    summary_.reset(new std::atomic<uint64_t>[summary_words_]);
+    for (size_t i = 0; i < summary_words_; i++) summary_[i].store(0, std::memory_order_relaxed);
+  } else {
+    words_ = 1;
+    uint64_t bits = uint64_t(expected_keys < 1 ? 1 : expected_keys) * kBloomBitsPerKey;
+    while (words_ < kMaxBloomWords && words_ * 64 < bits) words_ <<= 1;
+    word_mask_ = words_ - 1;
+  }
+  bits_.reset(new std::atomic<uint64_t>[words_]);
+  for (size_t i = 0; i < words_; i++) bits_[i].store(0, std::memory_order_relaxed);
+}
+
+uint64_t JoinKeyFilter::Hash(const unsigned char *key, size_t width) {
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ width;
+  while (width >= 8) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= uint64_t(key[i]) << (8 * i);
+    h = Mix64(h ^ v);
+    key += 8;
+    width -= 8;
+  }
+  if (width > 0) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; i++) v |= uint64_t(key[i]) << (8 * i);
+    h = Mix64(h ^ v);
+  }
+  return h;
+}
+
+void JoinKeyFilter::Add(const unsigned char *key) {
+  if (exact_) {
+    uint64_t code = KeyCode(key, key_width_);
+    uint64_t bit = 1ULL << (code & 63);
+    // Relaxed: the filter is read only after all the traversing tasks are joined.
+    if ((bits_[code >> 6].fetch_or(bit, std::memory_order_relaxed) & bit) == 0)
+      summary_[code >> 12].fetch_or(1ULL << ((code >> 6) & 63), std::memory_order_relaxed);
+    return;
+  }
+  uint64_t h = Hash(key, key_width_);
+  uint64_t mask = ProbeMask(h);
+  auto &word = bits_[(h >> 40) & word_mask_];
+  if ((word.load(std::memory_order_relaxed) & mask) != mask)
+    word.fetch_or(mask, std::memory_order_relaxed);
+}
+
+bool JoinKeyFilter::AnyBit(uint64_t lo, uint64_t hi, const std::atomic<uint64_t> *words) const {
+  uint64_t w_lo = lo >> 6;
+  uint64_t w_hi = hi >> 6;
+  uint64_t lo_mask = ~uint64_t(0) << (lo & 63);
+  uint64_t hi_mask = ~uint64_t(0) >> (63 - (hi & 63));
+  if (w_lo == w_hi)
+    return (words[w_lo].load(std::memory_order_relaxed) & lo_mask & hi_mask) != 0;
+  if (words[w_lo].load(std::memory_order_relaxed) & lo_mask)
+    return true;
+  for (uint64_t w = w_lo + 1; w < w_hi; w++)
+    if (words[w].load(std::memory_order_relaxed))
+      return true;
+  return (words[w_hi].load(std::memory_order_relaxed) & hi_mask) != 0;
+}
+
+bool JoinKeyFilter::MayContainRange(uint64_t lo, uint64_t hi) const {
+  if (!exact_)
+    return true;
+  uint64_t max_code = words_ * 64 - 1;
+  if (hi > max_code)
+    hi = max_code;
+  if (lo > hi)
+    return false;
+  uint64_t w_lo = lo >> 6;
+  uint64_t w_hi = hi >> 6;
+  if (w_hi - w_lo < 2)
+    return AnyBit(lo, hi, bits_.get());
+  // Edge words bit by bit, the whole words in between by the summary.
+  return AnyBit(lo, w_lo * 64 + 63, bits_.get()) || AnyBit(w_hi * 64, hi, bits_.get()) ||
+         AnyBit(w_lo + 1, w_hi - 1, summary_.get());
+}
+}  // namespace core
+}  // namespace Tianmu
@@ -0,0 +1,89 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_CORE_JOIN_KEY_FILTER_H_
+#define TIANMU_CORE_JOIN_KEY_FILTER_H_
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Tianmu {
+namespace core {
+// Runtime filter over the encoded join keys of the hash join build side,
+// filled by all the traversing tasks and checked on the matched side before
+// the hash table lookup. It has no false negatives.
+// - Keys of up to kMaxExactWidth bytes are kept in an exact bitmap indexed by
+//   the key code (the key bytes read as a big-endian number, which follows the
+//   value order of monotonic encoders), so whole code ranges may be tested.
+// - Wider keys go to a Bloom filter with all the probes of a key in one word.
+class JoinKeyFilter {
+ public:
+  static constexpr size_t kMaxExactWidth = 3;
+
+  // key_width - number of meaningful bytes of the key buffer,
+  // expected_keys - upper bound of the number of keys to be added.
+  JoinKeyFilter(size_t key_width, int64_t expected_keys);
+  JoinKeyFilter(const JoinKeyFilter &) = delete;
+  JoinKeyFilter &operator=(const JoinKeyFilter &) = delete;
+  ~JoinKeyFilter() = default;
+
+  bool IsExact() const { return exact_; }
+  size_t KeyWidth() const { return key_width_; }
+  size_t MemorySize() const { return (words_ + summary_words_) * sizeof(uint64_t); }
+
+  void Add(const unsigned char *key);  // may be called concurrently
+  bool MayContain(const unsigned char *key) const {
+    if (exact_) {
+      uint64_t code = KeyCode(key, key_width_);
+      return (bits_[code >> 6].load(std::memory_order_relaxed) >> (code & 63)) & 1;
+    }
+    uint64_t h = Hash(key, key_width_);
+    uint64_t mask = ProbeMask(h);
+    return (bits_[(h >> 40) & word_mask_].load(std::memory_order_relaxed) & mask) == mask;
+  }
+  // Exact mode only: true if any code of [lo, hi] was added.
+  bool MayContainRange(uint64_t lo, uint64_t hi) const;
+
+  static uint64_t KeyCode(const unsigned char *key, size_t width) {
+    uint64_t code = 0;
+    for (size_t i = 0; i < width; i++) code = (code << 8) | key[i];
+    return code;
+  }
+
+ private:
+  static uint64_t Hash(const unsigned char *key, size_t width);
+  static uint64_t ProbeMask(uint64_t h) {
+    return (1ULL << (h & 63)) | (1ULL << ((h >> 6) & 63)) | (1ULL << ((h >> 12) & 63)) | (1ULL << ((h >> 18) & 63));
+  }
+  bool AnyBit(uint64_t lo, uint64_t hi, const std::atomic<uint64_t> *words) const;
+
+  size_t key_width_;
+  bool exact_;
+  size_t words_;
+  size_t summary_words_ = 0;
+  uint64_t word_mask_ = 0;
+  std::unique_ptr<std::atomic<uint64_t>[]> bits_;
+  // Exact mode: one bit per non-empty word of bits_, to skip empty parts of
+  // wide ranges quickly.
+  std::unique_ptr<std::atomic<uint64_t>[]> summary_;
+};
+}  // namespace core
+}  // namespace Tianmu
+
+#endif  // TIANMU_CORE_JOIN_KEY_FILTER_H_
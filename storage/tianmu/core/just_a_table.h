@@ -43,6 +43,8 @@ class JustATable : public std::enable_shared_from_this<JustATable> {
   }  // null pack number (interpreted properly)
   virtual void LockPackForUse(unsigned attr, unsigned pack_no) = 0;
   virtual void UnlockPackFromUse(unsigned attr, unsigned pack_no) = 0;
+  // hint that the pack will be locked soon, so it may be loaded in advance
+  virtual void PrefetchPack([[maybe_unused]] unsigned attr, [[maybe_unused]] unsigned pack_no) {}
   virtual int64_t NumOfObj() const = 0;
   virtual uint NumOfAttrs() const = 0;
   virtual uint NumOfDisplaybleAttrs() const = 0;
@@ -0,0 +1,413 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#include "core/native_expression.h"
+
+#include <algorithm>
+
+#include "common/assert.h"
+#include "types/tianmu_data_types.h"
+
+namespace Tianmu {
+namespace core {
+
+namespace {
+const size_t kBatchRows = 1024;  // rows a node computes at a time, keeps the node vectors in cache
+const int kMaxScale = 18;
+}  // namespace
+
+std::unique_ptr<NativeExpression> NativeExpression::Compile(MysqlExpression &expr,
+                                                            const MysqlExpression::TypOfVars &types) {
+  Item *item = expr.GetItem();
+  if (item == nullptr || !expr.IsDeterministic())
+    return nullptr;
+
+  std::unique_ptr<NativeExpression> native(new NativeExpression());
+  native->fields_ = &expr.GetTIANMUItems();
+  native->types_ = &types;
+  int root = -1;
+  try {
+    root = native->CompileItem(item);
+  } catch (common::Exception &) {  // e.g. a literal that does not fit int64
+    root = -1;
+  }
+  native->fields_ = nullptr;
+  native->types_ = nullptr;
+
+  if (root < 0 || native->vars_.empty())
+    return nullptr;
+  // the value must be what MysqlExpression::Evaluate() returns: scaled to item->decimals for DECIMAL_RESULT
+  int scale = item->result_type() == DECIMAL_RESULT ? item->decimals : 0;
+  root = native->Rescale(root, scale);
+  if (root < 0 || native->nodes_[root].scale != scale)
+    return nullptr;
+  // the root is evaluated last
+  if (size_t(root) != native->nodes_.size() - 1)
+    native->AddNode(Op::RESCALE, scale, {root});
+  return native;
+}
+
+int NativeExpression::AddNode(Op op, int scale, std::vector<int> args) {
+  nodes_.push_back(Node{op, scale, std::move(args)});
+  if (op == Op::RESCALE) {
+    auto &n = nodes_.back();
+    n.value = int64_t(types::Uint64PowOfTen(short(scale - nodes_[n.args[0]].scale)));
+  }
+  return int(nodes_.size()) - 1;
+}
+
+int NativeExpression::Rescale(int node, int scale) {
+  if (node < 0 || nodes_[node].scale > scale || scale > kMaxScale)
+    return -1;
+  if (nodes_[node].scale == scale)
+    return node;
+  return AddNode(Op::RESCALE, scale, {node});
+}
+
+int NativeExpression::CompileItem(Item *item) {
+  switch (static_cast<int>(item->type())) {
+    case Item::REF_ITEM: {
+      Item_ref *ref = static_cast<Item_ref *>(item);
+      return (ref->ref && *ref->ref) ? CompileItem(*ref->ref) : -1;
+    }
+    case Item::NULL_ITEM: {
+      int n = AddNode(Op::CONST, 0, {});
+      nodes_[n].null = true;
+      return n;
+    }
+    default:
+      break;
+  }
+
+  Item_result type = item->result_type();
+  if (type != INT_RESULT && type != DECIMAL_RESULT)
+    return -1;
+  int scale = type == DECIMAL_RESULT ? item->decimals : 0;
+  if (scale > kMaxScale)
+    return -1;
+
+  switch (static_cast<int>(item->type())) {
+    case static_cast<int>(Item_tianmufield::enumTIANMUFiledItem::TIANMUFIELD_ITEM):
+      return CompileColumn(item, scale);
+    case Item::INT_ITEM:
+    case Item::DECIMAL_ITEM:
+    case Item::CACHE_ITEM: {
+      if (!item->const_item() || item->unsigned_flag)
+        return -1;
+      auto v = type == INT_RESULT ? MysqlExpression::ItemInt2ValueOrNull(item)
+                                  : MysqlExpression::ItemDecimal2ValueOrNull(item, scale);
+      int n = AddNode(Op::CONST, scale, {});
+      nodes_[n].null = v->IsNull();
+      nodes_[n].value = v->IsNull() ? 0 : v->Get64();
+      return n;
+    }
+    case Item::FUNC_ITEM:
+    case Item::COND_ITEM:
+      return CompileFunc(static_cast<Item_func *>(item), scale);
+    default:
+      return -1;
+  }
+}
+
+int NativeExpression::CompileColumn(Item *item, int scale) {
+  if (item->unsigned_flag)
+    return -1;
+
+  // the variable is the one whose usages include this item
+  const VarID *var = nullptr;
+  for (auto &it : *fields_) {
+    if (it.second.count(static_cast<Item_tianmufield *>(item)) == 0)
+      continue;
+    if (var != nullptr)
+      return -1;
+    var = &it.first;
+  }
+  if (var == nullptr)
+    return -1;
+
+  auto type = types_->find(*var);
+  if (type == types_->end())
+    return -1;
+  const DataType &dt = type->second;
+  if (!dt.IsFixed() || dt.unsigned_flag_ || dt.fixscale != scale ||
+      (!ATI::IsIntegerType(dt.attrtype) && dt.attrtype != common::ColumnType::NUM))
+    return -1;
+
+  int n = AddNode(Op::COLUMN, scale, {});
+  auto pos = std::find(vars_.begin(), vars_.end(), *var);
+  nodes_[n].var = int(pos - vars_.begin());
+  if (pos == vars_.end())
+    vars_.push_back(*var);
+  return n;
+}
+
+int NativeExpression::CompileFunc(Item_func *func, int scale) {
+  std::vector<int> args;
+  if (func->type() == Item::COND_ITEM) {
+    List_iterator<Item> li(*static_cast<Item_cond *>(func)->argument_list());
+    for (Item *arg; (arg = li++);) args.push_back(CompileItem(arg));
+  } else {
+    for (uint i = 0; i < func->argument_count(); i++) args.push_back(CompileItem(func->arguments()[i]));
+  }
+  if (std::find(args.begin(), args.end(), -1) != args.end())
+    return -1;
+
+  // operands of comparisons and arithmetic are compared/added at a common scale
+  auto align = [this, &args](int to) {
+    for (auto &a : args) {
+      a = Rescale(a, to);
+      if (a < 0)
+        return false;
+    }
+    return true;
+  };
+  auto max_scale = [this, &args]() {
+    int s = 0;
+    for (auto a : args) s = std::max(s, nodes_[a].scale);
+    return s;
+  };
+
+  Op op;
+  switch (func->functype()) {
+    case Item_func::EQ_FUNC:
+      op = Op::EQ;
+      break;
+    case Item_func::NE_FUNC:
+      op = Op::NE;
+      break;
+    case Item_func::LT_FUNC:
+      op = Op::LT;
+      break;
+    case Item_func::LE_FUNC:
+      op = Op::LE;
+      break;
+    case Item_func::GT_FUNC:
+      op = Op::GT;
+      break;
+    case Item_func::GE_FUNC:
+      op = Op::GE;
+      break;
+    case Item_func::EQUAL_FUNC:
+      op = Op::EQ_NULL_SAFE;
+      break;
+    case Item_func::COND_AND_FUNC:
+    case Item_func::COND_OR_FUNC: {
+      if (args.empty() || scale != 0)
+        return -1;
+      op = func->functype() == Item_func::COND_AND_FUNC ? Op::AND : Op::OR;
+      int n = args[0];
+      for (size_t i = 1; i < args.size(); i++) n = AddNode(op, 0, {n, args[i]});
+      return n;
+    }
+    case Item_func::NOT_FUNC:
+      return (args.size() == 1 && scale == 0) ? AddNode(Op::NOT, 0, args) : -1;
+    case Item_func::ISNULL_FUNC:
+      return (args.size() == 1 && scale == 0) ? AddNode(Op::IS_NULL, 0, args) : -1;
+    case Item_func::ISNOTNULL_FUNC:
+      return (args.size() == 1 && scale == 0) ? AddNode(Op::IS_NOT_NULL, 0, args) : -1;
+    case Item_func::NEG_FUNC:
+      return (args.size() == 1 && !func->unsigned_flag && nodes_[args[0]].scale == scale)
+                 ? AddNode(Op::NEG, scale, args)
+                 : -1;
+    default: {
+      if (func->unsigned_flag)
+        return -1;
+      if (dynamic_cast<Item_func_plus *>(func) || dynamic_cast<Item_func_minus *>(func)) {
+        if (args.size() != 2 || max_scale() != scale || !align(scale))
+          return -1;
+        return AddNode(dynamic_cast<Item_func_plus *>(func) ? Op::ADD : Op::SUB, scale, args);
+      }
+      if (dynamic_cast<Item_func_mul *>(func)) {
+        if (args.size() != 2 || nodes_[args[0]].scale + nodes_[args[1]].scale != scale)
+          return -1;
+        return AddNode(Op::MUL, scale, args);
+      }
+      if (dynamic_cast<Item_func_abs *>(func))
+        return (args.size() == 1 && nodes_[args[0]].scale == scale) ? AddNode(Op::ABS, scale, args) : -1;
+      if (dynamic_cast<Item_func_if *>(func)) {
+        if (args.size() != 3)
+          return -1;
+        args[1] = Rescale(args[1], scale);
+        args[2] = Rescale(args[2], scale);
+        return (args[1] < 0 || args[2] < 0) ? -1 : AddNode(Op::IF, scale, args);
+      }
+      if (dynamic_cast<Item_func_coalesce *>(func))  // also IFNULL
+        return (!args.empty() && align(scale)) ? AddNode(Op::COALESCE, scale, args) : -1;
+      return -1;
+    }
+  }
+
+  // comparisons
+  if (args.size() != 2 || scale != 0 || !align(max_scale()))
+    return -1;
+  return AddNode(op, 0, args);
+}
+
+bool NativeExpression::Evaluate(const std::vector<const int64_t *> &args, size_t n, int64_t *out) const {
+  DEBUG_ASSERT(args.size() == vars_.size());
+  std::vector<int64_t> values(nodes_.size() * kBatchRows);
+  std::vector<uint8_t> nulls(nodes_.size() * kBatchRows);
+  bool overflow = false;
+
+  for (size_t start = 0; start < n; start += kBatchRows) {
+    size_t rows = std::min(kBatchRows, n - start);
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      const Node &node = nodes_[i];
+      int64_t *v = &values[i * kBatchRows];
+      uint8_t *nl = &nulls[i * kBatchRows];
+      const int64_t *a = node.args.size() > 0 ? &values[node.args[0] * kBatchRows] : nullptr;
+      const uint8_t *an = node.args.size() > 0 ? &nulls[node.args[0] * kBatchRows] : nullptr;
+      const int64_t *b = node.args.size() > 1 ? &values[node.args[1] * kBatchRows] : nullptr;
+      const uint8_t *bn = node.args.size() > 1 ? &nulls[node.args[1] * kBatchRows] : nullptr;
+
+      // null rows hold 0, so the arithmetic below can run over them unconditionally
+      switch (node.op) {
+        case Op::COLUMN: {
+          const int64_t *src = args[node.var] + start;
+          for (size_t r = 0; r < rows; r++) {
+            nl[r] = src[r] == common::NULL_VALUE_64;
+            v[r] = nl[r] ? 0 : src[r];
+          }
+        } break;
+        case Op::CONST:
+          std::fill(v, v + rows, node.value);
+          std::fill(nl, nl + rows, node.null);
+          break;
+        case Op::RESCALE:
+          for (size_t r = 0; r < rows; r++) {
+            overflow |= __builtin_mul_overflow(a[r], node.value, &v[r]);
+            nl[r] = an[r];
+          }
+          break;
+        case Op::ADD:
+          for (size_t r = 0; r < rows; r++) {
+            overflow |= __builtin_add_overflow(a[r], b[r], &v[r]);
+            nl[r] = an[r] | bn[r];
+          }
+          break;
+        case Op::SUB:
+          for (size_t r = 0; r < rows; r++) {
+            overflow |= __builtin_sub_overflow(a[r], b[r], &v[r]);
+            nl[r] = an[r] | bn[r];
+          }
+          break;
+        case Op::MUL:
+          for (size_t r = 0; r < rows; r++) {
+            overflow |= __builtin_mul_overflow(a[r], b[r], &v[r]);
+            nl[r] = an[r] | bn[r];
+          }
+          break;
+        case Op::NEG:
+          for (size_t r = 0; r < rows; r++) {
+            overflow |= __builtin_sub_overflow(int64_t(0), a[r], &v[r]);
+            nl[r] = an[r];
+          }
+          break;
+        case Op::ABS:
+          for (size_t r = 0; r < rows; r++) {
+            overflow |= __builtin_sub_overflow(int64_t(0), a[r], &v[r]);
+            v[r] = a[r] < 0 ? v[r] : a[r];
+            nl[r] = an[r];
+          }
+          break;
+#define TIANMU_NATIVE_COMPARE(OP, EXPR)              \
+  case Op::OP:                                       \
+    for (size_t r = 0; r < rows; r++) {              \
+      nl[r] = an[r] | bn[r];                         \
+      v[r] = !nl[r] && (EXPR);                       \
+    }                                                \
+    break;
+          TIANMU_NATIVE_COMPARE(EQ, a[r] == b[r])
+          TIANMU_NATIVE_COMPARE(NE, a[r] != b[r])
+          TIANMU_NATIVE_COMPARE(LT, a[r] < b[r])
+          TIANMU_NATIVE_COMPARE(LE, a[r] <= b[r])
+          TIANMU_NATIVE_COMPARE(GT, a[r] > b[r])
+          TIANMU_NATIVE_COMPARE(GE, a[r] >= b[r])
+#undef TIANMU_NATIVE_COMPARE
+        case Op::EQ_NULL_SAFE:
+          for (size_t r = 0; r < rows; r++) {
+            v[r] = (an[r] && bn[r]) || (!an[r] && !bn[r] && a[r] == b[r]);
+            nl[r] = 0;
+          }
+          break;
+        case Op::AND:  // false wins over null
+          for (size_t r = 0; r < rows; r++) {
+            bool is_false = (!an[r] && a[r] == 0) || (!bn[r] && b[r] == 0);
+            nl[r] = !is_false && (an[r] | bn[r]);
+            v[r] = !is_false && !nl[r];
+          }
+          break;
+        case Op::OR:  // true wins over null
+          for (size_t r = 0; r < rows; r++) {
+            bool is_true = (!an[r] && a[r] != 0) || (!bn[r] && b[r] != 0);
+            nl[r] = !is_true && (an[r] | bn[r]);
+            v[r] = is_true;
+          }
+          break;
+        case Op::NOT:
+          for (size_t r = 0; r < rows; r++) {
+            nl[r] = an[r];
+            v[r] = !an[r] && a[r] == 0;
+          }
+          break;
+        case Op::IS_NULL:
+        case Op::IS_NOT_NULL:
+          for (size_t r = 0; r < rows; r++) {
+            v[r] = (an[r] != 0) == (node.op == Op::IS_NULL);
+            nl[r] = 0;
+          }
+          break;
+        case Op::IF: {
+          const int64_t *c = &values[node.args[2] * kBatchRows];
+          const uint8_t *cn = &nulls[node.args[2] * kBatchRows];
+          // a: condition, b: then, c: else
+          for (size_t r = 0; r < rows; r++) {
+            bool cond = !an[r] && a[r] != 0;
+            v[r] = cond ? b[r] : c[r];
+            nl[r] = cond ? bn[r] : cn[r];
+          }
+        } break;
+        case Op::COALESCE:
+          std::copy(a, a + rows, v);
+          std::copy(an, an + rows, nl);
+          for (size_t k = 1; k < node.args.size(); k++) {
+            const int64_t *x = &values[node.args[k] * kBatchRows];
+            const uint8_t *xn = &nulls[node.args[k] * kBatchRows];
+            for (size_t r = 0; r < rows; r++) {
+              if (nl[r]) {
+                v[r] = x[r];
+                nl[r] = xn[r];
+              }
+            }
+          }
+          break;
+      }
+    }
+    if (overflow)
+      return false;
+
+    const int64_t *v = &values[(nodes_.size() - 1) * kBatchRows];
+    const uint8_t *nl = &nulls[(nodes_.size() - 1) * kBatchRows];
+    for (size_t r = 0; r < rows; r++) {
+      // as MysqlExpression::ItemInt2ValueOrNull, a value equal to the null marker moves by one
+      out[start + r] = nl[r] ? common::NULL_VALUE_64 : (v[r] == common::NULL_VALUE_64 ? v[r] + 1 : v[r]);
+    }
+  }
+  return true;
+}
+
+}  // namespace core
+}  // namespace Tianmu
@@ -0,0 +1,103 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_CORE_NATIVE_EXPRESSION_H_
+#define TIANMU_CORE_NATIVE_EXPRESSION_H_
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "core/mysql_expression.h"
+
+namespace Tianmu {
+namespace core {
+
+// Integer and DECIMAL(18) expressions compiled from a transformed MySQL item
+// tree: + - *, unary minus, ABS, comparisons, AND/OR/NOT, IS [NOT] NULL, IF,
+// IFNULL and COALESCE over numeric columns and literals. Values are fixed point
+// int64 at the scale MySQL gives each item, evaluated a batch of rows at a time
+// into value vectors with null flags. Anything else is not compiled and stays
+// on the MysqlExpression::Evaluate() path.
+class NativeExpression final {
+ public:
+  // nullptr if some node of the tree is not supported
+  static std::unique_ptr<NativeExpression> Compile(MysqlExpression &expr, const MysqlExpression::TypOfVars &types);
+
+  // variables in the order Evaluate() takes their values
+  const std::vector<VarID> &GetVars() const { return vars_; }
+
+  // args[i][r] is GetVars()[i] in row r, common::NULL_VALUE_64 for null; the n results
+  // are encoded the same way. False if an int64 overflowed, the rows need the item path then.
+  bool Evaluate(const std::vector<const int64_t *> &args, size_t n, int64_t *out) const;
+
+ private:
+  enum class Op : uint8_t {
+    COLUMN,
+    CONST,
+    RESCALE,
+    ADD,
+    SUB,
+    MUL,
+    NEG,
+    ABS,
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE,
+    EQ_NULL_SAFE,
+    AND,
+    OR,
+    NOT,
+    IS_NULL,
+    IS_NOT_NULL,
+    IF,
+    COALESCE,
+  };
+
+  struct Node {
+    Op op;
+    int scale;              // decimal digits of the value
+    std::vector<int> args;  // indexes of earlier nodes
+    int64_t value = 0;      // CONST value, RESCALE multiplier
+    bool null = false;      // CONST is null
+    int var = -1;           // COLUMN position in vars_
+  };
+
+  NativeExpression() = default;
+
+  // index of the node computing `item`, -1 if not supported
+  int CompileItem(Item *item);
+  int CompileFunc(Item_func *func, int scale);
+  int CompileColumn(Item *item, int scale);
+  int AddNode(Op op, int scale, std::vector<int> args);
+  // `node` brought up to `scale`, -1 if that would lose digits
+  int Rescale(int node, int scale);
+
+  // only set while compiling
+  const MysqlExpression::tianmu_fields_cache_t *fields_ = nullptr;
+  const MysqlExpression::TypOfVars *types_ = nullptr;
+
+  std::vector<Node> nodes_;  // children before parents, the root last
+  std::vector<VarID> vars_;
+};
+
+}  // namespace core
+}  // namespace Tianmu
+
+#endif  // TIANMU_CORE_NATIVE_EXPRESSION_H_
@@ -15,7 +15,10 @@
    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
 */
 
+#include <algorithm>
+#include <cstring>
 #include <list>
+#include <numeric>
 
 #include "common/assert.h"
 #include "core/engine.h"
@@ -27,6 +30,7 @@
 #include "executor/task_executor.h"
 #include "optimizer/joiner_hash.h"
 #include "system/fet.h"
+#include "util/bin_tools.h"
 #include "util/thread_pool.h"
 #include "vc/virtual_column.h"
 
@@ -43,6 +47,17 @@ const int kJoinSplittedMinPacks = INT_MAX32 / 2;
 // we'll re-enable the hash join later if the bug is fixed in near future.
 const int kTraversedPacksPerFragment = INT_MAX32 / 2;
 
+// Radix join: records and buckets of one partition should fit in the L2 cache.
+const uint64_t kRadixPartitionBytes = 256 * 1024;
+const uint32_t kMaxRadixBits = 12;
+// Grace hash join: a partition too large to be joined in memory is split by
+// this many more bits of the hash.
+const uint32_t kSpillRadixBits = 6;
+
+// Rows a matching task probes before it keeps the runtime filter only if at
+// least 1/8 of them were omitted.
+const int64_t kRuntimeFilterTrialRows = 65536;
+
 int EvaluateTraversedFragments(int packs_count) {
   const int kMaxTraversedFragmentCount = 8;
   return std::max(std::min(packs_count / kTraversedPacksPerFragment, kMaxTraversedFragmentCount), 1);
@@ -62,6 +77,30 @@ int EvaluateMatchedFragmentsWithRows([[maybe_unused]] uint32_t pack_power, int64
   return std::max(fragments, 1);
 }
 
+// Calls f(records, size) for the records of the partition kept in memory and
+// then for each of its spilled blocks, read into block.
+template <typename Params, typename Func>
+void ForEachRadixBlock(Params &params, int partition, std::vector<unsigned char> &block, Func f) {
+  auto &records = params.partitions[partition];
+  if (!records.empty())
+    f(records.data(), records.size());
+  if (params.spilled)
+    for (size_t index = 0; index < params.spilled->NumOfBlocks(partition); ++index) {
+      params.spilled->Get(partition, index, block);
+      f(block.data(), block.size());
+    }
+}
+
+template <typename Params>
+uint64_t RadixPartitionBytes(std::vector<Params> &sides, int partition) {
+  uint64_t bytes = 0;
+  for (auto &side : sides) {
+    bytes += side.partitions[partition].size();
+    if (side.spilled)
+      bytes += side.spilled->Bytes(partition);
+  }
+  return bytes;
+}
 }  // namespace
 
 //----------------------------------------------MITaskIterator-----------------------------------------------
@@ -207,6 +246,13 @@ ParallelHashJoiner::MatchTaskParams::~MatchTaskParams() {
   }
 }
 
+ParallelHashJoiner::RadixPartitionParams::~RadixPartitionParams() {
+  if (task_miter) {
+    delete task_miter;
+    task_miter = nullptr;
+  }
+}
+
 // ParallelHashJoiner
 ParallelHashJoiner::ParallelHashJoiner(MultiIndex *multi_index, TempTable *temp_table, JoinTips &join_tips)
     : TwoDimensionalJoiner(multi_index, temp_table, join_tips), interrupt_matching_(false) {
@@ -219,6 +265,7 @@ ParallelHashJoiner::ParallelHashJoiner(MultiIndex *multi_index, TempTable *temp_
   other_cond_exist_ = false;
   packrows_omitted_ = 0;
   packrows_matched_ = 0;
+  rows_filtered_ = 0;
   actually_traversed_rows_ = 0;
   watch_traversed_ = false;
   watch_matched_ = false;
@@ -387,6 +434,7 @@ bool ParallelHashJoiner::PrepareBeforeJoin(Condition &cond) {
     column_bin_encoder_[index].SetPrimaryOffset(key_buf_width);
     key_buf_width += hash_table_key_size_[index];
   }
+  key_buf_width_ = key_buf_width;
 
   InitOuter(cond);
 
@@ -432,7 +480,9 @@ void ParallelHashJoiner::ExecuteJoin() {
   actually_traversed_rows_ = 0;
   outer_tuples_ = 0;
 
-  if (traversed_dims_size > 0 && matched_dims_size > 0) {
+  if (traversed_dims_size > 0 && matched_dims_size > 0 && RadixJoinApplicable()) {
+    joined_tuples += RadixJoin(traversed_mit, match_mit);
+  } else if (traversed_dims_size > 0 && matched_dims_size > 0) {
     int64_t outer_tuples = 0;
     TraverseDim(traversed_mit, &outer_tuples);
 
@@ -463,6 +513,9 @@ void ParallelHashJoiner::ExecuteJoin() {
     tianmu_control_.lock(m_conn->GetThreadID())
         << "Roughly omitted " << int(packrows_omitted_ / double(packrows_matched_) * 10000.0) / 100.0 << "% packrows."
         << system::unlock;
+  if (rows_filtered_ > 0)
+    tianmu_control_.lock(m_conn->GetThreadID())
+        << "Runtime filter omitted " << rows_filtered_ << " rows." << system::unlock;
 
   multi_index_builder_->Commit(joined_tuples, tips.count_only);
 
@@ -491,47 +544,7 @@ int64_t ParallelHashJoiner::TraverseDim(MIIterator &mit, int64_t *outer_tuples)
 
   std::string splitting_type("none");
   std::vector<MITaskIterator *> task_iterators;
-  MIIterator::SliceCapability slice_capability = mit.GetSliceCapability();
-  if (slice_capability.type == MIIterator::SliceCapability::Type::kFixed) {
-    DEBUG_ASSERT(!slice_capability.slices.empty());
-    splitting_type = "fixed";
-    size_t slices_size = slice_capability.slices.size();
-    int64_t rows_started = 0;
-    for (size_t index = 0; index < slices_size; ++index) {
-      MITaskIterator *iter = new MIFixedTaskIterator(pack_power_, mind, traversed_dims_, index, slices_size,
-                                                     slice_capability.slices[index], rows_started, index);
-      rows_started += slice_capability.slices[index];
-      task_iterators.push_back(iter);
-    }
-  } else if ((slice_capability.type == MIIterator::SliceCapability::Type::kLinear) &&
-             (availabled_packs > kTraversedPacksPerFragment * 2)) {
-    int64_t origin_size = rows_count;
-    for (int index = 0; index < mind->NumOfDimensions(); index++) {
-      if (traversed_dims_[index]) {
-        origin_size = std::max<int64_t>(origin_size, mind->OrigSize(index));
-      }
-    }
-
-    splitting_type = "packs";
-    int packs_count = (int)((origin_size + (1 << pack_power_) - 1) >> pack_power_);
-    int split_count = EvaluateTraversedFragments(packs_count);
-    int packs_per_fragment = packs_count / split_count;
-    int64_t rows_length = origin_size / split_count;
-    for (int index = 0; index < split_count; ++index) {
-      int packs_started = index * packs_per_fragment;
-      if (packs_started >= packs_count)
-        break;
-
-      int packs_increased = (index == split_count - 1) ? (-1 - packs_started) : (packs_per_fragment - 1);
-
-      MITaskIterator *iter = new MILinearPackTaskIterator(pack_power_, mind, traversed_dims_, index, split_count,
-                                                          rows_length, packs_started, packs_started + packs_increased);
-      task_iterators.push_back(iter);
-    }
-  } else {
-    MITaskIterator *iter = new MITaskIterator(mind, traversed_dims_, 0, 1, rows_count);
-    task_iterators.push_back(iter);
-  }
+  CreateTraversingTasks(mit, rows_count, &task_iterators, &splitting_type);
 
   int traversed_fragment_count = (int)task_iterators.size();
   tianmu_control_.lock(m_conn->GetThreadID()) << "Begin traversed with " << traversed_fragment_count << " threads with "
@@ -544,6 +557,8 @@ int64_t ParallelHashJoiner::TraverseDim(MIIterator &mit, int64_t *outer_tuples)
   // Preload packs data of TempTable.
   TempTablePackLocker temptable_pack_locker(vc1_, cond_hashed_, availabled_packs);
 
+  PrepareRuntimeFilter(rows_count);
+
   int64_t traversed_rows = 0;
   bool no_except = true;
   utils::result_set<int64_t> res;
@@ -654,6 +669,9 @@ int64_t ParallelHashJoiner::AsyncTraverseDim(TraverseTaskParams *params) {
       if (!force_switching_sides_ && params->too_many_conflicts && !tianmu_sysvar_join_disable_switch_side)
         break;  // and exit the function
 
+      if (runtime_filter_)
+        runtime_filter_->Add(reinterpret_cast<unsigned char *>(key_input_buffer.data()));
+
       if (watch_traversed_)
         params->traversed_hash_table->outer_filter()->Set(hash_row);
 
@@ -689,6 +707,56 @@ int64_t ParallelHashJoiner::AsyncTraverseDim(TraverseTaskParams *params) {
   return traversed_rows;
 }
 
+bool ParallelHashJoiner::CreateTraversingTasks(MIIterator &mit, int64_t rows_count,
+                                               std::vector<MITaskIterator *> *task_iterators,
+                                               std::string *splitting_type) {
+  int availabled_packs = (int)((rows_count + (1 << pack_power_) - 1) >> pack_power_);
+
+  MIIterator::SliceCapability slice_capability = mit.GetSliceCapability();
+  if (slice_capability.type == MIIterator::SliceCapability::Type::kFixed) {
+    DEBUG_ASSERT(!slice_capability.slices.empty());
+    *splitting_type = "fixed";
+    size_t slices_size = slice_capability.slices.size();
+    int64_t rows_started = 0;
+    for (size_t index = 0; index < slices_size; ++index) {
+      MITaskIterator *iter = new MIFixedTaskIterator(pack_power_, mind, traversed_dims_, index, slices_size,
+                                                     slice_capability.slices[index], rows_started, index);
+      rows_started += slice_capability.slices[index];
+      task_iterators->push_back(iter);
+    }
+  } else if ((slice_capability.type == MIIterator::SliceCapability::Type::kLinear) &&
+             (availabled_packs > kTraversedPacksPerFragment * 2)) {
+    int64_t origin_size = rows_count;
+    for (int index = 0; index < mind->NumOfDimensions(); index++) {
+      if (traversed_dims_[index]) {
+        origin_size = std::max<int64_t>(origin_size, mind->OrigSize(index));
+      }
+    }
+
+    *splitting_type = "packs";
+    int packs_count = (int)((origin_size + (1 << pack_power_) - 1) >> pack_power_);
+    int split_count = EvaluateTraversedFragments(packs_count);
+    int packs_per_fragment = packs_count / split_count;
+    int64_t rows_length = origin_size / split_count;
+    for (int index = 0; index < split_count; ++index) {
+      int packs_started = index * packs_per_fragment;
+      if (packs_started >= packs_count)
+        break;
+
+      int packs_increased = (index == split_count - 1) ? (-1 - packs_started) : (packs_per_fragment - 1);
+
+      MITaskIterator *iter = new MILinearPackTaskIterator(pack_power_, mind, traversed_dims_, index, split_count,
+                                                          rows_length, packs_started, packs_started + packs_increased);
+      task_iterators->push_back(iter);
+    }
+  } else {
+    MITaskIterator *iter = new MITaskIterator(mind, traversed_dims_, 0, 1, rows_count);
+    task_iterators->push_back(iter);
+  }
+
+  return true;
+}
+
 bool ParallelHashJoiner::CreateMatchingTasks(MIIterator &mit, int64_t rows_count,
                                              std::vector<MITaskIterator *> *task_iterators,
                                              std::string *splitting_type) {
@@ -875,6 +943,11 @@ int64_t ParallelHashJoiner::AsyncMatchDim(MatchTaskParams *params) {
   int64_t matching_row = params->task_miter->GetStartPackrows();
   MIDummyIterator combined_mit(mind);  // a combined iterator for checking non-hashed conditions, if any
 
+  // The row filter is turned off for the task if it does not pay off.
+  bool use_runtime_filter = (runtime_filter_ != nullptr);
+  int64_t filter_probes = 0;
+  int64_t filter_omitted = 0;
+
   while (params->task_miter->IsValid() && !interrupt_matching_) {
     if (m_conn->Killed())
       break;
@@ -906,6 +979,12 @@ int64_t ParallelHashJoiner::AsyncMatchDim(MatchTaskParams *params) {
             omit_this_packrow = true;
             break;
           }
+          if (runtime_filter_ranges_ &&
+              RuntimeFilterOmitsPack(column_bin_encoder[index],
+                                     reinterpret_cast<unsigned char *>(key_input_buffer.data()), local_min, local_max)) {
+            omit_this_packrow = true;
+            break;
+          }
           if (other_cond_exist_ || local_min != local_max || vc2_[index]->IsNullsPossible()) {
             packrow_uniform = false;
           }
@@ -968,7 +1047,17 @@ int64_t ParallelHashJoiner::AsyncMatchDim(MatchTaskParams *params) {
       column_bin_encoder[index].Encode(reinterpret_cast<unsigned char *>(key_input_buffer.data()), miter, vc2_[index]);
     }
 
-    if (!null_found && !non_matching_sizes) {  // else go to the next row -
+    bool filtered_out = false;
+    if (!null_found && use_runtime_filter) {
+      filtered_out = !runtime_filter_->MayContain(reinterpret_cast<unsigned char *>(key_input_buffer.data()));
+      filter_probes++;
+      if (filtered_out)
+        filter_omitted++;
+      if (filter_probes == kRuntimeFilterTrialRows && filter_omitted * 8 < filter_probes)
+        use_runtime_filter = false;
+    }
+
+    if (!null_found && !non_matching_sizes && !filtered_out) {  // else go to the next row -
                                                // equality cannot be fulfilled
       for (auto &traversed_hash_table : traversed_hash_tables_) {
         HashTable *hash_table = traversed_hash_table.hash_table();
@@ -1036,6 +1125,7 @@ int64_t ParallelHashJoiner::AsyncMatchDim(MatchTaskParams *params) {
   if (watch_matched_)
     outer_matched_filter_->Commit(true);  // Commit the delayed resetsC.
 
+  rows_filtered_ += filter_omitted;
   params->build_item->Finish();
 
   if (outer_nulls_only_)
@@ -1064,8 +1154,458 @@ void ParallelHashJoiner::SubmitJoinedTuple(MultiIndexBuilder::BuildItem *build_i
   }
 }
 
+// radix join part
+
+bool ParallelHashJoiner::RadixJoinApplicable() {
+  // Outer joins and non-hashed conditions need the shared table (outer filters, tuple lookups).
+  if (!(tianmu_sysvar_join_radix_partition || tianmu_sysvar_spill_memory_limit > 0) || other_cond_exist_ ||
+      watch_traversed_ || watch_matched_)
+    return false;
+  if (tianmu_sysvar_spill_memory_limit > 0)  // the partitions over the limit are spilled
+    return true;
+
+  // Without spilling both sides are held in memory at once, which must stay within the
+  // limit used for the shared hash table, otherwise it is the safer choice.
+  int traversed_tuple_cols = tips.count_only ? 0 : traversed_dims_.NoDimsUsed();
+  int matched_tuple_cols = tips.count_only ? 0 : matched_dims_.NoDimsUsed();
+  uint64_t traversed_bytes =
+      mind->NumOfTuples(traversed_dims_) *
+      (sizeof(uint32_t) * 3 + sizeof(void *) + key_buf_width_ + traversed_tuple_cols * sizeof(int64_t));
+  uint64_t matched_bytes =
+      mind->NumOfTuples(matched_dims_) * (sizeof(uint32_t) + key_buf_width_ + matched_tuple_cols * sizeof(int64_t));
+  uint64_t max_bytes = mm::TraceableObject::MaxBufferSize();
+  if (traversed_bytes + matched_bytes > max_bytes) {
+    tianmu_control_.lock(m_conn->GetThreadID())
+        << "Radix join needs " << (traversed_bytes + matched_bytes) / 1_MB << " MB over the " << max_bytes / 1_MB
+        << " MB limit, using the shared hash table." << system::unlock;
+    return false;
+  }
+  return true;
+}
+
+template <typename Params>
+int64_t ParallelHashJoiner::RunTasks(std::vector<Params> &params, int64_t (ParallelHashJoiner::*task)(Params *)) {
+  if (params.size() == 1)
+    return (this->*task)(&params[0]);
+
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  assert(eng);
+
+  utils::result_set<int64_t> res;
+  try {
+    for (auto &param : params) res.insert(eng->query_thread_pool.add_task(task, this, &param));
+  } catch (std::exception &e) {
+    res.get_all_with_except();
+    throw e;
+  } catch (...) {
+    res.get_all_with_except();
+    throw;
+  }
+
+  int64_t total = 0;
+  bool no_except = true;
+  for (size_t i = 0; i < res.size(); i++) try {
+      total += res.get(i);
+    } catch (std::exception &e) {
+      no_except = false;
+      TIANMU_LOG(LogCtl_Level::ERROR, "An exception is caught: %s", e.what());
+    } catch (...) {
+      no_except = false;
+      TIANMU_LOG(LogCtl_Level::ERROR, "An unknown system exception error caught.");
+    }
+  if (!no_except) {
+    throw common::Exception("Parallel hash join failed.");
+  }
+  return total;
+}
+
+int64_t ParallelHashJoiner::RadixJoin(MIIterator &traversed_mit, MIIterator &match_mit) {
+  MEASURE_FET("ParallelHashJoiner::RadixJoin(...)");
+
+  int traversed_tuple_cols = tips.count_only ? 0 : traversed_dims_.NoDimsUsed();
+  int matched_tuple_cols = tips.count_only ? 0 : matched_dims_.NoDimsUsed();
+  traversed_record_size_ = sizeof(uint32_t) + key_buf_width_ + traversed_tuple_cols * sizeof(int64_t);
+  matched_record_size_ = sizeof(uint32_t) + key_buf_width_ + matched_tuple_cols * sizeof(int64_t);
+
+  // Choose the number of partitions so that the records and buckets of one partition fit in the cache.
+  int64_t traversed_rows = mind->NumOfTuples(traversed_dims_);
+  int64_t matched_rows = mind->NumOfTuples(matched_dims_);
+  uint64_t table_bytes = traversed_rows * (traversed_record_size_ + sizeof(void *) + 2 * sizeof(uint32_t));
+  radix_bits_ = 0;
+  while (radix_bits_ < kMaxRadixBits && (table_bytes >> radix_bits_) > kRadixPartitionBytes) radix_bits_++;
+  int partitions = 1 << radix_bits_;
+  spill_memory_ = size_t(tianmu_sysvar_spill_memory_limit) << 20;
+
+  std::string splitting_type("none");
+  std::vector<MITaskIterator *> task_iterators;
+  CreateTraversingTasks(traversed_mit, traversed_rows, &task_iterators, &splitting_type);
+
+  tianmu_control_.lock(m_conn->GetThreadID())
+      << "Begin radix join of " << traversed_rows << " x " << matched_rows << " rows in " << partitions
+      << " partitions, traversed with " << task_iterators.size() << " threads with " << splitting_type << " type."
+      << system::unlock;
+
+  // 1. Partition the traversed side, gathering the key statistics for the rough part of matching.
+  std::vector<RadixPartitionParams> traversed_params;
+  traversed_params.reserve(task_iterators.size());
+  for (MITaskIterator *iter : task_iterators) {
+    auto &params = traversed_params.emplace_back();
+    params.task_miter = iter;
+    params.traversed = true;
+    params.column_bin_encoder = column_bin_encoder_;
+    params.partitions.resize(partitions);
+    params.record_size = traversed_record_size_;
+    params.memory_limit = spill_memory_ / (2 * std::max<size_t>(task_iterators.size(), 1));  // a half for each side
+  }
+  {
+    int availabled_packs = (int)((traversed_rows + (1 << pack_power_) - 1) >> pack_power_);
+    TempTablePackLocker temptable_pack_locker(vc1_, cond_hashed_, availabled_packs);
+    actually_traversed_rows_ = RunTasks(traversed_params, &ParallelHashJoiner::AsyncRadixPartition);
+    for (int index = 0; index < cond_hashed_; ++index) vc1_[index]->UnlockSourcePacks();
+  }
+  if (m_conn->Killed())
+    throw common::KilledException();
+
+  // Only the encoders are used, see ImpossibleValues().
+  traversed_hash_tables_.reserve(traversed_params.size());
+  for (auto &params : traversed_params) {
+    auto &ht = traversed_hash_tables_.emplace_back(hash_table_key_size_, hash_table_tuple_size_, 0, pack_power_, false);
+    ht.AssignColumnEncoder(params.column_bin_encoder);
+  }
+
+  // 2. Partition the matched side.
+  task_iterators.clear();
+  CreateMatchingTasks(match_mit, matched_rows, &task_iterators, &splitting_type);
+  std::vector<RadixPartitionParams> matched_params;
+  matched_params.reserve(task_iterators.size());
+  for (MITaskIterator *iter : task_iterators) {
+    auto &params = matched_params.emplace_back();
+    params.task_miter = iter;
+    traversed_hash_tables_[0].GetColumnEncoder(&params.column_bin_encoder);
+    params.partitions.resize(partitions);
+    params.record_size = matched_record_size_;
+    params.memory_limit = spill_memory_ / (2 * std::max<size_t>(task_iterators.size(), 1));
+  }
+  {
+    int availabled_packs = (int)((matched_rows + (1 << pack_power_) - 1) >> pack_power_);
+    TempTablePackLocker temptable_pack_locker(vc2_, cond_hashed_, availabled_packs);
+    RunTasks(matched_params, &ParallelHashJoiner::AsyncRadixPartition);
+    for (int index = 0; index < cond_hashed_; ++index) vc2_[index]->UnlockSourcePacks();
+  }
+  if (m_conn->Killed())
+    throw common::KilledException();
+
+  uint64_t spilled_bytes = 0;
+  for (auto *sides : {&traversed_params, &matched_params})
+    for (auto &params : *sides)
+      if (params.spilled)
+        spilled_bytes += params.spilled->DiskBytes();
+  if (spilled_bytes > 0)
+    tianmu_control_.lock(m_conn->GetThreadID())
+        << "Spilled " << spilled_bytes / 1_MB << " MB of join partitions to the cache folder." << system::unlock;
+
+  // 3. Build and probe the partitions, a contiguous range of them per task.
+  int max_threads = tianmu_sysvar_query_threads ? tianmu_sysvar_query_threads : std::thread::hardware_concurrency();
+  int join_tasks = std::max(std::min(partitions, max_threads), 1);
+  radix_join_memory_ = spill_memory_ / (2 * join_tasks);
+  std::vector<RadixJoinParams> join_params;
+  join_params.reserve(join_tasks);
+  for (int index = 0; index < join_tasks; ++index) {
+    auto &params = join_params.emplace_back();
+    params.build_item = multi_index_builder_->CreateBuildItem();
+    params.partition_begin = int(int64_t(partitions) * index / join_tasks);
+    params.partition_end = int(int64_t(partitions) * (index + 1) / join_tasks);
+  }
+
+  radix_traversed_ = &traversed_params;
+  radix_matched_ = &matched_params;
+  int64_t joined_tuples = RunTasks(join_params, &ParallelHashJoiner::AsyncRadixJoin);
+  radix_traversed_ = nullptr;
+  radix_matched_ = nullptr;
+
+  if (m_conn->Killed())
+    throw common::KilledException();
+
+  for (auto &params : join_params) multi_index_builder_->AddBuildItem(params.build_item);
+
+  tianmu_control_.lock(m_conn->GetThreadID())
+      << "End radix join with " << join_tasks << " threads. Produced tuples:" << joined_tuples << system::unlock;
+
+  return joined_tuples;
+}
+
+int64_t ParallelHashJoiner::AsyncRadixPartition(RadixPartitionParams *params) {
+  std::vector<vcolumn::VirtualColumn *> &vc = params->traversed ? vc1_ : vc2_;
+  DimensionVector &dims = params->traversed ? traversed_dims_ : matched_dims_;
+  std::vector<ColumnBinEncoder> &column_bin_encoder(params->column_bin_encoder);
+
+  std::vector<unsigned char> record(params->traversed ? traversed_record_size_ : matched_record_size_, 0);
+  unsigned char *key = record.data() + sizeof(uint32_t);
+  MIIterator &miter(*params->task_miter->GetIter());
+
+  int64_t partitioned_rows = 0;
+  while (params->task_miter->IsValid()) {
+    if (m_conn->Killed())
+      break;
+
+    if (miter.PackrowStarted()) {
+      if (!params->traversed) {
+        // Rough part: packs without any key value of the traversed side are skipped.
+        bool omit_this_packrow = false;
+        for (int index = 0; index < cond_hashed_ && !omit_this_packrow; ++index) {
+          if (column_bin_encoder[index].IsString()) {
+            if (!vc2_[index]->Type().Lookup()) {
+              types::BString local_min = vc2_[index]->GetMinString(miter);
+              types::BString local_max = vc2_[index]->GetMaxString(miter);
+              omit_this_packrow =
+                  !local_min.IsNull() && !local_max.IsNull() && ImpossibleValues(index, local_min, local_max);
+            }
+          } else {
+            int64_t local_min = vc2_[index]->GetMinInt64(miter);
+            int64_t local_max = vc2_[index]->GetMaxInt64(miter);
+            omit_this_packrow = local_min == common::NULL_VALUE_64 || local_max == common::NULL_VALUE_64 ||
+                                ImpossibleValues(index, local_min, local_max);
+          }
+        }
+        packrows_matched_++;
+        if (omit_this_packrow) {
+          packrows_omitted_++;
+          miter.NextPackrow();
+          continue;
+        }
+      }
+      for (int index = 0; index < cond_hashed_; ++index) vc[index]->LockSourcePacks(miter);
+    }
+
+    bool null_found = false;
+    for (int index = 0; index < cond_hashed_; ++index) {
+      if (vc[index]->IsNull(miter)) {
+        null_found = true;
+        break;
+      }
+      if (params->traversed)
+        column_bin_encoder[index].Encode(key, miter, nullptr, true);
+      else
+        column_bin_encoder[index].Encode(key, miter, vc2_[index]);
+    }
+
+    if (!null_found) {  // nulls never match
+      uint32_t hash = HashValue(key, key_buf_width_);
+      std::memcpy(record.data(), &hash, sizeof(hash));
+      if (!tips.count_only) {
+        unsigned char *tuple = key + key_buf_width_;
+        for (int index = 0; index < mind->NumOfDimensions(); ++index) {
+          if (dims[index]) {
+            int64_t row = miter[index];
+            std::memcpy(tuple, &row, sizeof(row));
+            tuple += sizeof(row);
+          }
+        }
+      }
+      // The top bits choose the partition, the bottom ones the bucket in its hash table.
+      AddRadixRecord(params, radix_bits_ ? hash >> (32 - radix_bits_) : 0, record.data());
+      partitioned_rows++;
+    }
+    ++miter;
+  }
+
+  return partitioned_rows;
+}
+
+int64_t ParallelHashJoiner::AsyncRadixJoin(RadixJoinParams *params) {
+  for (int partition = params->partition_begin; partition < params->partition_end; ++partition) {
+    if (interrupt_matching_ || m_conn->Killed())
+      break;
+    JoinRadixPartition(params, *radix_traversed_, *radix_matched_, partition, radix_bits_);
+  }
+
+  params->build_item->Finish();
+
+  return params->joined_tuples;
+}
+
+void ParallelHashJoiner::AddRadixRecord(RadixPartitionParams *params, int partition, const unsigned char *record) {
+  auto &records = params->partitions[partition];
+  records.insert(records.end(), record, record + params->record_size);
+  params->buffered += params->record_size;
+  if (params->memory_limit > 0 && params->buffered > params->memory_limit)
+    SpillRadixPartitions(params);
+}
+
+void ParallelHashJoiner::SpillRadixPartitions(RadixPartitionParams *params) {
+  if (!params->spilled)
+    params->spilled = std::make_shared<SpilledPartitions>(int(params->partitions.size()), params->record_size);
+
+  // The largest partitions go first, until a half of the limit is free again.
+  std::vector<int> order(params->partitions.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [params](int a, int b) { return params->partitions[a].size() > params->partitions[b].size(); });
+  for (int partition : order) {
+    if (params->buffered <= params->memory_limit / 2 || params->partitions[partition].empty())
+      break;
+    params->buffered -= params->partitions[partition].size();
+    params->spilled->Put(partition, params->partitions[partition]);
+  }
+}
+
+void ParallelHashJoiner::SplitRadixPartition(std::vector<RadixPartitionParams> &sides, int partition,
+                                             uint32_t hash_bits, RadixPartitionParams *target) {
+  std::vector<unsigned char> block;
+  for (auto &side : sides) {
+    ForEachRadixBlock(side, partition, block, [&](const unsigned char *records, size_t size) {
+      for (size_t pos = 0; pos < size; pos += target->record_size) {
+        uint32_t hash;
+        std::memcpy(&hash, records + pos, sizeof(hash));
+        AddRadixRecord(target, (hash << hash_bits) >> (32 - kSpillRadixBits), records + pos);
+      }
+    });
+    std::vector<unsigned char>().swap(side.partitions[partition]);
+  }
+}
+
+void ParallelHashJoiner::JoinRadixPartition(RadixJoinParams *params, std::vector<RadixPartitionParams> &traversed,
+                                            std::vector<RadixPartitionParams> &matched, int partition,
+                                            uint32_t hash_bits) {
+  uint64_t traversed_bytes = RadixPartitionBytes(traversed, partition);
+  if (traversed_bytes == 0) {
+    for (auto &side : matched) std::vector<unsigned char>().swap(side.partitions[partition]);
+    return;
+  }
+
+  if (spill_memory_ > 0 && traversed_bytes > radix_join_memory_ && hash_bits + kSpillRadixBits <= 32) {
+    // Too large to be joined in memory: split both sides by the next bits of the hash.
+    std::vector<RadixPartitionParams> sub_traversed(1);
+    std::vector<RadixPartitionParams> sub_matched(1);
+    for (auto *sub : {&sub_traversed[0], &sub_matched[0]}) {
+      sub->partitions.resize(1 << kSpillRadixBits);
+      sub->memory_limit = radix_join_memory_;
+    }
+    sub_traversed[0].record_size = traversed_record_size_;
+    sub_matched[0].record_size = matched_record_size_;
+    SplitRadixPartition(traversed, partition, hash_bits, &sub_traversed[0]);
+    SplitRadixPartition(matched, partition, hash_bits, &sub_matched[0]);
+
+    for (int sub = 0; sub < (1 << kSpillRadixBits); ++sub) {
+      if (interrupt_matching_ || m_conn->Killed())
+        break;
+      JoinRadixPartition(params, sub_traversed, sub_matched, sub, hash_bits + kSpillRadixBits);
+    }
+    return;
+  }
+
+  MultiIndexBuilder::BuildItem *build_item = params->build_item.get();
+  const size_t key_width = sizeof(uint32_t) + key_buf_width_;  // hash and keys compared together
+  auto &rows = params->rows;
+  auto &buckets = params->buckets;
+  auto &chain = params->chain;
+
+  rows.clear();
+  params->loaded.clear();
+  for (auto &side : traversed) {
+    auto &records = side.partitions[partition];
+    for (size_t pos = 0; pos < records.size(); pos += traversed_record_size_) rows.push_back(records.data() + pos);
+    if (side.spilled)
+      for (size_t index = 0; index < side.spilled->NumOfBlocks(partition); ++index) {
+        auto &block = params->loaded.emplace_back();
+        side.spilled->Get(partition, index, block);
+        for (size_t pos = 0; pos < block.size(); pos += traversed_record_size_) rows.push_back(block.data() + pos);
+      }
+  }
+
+  size_t mask = 1;
+  while (mask < rows.size()) mask <<= 1;
+  mask--;
+  buckets.assign(mask + 1, 0);
+  chain.resize(rows.size());
+  for (size_t row = 0; row < rows.size(); ++row) {
+    uint32_t hash;
+    std::memcpy(&hash, rows[row], sizeof(hash));
+    chain[row] = buckets[hash & mask];
+    buckets[hash & mask] = uint32_t(row + 1);
+  }
+
+  std::vector<unsigned char> block;
+  for (auto &side : matched) {
+    ForEachRadixBlock(side, partition, block, [&](const unsigned char *records, size_t size) {
+      for (size_t pos = 0; pos < size && !interrupt_matching_; pos += matched_record_size_) {
+        const unsigned char *record = records + pos;
+        uint32_t hash;
+        std::memcpy(&hash, record, sizeof(hash));
+        for (uint32_t row = buckets[hash & mask]; row != 0; row = chain[row - 1]) {
+          const unsigned char *traversed_tuple = rows[row - 1];
+          if (std::memcmp(traversed_tuple, record, key_width) != 0)
+            continue;
+          params->joined_tuples++;
+          if (tips.count_only)
+            continue;
+
+          traversed_tuple += key_width;
+          const unsigned char *matched_tuple = record + key_width;
+          for (int index = 0; index < mind->NumOfDimensions(); ++index) {
+            int64_t value;
+            if (matched_dims_[index]) {
+              std::memcpy(&value, matched_tuple, sizeof(value));
+              matched_tuple += sizeof(value);
+              build_item->SetTableValue(index, value);
+            } else if (traversed_dims_[index]) {
+              std::memcpy(&value, traversed_tuple, sizeof(value));
+              traversed_tuple += sizeof(value);
+              build_item->SetTableValue(index, value);
+            }
+          }
+          build_item->CommitTableValues();
+        }
+        if (tips.limit != -1 && tips.limit <= params->joined_tuples)
+          interrupt_matching_ = true;
+      }
+    });
+  }
+
+  // Each partition is joined by one task only, its memory is not needed any more.
+  if (spill_memory_ > 0) {
+    for (auto *sides : {&traversed, &matched})
+      for (auto &side : *sides) std::vector<unsigned char>().swap(side.partitions[partition]);
+    params->loaded.clear();
+  }
+}
+
 // outer part
 
+void ParallelHashJoiner::PrepareRuntimeFilter(int64_t traversed_rows) {
+  runtime_filter_.reset();
+  runtime_filter_ranges_ = false;
+  if (!tianmu_sysvar_join_runtime_filter)
+    return;
+
+  size_t key_width = std::accumulate(hash_table_key_size_.begin(), hash_table_key_size_.end(), size_t(0));
+  runtime_filter_.reset(new JoinKeyFilter(key_width, traversed_rows));
+
+  // Pack min/max map monotonically to the key codes only for the plain integer
+  // encoding, i.e. a single fixed point key of the same scale on both sides.
+  runtime_filter_ranges_ = runtime_filter_->IsExact() && cond_hashed_ == 1 && vc1_[0]->Type().IsFixed() &&
+                           vc2_[0]->Type().IsFixed() && vc1_[0]->Type().GetScale() == vc2_[0]->Type().GetScale() &&
+                           column_bin_encoder_[0].GetSecondarySize() == 0;
+
+  tianmu_control_.lock(m_conn->GetThreadID())
+      << "Runtime filter: " << (runtime_filter_->IsExact() ? "exact" : "bloom") << ", "
+      << runtime_filter_->MemorySize() << " bytes." << system::unlock;
+}
+
+bool ParallelHashJoiner::RuntimeFilterOmitsPack(ColumnBinEncoder &encoder, unsigned char *buf, int64_t pack_min,
+                                                int64_t pack_max) {
+  if (pack_min > pack_max)
+    return false;
+  size_t width = runtime_filter_->KeyWidth();
+  if (!encoder.PutValue64(buf, pack_min, true, false))
+    return false;
+  uint64_t lo = JoinKeyFilter::KeyCode(buf, width);
+  if (!encoder.PutValue64(buf, pack_max, true, false))
+    return false;
+  uint64_t hi = JoinKeyFilter::KeyCode(buf, width);
+  return lo <= hi && !runtime_filter_->MayContainRange(lo, hi);
+}
+
 void ParallelHashJoiner::InitOuter(Condition &cond) {
   DimensionVector outer_dims(cond[0].right_dims);  // outer_dims will be filled with nulls for
                                                    // non-matching tuples
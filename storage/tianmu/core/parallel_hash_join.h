@@ -23,6 +23,8 @@
 #include <vector>
 
 #include "core/hash_table.h"
+#include "core/join_key_filter.h"
+#include "core/spilled_partitions.h"
 #include "index/multi_index_builder.h"
 #include "optimizer/joiner.h"
 #include "vc/column_bin_encoder.h"
@@ -140,6 +142,33 @@ class ParallelHashJoiner : public TwoDimensionalJoiner {
     ~MatchTaskParams();
   };
 
+  struct RadixPartitionParams {
+    MITaskIterator *task_miter = nullptr;
+    bool traversed = false;
+    std::vector<ColumnBinEncoder> column_bin_encoder;
+    // Records <hash><keys><tuple numbers of the side> by the top bits of the hash.
+    std::vector<std::vector<unsigned char>> partitions;
+    size_t record_size = 0;
+    // Over memory_limit bytes the largest partitions go to the spill files, 0 - no limit.
+    size_t memory_limit = 0;
+    size_t buffered = 0;
+    std::shared_ptr<SpilledPartitions> spilled;
+
+    ~RadixPartitionParams();
+  };
+
+  struct RadixJoinParams {
+    std::shared_ptr<MultiIndexBuilder::BuildItem> build_item;
+    int partition_begin = 0;
+    int partition_end = 0;
+    int64_t joined_tuples = 0;
+    // Hash table of the partition being joined, reused for the next ones.
+    std::vector<const unsigned char *> rows;
+    std::vector<uint32_t> buckets;  // 1 + the last row of the bucket, 0 if empty
+    std::vector<uint32_t> chain;    // 1 + the previous row of the same bucket, 0 if none
+    std::vector<std::vector<unsigned char>> loaded;  // spilled traversed records
+  };
+
  public:
   ParallelHashJoiner(MultiIndex *multi_index, TempTable *temp_table, JoinTips &join_tips);
   ~ParallelHashJoiner();
@@ -158,9 +187,38 @@ class ParallelHashJoiner : public TwoDimensionalJoiner {
 
   void ExecuteJoin();
 
+  bool CreateTraversingTasks(MIIterator &mit, int64_t rows_count, std::vector<MITaskIterator *> *task_iterators,
+                             std::string *splitting_type);
   bool CreateMatchingTasks(MIIterator &mit, int64_t rows_count, std::vector<MITaskIterator *> *task_iterators,
                            std::string *splitting_type);
 
+  // Radix-partitioned join, for inner joins on equalities only:
+  // 1. both sides are scanned once and the encoded keys, together with the
+  //    tuple numbers, are scattered into 2^radix_bits_ partitions by the hash,
+  // 2. each partition gets its own hash table, small enough to stay in cache,
+  //    which is built and probed by a single task without any locking.
+  // With tianmu_spill_memory_limit set it is a grace hash join: the partitions
+  // over the limit go to compressed spill files in the cache folder, and a
+  // partition still too large to be joined in memory is split again by the
+  // next bits of the hash. Without a spill limit the join falls back to the
+  // shared table when the partitions would not fit in MaxBufferSize().
+  bool RadixJoinApplicable();
+  int64_t RadixJoin(MIIterator &traversed_mit, MIIterator &match_mit);
+  int64_t AsyncRadixPartition(RadixPartitionParams *params);
+  int64_t AsyncRadixJoin(RadixJoinParams *params);
+  void AddRadixRecord(RadixPartitionParams *params, int partition, const unsigned char *record);
+  void SpillRadixPartitions(RadixPartitionParams *params);
+  void SplitRadixPartition(std::vector<RadixPartitionParams> &sides, int partition, uint32_t hash_bits,
+                           RadixPartitionParams *target);
+  void JoinRadixPartition(RadixJoinParams *params, std::vector<RadixPartitionParams> &traversed,
+                          std::vector<RadixPartitionParams> &matched, int partition, uint32_t hash_bits);
+  template <typename Params>
+  int64_t RunTasks(std::vector<Params> &params, int64_t (ParallelHashJoiner::*task)(Params *));
+
+  // Runtime filter of the traversed keys, see JoinKeyFilter.
+  void PrepareRuntimeFilter(int64_t traversed_rows);
+  bool RuntimeFilterOmitsPack(ColumnBinEncoder &encoder, unsigned char *buf, int64_t pack_min, int64_t pack_max);
+
   void InitOuter(Condition &cond);
   void SubmitJoinedTuple(MultiIndexBuilder::BuildItem *build_item, TraversedHashTable *traversed_hash_table,
                          int64_t hash_row, MIIterator &mit);
@@ -186,6 +244,19 @@ class ParallelHashJoiner : public TwoDimensionalJoiner {
 
   std::vector<TraversedHashTable> traversed_hash_tables_;
 
+  std::unique_ptr<JoinKeyFilter> runtime_filter_;
+  bool runtime_filter_ranges_ = false;  // whole packs may be checked by their min/max codes
+
+  // Radix join part
+  uint32_t radix_bits_ = 0;
+  size_t key_buf_width_ = 0;
+  size_t traversed_record_size_ = 0;
+  size_t matched_record_size_ = 0;
+  std::vector<RadixPartitionParams> *radix_traversed_ = nullptr;
+  std::vector<RadixPartitionParams> *radix_matched_ = nullptr;
+  size_t spill_memory_ = 0;       // memory limit of all the partitions, 0 - no spilling
+  size_t radix_join_memory_ = 0;  // traversed records a join task may load at once
+
   uint32_t pack_power_;  // 2 ^ power
   // dimensions description
   DimensionVector traversed_dims_;          // the mask of dimension numbers of traversed dimensions
@@ -210,6 +281,7 @@ class ParallelHashJoiner : public TwoDimensionalJoiner {
   // Statistics
   std::atomic<int64_t> packrows_omitted_;  // roughly omitted by by matching
   std::atomic<int64_t> packrows_matched_;
+  std::atomic<int64_t> rows_filtered_;  // omitted by the runtime filter before the hash table lookup
 
   std::atomic<int64_t> actually_traversed_rows_;  // "traversed" side rows, which had a chance to
                                                   // be in the
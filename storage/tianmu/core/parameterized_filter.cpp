@@ -19,6 +19,7 @@
 
 #include "core/engine.h"
 #include "core/query.h"
+#include "core/query_profile.h"
 #include "core/temp_table.h"
 #include "core/transaction.h"
 #include "core/value_set.h"
@@ -1589,6 +1590,7 @@ void ParameterizedFilter::ApplyDescriptor(int desc_number, int64_t limit)
       common::RoughSetValue cur_roughval;
       uint64_t passed = 0;
       int pack = -1;
+      int64_t packs_touched = 0, packs_skipped = 0;
 
       while (mit.IsValid()) {
         if (limit != -1 && rf) {  // rf - not null if there is one dim only (otherwise packs make no sense)
@@ -1613,11 +1615,14 @@ void ParameterizedFilter::ApplyDescriptor(int desc_number, int64_t limit)
         if (cur_roughval == common::RoughSetValue::RS_NONE) {
           mit.ResetCurrentPack();
           mit.NextPackrow();
+          packs_skipped++;
         } else if (cur_roughval == common::RoughSetValue::RS_ALL) {
           mit.NextPackrow();
+          packs_skipped++;
         } else {
           // common::RoughSetValue::RS_SOME or common::RoughSetValue::RS_UNKNOWN
           desc.EvaluatePack(mit);
+          packs_touched++;
         }
 
         if (mind_->m_conn->Killed())
@@ -1625,6 +1630,8 @@ void ParameterizedFilter::ApplyDescriptor(int desc_number, int64_t limit)
       }
 
       mit.Commit();
+      QueryProfile::Count(QueryProfile::Counter::PACKS_TOUCHED, packs_touched);
+      QueryProfile::Count(QueryProfile::Counter::PACKS_SKIPPED, packs_skipped);
     }
   }
 
@@ -1650,6 +1657,7 @@ void ParameterizedFilter::TaskProcessPacks(MIUpdatingIterator *taskIterator, Tra
   common::RoughSetValue cur_roughval;
   uint64_t passed = 0;
   int pack = -1;
+  int64_t packs_touched = 0, packs_skipped = 0;
   Descriptor &desc = descriptors_[desc_number];
   current_txn_ = ci;
   common::SetMySQLTHD(ci->Thd());
@@ -1677,14 +1685,19 @@ void ParameterizedFilter::TaskProcessPacks(MIUpdatingIterator *taskIterator, Tra
     if (cur_roughval == common::RoughSetValue::RS_NONE) {
       taskIterator->ResetCurrentPack();
       taskIterator->NextPackrow();
+      packs_skipped++;
     } else if (cur_roughval == common::RoughSetValue::RS_ALL) {
       taskIterator->NextPackrow();
+      packs_skipped++;
     } else {
       desc.EvaluatePack(*taskIterator);
+      packs_touched++;
     }
   }
 
   taskIterator->Commit(false);
+  QueryProfile::Count(QueryProfile::Counter::PACKS_TOUCHED, packs_touched);
+  QueryProfile::Count(QueryProfile::Counter::PACKS_SKIPPED, packs_skipped);
 }
 
 void ParameterizedFilter::FilterDeletedByTable(JustATable *rcTable, int &no_dims, int tableIndex) {
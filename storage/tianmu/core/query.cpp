@@ -21,6 +21,7 @@
 #include "core/engine.h"
 #include "core/mysql_expression.h"
 #include "core/parameterized_filter.h"
+#include "core/query_profile.h"
 #include "core/temp_table.h"
 #include "core/transaction.h"
 #include "core/value_set.h"
@@ -806,10 +807,15 @@ TempTable *Query::Preexecute(CompiledQuery &qu, ResultSender *sender, [[maybe_un
                 : filter->mind_->SetUsedInOutput(i);
           }
 
+          QueryProfile::Scope profile_step("filter/join");
+          if (profile_step.Active() && !filter->mind_->TooManyTuples())
+            profile_step.SetRowsIn(filter->mind_->NumOfTuples());
           if (IsRoughQuery()) {
             filter->RoughUpdateParamFilter();
           } else
             filter->UpdateMultiIndex(qu.CountColumnOnly(step.t1), cur_limit);
+          if (profile_step.Active() && !filter->mind_->TooManyTuples())
+            profile_step.SetRowsOut(filter->mind_->NumOfTuples());
           break;
         }
         case CompiledQuery::StepType::ADD_COLUMN: {
@@ -0,0 +1,113 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include "core/query_profile.h"
+
+#include <time.h>
+#include <cstdio>
+
+#include "core/transaction.h"
+
+namespace Tianmu {
+namespace core {
+
+std::atomic<int> QueryProfile::active_profiles_{0};
+std::mutex QueryProfile::published_mutex_;
+std::vector<QueryProfile::Record> QueryProfile::published_;
+uint64_t QueryProfile::next_query_id_ = 1;
+
+namespace {
+int64_t ThreadCpuNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+}  // namespace
+
+QueryProfile::Scope::Scope(const char *name, int64_t rows_in)
+    : profile_(current_txn_ ? current_txn_->Profile() : nullptr), rows_in_(rows_in) {
+  if (!profile_)
+    return;
+  {
+    std::scoped_lock guard(profile_->steps_mutex_);
+    step_ = profile_->steps_.size();
+    profile_->steps_.emplace_back();
+    profile_->steps_.back().name = name;
+    profile_->steps_.back().depth = profile_->depth_++;
+  }
+  for (int i = 0; i < kNumOfCounters; i++) counters_start_[i] = profile_->counters_[i].load();
+  cpu_start_ns_ = ThreadCpuNs();
+  wall_start_ = std::chrono::steady_clock::now();
+}
+
+QueryProfile::Scope::~Scope() {
+  if (!profile_)
+    return;
+  double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start_).count();
+  double cpu_ms = (ThreadCpuNs() - cpu_start_ns_) / 1000000.0;
+
+  std::scoped_lock guard(profile_->steps_mutex_);
+  profile_->depth_--;
+  Step &step = profile_->steps_[step_];
+  step.wall_ms = wall_ms;
+  step.cpu_ms = cpu_ms;
+  step.rows_in = rows_in_;
+  step.rows_out = rows_out_;
+  for (int i = 0; i < kNumOfCounters; i++) step.counters[i] = profile_->counters_[i].load() - counters_start_[i];
+}
+
+void QueryProfile::CountCurrent(Counter c, int64_t n) {
+  if (current_txn_ == nullptr)
+    return;
+  if (QueryProfile *profile = current_txn_->Profile())
+    profile->Add(c, n);
+}
+
+std::string QueryProfile::FormatStep(const Step &step) const {
+  char buf[512];
+  std::snprintf(buf, sizeof(buf),
+                "%*s%s: wall=%.3fms cpu=%.3fms rows=%lld->%lld packs=%lld skipped=%lld cache=%lld/%lld "
+                "decompressed=%lldB",
+                step.depth * 2, "", step.name.c_str(), step.wall_ms, step.cpu_ms,
+                static_cast<long long>(step.rows_in), static_cast<long long>(step.rows_out),
+                static_cast<long long>(step.counters[static_cast<int>(Counter::PACKS_TOUCHED)]),
+                static_cast<long long>(step.counters[static_cast<int>(Counter::PACKS_SKIPPED)]),
+                static_cast<long long>(step.counters[static_cast<int>(Counter::CACHE_HITS)]),
+                static_cast<long long>(step.counters[static_cast<int>(Counter::CACHE_MISSES)]),
+                static_cast<long long>(step.counters[static_cast<int>(Counter::BYTES_DECOMPRESSED)]));
+  return buf;
+}
+
+void QueryProfile::Report(THD *thd, uint64_t conn_id, const std::string &query) {
+  std::scoped_lock guard(steps_mutex_);
+  for (auto &step : steps_)
+    push_warning(thd, Sql_condition::SL_NOTE, ER_UNKNOWN_ERROR, ("Tianmu profile: " + FormatStep(step)).c_str());
+
+  std::scoped_lock published_guard(published_mutex_);
+  if (published_.size() == kKeptQueries)
+    published_.erase(published_.begin());
+  const char *user = thd->security_context()->user().str;
+  published_.push_back(Record{next_query_id_++, conn_id, user ? user : "", query, steps_});
+}
+
+std::vector<QueryProfile::Record> QueryProfile::Published() {
+  std::scoped_lock guard(published_mutex_);
+  return published_;
+}
+
+}  // namespace core
+}  // namespace Tianmu
@@ -0,0 +1,117 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_CORE_QUERY_PROFILE_H_
+#define TIANMU_CORE_QUERY_PROFILE_H_
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class THD;
+
+namespace Tianmu {
+namespace core {
+
+// Operator-level profile of one query, collected when tianmu_query_profile is set for the session.
+// Steps nest, the numbers of a step include those of the steps opened inside it.
+class QueryProfile final {
+ public:
+  enum class Counter { PACKS_TOUCHED, PACKS_SKIPPED, CACHE_HITS, CACHE_MISSES, BYTES_DECOMPRESSED };
+  static constexpr int kNumOfCounters = static_cast<int>(Counter::BYTES_DECOMPRESSED) + 1;
+  // INFORMATION_SCHEMA.TIANMU_QUERY_PROFILE keeps the profiles of that many last queries
+  static constexpr size_t kKeptQueries = 64;
+
+  struct Step {
+    std::string name;
+    int depth = 0;
+    double wall_ms = 0;
+    double cpu_ms = 0;  // of the thread running the step, work of parallel tasks is not included
+    int64_t rows_in = -1;
+    int64_t rows_out = -1;
+    int64_t counters[kNumOfCounters] = {};
+  };
+
+  struct Record {
+    uint64_t query_id;
+    uint64_t conn_id;
+    std::string user;  // of the connection, to show the record only to it unless one has PROCESS
+    std::string query;
+    std::vector<Step> steps;
+  };
+
+  // A step of the profile of the current transaction, no-op if the query is not profiled.
+  class Scope final {
+   public:
+    Scope(const char *name, int64_t rows_in = -1);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+    bool Active() const { return profile_ != nullptr; }
+    void SetRowsIn(int64_t rows) { rows_in_ = rows; }
+    void SetRowsOut(int64_t rows) { rows_out_ = rows; }
+
+   private:
+    QueryProfile *profile_;
+    size_t step_ = 0;
+    int64_t rows_in_;
+    int64_t rows_out_ = -1;
+    std::chrono::steady_clock::time_point wall_start_;
+    int64_t cpu_start_ns_ = 0;
+    int64_t counters_start_[kNumOfCounters] = {};
+  };
+
+  QueryProfile() { active_profiles_++; }
+  ~QueryProfile() { active_profiles_--; }
+  QueryProfile(const QueryProfile &) = delete;
+  QueryProfile &operator=(const QueryProfile &) = delete;
+
+  // Adds to the profile of the query run by current_txn_, if there is one.
+  static void Count(Counter c, int64_t n = 1) {
+    if (active_profiles_.load(std::memory_order_relaxed) > 0)
+      CountCurrent(c, n);
+  }
+  void Add(Counter c, int64_t n) { counters_[static_cast<int>(c)].fetch_add(n, std::memory_order_relaxed); }
+
+  const std::vector<Step> &Steps() const { return steps_; }
+  std::string FormatStep(const Step &step) const;
+
+  // Keeps the profile for INFORMATION_SCHEMA and attaches it to the statement as notes.
+  void Report(THD *thd, uint64_t conn_id, const std::string &query);
+  static std::vector<Record> Published();
+
+ private:
+  static void CountCurrent(Counter c, int64_t n);
+
+  static std::atomic<int> active_profiles_;
+  static std::mutex published_mutex_;
+  static std::vector<Record> published_;
+  static uint64_t next_query_id_;
+
+  std::atomic<int64_t> counters_[kNumOfCounters] = {};
+  std::mutex steps_mutex_;
+  std::vector<Step> steps_;
+  int depth_ = 0;
+};
+
+}  // namespace core
+}  // namespace Tianmu
+
+#endif  // TIANMU_CORE_QUERY_PROFILE_H_
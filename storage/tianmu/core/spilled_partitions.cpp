@@ -0,0 +1,139 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include "spilled_partitions.h"
+
+#include <algorithm>
+
+#include "common/assert.h"
+#include "common/exception.h"
+#include "core/engine.h"
+#include "lz4.h"
+
+namespace Tianmu {
+namespace core {
+namespace {
+// Records are compressed and written in blocks of at most this size.
+const size_t kMaxBlockBytes = 16 * 1024 * 1024;
+// Compressed blocks waiting for the writer before Put() waits too.
+const size_t kMaxPendingBlocks = 4;
+}  // namespace
+
+SpilledPartitions::SpilledPartitions(int partitions, size_t record_size)
+    : system::CacheableItem("JW", "SPL"), record_size_(record_size), blocks_(partitions), bytes_(partitions, 0) {}
+
+SpilledPartitions::~SpilledPartitions() {
+  // the write task drops the blocks still pending, the partitions are not needed any more
+  std::unique_lock<std::mutex> lock(mtx_);
+  stop_ = true;
+  cv_.wait(lock, [this] { return !writing_; });
+}
+
+void SpilledPartitions::Put(int partition, std::vector<unsigned char> &records) {
+  const size_t piece = std::max(kMaxBlockBytes / record_size_, size_t(1)) * record_size_;
+  for (size_t pos = 0; pos < records.size(); pos += piece) {
+    int size = int(std::min(piece, records.size() - pos));
+    std::vector<char> data(LZ4_compressBound(size));
+    int compressed_size = LZ4_compress_default(reinterpret_cast<const char *>(records.data() + pos), data.data(), size,
+                                               int(data.size()));
+    if (compressed_size <= 0)
+      throw common::Exception("Failed to compress a spilled partition.");
+    data.resize(compressed_size);
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] { return pending_.size() < kMaxPendingBlocks || !error_.empty(); });
+    if (!error_.empty())
+      throw common::OutOfMemoryException(error_);
+    blocks_[partition].push_back({no_blocks_, size_t(size), compressed_size});
+    bytes_[partition] += size;
+    disk_bytes_ += compressed_size;
+    pending_.emplace_back(no_blocks_++, std::move(data));
+    bool start = !writing_;
+    writing_ = true;
+    lock.unlock();
+    if (start)
+      StartWriter();
+  }
+  std::vector<unsigned char>().swap(records);
+}
+
+void SpilledPartitions::Get(int partition, size_t index, std::vector<unsigned char> &records) {
+  WaitForWrites();
+
+  const Block &block = blocks_[partition][index];
+  std::vector<char> data(block.compressed_size);
+  {
+    std::scoped_lock guard(io_mtx_);
+    if (CI_Get(block.id, reinterpret_cast<unsigned char *>(data.data())) != 0)
+      throw common::Exception("Failed to read a spilled partition.");
+  }
+  records.resize(block.size);
+  if (LZ4_decompress_safe(data.data(), reinterpret_cast<char *>(records.data()), block.compressed_size,
+                          int(block.size)) != int(block.size))
+    throw common::Exception("Failed to decompress a spilled partition.");
+}
+
+void SpilledPartitions::StartWriter() {
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  assert(eng);
+  if (!eng->bg_load_thread_pool.is_owner()) {
+    try {
+      eng->bg_load_thread_pool.add_task(&SpilledPartitions::WritePending, this);
+      return;
+    } catch (std::exception &e) {
+      TIANMU_LOG(LogCtl_Level::WARN, "Spilled partitions written in the query thread: %s", e.what());
+    }
+  }
+  WritePending();  // a task of the pool can not wait for another one
+}
+
+void SpilledPartitions::WritePending() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (!pending_.empty() && !stop_) {
+    auto block = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+
+    std::string error;
+    try {
+      std::scoped_lock guard(io_mtx_);
+      CI_Put(block.first, reinterpret_cast<unsigned char *>(block.second.data()), int(block.second.size()));
+    } catch (std::exception &e) {
+      error = e.what();
+      if (error.empty())
+        error = "Failed to write a spilled partition.";
+    }
+
+    lock.lock();
+    if (!error.empty()) {
+      error_ = error;
+      pending_.clear();
+    }
+    cv_.notify_all();
+  }
+  writing_ = false;
+  cv_.notify_all();
+}
+
+void SpilledPartitions::WaitForWrites() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_.wait(lock, [this] { return (pending_.empty() && !writing_) || !error_.empty(); });
+  if (!error_.empty())
+    throw common::OutOfMemoryException(error_);
+}
+}  // namespace core
+}  // namespace Tianmu
@@ -0,0 +1,83 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_CORE_SPILLED_PARTITIONS_H_
+#define TIANMU_CORE_SPILLED_PARTITIONS_H_
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "system/cacheable_item.h"
+
+namespace Tianmu {
+namespace core {
+// Records of hash partitions which do not fit in memory, kept in temporary
+// files of the cache folder. Blocks are LZ4-compressed by the caller and
+// written by a task of the engine's background load pool while the caller goes
+// on partitioning.
+// Put() is called by one thread at a time, Get() may be called concurrently.
+class SpilledPartitions : private system::CacheableItem {
+ public:
+  SpilledPartitions(int partitions, size_t record_size);
+  SpilledPartitions(const SpilledPartitions &) = delete;
+  SpilledPartitions &operator=(const SpilledPartitions &) = delete;
+  ~SpilledPartitions();
+
+  // Queues the records of the partition for writing; the vector is left empty
+  // with its memory released.
+  void Put(int partition, std::vector<unsigned char> &records);
+  size_t NumOfBlocks(int partition) const { return blocks_[partition].size(); }
+  // Replaces the contents of records with the index-th block of the partition.
+  void Get(int partition, size_t index, std::vector<unsigned char> &records);
+
+  uint64_t Bytes(int partition) const { return bytes_[partition]; }  // uncompressed
+  uint64_t DiskBytes() const { return disk_bytes_; }
+
+ private:
+  struct Block {
+    int id;
+    size_t size;
+    int compressed_size;
+  };
+
+  void StartWriter();
+  void WritePending();
+  void WaitForWrites();
+
+  size_t record_size_;
+  std::vector<std::vector<Block>> blocks_;
+  std::vector<uint64_t> bytes_;
+  int no_blocks_ = 0;
+  uint64_t disk_bytes_ = 0;
+
+  std::mutex io_mtx_;  // guards the file handle of CacheableItem
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::deque<std::pair<int, std::vector<char>>> pending_;  // block id and compressed data
+  bool writing_ = false;  // a write task is queued or running
+  bool stop_ = false;
+  std::string error_;
+};
+}  // namespace core
+}  // namespace Tianmu
+
+#endif  // TIANMU_CORE_SPILLED_PARTITIONS_H_
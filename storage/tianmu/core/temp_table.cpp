@@ -22,6 +22,7 @@
 #include "core/mysql_expression.h"
 #include "core/parameterized_filter.h"
 #include "core/query.h"
+#include "core/query_profile.h"
 #include "core/temp_table.h"
 #include "core/transaction.h"
 #include "core/value_set.h"
@@ -691,6 +692,53 @@ int64_t TempTable::Attr::GetValueInt64(int64_t obj) const {
   return res;
 }
 
+namespace {
+template <class T>
+void CopyValues(AttrBuffer<T> &buf, T null_value, int64_t obj, size_t count, int64_t *values) {
+  for (size_t i = 0; i < count; i++) {
+    T v = buf[obj + i];
+    values[i] = (v == null_value ? common::NULL_VALUE_64 : int64_t(v));
+  }
+}
+}  // namespace
+
+void TempTable::Attr::GetValuesInt64(int64_t obj, size_t count, int64_t *values) const {
+  switch (TypeName()) {
+    case common::ColumnType::BIGINT:
+    case common::ColumnType::NUM:
+    case common::ColumnType::YEAR:
+    case common::ColumnType::TIME:
+    case common::ColumnType::DATE:
+    case common::ColumnType::DATETIME:
+    case common::ColumnType::TIMESTAMP:
+    case common::ColumnType::BIT:
+      CopyValues(*(AttrBuffer<int64_t> *)buffer, common::NULL_VALUE_64, obj, count, values);
+      break;
+    case common::ColumnType::INT:
+    case common::ColumnType::MEDIUMINT:
+      CopyValues(*(AttrBuffer<int> *)buffer, common::NULL_VALUE_32, obj, count, values);
+      break;
+    case common::ColumnType::SMALLINT:
+      CopyValues(*(AttrBuffer<short> *)buffer, common::NULL_VALUE_SH, obj, count, values);
+      break;
+    case common::ColumnType::BYTEINT:
+      CopyValues(*(AttrBuffer<char> *)buffer, common::NULL_VALUE_C, obj, count, values);
+      break;
+    case common::ColumnType::REAL:
+    case common::ColumnType::FLOAT: {
+      auto &buf = *(AttrBuffer<double> *)buffer;
+      for (size_t i = 0; i < count; i++) {
+        common::double_int_t v(buf[obj + i]);
+        values[i] = v.i;
+      }
+      break;
+    }
+    default:
+      DEBUG_ASSERT(0);
+      break;
+  }
+}
+
 int64_t TempTable::Attr::GetNotNullValueInt64(int64_t obj) const {
   int64_t res = common::NULL_VALUE_64;
   switch (TypeName()) {
@@ -2110,14 +2158,21 @@ void TempTable::Materialize(bool in_subq, ResultSender *sender, bool lazy) {
     CalculatePageSize();  // recalculate, as no_obj might changed
     // perform order by: in this case it can be done on source tables, not on  the result
     bool materialized_by_ordering = false;
-    if (CanOrderSources())  // false if no sorting used
-      materialized_by_ordering = this->OrderByAndMaterialize(order_by, local_limit, local_offset, sender);
+    if (CanOrderSources()) {  // false if no sorting used
+      QueryProfile::Scope profile_step("order by", no_obj);
+      int64_t sorted_rows = 0;
+      materialized_by_ordering =
+          this->OrderByAndMaterialize(order_by, local_limit, local_offset, sender, &sorted_rows);
+      profile_step.SetRowsOut(sorted_rows);
+    }
 
     if (!materialized_by_ordering) {  // not materialized yet?
+      QueryProfile::Scope profile_step("materialize", no_obj);
       // materialize without aggregations. If ordering then do not send result
       // or in case of order by we need to materialize all rows to be next ordered
       (order_by.size() == 0) ? FillMaterializedBuffers(local_limit, local_offset, sender, lazy)
                              : FillMaterializedBuffers(no_obj, 0, nullptr, lazy);
+      profile_step.SetRowsOut(no_materialized);
     }
   } else {
     // GROUP BY or DISTINCT -  compute aggregations
@@ -2132,8 +2187,12 @@ void TempTable::Materialize(bool in_subq, ResultSender *sender, bool lazy) {
       having_conds[0].tree->Simplify(true);
 
     ResultSender *local_sender = (distinct_on_materialized || order_by.size() > 0 ? nullptr : sender);
+    QueryProfile::Scope profile_step("aggregate");
+    if (profile_step.Active() && !filter.mind_->TooManyTuples())
+      profile_step.SetRowsIn(filter.mind_->NumOfTuples());
     AggregationAlgorithm aggr(this);
     aggr.Aggregate(table_distinct, local_limit, local_offset, local_sender);  // this->tree (HAVING) used inside
+    profile_step.SetRowsOut(no_obj);
 
     if (no_obj == 0) {
       order_by.clear();
@@ -2168,8 +2227,10 @@ void TempTable::Materialize(bool in_subq, ResultSender *sender, bool lazy) {
     std::shared_ptr<TempTable> temporary_source_table = CreateMaterializedCopy(false, in_subq);
     ResultSender *local_sender = (order_by.size() > 0 ? nullptr : sender);
 
+    QueryProfile::Scope profile_step("distinct", no_obj);
     AggregationAlgorithm aggr(this);
     aggr.Aggregate(true, local_limit, local_offset, local_sender);  // true => select-level distinct
+    profile_step.SetRowsOut(no_obj);
     DeleteMaterializedCopy(temporary_source_table);
     output_mind.Clear();
     output_mind.AddDimension_cross(no_obj);  // an artificial dimension for result
@@ -2191,10 +2252,13 @@ void TempTable::Materialize(bool in_subq, ResultSender *sender, bool lazy) {
       local_limit = no_obj;
 
     if (no_obj > 1 && !exists_only) {
+      QueryProfile::Scope profile_step("order by", no_obj);
       // true: translate definition of ordering
       std::shared_ptr<TempTable> temporary_source_table = CreateMaterializedCopy(true, in_subq);
-      OrderByAndMaterialize(order_by, local_limit, local_offset, sender);
+      int64_t sorted_rows = 0;
+      OrderByAndMaterialize(order_by, local_limit, local_offset, sender, &sorted_rows);
       DeleteMaterializedCopy(temporary_source_table);
+      profile_step.SetRowsOut(sorted_rows);
     }
 
     order_by.clear();
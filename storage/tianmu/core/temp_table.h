@@ -139,6 +139,8 @@ class TempTable : public JustATable {
     void SetPlusInf(int64_t obj);
     int64_t GetValueInt64(int64_t obj) const override;
     int64_t GetNotNullValueInt64(int64_t obj) const override;
+    // GetValueInt64() of rows [obj, obj + count), for the integer and real types only
+    void GetValuesInt64(int64_t obj, size_t count, int64_t *values) const;
     void SetValueInt64(int64_t obj, int64_t val);
     void InvalidateRow(int64_t obj);
     int64_t GetMinInt64(int pack) override;
@@ -220,7 +222,8 @@ class TempTable : public JustATable {
   // Maintenance and low-level functions
 
   bool OrderByAndMaterialize(std::vector<SortDescriptor> &ord, int64_t limit, int64_t offset,
-                             ResultSender *sender = nullptr);  // Sort data contained in
+                             ResultSender *sender = nullptr,
+                             int64_t *rows_out = nullptr);  // Sort data contained in
                                                                // ParameterizedFilter by using some
                                                                // attributes (usually specified by
                                                                // AddOrder, but in general -
@@ -41,14 +41,16 @@ namespace Tianmu {
 namespace core {
 
 bool TempTable::OrderByAndMaterialize(
-    std::vector<SortDescriptor> &ord, int64_t limit, int64_t offset,
-    ResultSender *sender)  // Sort MultiIndex using some (existing) attributes in some tables
+    std::vector<SortDescriptor> &ord, int64_t limit, int64_t offset, ResultSender *sender,
+    int64_t *rows_out)  // Sort MultiIndex using some (existing) attributes in some tables, rows_out: rows produced
 {
   // "limit=10; offset=20" means that the first 10 positions of sorted table will contain objects 21...30.
   MEASURE_FET("TempTable::OrderBy(...)");
   thd_proc_info(m_conn->Thd(), "order by");
   DEBUG_ASSERT(limit >= 0 && offset >= 0);
   no_obj = limit;
+  if (rows_out)
+    *rows_out = 0;
   if ((int)ord.size() == 0 || filter.mind_->NumOfTuples() < 2 || limit == 0) {
     ord.clear();
     return false;
@@ -300,6 +302,8 @@ bool TempTable::OrderByAndMaterialize(
     }
   } while (valid && global_row < limit + offset);
   tianmu_control_.lock(m_conn->GetThreadID()) << "Sorted end, rows retrieved." << system::unlock;
+  if (rows_out)
+    *rows_out = produced_rows;
 
   // TIANMU_LOG(LogCtl_Level::INFO, "OrderByAndMaterialize complete global_row %d, limit %d,
   // offset %d", global_row, limit, offset);
@@ -180,6 +180,12 @@ class DelayedInsertParser final {
                       uint packsize, std::shared_ptr<index::TianmuTableIndex> index, core::Transaction *tx)
       : pack_size(packsize), attrs(attrs), vec(vec), index_table(index), tx(tx) {}
 
+  // null records in 'vec' are the rows of 'row_ids' held by 'segment'
+  void SetSegment(const DeltaSegment *delta_segment, const std::vector<uint64_t> *ids) {
+    segment = delta_segment;
+    row_ids = ids;
+  }
+
   uint GetRows(uint no_of_rows, std::vector<loader::ValueCache> &value_buffers) {
     int64_t start_row = attrs[0]->NumOfObj();
 
@@ -194,6 +200,18 @@ class DelayedInsertParser final {
         // no more to parse
         return no_of_rows_returned;
       }
+      if (!(*vec)[processed]) {
+        // copy the longest run of consecutive segment rows column by column
+        uint64_t first = (*row_ids)[processed];
+        uint run = 1;
+        while (no_of_rows_returned + run < no_of_rows && processed + run < vec->size() && !(*vec)[processed + run] &&
+               (*row_ids)[processed + run] == first + run && first + run < segment->BlockEnd(first))
+          run++;
+        for (uint i = 0; i < attrs.size(); i++) segment->CopyTo(first, run, i, value_buffers[i]);
+        processed += run;
+        no_of_rows_returned += run - 1;
+        continue;
+      }
       auto ptr = const_cast<const char *>((*vec)[processed].get());
       DeltaRecordHeadForInsert rec_head;
       ptr = rec_head.recordDecode(ptr);
@@ -262,6 +280,8 @@ class DelayedInsertParser final {
   std::vector<std::unique_ptr<char[]>> *vec;
   std::shared_ptr<index::TianmuTableIndex> index_table;
   core::Transaction *tx;
+  const DeltaSegment *segment = nullptr;
+  const std::vector<uint64_t> *row_ids = nullptr;
 };
 
 class DelayedUpdateParser final {
@@ -532,6 +552,12 @@ void TianmuTable::UnlockPackFromUse(unsigned attr, unsigned pack_no) {
   m_attrs[attr]->UnlockPackFromUse(pack_no);
 }
 
+void TianmuTable::PrefetchPack(unsigned attr, unsigned pack_no) {
+  if (pack_no == 0xFFFFFFFF)
+    return;
+  m_attrs[attr]->PrefetchPack(pack_no);
+}
+
 int TianmuTable::GetID() const { return share->TabID(); }
 
 std::vector<AttrInfo> TianmuTable::GetAttributesInfo() {
@@ -640,8 +666,9 @@ void TianmuTable::CommitVersion() {
     fs::create_symlink(v, m_path / common::TABLE_VERSION_FILE_TMP);
   }
 
-  // flush data with disk device
+  // flush data with disk device, together with concurrent commits
   if (tianmu_sysvar_sync_buffers) {
+    std::vector<std::string> files;
     for (auto &col : changed_columns) {
       fs::path dir = m_path / common::COLUMN_DIR / std::to_string(col);
 
@@ -654,14 +681,13 @@ void TianmuTable::CommitVersion() {
       }
 
       for (auto &it : fs::directory_iterator(dir)) {
-        if (fs::is_regular_file(it.path())) {
-          system::TianmuFile fb;
-          fb.OpenReadOnly(it.path().string());
-          fb.Flush();
-        }
+        if (fs::is_regular_file(it.path()))
+          files.emplace_back(it.path().string());
       }
+      files.emplace_back((dir / common::COL_VERSION_DIR / m_tx->GetID().ToString()).string());
     }
-    fv.Flush();
+    files.emplace_back((m_path / v).string());
+    system::FlushFilesGrouped(files);
     system::FlushDirectoryChanges(m_path);
   }
 
@@ -1601,6 +1627,12 @@ uint64_t TianmuTable::MergeDeltaTable(system::IOParameters &iop) {
   struct timespec t1, t2;
   clock_gettime(CLOCK_REALTIME, &t1);
   std::vector<std::unique_ptr<char[]>> insert_records;
+  std::vector<uint64_t> insert_row_ids;
+  auto segment = m_delta->Segment();
+  // LOOKUP columns are dictionary encoded by the row parser, the segment only keeps their strings
+  bool from_segment = segment && std::none_of(m_attrs.begin(), m_attrs.end(),
+                                              [](const auto &attr) { return attr->Type().Lookup(); });
+  uint64_t merged_end = 0;
   int insert_num = 0;
   std::map<uint64_t, std::unique_ptr<char[]>> update_records;
   int update_num = 0;
@@ -1636,14 +1668,19 @@ uint64_t TianmuTable::MergeDeltaTable(system::IOParameters &iop) {
       uint64_t row_id = index::be_to_uint64(reinterpret_cast<const uchar *>(key.data()) + sizeof(uint32_t));
       auto value = iter->value();
 
-      std::unique_ptr<char[]> buf(new char[value.size()]);
-      std::memcpy(buf.get(), value.data(), value.size());
+      auto type = *reinterpret_cast<const RecordType *>(value.data());
+      auto load_num = *reinterpret_cast<const uint32_t *>(value.data() + sizeof(RecordType));
 
-      auto type = *reinterpret_cast<RecordType *>(buf.get());
-      auto load_num = *reinterpret_cast<uint32_t *>(buf.get() + sizeof(RecordType));
+      std::unique_ptr<char[]> buf;
+      if (type != RecordType::kInsert || !from_segment || !segment->Contains(row_id)) {
+        buf.reset(new char[value.size()]);
+        std::memcpy(buf.get(), value.data(), value.size());
+      }
 
       if (type == RecordType::kInsert) {
+        // a null record is taken from the delta segment without decoding
         insert_records.emplace_back(std::move(buf));
+        insert_row_ids.emplace_back(row_id);
       } else if (type == RecordType::kUpdate) {
         update_records.emplace(row_id, std::move(buf));
       } else if (type == RecordType::kDelete) {
@@ -1658,6 +1695,7 @@ uint64_t TianmuTable::MergeDeltaTable(system::IOParameters &iop) {
       total_load_num += load_num;
       total_read_cnt++;
       total_read_bytes += value.size();
+      merged_end = row_id + 1;
 
       iter->Next();
     }
@@ -1666,7 +1704,7 @@ uint64_t TianmuTable::MergeDeltaTable(system::IOParameters &iop) {
   clock_gettime(CLOCK_REALTIME, &t2);
 
   if (!insert_records.empty()) {
-    insert_num += AsyncParseInsertRecords(&iop, &insert_records);
+    insert_num += AsyncParseInsertRecords(&iop, &insert_records, &insert_row_ids);
   }
 
   if (!update_records.empty()) {
@@ -1683,6 +1721,8 @@ uint64_t TianmuTable::MergeDeltaTable(system::IOParameters &iop) {
     eng->getStore()->GetRdb()->CompactRange(rocksdb::CompactRangeOptions(), m_delta->GetCFHandle(), nullptr, nullptr);
   }
 
+  if (segment)
+    segment->Release(merged_end);
   m_delta->merge_id.fetch_add(total_load_num);
   m_delta->stat.read_cnt += total_read_cnt;
   m_delta->stat.read_bytes += total_read_bytes;
@@ -1690,7 +1730,8 @@ uint64_t TianmuTable::MergeDeltaTable(system::IOParameters &iop) {
   return insert_num + update_num + delete_num;
 }
 
-int TianmuTable::AsyncParseInsertRecords(system::IOParameters *iop, std::vector<std::unique_ptr<char[]>> *insert_vec) {
+int TianmuTable::AsyncParseInsertRecords(system::IOParameters *iop, std::vector<std::unique_ptr<char[]>> *insert_vec,
+                                         const std::vector<uint64_t> *row_ids) {
   struct timespec t1, t2;
   clock_gettime(CLOCK_REALTIME, &t1);
 
@@ -1699,6 +1740,7 @@ int TianmuTable::AsyncParseInsertRecords(system::IOParameters *iop, std::vector<
 
   auto index_table = eng->GetTableIndex(share->Path());
   DelayedInsertParser parser(m_attrs, insert_vec, share->PackSize(), index_table, m_tx);
+  parser.SetSegment(m_delta->Segment(), row_ids);
   uint64_t loaded_row_num = 0;
 
   uint to_prepare, no_of_rows_returned;
@@ -81,6 +81,7 @@ class TianmuTable final : public JustATable {
   void UnlockPackInfoFromUse();  // return attribute data to memory manager
   void LockPackForUse(unsigned attr, unsigned pack_no) override;
   void UnlockPackFromUse(unsigned attr, unsigned pack_no) override;
+  void PrefetchPack(unsigned attr, unsigned pack_no) override;
 
   int GetID() const;
   TType TableType() const override { return TType::TABLE; }
@@ -147,7 +148,8 @@ class TianmuTable final : public JustATable {
   // delta backend
   void LoadDataInfile(system::IOParameters &iop);
   uint64_t MergeDeltaTable(system::IOParameters &iop);
-  int AsyncParseInsertRecords(system::IOParameters *iop, std::vector<std::unique_ptr<char[]>> *insert_vec);
+  int AsyncParseInsertRecords(system::IOParameters *iop, std::vector<std::unique_ptr<char[]>> *insert_vec,
+                              const std::vector<uint64_t> *row_ids);
   int AsyncParseUpdateRecords(system::IOParameters *iop, std::map<uint64_t, std::unique_ptr<char[]>> *update_records);
   int AsyncParseDeleteRecords(std::vector<uint64_t> &delete_records);
 
@@ -84,6 +84,7 @@ void Transaction::Commit([[maybe_unused]] THD *thd) {
 
   modified_tables_.clear();
   kv_trans_.Commit();
+  RunEndActions(true);
 }
 
 void Transaction::Rollback([[maybe_unused]] THD *thd, bool force_error_message) {
@@ -104,6 +105,20 @@ void Transaction::Rollback([[maybe_unused]] THD *thd, bool force_error_message)
   }
   modified_tables_.clear();
   kv_trans_.Rollback();
+  RunEndActions(false);
+}
+
+void Transaction::CommitKVBatch() {
+  kv_trans_.Commit();
+  kv_trans_.ResetWriteBatch();
+  kv_trans_.Acquiresnapshot();
+  RunEndActions(true);
+}
+
+void Transaction::RunEndActions(bool committed) {
+  auto actions = std::move(end_actions_);
+  end_actions_.clear();
+  for (auto &action : actions) action(committed);
 }
 
 ulong Transaction::GetThreadID() const { return pthread_self(); }
@@ -18,10 +18,13 @@
 #define TIANMU_CORE_TRANSACTION_H_
 #pragma once
 
+#include <functional>
 #include <unordered_map>
+#include <vector>
 
 #include "common/sequence_generator.h"
 #include "core/engine.h"
+#include "core/query_profile.h"
 #include "index/kv_store.h"
 #include "index/kv_transaction.h"
 namespace Tianmu {
@@ -44,10 +47,15 @@ class Transaction final {
   int session_trace_ = 0;
   int debug_level_ = 0;
   std::string explain_msg_;
+  std::unique_ptr<QueryProfile> profile_;  // set while a profiled query runs
   index::KVTransaction kv_trans_;
   common::LoadSource load_source_;
 
   uint32_t insert_row_num_ = 0;
+  // run in order when the transaction ends, with true if it committed
+  std::vector<std::function<void(bool)>> end_actions_;
+
+  void RunEndActions(bool committed);
 
  public:
   ulong GetThreadID() const;
@@ -64,11 +72,14 @@ class Transaction final {
   bool Explain() { return (thd ? thd->lex->describe : false); }
   std::string GetExplainMsg() { return explain_msg_; }
   void SetExplainMsg(const std::string &msg) { explain_msg_ = msg; }
+  QueryProfile *Profile() const { return profile_.get(); }
+  void StartProfile() { profile_ = std::make_unique<QueryProfile>(); }
+  std::unique_ptr<QueryProfile> TakeProfile() { return std::move(profile_); }
   bool explicit_lock_tables_ = false;
 
   Transaction(THD *thd) : txn_id_(seq_generator_.NextID()), thd(thd) {}
   Transaction() = delete;
-  ~Transaction() = default;
+  ~Transaction() { RunEndActions(false); }
 
   common::TX_ID GetID() const { return txn_id_; }
   common::LoadSource LoadSource() const { return load_source_; }
@@ -90,6 +101,10 @@ class Transaction final {
   uint32_t &GetInsertRowNum() { return insert_row_num_; }
   void AddInsertRowNum(uint32_t row_num = 1) { insert_row_num_ += row_num; }
   void ResetInsertRowNum() { insert_row_num_ = 0; }
+  void AddEndAction(std::function<void(bool)> action) { end_actions_.push_back(std::move(action)); }
+  // Commits the RocksDB writes of a large statement so far, they are final from now on and so
+  // are their end actions, which run before anything else can see the writes merged.
+  void CommitKVBatch();
 };
 }  // namespace core
 }  // namespace Tianmu
@@ -100,6 +100,8 @@ class Pack : public mm::TraceableObject {
     }
   }
   PackCoordinate GetPackCoordinate() const { return m_coord.co.pack; }
+  // size on disk of a pack that had to be decompressed when loaded, 0 otherwise
+  size_t CompressedBytes() const { return IsModeNoCompression() ? 0 : dpn_->dataLength; }
   void SetDPN(DPN *new_dpn) { dpn_ = new_dpn; }
 
  protected:
@@ -20,6 +20,7 @@
 #include "pack_guardian.h"
 
 #include "core/just_a_table.h"
+#include "system/configuration.h"
 #include "optimizer/iterators/mi_iterator.h"
 #include "vc/virtual_column.h"
 
@@ -55,6 +56,21 @@ void VCPackGuardian::ResizeLastPack(int taskNum) {
   guardian_threads_ = taskNum;
 }
 
+// Ask the table to read ahead the packs the iterator is going to visit after
+// the one just locked. The pack order is known from the iterator (including
+// the PackOrderer order), so the loads overlap with processing of this pack.
+void VCPackGuardian::PrefetchAhead(JustATable *tab, int col_index, int cur_dim, int cur_pack, const MIIterator &mit) {
+  if (tianmu_sysvar_prefetch_depth == 0 || !mit.IsValid() || !mit.DimUsed(cur_dim))
+    return;
+
+  for (uint ahead = 1; ahead <= tianmu_sysvar_prefetch_depth; ++ahead) {
+    int next_pack = mit.GetNextPackrow(cur_dim, ahead);
+    if (next_pack < 0 || next_pack == cur_pack)
+      break;
+    tab->PrefetchPack(col_index, next_pack);
+  }
+}
+
 void VCPackGuardian::LockPackrow(const MIIterator &mit) {
   switch (current_strategy_) {
     case GUARDIAN_LOCK_STRATEGY::LOCK_ONE:
@@ -119,6 +135,7 @@ void VCPackGuardian::LockPackrowOnLockOneByThread(const MIIterator &mit) {
 
     try {
       tab->LockPackForUse(col_index, cur_pack);
+      PrefetchAhead(tab, col_index, cur_dim, cur_pack, mit);
     } catch (...) {
       TIANMU_LOG(LogCtl_Level::ERROR,
                  "LockPackrowOnLockOneByThread LockPackForUse fail, cur_dim: %d col_index: %d cur_pack: %d", cur_dim,
@@ -212,6 +229,7 @@ void VCPackGuardian::LockPackrowOnLockOne(const MIIterator &mit) {
         tab->UnlockPackFromUse(iter->col_ndx, last_pack_[cur_dim][threadId]);
       try {
         tab->LockPackForUse(iter->col_ndx, mit.GetCurPackrow(cur_dim));
+        PrefetchAhead(tab, iter->col_ndx, cur_dim, mit.GetCurPackrow(cur_dim), mit);
       } catch (...) {
         TIANMU_LOG(LogCtl_Level::ERROR,
                    "LockPackrowOnLockOne LockPackForUse fail, cur_dim: %d threadId: %d cur_pack: %d", cur_dim, threadId,
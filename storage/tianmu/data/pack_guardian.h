@@ -27,6 +27,7 @@ namespace vcolumn {
 class VirtualColumn;
 }  // namespace vcolumn
 namespace core {
+class JustATable;
 class MIIterator;
 
 class VCPackGuardian final {
@@ -46,6 +47,7 @@ class VCPackGuardian final {
 
  private:
   void Initialize(int no_th);
+  void PrefetchAhead(JustATable *tab, int col_index, int cur_dim, int cur_pack, const MIIterator &mit);
   void ResizeLastPack(int taskNum);  // used only when Initialize is done
 
   vcolumn::VirtualColumn &my_vc_;
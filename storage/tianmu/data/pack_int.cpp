@@ -21,11 +21,14 @@
 #include <unordered_map>
 
 #include "compress/bit_stream_compressor.h"
+#include "compress/int_codec.h"
 #include "compress/num_compressor.h"
 #include "core/value.h"
 #include "loader/value_cache.h"
+#include "system/configuration.h"
 #include "system/tianmu_file.h"
 #include "util/bin_tools.h"
+#include "util/simd_filter.h"
 #include "vc/column_share.h"
 
 namespace Tianmu {
@@ -33,6 +36,8 @@ namespace core {
 PackInt::PackInt(DPN *dpn, PackCoordinate pc, ColumnShare *s) : Pack(dpn, pc, s) {
   is_real_ = ATI::IsRealType(s->ColType().GetTypeName());
   if (dpn_->NotTrivial()) {
+    if (tianmu_sysvar_pack_mmap && IsModeNoCompression() && LoadDataFromMapping())
+      return;
     system::TianmuFile f;
     f.OpenReadOnly(s->DataFile());
 
@@ -268,6 +273,7 @@ void PackInt::UpdateValueFloat(size_t locationInPack, const Value &v) {
 void PackInt::UpdateValue(size_t locationInPack, const Value &v) {
   if (IsDeleted(locationInPack))
     return;
+  Materialize();
   if (is_real_)
     UpdateValueFloat(locationInPack, v);
   else
@@ -287,6 +293,7 @@ void PackInt::UpdateValue(size_t locationInPack, const Value &v) {
 void PackInt::DeleteByRow(size_t locationInPack) {
   if (IsDeleted(locationInPack))
     return;
+  Materialize();
   dpn_->synced = false;
 
   if (!IsNull(locationInPack)) {
@@ -526,6 +533,7 @@ void PackInt::LoadValuesDouble(const loader::ValueCache *vc, const std::optional
 }
 
 void PackInt::LoadValues(const loader::ValueCache *vc, const std::optional<common::double_int_t> &nv) {
+  Materialize();
   if (is_real_)
     LoadValuesDouble(vc, nv);
   else
@@ -614,11 +622,78 @@ void PackInt::LoadValuesFixed(const loader::ValueCache *vc, const std::optional<
   dpn_->max_i = new_max;
 }
 
+void PackInt::BetweenMask(uint64_t lo, uint64_t hi, uint64_t *mask) const {
+  ASSERT(!is_real_ && !data_.empty());
+  utils::BetweenMask(data_.ptr_, data_.value_type_, dpn_->numOfRecords, lo, hi, mask);
+  ClearNullsInMask(mask);
+}
+
+void PackInt::InListMask(const std::vector<uint64_t> &vals, uint64_t *mask) const {
+  ASSERT(!is_real_ && !data_.empty());
+  utils::InListMask(data_.ptr_, data_.value_type_, dpn_->numOfRecords, vals.data(), vals.size(), mask);
+  ClearNullsInMask(mask);
+}
+
+void PackInt::NegateMask(uint64_t *mask) const {
+  size_t words = utils::MaskWords(dpn_->numOfRecords);
+  for (size_t w = 0; w < words; w++) mask[w] = ~mask[w];
+  if (dpn_->numOfRecords % 64)
+    mask[words - 1] &= (uint64_t(1) << (dpn_->numOfRecords % 64)) - 1;
+  ClearNullsInMask(mask);
+}
+
+void PackInt::ClearNullsInMask(uint64_t *mask) const {
+  if (dpn_->numOfNulls == 0)
+    return;
+  // the null bitmap is kept in 32-bit words, the mask in 64-bit ones
+  for (uint i = 0; i < (dpn_->numOfRecords + 31) / 32; i++)
+    mask[i >> 1] &= ~(uint64_t(nulls_ptr_[i]) << ((i & 1) * 32));
+}
+
 void PackInt::Destroy() {
-  dealloc(data_.ptr_);
+  if (!mapped_)
+    dealloc(data_.ptr_);
+  mapped_ = false;
   data_.ptr_ = 0;
 }
 
+bool PackInt::LoadDataFromMapping() {
+  FunctionExecutor fe([this]() { Lock(); }, [this]() { Unlock(); });
+
+  if (dpn_->NullOnly() || dpn_->Uniform())
+    data_.value_type_ = 0;
+  else
+    data_.value_type_ = GetValueSize(dpn_->max_i - dpn_->min_i);
+  size_t nulls_len = dpn_->numOfNulls > 0 ? bitmap_size_ : 0;
+  size_t deletes_len = dpn_->numOfDeleted > 0 ? bitmap_size_ : 0;
+  size_t data_len = data_.value_type_ * dpn_->numOfRecords;
+  const char *cur = col_share_->MapData(dpn_->dataAddress, nulls_len + deletes_len + data_len);
+  if (cur == nullptr)
+    return false;
+
+  // the bitmaps are small and owned by Pack, only the values stay in the mapping
+  std::memcpy(nulls_ptr_.get(), cur, nulls_len);
+  cur += nulls_len;
+  std::memcpy(deletes_ptr_.get(), cur, deletes_len);
+  cur += deletes_len;
+  if (data_len > 0) {
+    data_.ptr_ = const_cast<char *>(cur);
+    mapped_ = true;
+  }
+  dpn_->synced = false;
+  return true;
+}
+
+void PackInt::Materialize() {
+  if (!mapped_)
+    return;
+  size_t data_len = data_.value_type_ * dpn_->numOfRecords;
+  void *tmp = alloc(data_len, mm::BLOCK_TYPE::BLOCK_UNCOMPRESSED);
+  std::memcpy(tmp, data_.ptr_, data_len);
+  mapped_ = false;
+  data_.ptr_ = tmp;
+}
+
 PackInt::~PackInt() {
   DestructionLock();
   Destroy();
@@ -703,19 +778,14 @@ void PackInt::LoadDataFromFile(system::Stream *fcurfile) {
 
       if (IsModeDataCompressed() && data_.value_type_ > 0 &&
           *reinterpret_cast<uint64_t *>(cur_buf + 1) != (uint64_t)0) {
-        if (data_.value_type_ == 1) {
-          compress::NumCompressor<uchar> nc;
-          DecompressAndInsertNulls(nc, cur_buf);
-        } else if (data_.value_type_ == 2) {
-          compress::NumCompressor<ushort> nc;
-          DecompressAndInsertNulls(nc, cur_buf);
-        } else if (data_.value_type_ == 4) {
-          compress::NumCompressor<uint> nc;
-          DecompressAndInsertNulls(nc, cur_buf);
-        } else {
-          compress::NumCompressor<uint64_t> nc;
-          DecompressAndInsertNulls(nc, cur_buf);
-        }
+        if (data_.value_type_ == 1)
+          DecompressValues<uchar>(cur_buf);
+        else if (data_.value_type_ == 2)
+          DecompressValues<ushort>(cur_buf);
+        else if (data_.value_type_ == 4)
+          DecompressValues<uint>(cur_buf);
+        else
+          DecompressValues<uint64_t>(cur_buf);
       } else if (data_.value_type_ > 0) {
         for (uint o = 0; o < dpn_->numOfRecords; o++)
           if (!IsNull(int(o)))
@@ -775,10 +845,23 @@ void PackInt::SaveUncompressed(system::Stream *f) {
     f->WriteExact(data_.ptr_, data_.value_type_ * dpn_->numOfRecords);
 }
 
+compress::IntCodecType PackInt::GetCodecType() const {
+  switch (col_share_->ColType().GetFmt()) {
+    case common::PackFmt::FOR_BITPACK:
+      return compress::IntCodecType::FOR_BITPACK;
+    case common::PackFmt::DELTA_BITPACK:
+      return compress::IntCodecType::DELTA_BITPACK;
+    case common::PackFmt::ZSTD:
+      return compress::IntCodecType::ZSTD;
+    case common::PackFmt::INT_LZ4:
+      return compress::IntCodecType::LZ4;
+    default:
+      return compress::IntCodecType::RANGE_CODE;
+  }
+}
+
 template <typename etype>
-void PackInt::RemoveNullsAndCompress(compress::NumCompressor<etype> &nc, char *tmp_comp_buffer, uint &tmp_cb_len,
-                                     uint64_t &maxv) {
-  mm::MMGuard<etype> tmp_data;
+void PackInt::NonNullValues(mm::MMGuard<etype> &tmp_data) {
   if (dpn_->numOfNulls > 0) {
     tmp_data = mm::MMGuard<etype>(static_cast<etype *>(alloc((dpn_->numOfRecords - dpn_->numOfNulls) * sizeof(etype),
                                                              mm::BLOCK_TYPE::BLOCK_TEMPORARY)),
@@ -789,6 +872,48 @@ void PackInt::RemoveNullsAndCompress(compress::NumCompressor<etype> &nc, char *t
     }
   } else
     tmp_data = mm::MMGuard<etype>(static_cast<etype *>(data_.ptr_), *this, false);
+}
+
+template <typename etype>
+void PackInt::CompressValues(mm::MMGuard<char> &tmp_comp_buffer, uint &tmp_cb_len, uint64_t &maxv) {
+  auto codec = GetCodecType();
+  uint nrec = dpn_->numOfRecords - dpn_->numOfNulls;
+  if (codec == compress::IntCodecType::RANGE_CODE)
+    tmp_cb_len = nrec * sizeof(etype) + 20;
+  else
+    tmp_cb_len = compress::IntCodec<etype>::Bound(codec, nrec);
+  if (tmp_cb_len)
+    tmp_comp_buffer = mm::MMGuard<char>(
+        reinterpret_cast<char *>(alloc(tmp_cb_len * sizeof(char), mm::BLOCK_TYPE::BLOCK_TEMPORARY)), *this);
+
+  if (codec == compress::IntCodecType::RANGE_CODE) {
+    compress::NumCompressor<etype> nc;
+    RemoveNullsAndCompress(nc, tmp_comp_buffer.get(), tmp_cb_len, maxv);
+  } else {
+    RemoveNullsAndCompress(compress::IntCodec<etype>(codec), tmp_comp_buffer.get(), tmp_cb_len);
+  }
+  dpn_->codec = static_cast<uint8_t>(codec);
+}
+
+template <typename etype>
+void PackInt::RemoveNullsAndCompress(const compress::IntCodec<etype> &codec, char *tmp_comp_buffer,
+                                     uint &tmp_cb_len) {
+  mm::MMGuard<etype> tmp_data;
+  NonNullValues(tmp_data);
+  CprsErr res = codec.Compress(tmp_comp_buffer, tmp_cb_len, tmp_data.get(), dpn_->numOfRecords - dpn_->numOfNulls);
+  if (res != CprsErr::CPRS_SUCCESS) {
+    std::stringstream msg_buf;
+    msg_buf << "Compression of numerical values failed for column " << (pc_column(GetCoordinate().co.pack) + 1)
+            << ", pack " << (pc_dp(GetCoordinate().co.pack) + 1) << " (error " << static_cast<int>(res) << ").";
+    throw common::InternalException(msg_buf.str());
+  }
+}
+
+template <typename etype>
+void PackInt::RemoveNullsAndCompress(compress::NumCompressor<etype> &nc, char *tmp_comp_buffer, uint &tmp_cb_len,
+                                     uint64_t &maxv) {
+  mm::MMGuard<etype> tmp_data;
+  NonNullValues(tmp_data);
 
   CprsErr res =
       nc.Compress(tmp_comp_buffer, tmp_cb_len, tmp_data.get(), dpn_->numOfRecords - dpn_->numOfNulls, (etype)(maxv));
@@ -811,6 +936,36 @@ void PackInt::DecompressAndInsertNulls(compress::NumCompressor<etype> &nc, uint
             << ", pack " << (pc_dp(GetCoordinate().co.pack) + 1) << " (error " << static_cast<int>(res) << ").";
     throw common::DatabaseException(msg_buf.str());
   }
+  InsertNulls<etype>();
+}
+
+template <typename etype>
+void PackInt::DecompressAndInsertNulls(const compress::IntCodec<etype> &codec, uint *&cur_buf) {
+  CprsErr res = codec.Decompress(static_cast<etype *>(data_.ptr_), reinterpret_cast<char *>(cur_buf + 3), *cur_buf,
+                                 dpn_->numOfRecords - dpn_->numOfNulls);
+  if (res != CprsErr::CPRS_SUCCESS) {
+    std::stringstream msg_buf;
+    msg_buf << "Decompression of numerical values failed for column " << (pc_column(GetCoordinate().co.pack) + 1)
+            << ", pack " << (pc_dp(GetCoordinate().co.pack) + 1) << " (error " << static_cast<int>(res) << ").";
+    throw common::DatabaseException(msg_buf.str());
+  }
+  InsertNulls<etype>();
+}
+
+template <typename etype>
+void PackInt::DecompressValues(uint *&cur_buf) {
+  // packs written before codecs were selectable have codec 0, i.e. NumCompressor
+  auto codec = static_cast<compress::IntCodecType>(dpn_->codec);
+  if (codec == compress::IntCodecType::RANGE_CODE) {
+    compress::NumCompressor<etype> nc;
+    DecompressAndInsertNulls(nc, cur_buf);
+  } else {
+    DecompressAndInsertNulls(compress::IntCodec<etype>(codec), cur_buf);
+  }
+}
+
+template <typename etype>
+void PackInt::InsertNulls() {
   etype *d = (static_cast<etype *>(data_.ptr_)) + dpn_->numOfRecords - 1;
   etype *s = (static_cast<etype *>(data_.ptr_)) + dpn_->numOfRecords - dpn_->numOfNulls - 1;
   for (int i = dpn_->numOfRecords - 1; d > s; i--) {
@@ -828,6 +983,7 @@ std::pair<PackInt::UniquePtr, size_t> PackInt::Compress() {
 
   uint tmp_cb_len = 0;
   SetModeDataCompressed();
+  dpn_->codec = static_cast<uint8_t>(compress::IntCodecType::RANGE_CODE);
 
   uint64_t maxv = 0;
   if (data_.ptr_) {  // else maxv remains 0
@@ -843,35 +999,14 @@ std::pair<PackInt::UniquePtr, size_t> PackInt::Compress() {
 
   if (maxv != 0) {
     // ASSERT(last_set + 1 == dpn_->numOfRecords - dpn_->numOfNulls, "Expression evaluation failed!");
-    if (data_.value_type_ == 1) {
-      compress::NumCompressor<uchar> nc;
-      tmp_cb_len = (dpn_->numOfRecords - dpn_->numOfNulls) * sizeof(uchar) + 20;
-      if (tmp_cb_len)
-        tmp_comp_buffer = mm::MMGuard<char>(
-            reinterpret_cast<char *>(alloc(tmp_cb_len * sizeof(char), mm::BLOCK_TYPE::BLOCK_TEMPORARY)), *this);
-      RemoveNullsAndCompress(nc, tmp_comp_buffer.get(), tmp_cb_len, maxv);
-    } else if (data_.value_type_ == 2) {
-      compress::NumCompressor<ushort> nc;
-      tmp_cb_len = (dpn_->numOfRecords - dpn_->numOfNulls) * sizeof(ushort) + 20;
-      if (tmp_cb_len)
-        tmp_comp_buffer = mm::MMGuard<char>(
-            reinterpret_cast<char *>(alloc(tmp_cb_len * sizeof(char), mm::BLOCK_TYPE::BLOCK_TEMPORARY)), *this);
-      RemoveNullsAndCompress(nc, tmp_comp_buffer.get(), tmp_cb_len, maxv);
-    } else if (data_.value_type_ == 4) {
-      compress::NumCompressor<uint> nc;
-      tmp_cb_len = (dpn_->numOfRecords - dpn_->numOfNulls) * sizeof(uint) + 20;
-      if (tmp_cb_len)
-        tmp_comp_buffer = mm::MMGuard<char>(
-            reinterpret_cast<char *>(alloc(tmp_cb_len * sizeof(char), mm::BLOCK_TYPE::BLOCK_TEMPORARY)), *this);
-      RemoveNullsAndCompress(nc, tmp_comp_buffer.get(), tmp_cb_len, maxv);
-    } else {
-      compress::NumCompressor<uint64_t> nc;
-      tmp_cb_len = (dpn_->numOfRecords - dpn_->numOfNulls) * sizeof(uint64_t) + 20;
-      if (tmp_cb_len)
-        tmp_comp_buffer = mm::MMGuard<char>(
-            reinterpret_cast<char *>(alloc(tmp_cb_len * sizeof(char), mm::BLOCK_TYPE::BLOCK_TEMPORARY)), *this);
-      RemoveNullsAndCompress(nc, tmp_comp_buffer.get(), tmp_cb_len, maxv);
-    }
+    if (data_.value_type_ == 1)
+      CompressValues<uchar>(tmp_comp_buffer, tmp_cb_len, maxv);
+    else if (data_.value_type_ == 2)
+      CompressValues<ushort>(tmp_comp_buffer, tmp_cb_len, maxv);
+    else if (data_.value_type_ == 4)
+      CompressValues<uint>(tmp_comp_buffer, tmp_cb_len, maxv);
+    else
+      CompressValues<uint64_t>(tmp_comp_buffer, tmp_cb_len, maxv);
     buffer_size += tmp_cb_len;
   }
   buffer_size += 12;
@@ -34,6 +34,9 @@ class ValueCache;
 namespace compress {
 template <class T>
 class NumCompressor;
+template <class T>
+class IntCodec;
+enum class IntCodecType : uint8_t;
 }  // namespace compress
 
 namespace core {
@@ -59,6 +62,12 @@ class PackInt final : public Pack {
   }
   bool IsFixed() const { return !is_real_; }
 
+  // Batch predicates over the whole pack on level-2 encoded values (offsets from dpn min).
+  // Bit n of `mask` is set iff row n is not null and matches; see util/simd_filter.h.
+  void BetweenMask(uint64_t lo, uint64_t hi, uint64_t *mask) const;
+  void InListMask(const std::vector<uint64_t> &vals, uint64_t *mask) const;
+  void NegateMask(uint64_t *mask) const;  // flip the result for not-null rows (NOT BETWEEN, NOT IN)
+
  protected:
   std::pair<UniquePtr, size_t> Compress() override;
   void Destroy() override;
@@ -66,6 +75,11 @@ class PackInt final : public Pack {
  private:
   PackInt(const PackInt &apn, const PackCoordinate &pc);
 
+  // Serve an uncompressed pack straight from the page cache, false if it could not be mapped.
+  bool LoadDataFromMapping();
+  // Copy mapped values to an owned buffer before they are modified.
+  void Materialize();
+
   void AppendValue(uint64_t v) {
     dpn_->numOfRecords++;
     SetVal64(dpn_->numOfRecords - 1, v);
@@ -121,12 +135,26 @@ class PackInt final : public Pack {
   void LoadValuesFixed(const loader::ValueCache *vc, const std::optional<common::double_int_t> &nv);
 
   uint8_t GetValueSize(uint64_t v) const;
+  void ClearNullsInMask(uint64_t *mask) const;
 
   template <typename etype>
   void DecompressAndInsertNulls(compress::NumCompressor<etype> &nc, uint *&cur_buf);
   template <typename etype>
+  void DecompressAndInsertNulls(const compress::IntCodec<etype> &codec, uint *&cur_buf);
+  template <typename etype>
+  void DecompressValues(uint *&cur_buf);
+  template <typename etype>
+  void InsertNulls();
+  template <typename etype>
+  void NonNullValues(mm::MMGuard<etype> &tmp_data);
+  template <typename etype>
   void RemoveNullsAndCompress(compress::NumCompressor<etype> &nc, char *tmp_comp_buffer, uint &tmp_cb_len,
                               uint64_t &maxv);
+  template <typename etype>
+  void RemoveNullsAndCompress(const compress::IntCodec<etype> &codec, char *tmp_comp_buffer, uint &tmp_cb_len);
+  template <typename etype>
+  void CompressValues(mm::MMGuard<char> &tmp_comp_buffer, uint &tmp_cb_len, uint64_t &maxv);
+  compress::IntCodecType GetCodecType() const;
 
   // void alloc_data_ptr(uint32_t recordNum);
 
@@ -159,6 +187,7 @@ class PackInt final : public Pack {
       void *ptr_ = nullptr;
     };
   } data_ = {};
+  bool mapped_ = false;  // data_ points into the data file mapping of the column share
 };
 }  // namespace core
 }  // namespace Tianmu
@@ -0,0 +1,156 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include "data/pack_patch.h"
+#include "common/exception.h"
+#include "data/pack.h"
+#include "system/configuration.h"
+#include "system/tianmu_file.h"
+
+namespace Tianmu {
+namespace core {
+
+namespace {
+constexpr uint32_t kPatchMagic = 0x48435450;  // "PTCH"
+
+enum class ValueKind : uint8_t { NULL_VALUE, INT, DOUBLE, STRING };
+}  // namespace
+
+void PackPatch::Load(const fs::path &file) {
+  system::TianmuFile f;
+  f.OpenReadOnly(file);
+
+  uint32_t magic;
+  f.ReadExact(&magic, sizeof(magic));
+  if (magic != kPatchMagic)
+    throw common::DatabaseException("Invalid pack patch file " + file.string());
+  f.ReadExact(&base_, sizeof(base_));
+  base_.SetRefCount(0);
+
+  uint32_t n;
+  f.ReadExact(&n, sizeof(n));
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t row;
+    ValueKind kind;
+    f.ReadExact(&row, sizeof(row));
+    f.ReadExact(&kind, sizeof(kind));
+    Value &v = updates_[row];
+    switch (kind) {
+      case ValueKind::INT: {
+        int64_t l;
+        f.ReadExact(&l, sizeof(l));
+        v.SetInt(l);
+        break;
+      }
+      case ValueKind::DOUBLE: {
+        double d;
+        f.ReadExact(&d, sizeof(d));
+        v.SetDouble(d);
+        break;
+      }
+      case ValueKind::STRING: {
+        uint32_t len;
+        f.ReadExact(&len, sizeof(len));
+        std::string s(len, '\0');
+        f.ReadExact(s.data(), len);
+        v.SetString(s.data(), len);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  f.ReadExact(&n, sizeof(n));
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t row;
+    f.ReadExact(&row, sizeof(row));
+    deletes_.insert(row);
+  }
+}
+
+void PackPatch::Save(const fs::path &file) const {
+  fs::create_directories(file.parent_path());
+
+  system::TianmuFile f;
+  f.OpenCreateEmpty(file);
+  f.WriteExact(&kPatchMagic, sizeof(kPatchMagic));
+  f.WriteExact(&base_, sizeof(base_));
+
+  uint32_t n = updates_.size();
+  f.WriteExact(&n, sizeof(n));
+  for (auto &[row, v] : updates_) {
+    ValueKind kind = ValueKind::NULL_VALUE;
+    if (v.IsInt())
+      kind = ValueKind::INT;
+    else if (v.IsDouble())
+      kind = ValueKind::DOUBLE;
+    else if (v.IsString() || v.IsStringView())
+      kind = ValueKind::STRING;
+    f.WriteExact(&row, sizeof(row));
+    f.WriteExact(&kind, sizeof(kind));
+    switch (kind) {
+      case ValueKind::INT:
+        f.WriteExact(&v.GetInt(), sizeof(int64_t));
+        break;
+      case ValueKind::DOUBLE:
+        f.WriteExact(&v.GetDouble(), sizeof(double));
+        break;
+      case ValueKind::STRING: {
+        std::string_view s = v.IsString() ? std::string_view(v.GetString()) : v.GetStringView();
+        uint32_t len = s.size();
+        f.WriteExact(&len, sizeof(len));
+        f.WriteExact(s.data(), len);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  n = deletes_.size();
+  f.WriteExact(&n, sizeof(n));
+  for (auto row : deletes_) f.WriteExact(&row, sizeof(row));
+
+  if (tianmu_sysvar_sync_buffers)
+    f.Flush();
+}
+
+void PackPatch::Update(uint32_t row, const Value &v) {
+  if (deletes_.count(row) != 0)
+    return;
+  Value &u = updates_[row];
+  u = v;
+  // string views point into the caller's buffer
+  if (u.IsStringView()) {
+    std::string s(v.GetStringView());
+    u.SetString(s.data(), s.size());
+  }
+}
+
+void PackPatch::Delete(uint32_t row) {
+  updates_.erase(row);
+  deletes_.insert(row);
+}
+
+void PackPatch::ApplyTo(Pack &pack) const {
+  for (auto &[row, v] : updates_) pack.UpdateValue(row, v);
+  for (auto row : deletes_) pack.DeleteByRow(row);
+}
+
+}  // namespace core
+}  // namespace Tianmu
@@ -0,0 +1,66 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_CORE_PACK_PATCH_H_
+#define TIANMU_CORE_PACK_PATCH_H_
+#pragma once
+
+#include <map>
+#include <set>
+
+#include "common/common_definitions.h"
+#include "core/value.h"
+#include "data/dpn.h"
+#include "util/fs.h"
+
+namespace Tianmu {
+namespace core {
+class Pack;
+
+// Rows changed by UPDATE/DELETE since a pack was last written in full.
+// A patched DPN (DPN::patched) shares the data of the pack it was copied from;
+// the changes live in a small file next to the DPN and are applied on load.
+class PackPatch final {
+ public:
+  PackPatch() = default;
+  explicit PackPatch(const DPN &base) : base_(base) {}
+
+  static fs::path File(const fs::path &col_dir, common::PACK_INDEX pi) {
+    return col_dir / common::COL_PATCH_DIR / std::to_string(pi);
+  }
+
+  void Load(const fs::path &file);
+  void Save(const fs::path &file) const;
+
+  void Update(uint32_t row, const Value &v);
+  void Delete(uint32_t row);
+  // apply the changes to a pack built from Base()
+  void ApplyTo(Pack &pack) const;
+
+  // the DPN the shared data was written with, needed to decode it
+  const DPN &Base() const { return base_; }
+  size_t NumOfRows() const { return updates_.size() + deletes_.size(); }
+
+ private:
+  DPN base_;
+  std::map<uint32_t, Value> updates_;
+  std::set<uint32_t> deletes_;
+};
+
+}  // namespace core
+}  // namespace Tianmu
+
+#endif  // TIANMU_CORE_PACK_PATCH_H_
@@ -426,6 +426,33 @@ void Filter::Reset(Filter &f2) {
   }
 }
 
+void Filter::AndMask(size_t b, const uint64_t *mask) {
+  DEBUG_ASSERT(b < no_blocks);
+  if (block_status[b] == FB_EMPTY)
+    return;
+  block_changed[b] = 1;
+  if (block_status[b] == FB_FULL) {
+    int new_block_size = (b == no_blocks - 1 ? no_of_bits_in_last_block : pack_def);
+    int last_one = block_last_one[b];
+    bool no_change = true;
+    for (int w = 0; w <= last_one / 64 && no_change; w++) {
+      uint64_t used = (w < last_one / 64) ? ~uint64_t(0) : (~uint64_t(0) >> (63 - last_one % 64));
+      no_change = ((mask[w] & used) == used);
+    }
+    if (no_change)
+      return;
+    blocks[b] = block_allocator->Alloc();
+    new (blocks[b]) Block(block_filter, new_block_size, true);  // block_filter->this
+    if (blocks[b] == nullptr)
+      throw common::OutOfMemoryException();
+    block_status[b] = FB_MIXED;
+    if (last_one < new_block_size - 1)
+      blocks[b]->Reset(last_one + 1, new_block_size - 1);
+  }
+  if (blocks[b] && blocks[b]->AndMask(mask))
+    ResetBlock(b);
+}
+
 bool Filter::Get(size_t b, int n) {
   DEBUG_ASSERT(b < no_blocks);
   if (block_status[b] == FB_EMPTY)
@@ -112,6 +112,7 @@ class Filter final : public mm::TraceableObject {
   void ResetBetween(int64_t n1, int64_t n2);
   void ResetBetween(size_t b1, int n1, size_t b2, int n2);
   void Reset(Filter &f2);  // reset all positions where f2 is 1
+  void AndMask(size_t b, const uint64_t *mask);  // reset positions of block b which are 0 in mask (64 per word)
   bool Get(size_t b, int n);
   bool Get(int64_t n) {
     if (no_blocks == 0)
@@ -272,6 +273,7 @@ class Filter final : public mm::TraceableObject {
     bool Or(Block &b2);   // true => block is full
     void Not();
     bool AndNot(Block &b2);  // true => block is empty
+    bool AndMask(const uint64_t *mask);  // true => block is empty
     uint NumOfOnes() { return no_set_bits; }
     bool IsEmptyBetween(int n1, int n2);
     bool IsFullBetween(int n1, int n2);
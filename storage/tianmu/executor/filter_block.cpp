@@ -296,6 +296,19 @@ bool Filter::Block::AndNot(Block &b2) {
   return (no_set_bits == 0);
 }
 
+bool Filter::Block::AndMask(const uint64_t *mask) {
+  int new_set_bits = 0;
+  for (int i = 0; i < block_size; i++) {
+    uint m = uint(mask[i >> 1] >> ((i & 1) * 32));
+    if (i == block_size - 1 && (no_obj & 31))
+      m &= lshift1[no_obj & 31] - 1;  // a block created as full has ones past no_obj
+    block_table[i] &= m;
+    new_set_bits += CalculateBinSum(block_table[i]);
+  }
+  no_set_bits = new_set_bits;
+  return (no_set_bits == 0);
+}
+
 void Filter::Block::Not() {
   int new_set_bits;
   new_set_bits = no_obj - no_set_bits;
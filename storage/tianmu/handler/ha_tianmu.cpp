@@ -28,6 +28,7 @@
 #include "common/assert.h"
 #include "common/exception.h"
 #include "core/delta_record_head.h"
+#include "core/query_profile.h"
 #include "core/temp_table.h"
 #include "core/transaction.h"
 #include "core/value.h"
@@ -35,6 +36,7 @@
 #include "mm/initializer.h"
 #include "optimizer/compile/compilation_tools.h"
 #include "optimizer/compile/compiled_query.h"
+#include "sql_show.h"
 #include "system/configuration.h"
 #include "system/file_out.h"
 #include "util/fs.h"
@@ -2459,6 +2461,7 @@ void trace_update(MYSQL_THD thd, struct st_mysql_sys_var *var, void *var_ptr, co
 void controlquerylog_update(MYSQL_THD thd, struct st_mysql_sys_var *var, void *var_ptr, const void *save);
 void start_async_update(MYSQL_THD thd, struct st_mysql_sys_var *var, void *var_ptr, const void *save);
 extern void async_join_update(MYSQL_THD thd, struct st_mysql_sys_var *var, void *var_ptr, const void *save);
+void mm_thread_cache_size_update(MYSQL_THD thd, struct st_mysql_sys_var *var, void *var_ptr, const void *save);
 
 #define STATUS_FUNCTION(name, show_type, member)                                                            \
   int get_##name##_StatusVar([[maybe_unused]] MYSQL_THD thd, struct st_mysql_show_var *outvar, char *tmp) { \
@@ -2489,6 +2492,9 @@ STATUS_FUNCTION(gdcreadwaitinprogress, SHOW_LONGLONG, getReadWaitInProgress)
 STATUS_FUNCTION(gdcpackloads, SHOW_LONGLONG, getPackLoads)
 STATUS_FUNCTION(gdcloaderrors, SHOW_LONGLONG, getLoadErrors)
 STATUS_FUNCTION(gdcredecompress, SHOW_LONGLONG, getReDecompress)
+STATUS_FUNCTION(gdcprefetchloads, SHOW_LONGLONG, getPrefetchLoads)
+STATUS_FUNCTION(gdcprefetchhits, SHOW_LONGLONG, getPrefetchHits)
+STATUS_FUNCTION(gdcprefetchwasted, SHOW_LONGLONG, getPrefetchWasted)
 
 MM_STATUS_FUNCTION(mmallocblocks, SHOW_LONGLONG, getAllocBlocks)
 MM_STATUS_FUNCTION(mmallocobjs, SHOW_LONGLONG, getAllocObjs)
@@ -2521,6 +2527,9 @@ static struct st_mysql_show_var statusvars[] = {
     STATUS_MEMBER(gdcpackloads, gdc_pack_loads),
     STATUS_MEMBER(gdcloaderrors, gdc_load_errors),
     STATUS_MEMBER(gdcredecompress, gdc_redecompress),
+    STATUS_MEMBER(gdcprefetchloads, gdc_prefetch_loads),
+    STATUS_MEMBER(gdcprefetchhits, gdc_prefetch_hits),
+    STATUS_MEMBER(gdcprefetchwasted, gdc_prefetch_wasted),
     STATUS_MEMBER(mmrelease1, mm_release1),
     STATUS_MEMBER(mmrelease2, mm_release2),
     STATUS_MEMBER(mmrelease3, mm_release3),
@@ -2601,6 +2610,23 @@ static MYSQL_SYSVAR_UINT(hugefilesize, tianmu_sysvar_hugefilesize, PLUGIN_VAR_RE
                          UINT32_MAX, 0);
 static MYSQL_SYSVAR_UINT(cachinglevel, tianmu_sysvar_cachinglevel, PLUGIN_VAR_READONLY, "-", nullptr, nullptr, 1, 0,
                          512, 0);
+static MYSQL_SYSVAR_UINT(data_cache_shards, tianmu_sysvar_data_cache_shards, PLUGIN_VAR_READONLY,
+                         "Number of independently locked partitions of the pack cache, 0 means auto", nullptr, nullptr,
+                         0, 0, 1024, 0);
+static MYSQL_SYSVAR_UINT(prefetch_depth, tianmu_sysvar_prefetch_depth, PLUGIN_VAR_INT,
+                         "Number of packs loaded ahead of a scan in the background, 0 disables read-ahead", nullptr,
+                         nullptr, 0, 0, 16, 0);
+static MYSQL_SYSVAR_BOOL(pack_mmap, tianmu_sysvar_pack_mmap, PLUGIN_VAR_BOOL,
+                         "Map uncompressed integer packs from the data file instead of copying them", nullptr, nullptr,
+                         FALSE);
+static MYSQL_SYSVAR_UINT(pack_patch_max_rows, tianmu_sysvar_pack_patch_max_rows, PLUGIN_VAR_INT,
+                         "Max changed rows of a pack kept as a patch on UPDATE/DELETE before the pack is rewritten, 0 "
+                         "always rewrites",
+                         nullptr, nullptr, 0, 0, 65536, 0);
+static MYSQL_SYSVAR_UINT(version_checkpoint_interval, tianmu_sysvar_version_checkpoint_interval, PLUGIN_VAR_INT,
+                         "Commits between full column version manifests, the others only record changed packs, 0 "
+                         "always writes full manifests",
+                         nullptr, nullptr, 0, 0, 1024, 0);
 static MYSQL_SYSVAR_STR(mm_policy, tianmu_sysvar_mm_policy, PLUGIN_VAR_READONLY, "-", nullptr, nullptr, "");
 static MYSQL_SYSVAR_UINT(mm_hardlimit, tianmu_sysvar_mm_hardlimit, PLUGIN_VAR_READONLY, "-", nullptr, nullptr, 0, 0, 1,
                          0);
@@ -2610,6 +2636,9 @@ static MYSQL_SYSVAR_UINT(mm_largetempratio, tianmu_sysvar_mm_largetempratio, PLU
                          0, 0, 99, 0);
 static MYSQL_SYSVAR_UINT(mm_largetemppool_threshold, tianmu_sysvar_mm_large_threshold, PLUGIN_VAR_INT,
                          "size threshold in MB for using large temp thread pool", nullptr, nullptr, 16, 0, 10240, 0);
+static MYSQL_SYSVAR_UINT(mm_thread_cache_size, tianmu_sysvar_mm_thread_cache_size, PLUGIN_VAR_INT,
+                         "Memory in MB of freed blocks each thread keeps for reuse, 0 disables the thread caches",
+                         nullptr, mm_thread_cache_size_update, 0, 0, 1024, 0);
 static MYSQL_SYSVAR_UINT(sync_buffers, tianmu_sysvar_sync_buffers, PLUGIN_VAR_READONLY, "-", nullptr, nullptr, 0, 0, 1,
                          0);
 
@@ -2617,6 +2646,8 @@ static MYSQL_SYSVAR_UINT(query_threads, tianmu_sysvar_query_threads, PLUGIN_VAR_
                          100, 0);
 static MYSQL_SYSVAR_UINT(load_threads, tianmu_sysvar_load_threads, PLUGIN_VAR_READONLY, "-", nullptr, nullptr, 0, 0,
                          100, 0);
+static MYSQL_SYSVAR_BOOL(load_parallel_parse, tianmu_sysvar_load_parallel_parse, PLUGIN_VAR_BOOL,
+                         "Parse the values of LOAD DATA rows on the loader threads", nullptr, nullptr, FALSE);
 static MYSQL_SYSVAR_UINT(bg_load_threads, tianmu_sysvar_bg_load_threads, PLUGIN_VAR_READONLY, "-", nullptr, nullptr, 0,
                          0, 100, 0);
 static MYSQL_SYSVAR_UINT(insert_buffer_size, tianmu_sysvar_insert_buffer_size, PLUGIN_VAR_READONLY, "-", nullptr,
@@ -2627,6 +2658,9 @@ static MYSQL_SYSVAR_UINT(merge_rocks_expected_count, tianmu_sysvar_merge_rocks_e
                          nullptr, nullptr, 65536, 0, 6553600, 0);
 static MYSQL_SYSVAR_UINT(insert_write_batch_size, tianmu_sysvar_insert_write_batch_size, PLUGIN_VAR_READONLY, "-",
                          nullptr, nullptr, 10000, 0, 1000000, 0);
+static MYSQL_SYSVAR_UINT(delta_segment_size, tianmu_sysvar_delta_segment_size, PLUGIN_VAR_INT,
+                         "Memory (MB) per table for the columnar copy of unmerged delta inserts, 0 disables it",
+                         nullptr, nullptr, 256, 0, 1048576, 0);
 static MYSQL_SYSVAR_UINT(log_loop_interval, tianmu_sysvar_log_loop_interval, PLUGIN_VAR_READONLY, "-", nullptr, nullptr,
                          60, 0, 6000, 0);
 
@@ -2645,9 +2679,14 @@ static MYSQL_SYSVAR_UINT(groupby_parallel_degree, tianmu_sysvar_groupby_parallel
 static MYSQL_SYSVAR_ULONGLONG(groupby_parallel_rows_minimum, tianmu_sysvar_groupby_parallel_rows_minimum,
                               PLUGIN_VAR_LONGLONG, "group by parallel minimum rows", nullptr, nullptr, 655360, 100,
                               INT64_MAX, 0);
+static MYSQL_SYSVAR_BOOL(groupby_partitioned_merge, tianmu_sysvar_groupby_partitioned_merge, PLUGIN_VAR_BOOL,
+                         "merge parallel group by results by hash partitions in parallel", nullptr, nullptr, FALSE);
 static MYSQL_SYSVAR_UINT(slow_query_record_interval, tianmu_sysvar_slow_query_record_interval, PLUGIN_VAR_INT,
                          "slow Query Threshold of recording tianmu logs, in seconds", nullptr, nullptr, 0, 0, INT32_MAX,
                          0);
+static MYSQL_THDVAR_BOOL(query_profile, PLUGIN_VAR_OPCMDARG,
+                         "Profile the execution steps of the session's queries and report them as notes", nullptr,
+                         nullptr, FALSE);
 static MYSQL_SYSVAR_BOOL(orderby_speedup, tianmu_sysvar_orderby_speedup, PLUGIN_VAR_BOOL, "-", nullptr, nullptr, TRUE);
 static MYSQL_SYSVAR_UINT(join_parallel, tianmu_sysvar_join_parallel, PLUGIN_VAR_INT,
                          "join matching parallel: 0-Disabled, 1-Auto, N-specify count", nullptr, nullptr, 1, 0, 1000,
@@ -2694,6 +2733,36 @@ static MYSQL_SYSVAR_STR(async_join, tianmu_sysvar_async_join, PLUGIN_VAR_STR,
                         "1;0;0;0");
 static MYSQL_SYSVAR_BOOL(join_disable_switch_side, tianmu_sysvar_join_disable_switch_side, PLUGIN_VAR_BOOL, "-",
                          nullptr, nullptr, FALSE);
+static MYSQL_SYSVAR_BOOL(join_radix_partition, tianmu_sysvar_join_radix_partition, PLUGIN_VAR_BOOL,
+                         "Radix-partitioned hash join with a hash table per partition", nullptr, nullptr, FALSE);
+static MYSQL_SYSVAR_BOOL(join_runtime_filter, tianmu_sysvar_join_runtime_filter, PLUGIN_VAR_BOOL,
+                         "Filter the hash join matched side by the traversed keys", nullptr, nullptr, FALSE);
+static MYSQL_SYSVAR_BOOL(radix_sort, tianmu_sysvar_radix_sort, PLUGIN_VAR_BOOL,
+                         "Parallel radix sort of large in-memory sort buffers", nullptr, nullptr, FALSE);
+static MYSQL_SYSVAR_UINT(result_batch_rows, tianmu_sysvar_result_batch_rows, PLUGIN_VAR_INT,
+                         "Rows of a materialized result converted column by column at a time, 0 - row by row",
+                         nullptr, nullptr, 0, 0, 65536, 0);
+static MYSQL_SYSVAR_UINT(spill_memory_limit, tianmu_sysvar_spill_memory_limit, PLUGIN_VAR_INT,
+                         "Memory in MB for hash join partitions of a query before they spill, 0 - no limit",
+                         nullptr, nullptr, 0, 0, 1048576, 0);
+static MYSQL_SYSVAR_BOOL(index_table_compress, tianmu_sysvar_index_table_compress, PLUGIN_VAR_BOOL,
+                         "Bit-pack the swapped out blocks of intermediate tuple tables", nullptr, nullptr, FALSE);
+static MYSQL_SYSVAR_UINT(string_stats_length, tianmu_sysvar_string_stats_length, PLUGIN_VAR_INT,
+                         "Bytes of string pack min/max kept for rough checks beyond the 8-byte prefix, 0 - off",
+                         nullptr, nullptr, 0, 0, 4096, 0);
+static MYSQL_SYSVAR_BOOL(native_expression, tianmu_sysvar_native_expression, PLUGIN_VAR_BOOL,
+                         "Evaluate integer and decimal expressions a pack at a time without MySQL items", nullptr,
+                         nullptr, FALSE);
+static MYSQL_SYSVAR_UINT(subquery_memo_size, tianmu_sysvar_subquery_memo_size, PLUGIN_VAR_INT,
+                         "MB of memoized results per correlated subquery, keyed by the outer values, 0 - off",
+                         nullptr, nullptr, 0, 0, 65536, 0);
+static MYSQL_SYSVAR_BOOL(hll_sketches, tianmu_sysvar_hll_sketches, PLUGIN_VAR_READONLY,
+                         "Keep per-pack HyperLogLog sketches for tianmu_approx_count_distinct", nullptr, nullptr,
+                         FALSE);
+static MYSQL_THDVAR_BOOL(approx_count_distinct, PLUGIN_VAR_OPCMDARG,
+                         "Answer COUNT(DISTINCT col) of the session approximately from the pack sketches kept "
+                         "with tianmu_hll_sketches",
+                         nullptr, nullptr, FALSE);
 static MYSQL_SYSVAR_BOOL(enable_histogram_cmap_bloom, tianmu_sysvar_enable_histogram_cmap_bloom, PLUGIN_VAR_BOOL, "-",
                          nullptr, nullptr, FALSE);
 static MYSQL_SYSVAR_BOOL(large_prefix, tianmu_sysvar_large_prefix, PLUGIN_VAR_RQCMDARG,
@@ -2753,6 +2822,18 @@ void start_async_update([[maybe_unused]] MYSQL_THD thd, [[maybe_unused]] struct
   }
 }
 
+void mm_thread_cache_size_update([[maybe_unused]] MYSQL_THD thd, [[maybe_unused]] struct st_mysql_sys_var *var,
+                                 void *var_ptr, const void *save) {
+  uint size_mb = *static_cast<const uint *>(save);
+  *static_cast<uint *>(var_ptr) = size_mb;
+
+  // the caches only shrink on their own when their threads free blocks
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  if (eng) {
+    mm::TraceableObject::Instance()->TrimThreadCaches(size_t(size_mb) * 1_MB);
+  }
+}
+
 void resolve_async_join_settings(const std::string &settings) {
   std::vector<std::string> splits_vec;
   boost::split(splits_vec, settings, boost::is_any_of(";"));
@@ -2779,10 +2860,12 @@ static struct st_mysql_sys_var *tianmu_showvars[] = {MYSQL_SYSVAR(bg_load_thread
                                                      MYSQL_SYSVAR(cachinglevel),
                                                      MYSQL_SYSVAR(compensation_start),
                                                      MYSQL_SYSVAR(control_trace),
+                                                     MYSQL_SYSVAR(data_cache_shards),
                                                      MYSQL_SYSVAR(data_distribution_policy),
                                                      MYSQL_SYSVAR(delete_or_update_threads),
                                                      MYSQL_SYSVAR(merge_rocks_expected_count),
                                                      MYSQL_SYSVAR(insert_write_batch_size),
+                                                     MYSQL_SYSVAR(delta_segment_size),
                                                      MYSQL_SYSVAR(log_loop_interval),
                                                      MYSQL_SYSVAR(disk_usage_threshold),
                                                      MYSQL_SYSVAR(distinct_cache_size),
@@ -2790,7 +2873,9 @@ static struct st_mysql_sys_var *tianmu_showvars[] = {MYSQL_SYSVAR(bg_load_thread
                                                      MYSQL_SYSVAR(global_debug_level),
                                                      MYSQL_SYSVAR(groupby_parallel_degree),
                                                      MYSQL_SYSVAR(groupby_parallel_rows_minimum),
+                                                     MYSQL_SYSVAR(groupby_partitioned_merge),
                                                      MYSQL_SYSVAR(slow_query_record_interval),
+                                                     MYSQL_SYSVAR(query_profile),
                                                      MYSQL_SYSVAR(hugefiledir),
                                                      MYSQL_SYSVAR(hugefilesize),
                                                      MYSQL_SYSVAR(os_least_mem),
@@ -2815,36 +2900,120 @@ static struct st_mysql_sys_var *tianmu_showvars[] = {MYSQL_SYSVAR(bg_load_thread
                                                      MYSQL_SYSVAR(insert_wait_ms),
                                                      MYSQL_SYSVAR(insert_wait_time),
                                                      MYSQL_SYSVAR(join_disable_switch_side),
+                                                     MYSQL_SYSVAR(join_radix_partition),
+                                                     MYSQL_SYSVAR(join_runtime_filter),
+                                                     MYSQL_SYSVAR(radix_sort),
+                                                     MYSQL_SYSVAR(result_batch_rows),
+                                                     MYSQL_SYSVAR(spill_memory_limit),
+                                                     MYSQL_SYSVAR(index_table_compress),
+                                                     MYSQL_SYSVAR(string_stats_length),
+                                                     MYSQL_SYSVAR(native_expression),
+                                                     MYSQL_SYSVAR(subquery_memo_size),
+                                                     MYSQL_SYSVAR(hll_sketches),
+                                                     MYSQL_SYSVAR(approx_count_distinct),
                                                      MYSQL_SYSVAR(enable_histogram_cmap_bloom),
                                                      MYSQL_SYSVAR(join_parallel),
                                                      MYSQL_SYSVAR(join_splitrows),
                                                      MYSQL_SYSVAR(large_prefix),
                                                      MYSQL_SYSVAR(load_threads),
+                                                     MYSQL_SYSVAR(load_parallel_parse),
                                                      MYSQL_SYSVAR(lookup_max_size),
                                                      MYSQL_SYSVAR(max_execution_time),
                                                      MYSQL_SYSVAR(minmax_speedup),
                                                      MYSQL_SYSVAR(mm_hardlimit),
                                                      MYSQL_SYSVAR(mm_largetempratio),
+                                                     MYSQL_SYSVAR(mm_thread_cache_size),
                                                      MYSQL_SYSVAR(mm_largetemppool_threshold),
                                                      MYSQL_SYSVAR(mm_policy),
                                                      MYSQL_SYSVAR(mm_releasepolicy),
                                                      MYSQL_SYSVAR(orderby_speedup),
                                                      MYSQL_SYSVAR(parallel_filloutput),
                                                      MYSQL_SYSVAR(parallel_mapjoin),
+                                                     MYSQL_SYSVAR(prefetch_depth),
+                                                     MYSQL_SYSVAR(pack_mmap),
+                                                     MYSQL_SYSVAR(pack_patch_max_rows),
                                                      MYSQL_SYSVAR(qps_log),
                                                      MYSQL_SYSVAR(query_threads),
                                                      MYSQL_SYSVAR(refresh_sys_tianmu),
                                                      MYSQL_SYSVAR(session_debug_level),
                                                      MYSQL_SYSVAR(sync_buffers),
                                                      MYSQL_SYSVAR(trigger_error),
+                                                     MYSQL_SYSVAR(version_checkpoint_interval),
                                                      MYSQL_SYSVAR(async_join),
                                                      MYSQL_SYSVAR(force_hashjoin),
                                                      MYSQL_SYSVAR(start_async),
                                                      MYSQL_SYSVAR(result_sender_rows),
                                                      nullptr};
+
+static struct st_mysql_information_schema tianmu_query_profile_view = {MYSQL_INFORMATION_SCHEMA_INTERFACE_VERSION};
+
+static ST_FIELD_INFO tianmu_query_profile_fields[] = {
+    {"QUERY_ID", 21, MYSQL_TYPE_LONGLONG, 0, MY_I_S_UNSIGNED, 0, 0},
+    {"CONN_ID", 21, MYSQL_TYPE_LONGLONG, 0, MY_I_S_UNSIGNED, 0, 0},
+    {"QUERY", 1024, MYSQL_TYPE_STRING, 0, 0, 0, 0},
+    {"STEP_NO", 21, MYSQL_TYPE_LONGLONG, 0, MY_I_S_UNSIGNED, 0, 0},
+    {"STEP", 64, MYSQL_TYPE_STRING, 0, 0, 0, 0},
+    {"DEPTH", 21, MYSQL_TYPE_LONGLONG, 0, MY_I_S_UNSIGNED, 0, 0},
+    {"WALL_MS", 21, MYSQL_TYPE_DOUBLE, 0, 0, 0, 0},
+    {"CPU_MS", 21, MYSQL_TYPE_DOUBLE, 0, 0, 0, 0},
+    {"ROWS_IN", 21, MYSQL_TYPE_LONGLONG, 0, 0, 0, 0},
+    {"ROWS_OUT", 21, MYSQL_TYPE_LONGLONG, 0, 0, 0, 0},
+    {"PACKS_TOUCHED", 21, MYSQL_TYPE_LONGLONG, 0, 0, 0, 0},
+    {"PACKS_SKIPPED", 21, MYSQL_TYPE_LONGLONG, 0, 0, 0, 0},
+    {"CACHE_HITS", 21, MYSQL_TYPE_LONGLONG, 0, 0, 0, 0},
+    {"CACHE_MISSES", 21, MYSQL_TYPE_LONGLONG, 0, 0, 0, 0},
+    {"BYTES_DECOMPRESSED", 21, MYSQL_TYPE_LONGLONG, 0, 0, 0, 0},
+    {0, 0, MYSQL_TYPE_NULL, 0, 0, 0, 0}};
+
+static int tianmu_query_profile_fill(THD *thd, TABLE_LIST *tables, [[maybe_unused]] Item *cond) {
+  TABLE *table = tables->table;
+  // as for SHOW PROCESSLIST, the queries of other users need the PROCESS privilege
+  Security_context *sctx = thd->security_context();
+  bool all_users = sctx->check_access(PROCESS_ACL);
+  const char *user = sctx->user().str ? sctx->user().str : "";
+  for (auto &rec : core::QueryProfile::Published()) {
+    if (!all_users && rec.user != user)
+      continue;
+    for (size_t i = 0; i < rec.steps.size(); i++) {
+      auto &step = rec.steps[i];
+      int f = 0;
+      table->field[f++]->store(rec.query_id, true);
+      table->field[f++]->store(rec.conn_id, true);
+      table->field[f++]->store(rec.query.c_str(), std::min<size_t>(rec.query.size(), 1024), system_charset_info);
+      table->field[f++]->store(i, true);
+      table->field[f++]->store(step.name.c_str(), step.name.size(), system_charset_info);
+      table->field[f++]->store(step.depth, true);
+      table->field[f++]->store(step.wall_ms);
+      table->field[f++]->store(step.cpu_ms);
+      table->field[f++]->store(step.rows_in, false);
+      table->field[f++]->store(step.rows_out, false);
+      for (auto counter : step.counters) table->field[f++]->store(counter, false);
+      if (schema_table_store_record(thd, table))
+        return 1;
+    }
+  }
+  return 0;
+}
+
+static int tianmu_query_profile_init(void *p) {
+  ST_SCHEMA_TABLE *schema_table = static_cast<ST_SCHEMA_TABLE *>(p);
+  schema_table->fields_info = tianmu_query_profile_fields;
+  schema_table->fill_table = tianmu_query_profile_fill;
+  return 0;
+}
 }  // namespace DBHandler
 }  // namespace Tianmu
 
+bool tianmu_session_query_profile(THD *thd) {
+  using namespace Tianmu::DBHandler;
+  return THDVAR(thd, query_profile);
+}
+
+bool tianmu_session_approx_count_distinct(THD *thd) {
+  using namespace Tianmu::DBHandler;
+  return THDVAR(thd, approx_count_distinct);
+}
+
 mysql_declare_plugin(tianmu){
     MYSQL_STORAGE_ENGINE_PLUGIN,
     &Tianmu::DBHandler::tianmu_storage_engine,
@@ -2859,4 +3028,19 @@ mysql_declare_plugin(tianmu){
     Tianmu::DBHandler::tianmu_showvars, /* system variables  */
     nullptr,                            /* config options    */
     0                                   /* flags for plugin */
-} mysql_declare_plugin_end;
+},
+    {
+        MYSQL_INFORMATION_SCHEMA_PLUGIN,
+        &Tianmu::DBHandler::tianmu_query_profile_view,
+        "TIANMU_QUERY_PROFILE",
+        "StoneAtom Group Holding Limited",
+        "Step profiles of the last queries run with tianmu_query_profile",
+        PLUGIN_LICENSE_GPL,
+        Tianmu::DBHandler::tianmu_query_profile_init, /* Plugin Init */
+        nullptr,                                      /* Plugin Deinit */
+        0x0001 /* 0.1 */,
+        nullptr, /* status variables  */
+        nullptr, /* system variables  */
+        nullptr, /* config options    */
+        0        /* flags for plugin */
+    } mysql_declare_plugin_end;
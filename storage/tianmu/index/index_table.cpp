@@ -17,14 +17,17 @@
 
 #include "index_table.h"
 
+#include <algorithm>
+
 #include "core/transaction.h"
 #include "executor/filter.h"
+#include "system/configuration.h"
 #include "system/tianmu_system.h"
 
 namespace Tianmu {
 namespace core {
 IndexTable::IndexTable(int64_t _size, int64_t _orig_size, [[maybe_unused]] int mem_modifier)
-    : system::CacheableItem("JW", "INT"), m_conn(current_txn_) {
+    : system::CacheableItem("JW", "INT"), m_conn(current_txn_), compress_blocks(tianmu_sysvar_index_table_compress) {
   // Note: buffer size should be 2^n
   DEBUG_ASSERT(_orig_size >= 0);
   orig_size = _orig_size;
@@ -74,7 +77,8 @@ IndexTable::IndexTable(IndexTable &sec)
       orig_size(sec.orig_size),
       cur_block(0),
       block_changed(false),
-      m_conn(sec.m_conn) {
+      m_conn(sec.m_conn),
+      compress_blocks(sec.compress_blocks) {
   sec.Lock();
   CI_SetDefaultSize((int)max_buffer_size_in_bytes);
   buf = (unsigned char *)alloc(buffer_size_in_bytes, mm::BLOCK_TYPE::BLOCK_TEMPORARY, true);
@@ -90,8 +94,14 @@ IndexTable::IndexTable(IndexTable &sec)
   if (max_block_used == 0 && size > 0) {
     std::memcpy(buf, sec.buf, std::min(uint64_t(buffer_size_in_bytes), size * bytes_per_value));
     block_changed = true;
-  } else
-    for (uint k = 0; k < used_size; k++) Set64(k, sec.Get64(k));
+  } else {
+    std::vector<uint64_t> values(std::min(uint64_t(used_size), uint64_t(65536)));
+    for (uint64_t k = 0; k < uint64_t(used_size); k += values.size()) {
+      uint64_t count = std::min(uint64_t(values.size()), used_size - k);
+      sec.GetValues(k, count, values.data());
+      for (uint64_t i = 0; i < count; i++) Set64(k + i, values[i]);
+    }
+  }
   sec.Unlock();
   Unlock();
 }
@@ -100,6 +110,8 @@ IndexTable::~IndexTable() {
   DestructionLock();
   if (buf)
     dealloc(buf);
+  for (auto &block : packed_blocks) dealloc(block.data);
+  FreePackBuffer();
 }
 
 void IndexTable::LoadBlock(int b) {
@@ -110,10 +122,17 @@ void IndexTable::LoadBlock(int b) {
       TIANMU_LOG(LogCtl_Level::ERROR, "Could not allocate memory for IndexTable(LoadBlock).");
       throw common::OutOfMemoryException();
     }
-  } else if (block_changed)
-    CI_Put(cur_block, buf);
+  } else if (block_changed) {
+    if (compress_blocks)
+      PackBlock(cur_block);
+    else
+      CI_Put(cur_block, buf);
+  }
   DEBUG_ASSERT(buf != nullptr);
-  CI_Get(b, buf);
+  if (compress_blocks)
+    UnpackBlock(b);
+  else
+    CI_Get(b, buf);
   if (m_conn->Killed())  // from time to time...
     throw common::KilledException();
   max_block_used = std::max(max_block_used, b);
@@ -121,6 +140,133 @@ void IndexTable::LoadBlock(int b) {
   block_changed = false;
 }
 
+template <class T>
+uint IndexTable::CompressBlock(PackedBlock &block) {
+  const T *values = reinterpret_cast<const T *>(buf);
+  uint raw = block.nrec * sizeof(T);
+  uint bound = compress::IntCodec<T>::Bound(compress::IntCodecType::DELTA_BITPACK, block.nrec);
+  char *out = PackBuffer(2 * size_t(bound));
+
+  // deltas first, as join results are mostly sorted runs; values only if deltas do not pay off
+  uint len = bound;
+  if (compress::IntCodec<T>(compress::IntCodecType::DELTA_BITPACK)
+          .Compress(out, len, values, block.nrec) != CprsErr::CPRS_SUCCESS)
+    len = raw;
+  block.codec = compress::IntCodecType::DELTA_BITPACK;
+  if (len > raw / 2) {
+    uint for_len = bound;
+    if (compress::IntCodec<T>(compress::IntCodecType::FOR_BITPACK)
+                .Compress(out + bound, for_len, values, block.nrec) == CprsErr::CPRS_SUCCESS &&
+        for_len < len) {
+      std::memmove(out, out + bound, for_len);
+      len = for_len;
+      block.codec = compress::IntCodecType::FOR_BITPACK;
+    }
+  }
+
+  block.compressed = len < raw;
+  if (!block.compressed) {
+    std::memcpy(out, buf, raw);
+    len = raw;
+  }
+  return len;
+}
+
+char *IndexTable::PackBuffer(size_t size) {
+  if (pack_buffer_size < size) {
+    FreePackBuffer();
+    pack_buffer = static_cast<char *>(alloc(size, mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+    pack_buffer_size = size;
+  }
+  return pack_buffer;
+}
+
+void IndexTable::FreePackBuffer() {
+  dealloc(pack_buffer);
+  pack_buffer = nullptr;
+  pack_buffer_size = 0;
+}
+
+void IndexTable::PackBlock(int b) {
+  if (packed_blocks.size() <= size_t(b))
+    packed_blocks.resize(b + 1);
+  PackedBlock &block = packed_blocks[b];
+  if (block.data != nullptr) {
+    packed_in_memory -= block.len;
+    dealloc(block.data);
+    block.data = nullptr;
+  }
+
+  block.nrec = uint(buffer_size_in_bytes / bytes_per_value);
+  if (bytes_per_value == 4)
+    block.len = CompressBlock<unsigned int>(block);
+  else if (bytes_per_value == 8)
+    block.len = CompressBlock<uint64_t>(block);
+  else
+    block.len = CompressBlock<unsigned short>(block);
+
+  if (packed_in_memory + block.len <= max_buffer_size_in_bytes) {
+    block.data = static_cast<char *>(alloc(block.len, mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+    std::memcpy(block.data, pack_buffer, block.len);
+    packed_in_memory += block.len;
+  } else {
+    CI_Put(b, reinterpret_cast<unsigned char *>(pack_buffer), int(block.len));
+  }
+  FreePackBuffer();
+}
+
+void IndexTable::UnpackBlock(int b) {
+  if (size_t(b) >= packed_blocks.size() || packed_blocks[b].len == 0)
+    return;  // never saved, as CI_Get() of a missing block
+  PackedBlock &block = packed_blocks[b];
+  const char *data = block.data;
+  if (data == nullptr) {
+    data = PackBuffer(block.len);
+    CI_Get(b, reinterpret_cast<unsigned char *>(pack_buffer));
+  }
+  CprsErr res = CprsErr::CPRS_SUCCESS;
+  if (!block.compressed)
+    std::memcpy(buf, data, block.len);
+  else if (bytes_per_value == 4)
+    res = compress::IntCodec<unsigned int>(block.codec)
+              .Decompress(reinterpret_cast<unsigned int *>(buf), data, block.len, block.nrec);
+  else if (bytes_per_value == 8)
+    res = compress::IntCodec<uint64_t>(block.codec)
+              .Decompress(reinterpret_cast<uint64_t *>(buf), data, block.len, block.nrec);
+  else
+    res = compress::IntCodec<unsigned short>(block.codec)
+              .Decompress(reinterpret_cast<unsigned short *>(buf), data, block.len, block.nrec);
+  FreePackBuffer();
+  if (res != CprsErr::CPRS_SUCCESS)
+    throw common::DatabaseException("Corrupted IndexTable block.");
+}
+
+template <class T>
+void IndexTable::CopyValues(uint64_t n, uint64_t count, uint64_t *values) {
+  const T *block_values = reinterpret_cast<const T *>(buf) + (n & block_mask);
+  for (uint64_t i = 0; i < count; i++) values[i] = block_values[i];
+}
+
+void IndexTable::GetValues(uint64_t n, uint64_t count, uint64_t *values) {
+  DEBUG_ASSERT(IsLocked());
+  DEBUG_ASSERT(n + count <= size);
+  while (count > 0) {
+    int b = int(n >> block_shift);
+    if (b != cur_block)
+      LoadBlock(b);
+    uint64_t in_block = std::min(count, EndOfCurrentBlock(n) - n);
+    if (bytes_per_value == 4)
+      CopyValues<unsigned int>(n, in_block, values);
+    else if (bytes_per_value == 8)
+      CopyValues<uint64_t>(n, in_block, values);
+    else
+      CopyValues<unsigned short>(n, in_block, values);
+    n += in_block;
+    values += in_block;
+    count -= in_block;
+  }
+}
+
 void IndexTable::ExpandTo(uint64_t new_size) {
   DEBUG_ASSERT(IsLocked());
   if (new_size <= (uint64_t)size)
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <vector>
+#include "compress/int_codec.h"
 #include "mm/traceable_object.h"
 #include "system/cacheable_item.h"
 
@@ -83,6 +84,9 @@ class IndexTable : private system::CacheableItem, public mm::TraceableObject {
     return res;
   }
 
+  // bulk version of Get64(): values of rows [n, n + count), block by block
+  void GetValues(uint64_t n, uint64_t count, uint64_t *values);
+
   inline uint64_t EndOfCurrentBlock(uint64_t n) {  // return the upper bound of this large block (n which will
                                                    // cause reload)
     return ((n >> block_shift) + 1) << block_shift;
@@ -114,7 +118,26 @@ class IndexTable : private system::CacheableItem, public mm::TraceableObject {
   mm::TO_TYPE TraceableType() const override { return mm::TO_TYPE::TO_INDEXTABLE; }
 
  private:
+  // A block swapped out with tianmu_index_table_compress: bit-packed deltas
+  // (sorted runs, contiguous rows take no bits) or values, whichever is
+  // smaller. Kept in memory up to one buffer in total, then on disk.
+  struct PackedBlock {
+    compress::IntCodecType codec = compress::IntCodecType::DELTA_BITPACK;
+    bool compressed = false;  // false - raw values
+    uint nrec = 0;
+    uint len = 0;          // 0 - never saved
+    char *data = nullptr;  // nullptr when on disk
+  };
+
   void LoadBlock(int b);
+  void PackBlock(int b);
+  void UnpackBlock(int b);
+  template <class T>
+  uint CompressBlock(PackedBlock &block);
+  char *PackBuffer(size_t size);
+  void FreePackBuffer();
+  template <class T>
+  void CopyValues(uint64_t n, uint64_t count, uint64_t *values);
 
   unsigned char *buf = nullptr;  // polymorphic: unsigned short, unsigned int or int64_t
 
@@ -131,6 +154,12 @@ class IndexTable : private system::CacheableItem, public mm::TraceableObject {
   int cur_block;
   bool block_changed;
   Transaction *m_conn;  // external pointer
+
+  bool compress_blocks = false;
+  std::vector<PackedBlock> packed_blocks;
+  uint64_t packed_in_memory = 0;
+  char *pack_buffer = nullptr;  // packed blocks and the buffer are allocated as the table is
+  size_t pack_buffer_size = 0;
 };
 }  // namespace core
 }  // namespace Tianmu
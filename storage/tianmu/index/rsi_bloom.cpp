@@ -16,6 +16,7 @@
 */
 
 #include "index/rsi_bloom.h"
+#include "data/pack_int.h"
 #include "data/pack_str.h"
 #include "system/tianmu_file.h"
 #include "system/tianmu_system.h"
@@ -42,6 +43,7 @@ RSIndex_Bloom::RSIndex_Bloom(const fs::path &dir, common::TX_ID ver) {
   // allocate more than requested
   capacity = (hdr.no_pack / 1024 + 1) * 1024;
   bloom_buffers = static_cast<BF *>(alloc(capacity * sizeof(BF), mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+  for (size_t i = hdr.no_pack; i < capacity; i++) bloom_buffers[i].len = 0;
 
   if (hdr.no_pack > 0) {
     frs_index.ReadExact(bloom_buffers, hdr.no_pack * sizeof(BF));
@@ -65,38 +67,65 @@ void RSIndex_Bloom::SaveToFile(common::TX_ID ver) {
   }
 }
 
-common::RoughSetValue RSIndex_Bloom::IsValue(types::BString min_v, types::BString max_v, int pack) {
-  if (min_v == max_v) {
-    auto &bf = bloom_buffers[pack];
-    if (bf.len == 0) {  // this pack no bloom filter data
-      return common::RoughSetValue::RS_SOME;
-    }
-
-    Slice key(max_v.val_, max_v.size());
-    // get filter data
-    Slice pack_block(bf.data, bf.len);
-    FilterBlockReader reader(bloom_filter_policy.get(), pack_block);
-    if (!reader.KeyMayMatch(0, key)) {
-      return common::RoughSetValue::RS_NONE;
-    }
+common::RoughSetValue RSIndex_Bloom::KeyMayMatch(const Slice &key, int pack) {
+  // packs written before the filter existed (e.g. FILTER added to an old numeric column) have no data
+  if (pack < 0 || uint32_t(pack) >= hdr.no_pack)
+    return common::RoughSetValue::RS_SOME;
 
+  auto &bf = bloom_buffers[pack];
+  if (bf.len == 0) {  // this pack no bloom filter data
     return common::RoughSetValue::RS_SOME;
+  }
+
+  // get filter data
+  Slice pack_block(bf.data, bf.len);
+  FilterBlockReader reader(bloom_filter_policy.get(), pack_block);
+  if (!reader.KeyMayMatch(0, key)) {
+    return common::RoughSetValue::RS_NONE;
+  }
+
+  return common::RoughSetValue::RS_SOME;
+}
+
+common::RoughSetValue RSIndex_Bloom::IsValue(types::BString min_v, types::BString max_v, int pack) {
+  if (min_v == max_v) {
+    return KeyMayMatch(Slice(max_v.val_, max_v.size()), pack);
   } else {
     return common::RoughSetValue::RS_SOME;
   }
 }
 
-void RSIndex_Bloom::Update(common::PACK_INDEX pi, DPN &dpn, const PackStr *pack) {
+common::RoughSetValue RSIndex_Bloom::IsValue(int64_t v, int pack) {
+  return KeyMayMatch(Slice(reinterpret_cast<const char *>(&v), sizeof(v)), pack);
+}
+
+void RSIndex_Bloom::Reserve(common::PACK_INDEX pi) {
   if (pi >= hdr.no_pack) {
     hdr.no_pack = pi + 1;
   }
 
   if (hdr.no_pack > capacity) {
+    size_t old_capacity = capacity;
     capacity += 1024;
     bloom_buffers =
         static_cast<BF *>(rc_realloc(bloom_buffers, capacity * sizeof(BF), mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+    for (size_t i = old_capacity; i < capacity; i++) bloom_buffers[i].len = 0;
     //  rclog << lock << "bloom filter capacity increased to " << capacity << system::unlock;
   }
+}
+
+void RSIndex_Bloom::Store(common::PACK_INDEX pi, const Slice &block) {
+  if (block.size() > sizeof(BF) - 4) {
+    TIANMU_LOG(LogCtl_Level::WARN, "Bloom len of pack:%d larger than expected", pi);
+    bloom_buffers[pi].len = 0;
+  } else {
+    bloom_buffers[pi].len = block.size();
+    std::memcpy(bloom_buffers[pi].data, block.data(), block.size());
+  }
+}
+
+void RSIndex_Bloom::Update(common::PACK_INDEX pi, DPN &dpn, const PackStr *pack) {
+  Reserve(pi);
 
   auto bloom_builder = std::make_unique<FilterBlockBuilder>(bloom_filter_policy.get());
 
@@ -106,15 +135,31 @@ void RSIndex_Bloom::Update(common::PACK_INDEX pi, DPN &dpn, const PackStr *pack)
     if (pack->NotNull(i))
       bloom_builder->AddKey(Slice(pack->GetValueBinary(i).ToString()));
 
-  Slice block = bloom_builder->Finish();
+  Store(pi, bloom_builder->Finish());
+}
 
-  if (block.size() > sizeof(BF) - 4) {
-    TIANMU_LOG(LogCtl_Level::WARN, "Bloom len of pack:%d larger than expected", pi);
+void RSIndex_Bloom::Update(common::PACK_INDEX pi, DPN &dpn, const PackInt *pack) {
+  Reserve(pi);
+
+  // a trivial pack holds a single value that min/max already describe
+  if (dpn.Trivial() || pack == nullptr) {
     bloom_buffers[pi].len = 0;
-  } else {
-    bloom_buffers[pi].len = block.size();
-    std::memcpy(bloom_buffers[pi].data, block.data(), block.size());
+    return;
   }
+
+  auto bloom_builder = std::make_unique<FilterBlockBuilder>(bloom_filter_policy.get());
+
+  bloom_builder->StartBlock(0);
+
+  // AddKey copies the key, so one buffer serves all rows
+  int64_t key;
+  for (size_t i = 0; i < dpn.numOfRecords; i++)
+    if (pack->NotNull(i)) {
+      key = pack->GetValInt(i) + dpn.min_i;
+      bloom_builder->AddKey(Slice(reinterpret_cast<const char *>(&key), sizeof(key)));
+    }
+
+  Store(pi, bloom_builder->Finish());
 }
 
 }  // namespace core
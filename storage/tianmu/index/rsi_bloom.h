@@ -26,6 +26,7 @@
 namespace Tianmu {
 namespace core {
 
+class PackInt;
 class PackStr;
 
 class RSIndex_Bloom final : public RSIndex {
@@ -35,7 +36,10 @@ class RSIndex_Bloom final : public RSIndex {
 
   void SaveToFile(common::TX_ID ver) override;
   void Update(common::PACK_INDEX pi, DPN &dpn, const PackStr *pack);
+  // numeric packs are keyed by their level-1 values (pack value + dpn.min_i)
+  void Update(common::PACK_INDEX pi, DPN &dpn, const PackInt *pack);
   common::RoughSetValue IsValue(types::BString min_v, types::BString max_v, int pack);
+  common::RoughSetValue IsValue(int64_t v, int pack);
 
  private:
   static const int FORMAT_VERSION = 2;
@@ -52,6 +56,10 @@ class RSIndex_Bloom final : public RSIndex {
     char data[64 * 1024 - sizeof(len)];
   };
 
+  void Reserve(common::PACK_INDEX pi);
+  void Store(common::PACK_INDEX pi, const Slice &block);
+  common::RoughSetValue KeyMayMatch(const Slice &key, int pack);
+
   BF *bloom_buffers = nullptr;
   size_t capacity = 0;
   std::unique_ptr<const FilterPolicy> bloom_filter_policy;
@@ -0,0 +1,174 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#include "index/rsi_hll.h"
+
+#include <cmath>
+#include <string_view>
+
+#include "data/pack_int.h"
+#include "data/pack_str.h"
+#include "system/tianmu_file.h"
+#include "system/tianmu_system.h"
+
+namespace Tianmu {
+namespace core {
+
+RSIndex_HLL::RSIndex_HLL(const fs::path &dir, common::TX_ID ver) {
+  m_path = dir / common::COL_FILTER_HLL_DIR;
+  auto fpath = dir / common::COL_FILTER_HLL_DIR / ver.ToString();
+
+  system::TianmuFile frs_index;
+
+  if (fs::exists(fpath)) {
+    frs_index.OpenReadOnly(fpath);
+    frs_index.ReadExact(&hdr, sizeof(hdr));
+    ASSERT(hdr.ver == FORMAT_VERSION, "bad distinct sketch format");
+    ASSERT(fs::file_size(fpath) == (sizeof(HDR) + hdr.no_pack * sizeof(SKETCH)),
+           "distinct sketch corrupted: " + fpath.string());
+  }
+
+  capacity = (hdr.no_pack / 1024 + 1) * 1024;
+  sketches = static_cast<SKETCH *>(alloc(capacity * sizeof(SKETCH), mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+  for (size_t i = hdr.no_pack; i < capacity; i++) sketches[i].valid = 0;
+
+  if (hdr.no_pack > 0) {
+    frs_index.ReadExact(sketches, hdr.no_pack * sizeof(SKETCH));
+  }
+}
+
+RSIndex_HLL::~RSIndex_HLL() { dealloc(sketches); }
+
+void RSIndex_HLL::SaveToFile(common::TX_ID ver) {
+  auto fpath = m_path / ver.ToString();
+  ASSERT(!fs::exists(fpath), "file already exists: " + fpath.string());
+
+  // tables created before the sketches existed have no directory for them
+  if (!fs::exists(m_path))
+    fs::create_directory(m_path);
+
+  system::TianmuFile frs_index;
+
+  frs_index.OpenCreate(fpath);
+  frs_index.WriteExact(&hdr, sizeof(hdr));
+  frs_index.WriteExact(sketches, hdr.no_pack * sizeof(SKETCH));
+
+  if (tianmu_sysvar_sync_buffers) {
+    frs_index.Flush();
+  }
+}
+
+RSIndex_HLL::SKETCH *RSIndex_HLL::Reserve(common::PACK_INDEX pi) {
+  if (pi >= hdr.no_pack) {
+    hdr.no_pack = pi + 1;
+  }
+
+  if (hdr.no_pack > capacity) {
+    size_t old_capacity = capacity;
+    capacity = (hdr.no_pack / 1024 + 1) * 1024;
+    sketches = static_cast<SKETCH *>(rc_realloc(sketches, capacity * sizeof(SKETCH), mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+    for (size_t i = old_capacity; i < capacity; i++) sketches[i].valid = 0;
+  }
+
+  SKETCH *s = &sketches[pi];
+  s->valid = 0;
+  std::memset(s->regs, 0, REGISTERS);
+  return s;
+}
+
+void RSIndex_HLL::Update(common::PACK_INDEX pi, DPN &dpn, const PackInt *pack) {
+  SKETCH *s = Reserve(pi);
+
+  if (pack == nullptr) {
+    // trivial packs: nulls only or one value
+    if (!dpn.NullOnly() && dpn.min_i == dpn.max_i)
+      Add(s->regs, Hash(dpn.min_i));
+    s->valid = dpn.NullOnly() || dpn.min_i == dpn.max_i;
+    return;
+  }
+
+  for (size_t i = 0; i < dpn.numOfRecords; i++) {
+    if (pack->IsNull(i) || (dpn.numOfDeleted > 0 && pack->IsDeleted(i)))
+      continue;
+    Add(s->regs, Hash(int64_t(pack->GetValInt(i) + dpn.min_i)));
+  }
+  s->valid = 1;
+}
+
+void RSIndex_HLL::Update(common::PACK_INDEX pi, DPN &dpn, const PackStr *pack) {
+  SKETCH *s = Reserve(pi);
+
+  if (pack == nullptr) {
+    s->valid = dpn.NullOnly();
+    return;
+  }
+
+  for (size_t i = 0; i < dpn.numOfRecords; i++) {
+    if (pack->IsNull(i) || (dpn.numOfDeleted > 0 && pack->IsDeleted(i)))
+      continue;
+    types::BString v = pack->GetValueBinary(i);
+    Add(s->regs, Hash(v.GetDataBytesPointer(), v.len_));
+  }
+  s->valid = 1;
+}
+
+bool RSIndex_HLL::Merge(int pack, uint8_t *regs) const {
+  if (pack < 0 || uint32_t(pack) >= hdr.no_pack || !sketches[pack].valid)
+    return false;
+  const uint8_t *src = sketches[pack].regs;
+  for (size_t i = 0; i < REGISTERS; i++) regs[i] = std::max(regs[i], src[i]);
+  return true;
+}
+
+// the finalizer of MurmurHash3, spreads close integers over all the bits
+uint64_t RSIndex_HLL::Hash(int64_t v) {
+  uint64_t h = uint64_t(v);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t RSIndex_HLL::Hash(const char *s, size_t len) {
+  return Hash(int64_t(std::hash<std::string_view>()(std::string_view(s, len))));
+}
+
+void RSIndex_HLL::Add(uint8_t *regs, uint64_t hash) {
+  size_t idx = hash >> (64 - PRECISION);
+  // leading zeros of the remaining bits plus one; the sentinel bit bounds it
+  uint8_t rank = __builtin_clzll((hash << PRECISION) | (1ULL << (PRECISION - 1))) + 1;
+  regs[idx] = std::max(regs[idx], rank);
+}
+
+double RSIndex_HLL::Estimate(const std::vector<uint8_t> &regs) {
+  const double m = REGISTERS;
+  double sum = 0;
+  size_t zeros = 0;
+  for (auto r : regs) {
+    sum += std::ldexp(1.0, -r);
+    zeros += (r == 0);
+  }
+  double e = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+  // small cardinalities: linear counting is more precise
+  if (e <= 2.5 * m && zeros > 0)
+    e = m * std::log(m / zeros);
+  return e;
+}
+
+}  // namespace core
+}  // namespace Tianmu
@@ -0,0 +1,78 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_CORE_RSI_HLL_H_
+#define TIANMU_CORE_RSI_HLL_H_
+#pragma once
+
+#include <vector>
+
+#include "common/common_definitions.h"
+#include "index/rsi_index.h"
+
+namespace Tianmu {
+namespace core {
+
+class PackInt;
+class PackStr;
+
+// Per-pack HyperLogLog sketch of the non-null values, merged at query time to
+// estimate COUNT(DISTINCT) without reading the packs. Numeric packs hash their
+// level-1 values, string packs the bytes (built for collations without UTF
+// conversions only, as equal values are then equal bytes).
+class RSIndex_HLL final : public RSIndex {
+ public:
+  static const int PRECISION = 10;  // standard error about 1.04 / sqrt(2^10) = 3.3%
+  static const size_t REGISTERS = 1 << PRECISION;
+
+  RSIndex_HLL(const fs::path &dir, common::TX_ID ver);
+  ~RSIndex_HLL();
+
+  void SaveToFile(common::TX_ID ver) override;
+  void Update(common::PACK_INDEX pi, DPN &dpn, const PackInt *pack);
+  void Update(common::PACK_INDEX pi, DPN &dpn, const PackStr *pack);
+
+  // max of the registers of the pack into `regs` (REGISTERS bytes), false if the pack has no sketch
+  bool Merge(int pack, uint8_t *regs) const;
+
+  static uint64_t Hash(int64_t v);
+  static uint64_t Hash(const char *s, size_t len);
+  static void Add(uint8_t *regs, uint64_t hash);
+  static double Estimate(const std::vector<uint8_t> &regs);
+
+ private:
+  static const int FORMAT_VERSION = 1;
+
+  struct HDR final {
+    int32_t ver = FORMAT_VERSION;
+    uint32_t no_pack;
+  } hdr{};
+
+  struct SKETCH final {
+    uint32_t valid;
+    uint8_t regs[REGISTERS];
+  };
+
+  SKETCH *Reserve(common::PACK_INDEX pi);
+
+  SKETCH *sketches = nullptr;
+  size_t capacity = 0;
+};
+
+}  // namespace core
+}  // namespace Tianmu
+
+#endif  // TIANMU_CORE_RSI_HLL_H_
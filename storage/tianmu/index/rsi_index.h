@@ -27,9 +27,11 @@
 namespace Tianmu {
 namespace core {
 enum class FilterType : int {
-  HIST,   // histogram
-  CMAP,   // character maps
-  BLOOM,  // bloom filter
+  HIST,      // histogram
+  CMAP,      // character maps
+  BLOOM,     // bloom filter
+  STRSTATS,  // long string min/max
+  HLL,       // distinct value sketches
 };
 
 class RSIndex : public mm::TraceableObject {
@@ -0,0 +1,212 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#include "index/rsi_strstats.h"
+
+#include <string_view>
+#include <unordered_set>
+
+#include "data/pack_str.h"
+#include "system/tianmu_file.h"
+#include "system/tianmu_system.h"
+
+namespace Tianmu {
+namespace core {
+
+namespace {
+// memcmp of the first min(v.len_, len) bytes of v and s
+int PrefixCompare(const types::BString &v, const char *s, size_t len) {
+  size_t n = std::min<size_t>(v.len_, len);
+  return n == 0 ? 0 : std::memcmp(v.GetDataBytesPointer(), s, n);
+}
+
+int BytesCompare(const char *a, size_t alen, const char *b, size_t blen) {
+  size_t n = std::min(alen, blen);
+  int c = n == 0 ? 0 : std::memcmp(a, b, n);
+  return c != 0 ? c : (alen < blen ? -1 : alen > blen);
+}
+
+int BytesCompare(const types::BString &a, const types::BString &b) {
+  return BytesCompare(a.GetDataBytesPointer(), a.len_, b.GetDataBytesPointer(), b.len_);
+}
+}  // namespace
+
+RSIndex_StrStats::RSIndex_StrStats(const fs::path &dir, common::TX_ID ver, uint len) {
+  m_path = dir / common::COL_FILTER_STRSTATS_DIR;
+  auto fpath = dir / common::COL_FILTER_STRSTATS_DIR / ver.ToString();
+
+  system::TianmuFile frs_index;
+
+  if (fs::exists(fpath)) {
+    frs_index.OpenReadOnly(fpath);
+    frs_index.ReadExact(&hdr, sizeof(hdr));
+    ASSERT(hdr.ver == FORMAT_VERSION, "bad string statistics format");
+    ASSERT(fs::file_size(fpath) == (sizeof(HDR) + hdr.no_pack * RecordSize()),
+           "string statistics corrupted: " + fpath.string());
+  } else {
+    hdr.len = len;
+  }
+
+  capacity = (hdr.no_pack / 1024 + 1) * 1024;
+  stats_buffers = static_cast<char *>(alloc(capacity * RecordSize(), mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+  for (size_t i = hdr.no_pack; i < capacity; i++) Record(i)->flags = 0;
+
+  if (hdr.no_pack > 0) {
+    frs_index.ReadExact(stats_buffers, hdr.no_pack * RecordSize());
+  }
+}
+
+RSIndex_StrStats::~RSIndex_StrStats() { dealloc(stats_buffers); }
+
+void RSIndex_StrStats::SaveToFile(common::TX_ID ver) {
+  auto fpath = m_path / ver.ToString();
+  ASSERT(!fs::exists(fpath), "file already exists: " + fpath.string());
+
+  // tables created before the statistics existed have no directory for them
+  if (!fs::exists(m_path))
+    fs::create_directory(m_path);
+
+  system::TianmuFile frs_index;
+
+  frs_index.OpenCreate(fpath);
+  frs_index.WriteExact(&hdr, sizeof(hdr));
+  frs_index.WriteExact(stats_buffers, hdr.no_pack * RecordSize());
+
+  if (tianmu_sysvar_sync_buffers) {
+    frs_index.Flush();
+  }
+}
+
+void RSIndex_StrStats::Reserve(common::PACK_INDEX pi) {
+  if (pi >= hdr.no_pack) {
+    hdr.no_pack = pi + 1;
+  }
+
+  if (hdr.no_pack > capacity) {
+    size_t old_capacity = capacity;
+    capacity += 1024;
+    stats_buffers =
+        static_cast<char *>(rc_realloc(stats_buffers, capacity * RecordSize(), mm::BLOCK_TYPE::BLOCK_TEMPORARY));
+    for (size_t i = old_capacity; i < capacity; i++) Record(i)->flags = 0;
+  }
+}
+
+void RSIndex_StrStats::Update(common::PACK_INDEX pi, DPN &dpn, const PackStr *pack) {
+  Reserve(pi);
+
+  STATS *s = Record(pi);
+  s->flags = 0;
+  if (pack == nullptr)
+    return;
+
+  types::BString min_v, max_v;
+  std::unordered_set<std::string_view> values;
+  values.reserve(dpn.numOfRecords);
+
+  for (size_t i = 0; i < dpn.numOfRecords; i++) {
+    if (pack->IsNull(i))
+      continue;
+    types::BString v = pack->GetValueBinary(i);
+    if (min_v.IsNull() || BytesCompare(v, min_v) < 0)
+      min_v = v;
+    if (max_v.IsNull() || BytesCompare(v, max_v) > 0)
+      max_v = v;
+    values.emplace(v.GetDataBytesPointer(), v.len_);
+  }
+
+  if (values.empty())
+    return;
+
+  char *min_buf = reinterpret_cast<char *>(s + 1);
+  char *max_buf = min_buf + hdr.len;
+  s->distinct = values.size();
+  s->min_len = std::min<size_t>(min_v.len_, hdr.len);
+  s->max_len = std::min<size_t>(max_v.len_, hdr.len);
+  if (s->min_len > 0)
+    std::memcpy(min_buf, min_v.GetDataBytesPointer(), s->min_len);
+  if (s->max_len > 0)
+    std::memcpy(max_buf, max_v.GetDataBytesPointer(), s->max_len);
+  s->flags = STATS_VALID;
+  if (s->min_len < min_v.len_)
+    s->flags |= MIN_TRUNCATED;
+  if (s->max_len < max_v.len_)
+    s->flags |= MAX_TRUNCATED;
+}
+
+const RSIndex_StrStats::STATS *RSIndex_StrStats::ValidRecord(int pack) const {
+  if (pack < 0 || uint32_t(pack) >= hdr.no_pack)
+    return nullptr;
+  const STATS *s = Record(pack);
+  return (s->flags & STATS_VALID) ? s : nullptr;
+}
+
+// A truncated min is a prefix of the real one, so it stays a lower bound.
+bool RSIndex_StrStats::BelowMin(const STATS *s, const types::BString &v) const {
+  int c = PrefixCompare(v, reinterpret_cast<const char *>(s + 1), s->min_len);
+  return c < 0 || (c == 0 && v.len_ < s->min_len);
+}
+
+// A truncated max only bounds values that differ from it within the stored bytes.
+bool RSIndex_StrStats::AboveMax(const STATS *s, const types::BString &v) const {
+  int c = PrefixCompare(v, reinterpret_cast<const char *>(s + 1) + hdr.len, s->max_len);
+  return c > 0 || (c == 0 && v.len_ > s->max_len && !(s->flags & MAX_TRUNCATED));
+}
+
+common::RoughSetValue RSIndex_StrStats::IsValue(const types::BString &min_v, const types::BString &max_v, int pack) {
+  const STATS *s = ValidRecord(pack);
+  if (s == nullptr)
+    return common::RoughSetValue::RS_SOME;
+
+  if ((max_v.val_ && BelowMin(s, max_v)) || (min_v.val_ && AboveMax(s, min_v)))
+    return common::RoughSetValue::RS_NONE;
+
+  // the whole pack is inside only if both ends are known exactly
+  if (!(s->flags & (MIN_TRUNCATED | MAX_TRUNCATED))) {
+    const char *min_buf = reinterpret_cast<const char *>(s + 1);
+    const char *max_buf = min_buf + hdr.len;
+    if ((min_v.val_ == nullptr ||
+         BytesCompare(min_buf, s->min_len, min_v.GetDataBytesPointer(), min_v.len_) >= 0) &&
+        (max_v.val_ == nullptr || BytesCompare(max_buf, s->max_len, max_v.GetDataBytesPointer(), max_v.len_) <= 0))
+      return common::RoughSetValue::RS_ALL;
+  }
+  return common::RoughSetValue::RS_SOME;
+}
+
+common::RoughSetValue RSIndex_StrStats::IsPrefix(const types::BString &prefix, int pack) {
+  const STATS *s = ValidRecord(pack);
+  if (s == nullptr || prefix.len_ == 0)
+    return common::RoughSetValue::RS_SOME;
+
+  const char *min_buf = reinterpret_cast<const char *>(s + 1);
+  const char *max_buf = min_buf + hdr.len;
+  // all strings starting with the prefix lie in [prefix, prefix + 0xFF...]
+  if (PrefixCompare(prefix, min_buf, s->min_len) < 0 || AboveMax(s, prefix))
+    return common::RoughSetValue::RS_NONE;
+
+  // min and max sharing the prefix means every value between them does
+  if (s->min_len >= prefix.len_ && s->max_len >= prefix.len_ && PrefixCompare(prefix, min_buf, prefix.len_) == 0 &&
+      PrefixCompare(prefix, max_buf, prefix.len_) == 0)
+    return common::RoughSetValue::RS_ALL;
+  return common::RoughSetValue::RS_SOME;
+}
+
+uint64_t RSIndex_StrStats::NumOfDistinct(int pack) {
+  const STATS *s = ValidRecord(pack);
+  return s == nullptr ? 0 : s->distinct;
+}
+
+}  // namespace core
+}  // namespace Tianmu
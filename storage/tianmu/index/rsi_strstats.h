@@ -0,0 +1,84 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_CORE_RSI_STRSTATS_H_
+#define TIANMU_CORE_RSI_STRSTATS_H_
+#pragma once
+
+#include "common/common_definitions.h"
+#include "index/rsi_index.h"
+#include "types/tianmu_data_types.h"
+
+namespace Tianmu {
+namespace core {
+
+class PackStr;
+
+// Per-pack min/max of string packs kept up to a configurable length (DPN only
+// has an 8-byte prefix), with the number of distinct values. Values compare
+// bytewise, so it is only built for collations without UTF conversions.
+class RSIndex_StrStats final : public RSIndex {
+ public:
+  // `len` is the stored min/max length for a new file; an existing one keeps its own
+  RSIndex_StrStats(const fs::path &dir, common::TX_ID ver, uint len);
+  ~RSIndex_StrStats();
+
+  void SaveToFile(common::TX_ID ver) override;
+  void Update(common::PACK_INDEX pi, DPN &dpn, const PackStr *pack);
+
+  // min_v/max_v with val_ == nullptr are open ends, as in BETWEEN encoded conditions
+  common::RoughSetValue IsValue(const types::BString &min_v, const types::BString &max_v, int pack);
+  // whether values of the pack start with `prefix`
+  common::RoughSetValue IsPrefix(const types::BString &prefix, int pack);
+  // distinct non-null values of the pack, 0 if unknown
+  uint64_t NumOfDistinct(int pack);
+
+ private:
+  static const int FORMAT_VERSION = 1;
+
+  enum : uint8_t { STATS_VALID = 1, MIN_TRUNCATED = 2, MAX_TRUNCATED = 4 };
+
+  struct HDR final {
+    int32_t ver = FORMAT_VERSION;
+    uint32_t no_pack;
+    uint32_t len;  // bytes of min and of max stored per pack
+  } hdr{};
+
+  // followed by hdr.len bytes of min and hdr.len bytes of max
+  struct STATS final {
+    uint32_t distinct;
+    uint16_t min_len;
+    uint16_t max_len;
+    uint8_t flags;
+  };
+
+  size_t RecordSize() const { return sizeof(STATS) + (2 * hdr.len + 3) / 4 * 4; }
+  STATS *Record(size_t pack) const { return reinterpret_cast<STATS *>(stats_buffers + pack * RecordSize()); }
+  const STATS *ValidRecord(int pack) const;
+  void Reserve(common::PACK_INDEX pi);
+
+  // v below the pack minimum / above the pack maximum for sure
+  bool BelowMin(const STATS *s, const types::BString &v) const;
+  bool AboveMax(const STATS *s, const types::BString &v) const;
+
+  char *stats_buffers = nullptr;
+  size_t capacity = 0;
+};
+
+}  // namespace core
+}  // namespace Tianmu
+
+#endif  // TIANMU_CORE_RSI_STRSTATS_H_
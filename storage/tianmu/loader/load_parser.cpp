@@ -19,14 +19,19 @@
 
 #include "binlog.h"
 #include "core/engine.h"
+#include "core/transaction.h"
 #include "loader/value_cache.h"
 #include "log_event.h"
+#include "system/configuration.h"
 #include "system/io_parameters.h"
 #include "util/timer.h"
 #include "vc/tianmu_attr.h"
 
 namespace Tianmu {
 namespace loader {
+// a smaller block is not worth splitting among the loader threads
+constexpr size_t kMinParallelParseRows = 1024;
+
 LoadParser::LoadParser(TianmuAttrPtrVect_t &attrs, const system::IOParameters &iop, uint packsize,
                        std::unique_ptr<system::Stream> &f)
     : attrs_(attrs),
@@ -85,9 +90,14 @@ uint LoadParser::GetPackrow(uint no_of_rows, std::vector<ValueCache> &value_buff
     [[maybe_unused]] int err = thd->binlog_write_table_map(table, has_trans, need_binlog_rows_query);
   }
 
+  // the row binlog events are built from the table record, which only the serial parsing fills
+  if (!parallel_parse_)
+    parallel_parse_ =
+        tianmu_sysvar_load_parallel_parse && !need_rows_binlog && strategy_->ParallelParseAllowed(cur_ptr_, buf_end_);
+
   uint no_of_rows_returned;
   for (no_of_rows_returned = 0; no_of_rows_returned < no_of_rows; no_of_rows_returned++) {
-    if (!MakeRow(value_buffers))
+    if (!(*parallel_parse_ ? MakeRowInParallel(value_buffers) : MakeRow(value_buffers)))
       break;
     /* write row after one row is ready */
     if (need_rows_binlog)
@@ -138,59 +148,175 @@ bool LoadParser::MakeRow(std::vector<ValueCache> &value_buffers) {
         cont = false;
         break;
 
-      case ParsingStrategy::ParseResult::OK: {
-        bool make_value_ok{true};
-        for (uint att = 0; make_value_ok && att < attrs_.size(); ++att)
-          if (!MakeValue(att, value_buffers[att])) {
-            rejecter_.ConsumeBadRow(cur_ptr_, rowsize, cur_row_ + 1, att + 1);
-            make_value_ok = false;
-          }
+      case ParsingStrategy::ParseResult::OK:
+        if (CommitRow(value_buffers, rowsize))
+          return true;
+        break;
+    }
+  }
 
-        cur_ptr_ += rowsize;
-        cur_row_++;
+  return false;
+}
 
-        if (!make_value_ok)
-          break;
+// Completes a parsed row. Returns false if the row is rejected, skipped or a duplicate.
+bool LoadParser::CommitRow(std::vector<ValueCache> &value_buffers, uint rowsize) {
+  // the warnings found by a loader thread, where GetOneRow() would raise them
+  THD *thd = io_param_.GetTHD();
+  for (auto &warning : row_warnings_)
+    if (thd->count_cuted_fields) {
+      thd->cuted_fields++;
+      push_warning_printf(thd, Sql_condition::SL_WARNING, warning.code, ER(warning.code), warning.field_name,
+                          thd->get_stmt_da()->current_row_for_condition());
+    }
+  row_warnings_.clear();
 
-        for (uint att = 0; att < attrs_.size(); ++att) {
-          value_buffers[att].Commit();
-        }
+  bool make_value_ok{true};
+  for (uint att = 0; make_value_ok && att < attrs_.size(); ++att)
+    if (!MakeValue(att, value_buffers[att])) {
+      rejecter_.ConsumeBadRow(cur_ptr_, rowsize, cur_row_ + 1, att + 1);
+      make_value_ok = false;
+    }
 
-        num_of_row_++;
-        io_param_.GetTHD()->get_stmt_da()->inc_current_row_for_condition();
-        if (num_of_skip_ < io_param_.GetSkipLines()) /*check skip lines */
-        {
-          // does not load this line,continue to get next line
-          num_of_skip_++;
-          num_of_row_--;
-          for (uint att = 0; att < attrs_.size(); ++att) {
-            value_buffers[att].Rollback();
-
-            auto &attr(attrs_[att]);
-            attr->RollBackIfAutoInc();
-          }
-          break;
-        } else if (tab_index_ != nullptr) { /* check duplicate */
-          if (HA_ERR_FOUND_DUPP_KEY == ProcessInsertIndex(tab_index_, value_buffers, num_of_row_ - 1)) {
-            // dose not load this line, continue to get next line
-            num_of_row_--;
-            num_of_dup_++;
-            for (uint att = 0; att < attrs_.size(); ++att) {
-              value_buffers[att].Rollback();
-
-              auto &attr(attrs_[att]);
-              attr->RollBackIfAutoInc();
-            }
-            break;
-          }
-        }
+  cur_ptr_ += rowsize;
+  cur_row_++;
 
-        return true;
+  if (!make_value_ok)
+    return false;
+
+  for (uint att = 0; att < attrs_.size(); ++att) {
+    value_buffers[att].Commit();
+  }
+
+  num_of_row_++;
+  io_param_.GetTHD()->get_stmt_da()->inc_current_row_for_condition();
+  if (num_of_skip_ < io_param_.GetSkipLines()) /*check skip lines */
+  {
+    // does not load this line,continue to get next line
+    num_of_skip_++;
+    num_of_row_--;
+    for (uint att = 0; att < attrs_.size(); ++att) {
+      value_buffers[att].Rollback();
+
+      auto &attr(attrs_[att]);
+      attr->RollBackIfAutoInc();
+    }
+    return false;
+  } else if (tab_index_ != nullptr) { /* check duplicate */
+    if (HA_ERR_FOUND_DUPP_KEY == ProcessInsertIndex(tab_index_, value_buffers, num_of_row_ - 1)) {
+      // dose not load this line, continue to get next line
+      num_of_row_--;
+      num_of_dup_++;
+      for (uint att = 0; att < attrs_.size(); ++att) {
+        value_buffers[att].Rollback();
+
+        auto &attr(attrs_[att]);
+        attr->RollBackIfAutoInc();
       }
+      return false;
     }
   }
 
-  return false;
+  return true;
+}
+
+// The complete rows of the current block are parsed by the loader threads in chunks
+// and taken from there in order. The incomplete row at the end of the block is left to
+// MakeRow(), which also fetches the next block.
+bool LoadParser::MakeRowInParallel(std::vector<ValueCache> &value_buffers) {
+  while (true) {
+    if (chunk_no_ < parsed_chunks_.size()) {
+      if (StitchRow(value_buffers))
+        return true;
+    } else if (!ParseInParallel()) {
+      return MakeRow(value_buffers);
+    }
+  }
+}
+
+bool LoadParser::ParseInParallel() {
+  parsed_chunks_.clear();
+  chunk_no_ = 0;
+  chunk_row_ = 0;
+
+  std::vector<uint> row_sizes;
+  strategy_->SplitRows(cur_ptr_, buf_end_, row_sizes);
+  if (row_sizes.empty())
+    return false;
+
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  assert(eng);
+
+  size_t no_chunks = std::min(eng->load_thread_pool.size(), row_sizes.size() / kMinParallelParseRows);
+  if (no_chunks == 0)
+    no_chunks = 1;
+  parsed_chunks_.resize(no_chunks);
+
+  utils::result_set<void> res;
+  const char *chunk_start = cur_ptr_;
+  size_t first_row = 0;
+  for (size_t i = 0; i < no_chunks; ++i) {
+    size_t end_row = row_sizes.size() * (i + 1) / no_chunks;
+    auto &chunk = parsed_chunks_[i];
+    chunk.row_sizes.assign(row_sizes.begin() + first_row, row_sizes.begin() + end_row);
+    size_t chunk_size = 0;
+    for (auto size : chunk.row_sizes) chunk_size += size;
+
+    // no reallocation of 'values' later, ValueCache does not move safely
+    chunk.values.reserve(attrs_.size());
+    for (uint att = 0; att < attrs_.size(); att++)
+      chunk.values.emplace_back(chunk.row_sizes.size(), chunk.row_sizes.size() * sizeof(int64_t) + 512);
+
+    res.insert(eng->load_thread_pool.add_task(&LoadParser::ParseChunk, this, chunk_start, &chunk, current_txn_));
+    chunk_start += chunk_size;
+    first_row = end_row;
+  }
+  res.get_all_with_except();
+  return true;
+}
+
+void LoadParser::ParseChunk(const char *buf, ParsedChunk *chunk, core::Transaction *txn) {
+  common::SetMySQLTHD(txn->Thd());
+  current_txn_ = txn;
+  strategy_->ParseRows(buf, chunk->row_sizes, chunk->values, chunk->serial, chunk->warnings);
+}
+
+// Takes the next parsed row into value_buffers, it starts at cur_ptr_.
+bool LoadParser::StitchRow(std::vector<ValueCache> &value_buffers) {
+  auto &chunk = parsed_chunks_[chunk_no_];
+  size_t row = chunk_row_;
+  uint rowsize = chunk.row_sizes[row];
+  if (++chunk_row_ == chunk.row_sizes.size()) {
+    chunk_no_++;
+    chunk_row_ = 0;
+  }
+
+  if (chunk.serial[row]) {
+    uint parsed_size = 0;
+    int errorinfo = -1;
+    if (strategy_->GetOneRow(cur_ptr_, rowsize, value_buffers, parsed_size, errorinfo) ==
+        ParsingStrategy::ParseResult::OK)
+      return CommitRow(value_buffers, rowsize);
+
+    rejecter_.ConsumeBadRow(cur_ptr_, rowsize, cur_row_ + 1, errorinfo + 1);
+    cur_ptr_ += rowsize;
+    cur_row_++;
+    return false;
+  }
+
+  for (uint att = 0; att < attrs_.size(); ++att) {
+    auto &value = chunk.values[att];
+    if (value.IsNull(row)) {
+      value_buffers[att].ExpectedNull(true);
+      continue;
+    }
+    size_t size = value.Size(row);
+    std::memcpy(value_buffers[att].Prepare(size), value.GetDataBytesPointer(row), size);
+    value_buffers[att].ExpectedSize(size);
+  }
+  for (; chunk.next_warning < chunk.warnings.size() && chunk.warnings[chunk.next_warning].row == row;
+       ++chunk.next_warning)
+    row_warnings_.push_back(chunk.warnings[chunk.next_warning]);
+  return CommitRow(value_buffers, rowsize);
 }
 
 bool LoadParser::MakeValue(uint att, ValueCache &buffer) {
@@ -18,6 +18,7 @@
 #define TIANMU_LOADER_LOAD_PARSER_H_
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include "loader/parsing_strategy.h"
@@ -30,6 +31,7 @@ namespace Tianmu {
 
 namespace core {
 class TianmuAttr;
+class Transaction;
 }
 namespace index {
 class TianmuTableIndex;
@@ -57,6 +59,15 @@ class LoadParser final {
   int64_t GetIgnoreRow() const { return num_of_skip_; }
 
  private:
+  // Rows of a block parsed by one loader thread, see ParsingStrategy::ParseRows()
+  struct ParsedChunk {
+    std::vector<uint> row_sizes;
+    std::vector<char> serial;
+    std::vector<ValueCache> values;
+    std::vector<ParsingStrategy::RowWarning> warnings;
+    size_t next_warning = 0;
+  };
+
   TianmuAttrPtrVect_t &attrs_;
 
   std::vector<int64_t> last_pack_size_;
@@ -78,8 +89,19 @@ class LoadParser final {
   int64_t num_of_dup_ = 0;
   int64_t num_of_skip_ = 0;
 
+  std::optional<bool> parallel_parse_;
+  std::vector<ParsedChunk> parsed_chunks_;
+  size_t chunk_no_ = 0;
+  size_t chunk_row_ = 0;
+  std::vector<ParsingStrategy::RowWarning> row_warnings_;  // of the row StitchRow() passes to CommitRow()
+
   bool MakeRow(std::vector<ValueCache> &value_buffers);
   bool MakeValue(uint col, ValueCache &buffer);
+  bool CommitRow(std::vector<ValueCache> &value_buffers, uint rowsize);
+  bool MakeRowInParallel(std::vector<ValueCache> &value_buffers);
+  bool ParseInParallel();
+  void ParseChunk(const char *buf, ParsedChunk *chunk, core::Transaction *txn);
+  bool StitchRow(std::vector<ValueCache> &value_buffers);
   int binlog_loaded_block(const char *buf_start, const char *buf_end);
 };
 }  // namespace loader
@@ -20,6 +20,10 @@
 #include <limits>
 #include <map>
 #include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "core/transaction.h"
 #include "item_timefunc.h"
 #include "loader/value_cache.h"
@@ -177,6 +181,28 @@ inline bool ParsingStrategy::SearchUnescapedPattern(const char *&ptr, const char
   return (ptr < search_end);
 }
 
+// Skips the bytes equal to none of c1..c4, i.e. those the scalar search loops just step over,
+// 16 at a time.
+static inline const char *SkipOrdinaryBytes(const char *ptr, const char *const end, char c1, char c2, char c3,
+                                            char c4) {
+#if defined(__SSE2__)
+  const __m128i v1 = _mm_set1_epi8(c1);
+  const __m128i v2 = _mm_set1_epi8(c2);
+  const __m128i v3 = _mm_set1_epi8(c3);
+  const __m128i v4 = _mm_set1_epi8(c4);
+  while (ptr + 16 <= end) {
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(data, v1), _mm_cmpeq_epi8(data, v2)),
+                              _mm_or_si128(_mm_cmpeq_epi8(data, v3), _mm_cmpeq_epi8(data, v4)));
+    int bits = _mm_movemask_epi8(eq);
+    if (bits)
+      return ptr + __builtin_ctz(bits);
+    ptr += 16;
+  }
+#endif
+  return ptr;
+}
+
 inline bool TailsMatch(const char *s1, const char *s2, const size_t size) {
   uint i = 1;
   while (i < size && s1[i] == s2[i]) i++;
@@ -195,6 +221,7 @@ inline ParsingStrategy::SearchResult ParsingStrategy::SearchUnescapedPatternNoEO
   const char *search_end = buf_end;
 
   if (size == 1) {
+    ptr = SkipOrdinaryBytes(ptr, search_end, escape_char_, string_qualifier_, *c_pattern, *c_eol);
     while (ptr < search_end && *ptr != *c_pattern) {
       if (escape_char_ && *ptr == escape_char_)
         ptr += 2;
@@ -203,10 +230,11 @@ inline ParsingStrategy::SearchResult ParsingStrategy::SearchUnescapedPatternNoEO
       else if (*ptr == *c_eol && ptr + crlf <= buf_end && TailsMatch(ptr, c_eol, crlf))
         return SearchResult::END_OF_LINE;
       else
-        ++ptr;
+        ptr = SkipOrdinaryBytes(ptr + 1, search_end, escape_char_, string_qualifier_, *c_pattern, *c_eol);
     }
   } else if (size == 2) {
     --search_end;
+    ptr = SkipOrdinaryBytes(ptr, search_end, escape_char_, string_qualifier_, *c_pattern, *c_eol);
     while (ptr < search_end && (*ptr != *c_pattern || ptr[1] != c_pattern[1])) {
       if (escape_char_ && *ptr == escape_char_)
         ptr += 2;
@@ -215,7 +243,7 @@ inline ParsingStrategy::SearchResult ParsingStrategy::SearchUnescapedPatternNoEO
       else if (*ptr == *c_eol && ptr + crlf <= buf_end && TailsMatch(ptr, c_eol, crlf))
         return SearchResult::END_OF_LINE;
       else
-        ++ptr;
+        ptr = SkipOrdinaryBytes(ptr + 1, search_end, escape_char_, string_qualifier_, *c_pattern, *c_eol);
     }
   } else {
     int b = 0;
@@ -597,7 +625,7 @@ ParsingStrategy::ParseResult ParsingStrategy::GetOneRow(const char *const buf, s
   // step4,row is completed, to make the whole row
   for (uint col = 0; col < attr_infos_.size(); ++col) {
     auto &ptr_field = vec_ptr_field[col];
-    GetValue(ptr_field.first, ptr_field.second, col, record[col]);
+    GetValue(ptr_field.first, ptr_field.second, col, record[col], temp_buf_);
   }
 
 end:
@@ -612,6 +640,194 @@ end:
   return !row_data_error ? ParseResult::OK : ParseResult::ERROR;
 }
 
+bool ParsingStrategy::ParallelParseAllowed(const char *const buf, const char *const buf_end) {
+  if (!prepared_) {
+    GetEOL(buf, buf_end);
+    prepared_ = true;
+  }
+
+  if (!thd_->lex->load_update_list.is_empty())
+    return false;
+
+  // the row and field ends are searched without the enclosure/escape context of a whole row
+  auto has_special_char = [this](const std::string &pattern) {
+    return (escape_char_ && pattern.find(escape_char_) != std::string::npos) ||
+           (string_qualifier_ && pattern.find(char(string_qualifier_)) != std::string::npos);
+  };
+  if (delimiter_.empty() || has_special_char(delimiter_) || has_special_char(terminator_))
+    return false;
+
+  field_cols_.clear();
+  std::vector<bool> used(table_->s->fields, false);
+  List_iterator_fast<Item> it(thd_->lex->load_field_list);
+  Item *item{nullptr};
+  while ((item = it++)) {
+    Item *real_item = item->real_item();
+    if (real_item->type() != Item::FIELD_ITEM)
+      return false;
+    uint col = ((Item_field *)real_item)->field->field_index;
+    if (col >= used.size() || used[col])
+      return false;
+    used[col] = true;
+    field_cols_.push_back(col);
+  }
+  // the columns missing in the list take their default values in GetOneRow()
+  if (field_cols_.size() != attr_infos_.size())
+    return false;
+
+  not_null_cols_.resize(attr_infos_.size());
+  for (uint col = 0; col < attr_infos_.size(); ++col) not_null_cols_[col] = !table_->field[col]->real_maybe_null();
+  return true;
+}
+
+// Finds the fields of the row starting at buf the same way as GetOneRow(), i.e. the
+// pair <value begin, value end> with the enclosing chars of each field.
+// Returns false if the row is not complete in the buffer.
+bool ParsingStrategy::ScanRow(const char *const buf, const char *const buf_end,
+                              std::vector<std::pair<const char *, const char *>> *fields, uint &rowsize,
+                              bool &too_many) {
+  const char *ptr = buf;
+  for (size_t i = 0; i < field_cols_.size(); ++i) {
+    const char *val_beg = ptr;
+    bool enclosed_column = string_qualifier_ && ptr < buf_end && *ptr == string_qualifier_;
+    if (enclosed_column)
+      ++ptr;
+    SearchResult res = SearchUnescapedPatternNoEOL(ptr, buf_end, enclosed_column ? enclose_delimiter_ : delimiter_,
+                                                   enclosed_column ? enclose_terminator_ : terminator_,
+                                                   enclosed_column ? kmp_next_enclose_delimiter_ : kmp_next_delimiter_);
+    if (res == SearchResult::END_OF_BUFFER)
+      return false;
+    if (enclosed_column)
+      ++ptr;
+    if (fields)
+      fields->emplace_back(val_beg, ptr);
+    if (res == SearchResult::END_OF_LINE)
+      break;
+    ptr += delimiter_.size();
+  }
+
+  const char *orig_ptr = ptr;
+  if (SearchUnescapedPatternNoEOL(ptr, buf_end, terminator_, terminator_, kmp_next_terminator_) ==
+      SearchResult::END_OF_BUFFER)
+    return false;
+  too_many = (orig_ptr != ptr);
+  ptr += terminator_.size();
+  rowsize = uint(ptr - buf);
+  return true;
+}
+
+void ParsingStrategy::SplitRows(const char *const buf, const char *const buf_end, std::vector<uint> &row_sizes) {
+  uint rowsize = 0;
+  bool too_many = false;
+  for (const char *ptr = buf; ptr < buf_end && ScanRow(ptr, buf_end, nullptr, rowsize, too_many); ptr += rowsize)
+    row_sizes.push_back(rowsize);
+}
+
+void ParsingStrategy::ParseRows(const char *buf, const std::vector<uint> &row_sizes, std::vector<ValueCache> &values,
+                                std::vector<char> &serial, std::vector<RowWarning> &warnings) {
+  const char *buf_end = buf;
+  for (auto size : row_sizes) buf_end += size;
+
+  std::vector<std::pair<const char *, const char *>> fields;
+  fields.reserve(field_cols_.size());
+  std::vector<char> temp_buf(temp_buf_.size());
+  serial.reserve(row_sizes.size());
+  for (auto row_size : row_sizes) {
+    fields.clear();
+    uint rowsize = 0;
+    bool too_many = false;
+    bool ok = !thd_->killed && ScanRow(buf, buf_end, &fields, rowsize, too_many) && !too_many &&
+              fields.size() == field_cols_.size();
+    size_t row_warnings = warnings.size();
+    for (size_t i = 0; ok && i < fields.size(); ++i) {
+      uint warning = 0;
+      ok = ParseField(fields[i].first, fields[i].second, field_cols_[i], values[field_cols_[i]], temp_buf, warning);
+      if (ok && warning)
+        warnings.push_back({uint(serial.size()), warning, table_->field[field_cols_[i]]->field_name});
+    }
+    if (!ok)  // GetOneRow() raises them again
+      warnings.resize(row_warnings);
+
+    for (auto &value : values) {
+      if (!ok) {
+        value.ExpectedSize(0);
+        value.ExpectedNull(true);
+      }
+      value.Commit();
+    }
+    serial.push_back(!ok);
+    buf += row_size;
+  }
+}
+
+// The part of ReadField() and GetValue() which does not need THD. Returns false if
+// the value has to be parsed by GetOneRow(). 'warning' is set to the code of the
+// warning Field::store() raises for the value, if any.
+bool ParsingStrategy::ParseField(const char *val_beg, const char *val_end, uint col, ValueCache &value,
+                                 std::vector<char> &temp_buf, uint &warning) {
+  bool is_enclosed = false;
+  const char *val_start = val_beg;
+  size_t val_len = val_end - val_beg;
+  if (string_qualifier_ && *val_beg == string_qualifier_) {
+    ++val_start;
+    val_len -= 2;
+    is_enclosed = true;
+  }
+
+  bool isnull = false;
+  switch (val_len) {
+    case 0:
+      if (!is_enclosed)
+        isnull = true;
+      break;
+    case 2:
+      if (*val_start == '\\' && (val_start[1] == 'N' || (!is_enclosed && val_start[1] == 'n')))
+        isnull = true;
+      break;
+    case 4:
+      if (string_qualifier_ && !is_enclosed && strncasecmp(val_start, "nullptr", 4) == 0)
+        isnull = true;
+      break;
+    default:
+      break;
+  }
+
+  if (isnull) {
+    if (not_null_cols_[col])
+      return false;
+    value.ExpectedNull(true);
+    return true;
+  }
+
+  // truncation is reported as a warning
+  if (core::ATI::IsTxtType(GetATI(col).Type()) && GetATI(col).Precision() < static_cast<uint>(val_len))
+    return false;
+
+  common::ErrorCode parse_code = common::ErrorCode::SUCCESS;
+  try {
+    GetValue(val_start, val_len, col, value, temp_buf, &parse_code);
+  } catch (common::Exception &) {
+    return false;
+  }
+
+  switch (parse_code) {
+    case common::ErrorCode::SUCCESS:
+      break;
+    case common::ErrorCode::OUT_OF_RANGE:
+      warning = ER_WARN_DATA_OUT_OF_RANGE;
+      break;
+    case common::ErrorCode::VALUE_TRUNCATED:
+      warning = WARN_DATA_TRUNCATED;
+      break;
+    default:
+      return false;
+  }
+  // the messages of the temporal types quote the value, let Field::store() raise them
+  if (warning && core::ATI::IsDateTimeType(GetATI(col).Type()))
+    return false;
+  return true;
+}
+
 char TranslateEscapedChar(char c) {
   static char in[] = {'0', 'b', 'n', 'r', 't', char(26)};
   static char out[] = {'\0', '\b', '\n', '\r', '\t', char(26)};
@@ -622,7 +838,8 @@ char TranslateEscapedChar(char c) {
   return c;
 }
 
-void ParsingStrategy::GetValue(const char *value_ptr, size_t value_size, ushort col, ValueCache &buffer) {
+void ParsingStrategy::GetValue(const char *value_ptr, size_t value_size, ushort col, ValueCache &buffer,
+                               std::vector<char> &temp_buf, common::ErrorCode *parse_code) {
   core::AttributeTypeInfo &ati = GetATI(col);
 
   // check for null
@@ -693,9 +910,9 @@ void ParsingStrategy::GetValue(const char *value_ptr, size_t value_size, ushort
       if (ati.CharsetInfo()->mbmaxlen <= charset_info_->mbmaxlen)
         new_size = copy_and_convert(buf, reserved, ati.CharsetInfo(), buf, new_size, charset_info_, &errors);
       else {
-        if (new_size > temp_buf_.size())
-          temp_buf_.resize(new_size);
-        char *tmpbuf = &temp_buf_[0];
+        if (new_size > temp_buf.size())
+          temp_buf.resize(new_size);
+        char *tmpbuf = &temp_buf[0];
         std::memcpy(tmpbuf, buf, new_size);
         new_size = copy_and_convert(buf, reserved, ati.CharsetInfo(), tmpbuf, new_size, charset_info_, &errors);
       }
@@ -712,9 +929,11 @@ void ParsingStrategy::GetValue(const char *value_ptr, size_t value_size, ushort
     types::BString tmp_string(value_ptr, value_size);
     // reaching here, the parsing function should not be null
     auto function = types::ValueParserForText::GetParsingFuntion(ati);
-    if (function(tmp_string, *reinterpret_cast<int64_t *>(buffer.Prepare(sizeof(int64_t)))) ==
-        common::ErrorCode::FAILED)
+    common::ErrorCode code = function(tmp_string, *reinterpret_cast<int64_t *>(buffer.Prepare(sizeof(int64_t))));
+    if (code == common::ErrorCode::FAILED)
       throw common::FormatException(0, col);  // TODO: throw appropriate exception
+    if (parse_code)
+      *parse_code = code;
     buffer.ExpectedSize(sizeof(int64_t));
   }
 }
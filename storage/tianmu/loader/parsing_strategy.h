@@ -41,6 +41,25 @@ class ParsingStrategy final {
   void SetTHD(THD *thd) { thd_ = thd; }
   THD *GetTHD() const { return thd_; };
 
+  // A warning Field::store() raises in GetOneRow() for a numeric value out of range or
+  // truncated, found by ParseRows() and raised when the row is committed.
+  struct RowWarning {
+    uint row;  // within the rows passed to ParseRows()
+    uint code;
+    const char *field_name;
+  };
+
+  // Parallel parsing: SplitRows() locates the complete rows of a block, ParseRows() converts
+  // a range of them and may run on several threads at once. It is possible only for a plain
+  // column list (no SET clause, no user variables). Rows ParseRows() can not handle without
+  // THD (NULL into NOT NULL, wrong number of fields, text truncation, errors) are marked in
+  // 'serial' and have to be passed to GetOneRow(). The warnings of the other rows are listed
+  // in 'warnings' in row order.
+  bool ParallelParseAllowed(const char *const buf, const char *const buf_end);
+  void SplitRows(const char *const buf, const char *const buf_end, std::vector<uint> &row_sizes);
+  void ParseRows(const char *buf, const std::vector<uint> &row_sizes, std::vector<ValueCache> &values,
+                 std::vector<char> &serial, std::vector<RowWarning> &warnings);
+
  protected:
   core::AttributeTypeInfo &GetATI(ushort col) { return attr_infos_[col]; }
 
@@ -72,6 +91,9 @@ class ParsingStrategy final {
   std::vector<uint> vec_field_num_to_index_;  // calculate the order number of the assignment fields and set fields
   std::map<std::string, uint> map_field_name_to_index_;  // field name to the table column index;
 
+  std::vector<uint> field_cols_;    // table column of each field of a row, for parallel parsing
+  std::vector<bool> not_null_cols_;
+
   void GuessUnescapedEOL(const char *ptr, const char *buf_end);
   void GuessUnescapedEOLWithEnclose(const char *ptr, const char *const buf_end);
 
@@ -82,7 +104,13 @@ class ParsingStrategy final {
                                            const std::string &line_termination, const std::vector<int> &kmp_next);
 
   void GetEOL(const char *const buf, const char *const buf_end);
-  void GetValue(const char *const value_ptr, size_t value_size, ushort col, ValueCache &value);
+  void GetValue(const char *const value_ptr, size_t value_size, ushort col, ValueCache &value,
+                std::vector<char> &temp_buf, common::ErrorCode *parse_code = nullptr);
+
+  bool ScanRow(const char *const buf, const char *const buf_end,
+               std::vector<std::pair<const char *, const char *>> *fields, uint &rowsize, bool &too_many);
+  bool ParseField(const char *val_beg, const char *val_end, uint col, ValueCache &value, std::vector<char> &temp_buf,
+                  uint &warning);
 };
 
 }  // namespace loader
@@ -38,6 +38,7 @@
 #include "mm/memory_statistics.h"
 #include "mm/sys_heap_policy.h"
 #include "mm/tcm_heap_policy.h"
+#include "mm/thread_cache.h"
 #include "mm/traceable_object.h"
 #include "system/fet.h"
 #include "system/tianmu_system.h"
@@ -46,6 +47,30 @@
 namespace Tianmu {
 namespace mm {
 
+// Counter changes are added to the shared counters after that many operations of a thread
+static constexpr unsigned kStatsBatch = 64;
+
+struct MemoryHandling::ThreadState {
+  std::mutex mutex;  // guards the cache, the manager empties the caches of all threads
+  ThreadCache cache;
+  std::atomic<MemoryHandling *> registered{nullptr};  // the manager whose blocks are cached
+  unsigned long stats[NUM_STATS] = {};
+  unsigned ops = 0;
+
+  ~ThreadState() {
+    // a pool thread may outlive the memory manager at shutdown
+    MemoryHandling *mh = live_.load();
+    if (mh == nullptr)
+      return;
+    if (registered.load() == mh)
+      mh->ForgetThreadCache(*this);
+    mh->FlushStats(*this);
+  }
+};
+
+thread_local MemoryHandling::ThreadState MemoryHandling::tls_state_;
+std::atomic<MemoryHandling *> MemoryHandling::live_{nullptr};
+
 unsigned long long MemoryHandling::getReleaseCount1() { return _releasePolicy->getCount1(); }
 
 unsigned long long MemoryHandling::getReleaseCount2() { return _releasePolicy->getCount2(); }
@@ -57,20 +82,7 @@ unsigned long long MemoryHandling::getReleaseCount4() { return _releasePolicy->g
 unsigned long long MemoryHandling::getReloaded() { return _releasePolicy->getReloaded(); }
 
 MemoryHandling::MemoryHandling([[maybe_unused]] size_t comp_heap_size, size_t uncomp_heap_size, std::string hugedir,
-                               [[maybe_unused]] core::DataCache *d, size_t hugesize)
-    : m_alloc_blocks(0),
-      m_alloc_objs(0),
-      m_alloc_size(0),
-      m_alloc_pack(0),
-      m_alloc_temp(0),
-      m_free_blocks(0),
-      m_alloc_temp_size(0),
-      m_alloc_pack_size(0),
-      m_free_pack(0),
-      m_free_temp(0),
-      m_free_pack_size(0),
-      m_free_temp_size(0),
-      m_free_size(0) {
+                               [[maybe_unused]] core::DataCache *d, size_t hugesize) {
   int64_t adj_mh_size, lt_size;
   std::string conf_error;
   std::string rpolicy = tianmu_sysvar_mm_releasepolicy;
@@ -126,9 +138,6 @@ MemoryHandling::MemoryHandling([[maybe_unused]] size_t comp_heap_size, size_t un
 
   tcm::_span_allocator.Init();
   main_heap_MB = int(adj_mh_size >> 20);
-  // set this large enough to get a low number of collisions
-  // m_objs.resize(main_heap_MB);
-  m_objs.clear();
 
   // rccontrol << lock << "Release Policy: " << rpolicy << unlock;
 
@@ -144,9 +153,20 @@ MemoryHandling::MemoryHandling([[maybe_unused]] size_t comp_heap_size, size_t un
     _releasePolicy = new Release2Q(1024, main_heap_MB * 4, 128);
   //_releaseStrat = new ReleaseALL( this );
   //_releaseStrat = new ReleaseNULL( this );
+  live_ = this;
 }
 
 MemoryHandling::~MemoryHandling() {
+  live_ = nullptr;
+  {
+    // the cached blocks go away with the heap
+    std::scoped_lock guard(m_caches_mutex);
+    for (ThreadState *ts : m_thread_caches) {
+      std::scoped_lock cache_guard(ts->mutex);
+      ts->cache.Trim(0, [](void *, size_t) {});
+      ts->registered = nullptr;
+    }
+  }
   delete m_main_heap;
   delete m_huge_heap;
   delete m_system;
@@ -155,19 +175,118 @@ MemoryHandling::~MemoryHandling() {
 }
 
 void MemoryHandling::DumpObjs(std::ostream &out) {
-  std::scoped_lock guard(m_mutex);
   out << "  MEMORY DUMP: {" << std::endl;
-  for (auto &[obj, heap_map] : m_objs) {
-    out << "    " << obj->GetCoordinate().ToString() << ", locks: " << obj->NumOfLocks() << ", size allocated "
-        << obj->SizeAllocated() << std::endl;
-    (void)heap_map;
+  for (auto &s : m_objs) {
+    std::scoped_lock guard(s.mutex);
+    for (auto &[obj, heap_map] : s.objs) {
+      out << "    " << obj->GetCoordinate().ToString() << ", locks: " << obj->NumOfLocks() << ", size allocated "
+          << obj->SizeAllocated() << std::endl;
+      (void)heap_map;
+    }
   }
   out << "  }" << std::endl;
 }
 
+void MemoryHandling::Account(bool is_alloc, TraceableObject *owner, size_t bsize) {
+  ThreadState &ts = tls_state_;
+  bool is_pack = owner != nullptr && owner->TraceableType() == TO_TYPE::TO_PACK;
+  if (is_alloc) {
+    ts.stats[ALLOC_BLOCKS]++;
+    ts.stats[ALLOC_SIZE] += bsize;
+    // I want this for type = BLOCK_TYPE::BLOCK_TEMPORARY but will take this for now
+    ts.stats[is_pack ? ALLOC_PACK : ALLOC_TEMP]++;
+    ts.stats[is_pack ? ALLOC_PACK_SIZE : ALLOC_TEMP_SIZE] += bsize;
+  } else {
+    ts.stats[FREE_BLOCKS]++;
+    ts.stats[FREE_SIZE] += bsize;
+    ts.stats[is_pack ? FREE_PACK : FREE_TEMP]++;
+    ts.stats[is_pack ? FREE_PACK_SIZE : FREE_TEMP_SIZE] += bsize;
+  }
+  if (++ts.ops >= kStatsBatch)
+    FlushStats(ts);
+}
+
+void MemoryHandling::FlushStats(ThreadState &ts) {
+  for (int i = 0; i < NUM_STATS; i++) {
+    if (ts.stats[i] != 0)
+      m_stats[i].fetch_add(ts.stats[i], std::memory_order_relaxed);
+    ts.stats[i] = 0;
+  }
+  ts.ops = 0;
+}
+
+MemoryHandling::ThreadState &MemoryHandling::CachingThread() {
+  ThreadState &ts = tls_state_;
+  if (ts.registered.load(std::memory_order_relaxed) != this) {
+    std::scoped_lock guard(m_caches_mutex);
+    m_thread_caches.push_back(&ts);
+    ts.registered = this;
+  }
+  return ts;
+}
+
+// The blocks taken for the cache are allocations from the heap and are accounted
+// as such, the one returned is accounted by alloc().
+void *MemoryHandling::RefillThreadCache(ThreadState &ts, int cl, size_t capacity) {
+  size_t csize = ThreadCache::ClassSize(cl);
+  void *blocks[ThreadCache::kMaxRefill];
+  int taken = 0;
+  {
+    std::scoped_lock guard(m_mutex);
+    while (taken < ThreadCache::RefillCount(cl) && (blocks[taken] = m_main_heap->alloc(csize)) != nullptr) taken++;
+  }
+  if (taken == 0)
+    return nullptr;
+  int kept = 1;
+  {
+    std::scoped_lock guard(ts.mutex);
+    while (kept < taken && ts.cache.Push(cl, blocks[kept], capacity)) kept++;
+  }
+  for (int i = 1; i < kept; i++) Account(true, nullptr, csize);
+  if (kept < taken) {
+    std::scoped_lock guard(m_mutex);
+    for (int i = kept; i < taken; i++) m_main_heap->dealloc(blocks[i]);
+  }
+  return blocks[0];
+}
+
+void MemoryHandling::FreeCachedBlocks(const CachedBlocks &blocks) {
+  if (blocks.empty())
+    return;
+  {
+    std::scoped_lock guard(m_mutex);
+    for (auto &[p, size] : blocks) m_main_heap->dealloc(p);
+  }
+  for (auto &[p, size] : blocks) Account(false, nullptr, size);
+}
+
+void MemoryHandling::ForgetThreadCache(ThreadState &ts) {
+  CachedBlocks blocks;
+  {
+    std::scoped_lock guard(m_caches_mutex);
+    m_thread_caches.erase(std::find(m_thread_caches.begin(), m_thread_caches.end(), &ts));
+    std::scoped_lock cache_guard(ts.mutex);
+    ts.cache.Trim(0, [&blocks](void *p, size_t size) { blocks.emplace_back(p, size); });
+    ts.registered = nullptr;
+  }
+  FreeCachedBlocks(blocks);
+}
+
+void MemoryHandling::TrimThreadCaches(size_t capacity) {
+  CachedBlocks blocks;
+  {
+    std::scoped_lock guard(m_caches_mutex);
+    for (ThreadState *ts : m_thread_caches) {
+      std::scoped_lock cache_guard(ts->mutex);
+      ts->cache.Trim(capacity, [&blocks](void *p, size_t size) { blocks.emplace_back(p, size); });
+    }
+  }
+  FreeCachedBlocks(blocks);
+  FlushStats(tls_state_);
+}
+
 void *MemoryHandling::alloc(size_t size, BLOCK_TYPE type, TraceableObject *owner, bool nothrow) {
   MEASURE_FET("MemoryHandling::alloc");
-  std::scoped_lock guard(m_mutex);
   HeapPolicy *heap;
 
   if (type != BLOCK_TYPE::BLOCK_HUGE && tianmu_sysvar_hugefilesize > 0 && tianmu_os_least_mem > 0) {
@@ -208,56 +327,73 @@ void *MemoryHandling::alloc(size_t size, BLOCK_TYPE type, TraceableObject *owner
       heap = m_main_heap;
   };
 
-  void *res = heap->alloc(size);
+  void *res = nullptr;
+  size_t bsize = 0;
+  size_t cache_capacity = size_t(tianmu_sysvar_mm_thread_cache_size) * 1_MB;
+  int cl = (heap == m_main_heap && cache_capacity > 0) ? ThreadCache::SizeClass(size) : -1;
+  bool cached = false;  // still accounted as allocated from the heap
+  if (cl >= 0) {
+    ThreadState &ts = CachingThread();
+    {
+      std::scoped_lock guard(ts.mutex);
+      res = ts.cache.Pop(cl);
+    }
+    cached = (res != nullptr);
+    if (res == nullptr)
+      res = RefillThreadCache(ts, cl, cache_capacity);
+    bsize = ThreadCache::ClassSize(cl);
+  }
+
   if (res == nullptr) {
-    heap = m_main_heap;
-    ReleaseMemory(size, nullptr);
+    std::scoped_lock guard(m_mutex);
     res = heap->alloc(size);
-
     if (res == nullptr) {
-      if (m_hard_limit) {
-        if (nothrow)
-          return res;
-        throw common::OutOfMemoryException(size);
-      }
-      res = m_system->alloc(size);
+      heap = m_main_heap;
+      // blocks cached by the threads go back to the heap before anything is released
+      TrimThreadCaches(0);
+      res = heap->alloc(size);
+    }
+    if (res == nullptr) {
+      ReleaseMemory(size, nullptr);
+      res = heap->alloc(size);
+
       if (res == nullptr) {
-        if (nothrow)
-          return res;
-        tianmu_control_.lock(current_txn_->GetThreadID())
-            << "Failed to alloc block of size " << static_cast<int>(size) << system::unlock;
-        throw common::OutOfMemoryException(size);
-      } else {
-        heap = m_system;
+        if (m_hard_limit) {
+          if (nothrow)
+            return res;
+          throw common::OutOfMemoryException(size);
+        }
+        res = m_system->alloc(size);
+        if (res == nullptr) {
+          if (nothrow)
+            return res;
+          tianmu_control_.lock(current_txn_->GetThreadID())
+              << "Failed to alloc block of size " << static_cast<int>(size) << system::unlock;
+          throw common::OutOfMemoryException(size);
+        } else {
+          heap = m_system;
+        }
       }
     }
+    bsize = heap->getBlockSize(res);
   }
-  auto it = m_objs.find(owner);
-  if (it != m_objs.end()) {
-    it->second->insert(std::make_pair((void *)res, heap));
-  } else {
-    m_alloc_objs++;
-    // TBD: pool these objects
-    auto tianmu = new PtrHeapMap();
-    tianmu->insert(std::make_pair((void *)res, heap));
-    m_objs.insert(std::make_pair(owner, tianmu));
-  }
-  size_t bsize = heap->getBlockSize(res);
-  m_alloc_blocks++;
-  m_alloc_size += bsize;
-  if (owner != nullptr)
-    if (owner->TraceableType() == TO_TYPE::TO_PACK) {
-      m_alloc_pack_size += bsize;
-      m_alloc_pack++;
+
+  {
+    auto &s = shard(owner);
+    std::scoped_lock guard(s.mutex);
+    auto it = s.objs.find(owner);
+    if (it != s.objs.end()) {
+      it->second->insert(std::make_pair(res, BlockInfo{heap, bsize}));
     } else {
-      // I want this for type = BLOCK_TYPE::BLOCK_TEMPORARY but will take this for now
-      m_alloc_temp_size += bsize;
-      m_alloc_temp++;
+      m_alloc_objs++;
+      // TBD: pool these objects
+      auto tianmu = new PtrHeapMap();
+      tianmu->insert(std::make_pair(res, BlockInfo{heap, bsize}));
+      s.objs.insert(std::make_pair(owner, tianmu));
     }
-  else {
-    m_alloc_temp_size += bsize;
-    m_alloc_temp++;
   }
+  if (!cached)
+    Account(true, owner, bsize);
 #ifdef MEM_INIT
   std::memset(res, MEM_INIT, bsize);
 #endif
@@ -267,57 +403,66 @@ void *MemoryHandling::alloc(size_t size, BLOCK_TYPE type, TraceableObject *owner
 size_t MemoryHandling::rc_msize(void *mh, TraceableObject *owner) {
   MEASURE_FET("MemoryHandling::rc_msize");
 
-  std::scoped_lock guard(m_mutex);
   // if( owner == nullptr || mh == 0 )
   if (mh == 0)
     return 0;
-  auto it = m_objs.find(owner);
-  ASSERT(it != m_objs.end(), "MSize Owner not found");
+  auto &s = shard(owner);
+  std::scoped_lock guard(s.mutex);
+  auto it = s.objs.find(owner);
+  ASSERT(it != s.objs.end(), "MSize Owner not found");
 
   auto h = (it->second)->find(mh);
   ASSERT(h != it->second->end(), "Did not find msize block in map");
-  return h->second->getBlockSize(mh);
+  return h->second.size;
 }
 
 void MemoryHandling::dealloc(void *mh, TraceableObject *owner) {
   MEASURE_FET("MemoryHandling::dealloc");
 
-  std::scoped_lock guard(m_mutex);
-
   if (mh == nullptr)
     return;
 
-  auto it = m_objs.find(owner);
-  ASSERT(it != m_objs.end(), "DeAlloc owner not found");
-
-  auto h = it->second->find(mh);
-  ASSERT(h != it->second->end(), "Dealloc heap not found.");
-  int bsize = int(h->second->getBlockSize(mh));
+  BlockInfo info;
+  {
+    auto &s = shard(owner);
+    std::scoped_lock guard(s.mutex);
+    auto it = s.objs.find(owner);
+    ASSERT(it != s.objs.end(), "DeAlloc owner not found");
+
+    auto h = it->second->find(mh);
+    ASSERT(h != it->second->end(), "Dealloc heap not found.");
+    info = h->second;
+    it->second->erase(h);
+    if (it->second->empty()) {
+      delete it->second;
+      s.objs.erase(it);
+      m_alloc_objs--;
+    }
+  }
 #ifdef MEM_CLEAR
-  std::memset(mh, MEM_CLEAR, bsize);
+  std::memset(mh, MEM_CLEAR, info.size);
 #endif
-  m_free_blocks++;
-  m_free_size += bsize;
-  if (owner != nullptr)
-    if (owner->TraceableType() == TO_TYPE::TO_PACK) {
-      m_free_pack_size += bsize;
-      m_free_pack++;
-    } else {
-      m_free_temp_size += bsize;
-      m_free_temp++;
+
+  // a main heap block of a class size is kept by this thread for reuse, it is not
+  // accounted as freed until it goes back to the heap
+  size_t cache_capacity = size_t(tianmu_sysvar_mm_thread_cache_size) * 1_MB;
+  int cl = (info.heap == m_main_heap && cache_capacity > 0) ? ThreadCache::SizeClass(info.size) : -1;
+  if (cl >= 0 && ThreadCache::ClassSize(cl) == info.size) {
+    ThreadState &ts = CachingThread();
+    CachedBlocks spilled;
+    {
+      std::scoped_lock guard(ts.mutex);
+      if (ts.cache.Push(cl, mh, cache_capacity))
+        return;
+      // full, give back half of the cache along with the block
+      ts.cache.Trim(cache_capacity / 2, [&spilled](void *p, size_t size) { spilled.emplace_back(p, size); });
     }
-  else {
-    m_free_temp_size += bsize;
-    m_free_temp++;
+    FreeCachedBlocks(spilled);
   }
 
-  h->second->dealloc(mh);
-  it->second->erase(h);
-  if (it->second->empty()) {
-    delete it->second;
-    m_objs.erase(it);
-    m_alloc_objs--;
-  }
+  Account(false, owner, info.size);
+  std::scoped_lock guard(m_mutex);
+  info.heap->dealloc(mh);
 }
 
 bool MemoryHandling::ReleaseMemory(size_t size, [[maybe_unused]] TraceableObject *untouchable) {
@@ -326,6 +471,9 @@ bool MemoryHandling::ReleaseMemory(size_t size, [[maybe_unused]] TraceableObject
   bool result = false;
   std::scoped_lock guard(m_release_mutex);
 
+  // the blocks kept by the thread caches are free memory of the heap
+  TrimThreadCaches(0);
+
   // release 10 packs for every MB requested + 20
   unsigned objs = uint(10 * (size >> 20) + 20);
 
@@ -341,16 +489,19 @@ bool MemoryHandling::ReleaseMemory(size_t size, [[maybe_unused]] TraceableObject
     m_release_count = 0;
     std::vector<TraceableObject *> dps;
 
-    for (auto &it : m_objs) {
-      if (it.first == nullptr)
-        continue;
-      if (it.first->IsLocked() || it.first->TraceableType() != TO_TYPE::TO_PACK)
-        continue;
-
-      for (auto &mit : *it.second) {
-        if (mit.second == m_system) {
-          dps.push_back(it.first);
-          break;
+    for (auto &s : m_objs) {
+      std::scoped_lock shard_guard(s.mutex);
+      for (auto &it : s.objs) {
+        if (it.first == nullptr)
+          continue;
+        if (it.first->IsLocked() || it.first->TraceableType() != TO_TYPE::TO_PACK)
+          continue;
+
+        for (auto &mit : *it.second) {
+          if (mit.second.heap == m_system) {
+            dps.push_back(it.first);
+            break;
+          }
         }
       }
     }
@@ -389,7 +540,6 @@ bool MemoryHandling::ReleaseMemory(size_t size, [[maybe_unused]] TraceableObject
 void *MemoryHandling::rc_realloc(void *mh, size_t size, TraceableObject *owner, BLOCK_TYPE type) {
   MEASURE_FET("MemoryHandling::rc_realloc");
 
-  std::scoped_lock guard(m_mutex);
   void *res = alloc(size, type, owner);
 
   if (mh == nullptr)
@@ -404,10 +554,13 @@ void *MemoryHandling::rc_realloc(void *mh, size_t size, TraceableObject *owner,
 void MemoryHandling::ReportLeaks() {
   int blocks = 0;
   size_t size = 0;
-  for (auto it : m_objs) {
-    blocks++;
-    for (auto it2 : *(it.second)) {
-      size += it2.second->getBlockSize(it2.first);
+  for (auto &s : m_objs) {
+    std::scoped_lock guard(s.mutex);
+    for (auto &it : s.objs) {
+      blocks++;
+      for (auto &it2 : *(it.second)) {
+        size += it2.second.size;
+      }
     }
   }
   if (blocks > 0)
@@ -416,11 +569,14 @@ void MemoryHandling::ReportLeaks() {
 
 void MemoryHandling::EnsureNoLeakedTraceableObject() {
   bool error_found = false;
-  for (auto it : m_objs) {
-    if (it.first->IsLocked() && (it.first->NumOfLocks() > 1 || it.first->TraceableType() == TO_TYPE::TO_PACK)) {
-      error_found = true;
-      TIANMU_LOG(LogCtl_Level::ERROR, "Object @[%ld] locked too many times. Object type: %d, no. locks: %d",
-                 long(it.first), int(it.first->TraceableType()), int(it.first->NumOfLocks()));
+  for (auto &s : m_objs) {
+    std::scoped_lock guard(s.mutex);
+    for (auto &it : s.objs) {
+      if (it.first->IsLocked() && (it.first->NumOfLocks() > 1 || it.first->TraceableType() == TO_TYPE::TO_PACK)) {
+        error_found = true;
+        TIANMU_LOG(LogCtl_Level::ERROR, "Object @[%ld] locked too many times. Object type: %d, no. locks: %d",
+                   long(it.first), int(it.first->TraceableType()), int(it.first->NumOfLocks()));
+      }
     }
   }
   ASSERT(!error_found, "Objects locked too many times found.");
@@ -492,10 +648,10 @@ void MemoryHandling::HeapHistogram(std::ostream &out) {
   used_blocks.insert(std::make_pair(m_system, &system_heap));
   used_blocks.insert(std::make_pair(m_large_temp, &large_temp));
 
-  {
-    std::scoped_lock guard(m_mutex);
+  for (auto &s : m_objs) {
+    std::scoped_lock guard(s.mutex);
 
-    for (auto it : m_objs) {
+    for (auto &it : s.objs) {
       SimpleHist *block_type;
 
       if (it.first->TraceableType() == TO_TYPE::TO_PACK && it.first->IsLocked())
@@ -529,19 +685,17 @@ void MemoryHandling::HeapHistogram(std::ostream &out) {
         default:
           block_type = &other;
       }
-      for (auto mit : *(it.second)) {
-        void *ptr = mit.first;
-        HeapPolicy *hp = mit.second;
-        auto hist = used_blocks.find(hp);
+      for (auto &mit : *(it.second)) {
+        auto hist = used_blocks.find(mit.second.heap);
 
         if (hist != used_blocks.end()) {
-          hist->second->accumulate(hp->getBlockSize(ptr));
+          hist->second->accumulate(mit.second.size);
           if (block_type != nullptr)
-            block_type->accumulate(hp->getBlockSize(ptr));
+            block_type->accumulate(mit.second.size);
         }
       }
     }
-  }  // close scope for m_mutex guard
+  }  // close scope for shard guards
 
   // rccontrol << lock;
   for (auto h : used_blocks) {
@@ -563,8 +717,9 @@ void MemoryHandling::HeapHistogram(std::ostream &out) {
 }
 
 void MemoryHandling::AssertNoLeak(TraceableObject *o) {
-  std::scoped_lock guard(m_mutex);
-  ASSERT(m_objs.find(o) == m_objs.end(), "MemoryLeakAssertion");
+  auto &s = shard(o);
+  std::scoped_lock guard(s.mutex);
+  ASSERT(s.objs.find(o) == s.objs.end(), "MemoryLeakAssertion");
 }
 
 void MemoryHandling::TrackAccess(TraceableObject *o) {
@@ -18,8 +18,10 @@
 #define TIANMU_MM_MEMORY_HANDLING_POLICY_H_
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "common/assert.h"
 #include "mm/memory_block.h"
@@ -38,8 +40,23 @@ class HeapPolicy;
 class MemoryHandling {
   friend class TraceableObject;
 
-  using PtrHeapMap = std::unordered_map<void *, HeapPolicy *>;
-  std::unordered_map<TraceableObject *, PtrHeapMap *> m_objs;
+  struct BlockInfo {
+    HeapPolicy *heap;
+    size_t size;
+  };
+  using PtrHeapMap = std::unordered_map<void *, BlockInfo>;
+
+  // The blocks of an owner are tracked in one of the shards picked by the owner
+  // address, so threads allocating for different objects lock different maps.
+  static constexpr size_t kOwnerShards = 64;
+  struct OwnerShard {
+    std::mutex mutex;
+    std::unordered_map<TraceableObject *, PtrHeapMap *> objs;
+  };
+  OwnerShard m_objs[kOwnerShards];
+  OwnerShard &shard(TraceableObject *owner) {
+    return m_objs[(reinterpret_cast<uintptr_t>(owner) >> 5) % kOwnerShards];
+  }
 
   HeapPolicy *m_main_heap, *m_huge_heap, *m_system, *m_large_temp;
   int main_heap_MB, comp_heap_MB;
@@ -47,16 +64,46 @@ class MemoryHandling {
   unsigned int m_release_count = 0;
   size_t m_release_total = 0;
 
-  std::recursive_mutex m_mutex;
+  std::recursive_mutex m_mutex;  // guards the heaps
   std::recursive_mutex m_release_mutex;
 
-  // status counters
-  unsigned long m_alloc_blocks, m_alloc_objs, m_alloc_size, m_alloc_pack, m_alloc_temp, m_free_blocks,
-      m_alloc_temp_size, m_alloc_pack_size, m_free_pack, m_free_temp, m_free_pack_size, m_free_temp_size, m_free_size;
+  // status counters, threads add their changes in batches
+  enum Stat {
+    ALLOC_BLOCKS,
+    ALLOC_SIZE,
+    ALLOC_PACK,
+    ALLOC_PACK_SIZE,
+    ALLOC_TEMP,
+    ALLOC_TEMP_SIZE,
+    FREE_BLOCKS,
+    FREE_SIZE,
+    FREE_PACK,
+    FREE_PACK_SIZE,
+    FREE_TEMP,
+    FREE_TEMP_SIZE,
+    NUM_STATS
+  };
+  std::atomic<unsigned long> m_stats[NUM_STATS] = {};
+  std::atomic<unsigned long> m_alloc_objs{0};
+
+  // the thread cache of freed main heap blocks and pending counter changes
+  struct ThreadState;
+  static thread_local ThreadState tls_state_;
+  static std::atomic<MemoryHandling *> live_;
+  // threads which cache blocks of the main heap, so that the blocks can be taken back
+  std::mutex m_caches_mutex;
+  std::vector<ThreadState *> m_thread_caches;
+  using CachedBlocks = std::vector<std::pair<void *, size_t>>;
 
   ReleaseStrategy *_releasePolicy = nullptr;
 
   void DumpObjs(std::ostream &out);
+  void Account(bool is_alloc, TraceableObject *owner, size_t bsize);
+  void FlushStats(ThreadState &ts);
+  ThreadState &CachingThread();
+  void *RefillThreadCache(ThreadState &ts, int cl, size_t capacity);
+  void FreeCachedBlocks(const CachedBlocks &blocks);
+  void ForgetThreadCache(ThreadState &ts);
 
  public:
   MemoryHandling(size_t comp_heap_size, size_t uncomp_heap_size, std::string hugedir = "", core::DataCache *d = nullptr,
@@ -75,24 +122,26 @@ class MemoryHandling {
 
   void AssertNoLeak(TraceableObject *);
   bool ReleaseMemory(size_t, TraceableObject *untouchable);  // Release given amount of memory
+  // Returns the blocks cached by each thread beyond `capacity` bytes to the heap
+  void TrimThreadCaches(size_t capacity);
 
   void ReportLeaks();
   void EnsureNoLeakedTraceableObject();
   void CompressPacks();
 
-  unsigned long getAllocBlocks() { return m_alloc_blocks; }
+  unsigned long getAllocBlocks() { return m_stats[ALLOC_BLOCKS]; }
   unsigned long getAllocObjs() { return m_alloc_objs; }
-  unsigned long getAllocSize() { return m_alloc_size; }
-  unsigned long getAllocPack() { return m_alloc_pack; }
-  unsigned long getAllocTemp() { return m_alloc_temp; }
-  unsigned long getFreeBlocks() { return m_free_blocks; }
-  unsigned long getAllocTempSize() { return m_alloc_temp_size; }
-  unsigned long getAllocPackSize() { return m_alloc_pack_size; }
-  unsigned long getFreePacks() { return m_free_pack; }
-  unsigned long getFreeTemp() { return m_free_temp; }
-  unsigned long getFreePackSize() { return m_free_pack_size; }
-  unsigned long getFreeTempSize() { return m_free_temp_size; }
-  unsigned long getFreeSize() { return m_free_size; }
+  unsigned long getAllocSize() { return m_stats[ALLOC_SIZE]; }
+  unsigned long getAllocPack() { return m_stats[ALLOC_PACK]; }
+  unsigned long getAllocTemp() { return m_stats[ALLOC_TEMP]; }
+  unsigned long getFreeBlocks() { return m_stats[FREE_BLOCKS]; }
+  unsigned long getAllocTempSize() { return m_stats[ALLOC_TEMP_SIZE]; }
+  unsigned long getAllocPackSize() { return m_stats[ALLOC_PACK_SIZE]; }
+  unsigned long getFreePacks() { return m_stats[FREE_PACK]; }
+  unsigned long getFreeTemp() { return m_stats[FREE_TEMP]; }
+  unsigned long getFreePackSize() { return m_stats[FREE_PACK_SIZE]; }
+  unsigned long getFreeTempSize() { return m_stats[FREE_TEMP_SIZE]; }
+  unsigned long getFreeSize() { return m_stats[FREE_SIZE]; }
   unsigned long getReleaseCount() { return m_release_count; }
   unsigned long getReleaseTotal() { return m_release_total; }
   unsigned long long getReleaseCount1();
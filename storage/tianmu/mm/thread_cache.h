@@ -0,0 +1,114 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_MM_THREAD_CACHE_H_
+#define TIANMU_MM_THREAD_CACHE_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tianmu {
+namespace mm {
+
+// Per-thread front end of a heap: blocks freed by a thread are kept in size
+// classes and handed out again to the same thread without the heap lock. The
+// class itself is not synchronized, the memory manager guards each cache with a
+// mutex of its thread so that it can empty the caches of all threads. Only
+// misses and overflows reach the heap, a batch of blocks at a time. Classes are
+// a quarter of a power of two apart, from 64 B up to 1 MB, which covers filter
+// blocks and the value buffers of packs.
+class ThreadCache final {
+ public:
+  static constexpr int kMinShift = 6;
+  static constexpr int kMaxShift = 20;
+  static constexpr int kNumClasses = (kMaxShift - kMinShift) * 4 + 1;
+
+  // -1 for sizes that are not cached
+  static int SizeClass(size_t size) {
+    if (size <= (size_t(1) << kMinShift))
+      return 0;
+    if (size > (size_t(1) << kMaxShift))
+      return -1;
+    size_t v = size - 1;
+    int k = 63 - __builtin_clzll(v);
+    return (k - kMinShift) * 4 + int((v >> (k - 2)) & 3) + 1;
+  }
+
+  static size_t ClassSize(int cl) {
+    if (cl == 0)
+      return size_t(1) << kMinShift;
+    int k = (cl - 1) / 4 + kMinShift;
+    return size_t(5 + (cl - 1) % 4) << (k - 2);
+  }
+
+  // Number of blocks taken from the heap at once on a miss, about 64 KB worth.
+  static constexpr int kMaxRefill = 16;
+  static int RefillCount(int cl) {
+    size_t n = (size_t(64) << 10) / ClassSize(cl);
+    return n < 1 ? 1 : (n > kMaxRefill ? kMaxRefill : int(n));
+  }
+
+  ThreadCache() = default;
+  ThreadCache(const ThreadCache &) = delete;
+  ThreadCache &operator=(const ThreadCache &) = delete;
+
+  void *Pop(int cl) {
+    void *p = lists_[cl].head;
+    if (p == nullptr)
+      return nullptr;
+    lists_[cl].head = *static_cast<void **>(p);
+    lists_[cl].length--;
+    cached_bytes_ -= ClassSize(cl);
+    return p;
+  }
+
+  // false if the cache would grow beyond `capacity` bytes, the block is not taken then
+  bool Push(int cl, void *p, size_t capacity) {
+    if (cached_bytes_ + ClassSize(cl) > capacity)
+      return false;
+    *static_cast<void **>(p) = lists_[cl].head;
+    lists_[cl].head = p;
+    lists_[cl].length++;
+    cached_bytes_ += ClassSize(cl);
+    return true;
+  }
+
+  // Hands out the blocks of every class, with their size, until at most `capacity`
+  // bytes stay cached, largest classes first.
+  template <typename F>
+  void Trim(size_t capacity, F free_block) {
+    for (int cl = kNumClasses - 1; cl >= 0 && cached_bytes_ > capacity; cl--) {
+      while (cached_bytes_ > capacity && lists_[cl].head != nullptr) free_block(Pop(cl), ClassSize(cl));
+    }
+  }
+
+  size_t CachedBytes() const { return cached_bytes_; }
+  uint32_t Length(int cl) const { return lists_[cl].length; }
+
+ private:
+  struct FreeList {
+    void *head = nullptr;  // the link to the next block is kept in the block itself
+    uint32_t length = 0;
+  };
+  FreeList lists_[kNumClasses];
+  size_t cached_bytes_ = 0;
+};
+
+}  // namespace mm
+}  // namespace Tianmu
+
+#endif  // TIANMU_MM_THREAD_CACHE_H_
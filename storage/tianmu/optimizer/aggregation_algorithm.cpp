@@ -182,6 +182,12 @@ void AggregationAlgorithm::Aggregate(bool just_distinct, int64_t &limit, int64_t
   }  // Special case 2, if applicable: SELECT COUNT(DISTINCT col) FROM .....;
   else if (gbw.IsCountDistinctOnly()) {
     int64_t count_distinct = t->GetAttrP(0)->term.vc->GetExactDistVals();  // multiindex checked inside
+    if (count_distinct == common::NULL_VALUE_64 && tianmu_session_approx_count_distinct(m_conn->Thd())) {
+      count_distinct = t->GetAttrP(0)->term.vc->GetSketchDistVals();  // estimated from the pack sketches
+      if (count_distinct != common::NULL_VALUE_64)
+        push_warning(m_conn->Thd(), Sql_condition::SL_NOTE, ER_UNKNOWN_ERROR,
+                     "COUNT(DISTINCT) is an estimate, see tianmu_approx_count_distinct");
+    }
     if (count_distinct != common::NULL_VALUE_64) {
       int64_t row = 0;
       gbw.FindCurrentRow(row);  // needed to initialize grouping buffer
@@ -362,10 +368,15 @@ void AggregationAlgorithm::MultiDimensionalGroupByScan(GroupByWrapper &gbw, int6
       MultiDimensionalDistinctScan(gbw, mit);  // if not needed, no effect
       ag_worker.Commit();
 
+      // a partitioned parallel merge leaves the groups spread over several wrappers
+      std::vector<GroupByWrapper *> outputs = ag_worker.Outputs();
+      int64_t no_groups = 0;
+      for (auto gb : outputs) no_groups += gb->NumOfGroups();
+
       // Now it is time to prepare output values
       if (first_pass) {
         first_pass = false;
-        int64_t upper_groups = gbw.NumOfGroups() + gbw.TuplesNoOnes();  // upper approximation: the current size +
+        int64_t upper_groups = no_groups + gbw.TuplesNoOnes();  // upper approximation: the current size +
                                                                         // all other possible rows (if any)
         t->CalculatePageSize(upper_groups);
         if (upper_groups > gbw.UpperApproxOfGroups())
@@ -384,36 +395,40 @@ void AggregationAlgorithm::MultiDimensionalGroupByScan(GroupByWrapper &gbw, int6
         }
       }
       tianmu_control_.lock(m_conn->GetThreadID()) << "Group/Aggregate end. Begin generating output." << system::unlock;
-      tianmu_control_.lock(m_conn->GetThreadID()) << "Output rows: " << gbw.NumOfGroups() + gbw.TuplesNoOnes()
+      tianmu_control_.lock(m_conn->GetThreadID()) << "Output rows: " << no_groups + gbw.TuplesNoOnes()
                                                   << ", output table row limit: " << t->GetPageSize() << system::unlock;
-      int64_t output_size = (gbw.NumOfGroups() + gbw.TuplesNoOnes()) * t->GetOneOutputRecordSize();
-      gbw.RewindRows();
-      if (t->GetPageSize() >= (gbw.NumOfGroups() + gbw.TuplesNoOnes()) && output_size > (1L << 29) &&
+      int64_t output_size = (no_groups + gbw.TuplesNoOnes()) * t->GetOneOutputRecordSize();
+      for (auto gb : outputs) gb->RewindRows();
+      if (t->GetPageSize() >= (no_groups + gbw.TuplesNoOnes()) && output_size > (1L << 29) &&
           !t->HasHavingConditions() && tianmu_sysvar_parallel_filloutput) {
         // Turn on parallel output when:
         // 1. output page is large enough to hold all output rows
         // 2. output result is larger than 512MB
         // 3. no have condition
         tianmu_control_.lock(m_conn->GetThreadID()) << "Start parallel output" << system::unlock;
-        ParallelFillOutputWrapper(gbw, offset, limit, mit);
+        for (auto gb : outputs) ParallelFillOutputWrapper(*gb, offset, limit, mit);
       } else {
-        while (gbw.RowValid()) {
-          // copy GroupTable into TempTable, row by row
-          if (t->NumOfObj() >= limit)
-            break;
-          AggregateFillOutput(gbw, gbw.GetCurrentRow(),
-                              offset);  // offset is decremented for each row, if positive
-          if (sender && t->NumOfObj() > (1 << mind->ValueOfPower()) - 1) {
-            TempTable::RecordIterator iter = t->begin();
-            for (int64_t i = 0; i < t->NumOfObj(); i++) {
-              sender->Send(iter);
-              ++iter;
+        for (auto gb : outputs) {
+          while (gb->RowValid()) {
+            // copy GroupTable into TempTable, row by row
+            if (t->NumOfObj() >= limit)
+              break;
+            AggregateFillOutput(*gb, gb->GetCurrentRow(),
+                                offset);  // offset is decremented for each row, if positive
+            if (sender && t->NumOfObj() > (1 << mind->ValueOfPower()) - 1) {
+              TempTable::RecordIterator iter = t->begin();
+              for (int64_t i = 0; i < t->NumOfObj(); i++) {
+                sender->Send(iter);
+                ++iter;
+              }
+              displayed_no_groups += t->NumOfObj();
+              limit -= t->NumOfObj();
+              t->SetNumOfObj(0);
             }
-            displayed_no_groups += t->NumOfObj();
-            limit -= t->NumOfObj();
-            t->SetNumOfObj(0);
+            gb->NextRow();
           }
-          gbw.NextRow();
+          if (t->NumOfObj() >= limit)
+            break;
         }
       }
       if (sender) {
@@ -990,6 +1005,7 @@ void AggregationWorkerEnt::DistributeAggreTaskAverage(MIIterator &mit, uint64_t
   Transaction *conn = current_txn_;
   DimensionVector dims(mind->NumOfDimensions());
   std::vector<CTask> vTask;
+  gb_partitions.clear();
   std::vector<std::unique_ptr<GroupByWrapper>> vGBW;
   vGBW.reserve(m_threads);
   vTask.reserve(m_threads);
@@ -1028,6 +1044,11 @@ void AggregationWorkerEnt::DistributeAggreTaskAverage(MIIterator &mit, uint64_t
              "DistributeAggreTaskAverage packnum: %d threads_num: %d loopcnt: %d num: %d mod: %d NumOfTuples: %d",
              packnum, threads_num, loopcnt, num, mod, mit.NumOfTuples());
 
+  // Two-phase aggregation: the tables of the tasks are merged by hash partitions in parallel,
+  // each of them owning one partition, the first one (gb_main) included.
+  bool partitioned = tianmu_sysvar_groupby_partitioned_merge && loopcnt > 1 && gb_main->NumOfGroupingAttrs() > 0 &&
+                     gb_main->MayBeParallel();
+
   utils::result_set<void> res;
   core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
   assert(eng);
@@ -1095,11 +1116,15 @@ void AggregationWorkerEnt::DistributeAggreTaskAverage(MIIterator &mit, uint64_t
   memory_statistics_record("AGGREGA", "TASK");
 #endif
 
-  for (size_t i = 0; i < vTask.size(); ++i) {
-    // Merge aggreation data together
-    if (i != 0) {
-      aa->MultiDimensionalDistinctScan(*(vGBW[i]), mit);
-      gb_main->Merge(*(vGBW[i]));
+  if (partitioned) {
+    PartitionedMerge(vGBW);
+  } else {
+    for (size_t i = 0; i < vTask.size(); ++i) {
+      // Merge aggreation data together
+      if (i != 0) {
+        aa->MultiDimensionalDistinctScan(*(vGBW[i]), mit);
+        gb_main->Merge(*(vGBW[i]));
+      }
     }
   }
 
@@ -1113,5 +1138,59 @@ void AggregationWorkerEnt::DistributeAggreTaskAverage(MIIterator &mit, uint64_t
   memory_statistics_record("AGGREGA", "MERGE");
 #endif
 }
+
+void AggregationWorkerEnt::PartitionedMerge(std::vector<std::unique_ptr<GroupByWrapper>> &vGBW) {
+  // the table of the first task is gb_main, vGBW[0] is not used
+  std::vector<GroupByWrapper *> owners{gb_main};
+  for (size_t i = 1; i < vGBW.size(); ++i) owners.push_back(vGBW[i].get());
+
+  if (tianmu_control_.isOn())
+    tianmu_control_.lock(current_txn_->GetThreadID())
+        << "Merge parallel aggregation in " << owners.size() << " partitions" << system::unlock;
+
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  assert(eng);
+
+  // rows[i][p] - copies of the rows of owners[i] belonging to partition p. All the tables are
+  // copied and emptied before any of them takes rows back, so no table is read while it grows.
+  std::vector<std::vector<std::vector<unsigned char>>> rows(owners.size());
+  utils::result_set<void> res;
+  for (size_t i = 0; i < owners.size(); ++i) {
+    rows[i].resize(owners.size());
+    res.insert(eng->query_thread_pool.add_task(&AggregationWorkerEnt::TaskPartitionRows, this, owners[i], &rows[i]));
+  }
+  res.get_all_with_except();
+
+  utils::result_set<void> res1;
+  for (size_t p = 0; p < owners.size(); ++p)
+    res1.insert(eng->query_thread_pool.add_task(&AggregationWorkerEnt::TaskMergePartition, this, &owners, &rows, p));
+  res1.get_all_with_except();
+
+  for (size_t i = 1; i < owners.size(); ++i) {
+    gb_main->MergeStatistics(*owners[i]);
+    gb_partitions.emplace_back(std::move(vGBW[i]));
+  }
+}
+
+void AggregationWorkerEnt::TaskPartitionRows(GroupByWrapper *gbw,
+                                             std::vector<std::vector<unsigned char>> *rows_by_partition) {
+  gbw->PartitionRows(*rows_by_partition);
+}
+
+void AggregationWorkerEnt::TaskMergePartition(std::vector<GroupByWrapper *> *owners,
+                                              std::vector<std::vector<std::vector<unsigned char>>> *rows,
+                                              size_t partition) {
+  for (size_t i = 0; i < owners->size(); ++i) {
+    auto &copied = (*rows)[i][partition];
+    (*owners)[partition]->MergeRows(copied);
+    std::vector<unsigned char>().swap(copied);
+  }
+}
+
+std::vector<GroupByWrapper *> AggregationWorkerEnt::Outputs() {
+  std::vector<GroupByWrapper *> outputs{gb_main};
+  for (auto &gbw : gb_partitions) outputs.push_back(gbw.get());
+  return outputs;
+}
 }  // namespace core
 }  // namespace Tianmu
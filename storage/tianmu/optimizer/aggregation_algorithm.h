@@ -104,6 +104,17 @@ class AggregationWorkerEnt {
   void DistributeAggreTaskAverage(MIIterator &mit, uint64_t *mem_used = nullptr);
   void PrepShardingCopy(MIIterator *mit, GroupByWrapper *gb_sharding,
                         std::vector<std::unique_ptr<GroupByWrapper>> *vGBW);
+  // Wrappers holding the result: gb_main, followed by the partitions of a partitioned merge.
+  std::vector<GroupByWrapper *> Outputs();
+
+ private:
+  // Second phase of the partitioned aggregation, after the tasks filling the thread-local
+  // wrappers have finished: the groups of all of them are copied out split by hash, then
+  // each wrapper takes the groups of one partition back, the first one being gb_main.
+  void PartitionedMerge(std::vector<std::unique_ptr<GroupByWrapper>> &vGBW);
+  void TaskPartitionRows(GroupByWrapper *gbw, std::vector<std::vector<unsigned char>> *rows_by_partition);
+  void TaskMergePartition(std::vector<GroupByWrapper *> *owners,
+                          std::vector<std::vector<std::vector<unsigned char>>> *rows, size_t partition);
 
  protected:
   GroupByWrapper *gb_main;
@@ -111,6 +122,7 @@ class AggregationWorkerEnt {
   int m_threads;
   AggregationAlgorithm *aa;
   std::mutex mtx;
+  std::vector<std::unique_ptr<GroupByWrapper>> gb_partitions;  // owners of partitions 1.. of a partitioned merge
 };
 }  // namespace core
 }  // namespace Tianmu
@@ -23,54 +23,72 @@
 
 namespace Tianmu {
 namespace core {
-void AggregatorSum64::PutAggregatedValue(unsigned char *buf, int64_t v, int64_t factor) {
-  std::scoped_lock scp_lk(aggr_mtx);
+namespace {
+// 128-bit sums are stored unaligned in the aggregation rows
+const __int128 kNullSum128 = (__int128)((unsigned __int128)1 << 127);  // NULL, the lowest 128-bit value
 
-  stats_updated = false;
-  int64_t *p = (int64_t *)buf;
-  if (*p == common::NULL_VALUE_64) {
-    *p = 0;
-  }
+inline __int128 Load128(const unsigned char *buf) {
+  __int128 v;
+  std::memcpy(&v, buf, sizeof(v));
+  return v;
+}
 
-  long double overflow_check = double(*p) + double(v) * factor;
-  if (overflow_check > std::numeric_limits<std::streamsize>::max() ||
-      overflow_check < std::numeric_limits<std::streamsize>::min()) {
-    char str_buff[1024] = {'\0'};
-    sprintf(str_buff, "Aggregation overflow for long double. over_check: %Lf", overflow_check);
+inline void Store128(unsigned char *buf, __int128 v) { std::memcpy(buf, &v, sizeof(v)); }
 
-    throw common::InternalException(str_buff);
-  }
+inline void Add128(unsigned char *buf, __int128 v) {
+  __int128 sum;
+  if (__builtin_add_overflow(Load128(buf), v, &sum))
+    throw common::NotImplementedException("Aggregation overflow.");
+  Store128(buf, sum);
+}
+}  // namespace
 
-  *p += v * factor;
+void AggregatorSum64::PutAggregatedValue(unsigned char *buf, int64_t v, int64_t factor) {
+  std::scoped_lock scp_lk(aggr_mtx);
+
+  stats_updated = false;
+  if (Load128(buf) == kNullSum128)
+    Store128(buf, 0);
+  Add128(buf, (__int128)v * factor);  // cannot overflow before the addition
 }
 
 void AggregatorSum64::Merge(unsigned char *buf, unsigned char *src_buf) {
-  int64_t *p = (int64_t *)buf;
-  int64_t *ps = (int64_t *)src_buf;
-  if (*ps == common::NULL_VALUE_64)
+  __int128 src = Load128(src_buf);
+  if (src == kNullSum128)
     return;
   stats_updated = false;
-  if (*p == common::NULL_VALUE_64) {
-    *p = 0;
-  }
-  double overflow_check = double(*p) + double(*ps);
-  if (overflow_check > std::numeric_limits<std::streamsize>::max() ||
-      overflow_check < std::numeric_limits<std::streamsize>::min())
-    throw common::NotImplementedException("Aggregation overflow.");
-  *p += *ps;
+  if (Load128(buf) == kNullSum128)
+    Store128(buf, 0);
+  Add128(buf, src);
 }
 
-void AggregatorSum64::SetAggregatePackSum(int64_t par1, int64_t factor) {
-  double overflow_check = double(par1) * factor;
-  if (overflow_check > std::numeric_limits<std::streamsize>::max() ||
-      overflow_check < std::numeric_limits<std::streamsize>::min())
+int64_t AggregatorSum64::GetValue64(unsigned char *buf) {
+  __int128 sum = Load128(buf);
+  if (sum == kNullSum128)
+    return common::NULL_VALUE_64;
+  // the result column is 64-bit, only the final sum has to fit
+  if (sum <= common::NULL_VALUE_64 || sum > std::numeric_limits<int64_t>::max())
     throw common::NotImplementedException("Aggregation overflow.");
-  pack_sum = par1 * factor;
+  return int64_t(sum);
+}
+
+void AggregatorSum64::Reset(unsigned char *buf) { Store128(buf, kNullSum128); }
+
+bool AggregatorSum64::UpdateStatistics(unsigned char *buf) {
+  if (Load128(buf) == kNullSum128)
+    null_group_found = true;
+  return null_group_found;  // if found, do not search any more
 }
 
+void AggregatorSum64::SetAggregatePackSum(int64_t par1, int64_t factor) { pack_sum = (__int128)par1 * factor; }
+
 bool AggregatorSum64::AggregatePack(unsigned char *buf) {
-  DEBUG_ASSERT(pack_sum != common::NULL_VALUE_64);
-  PutAggregatedValue(buf, pack_sum, 1);
+  std::scoped_lock scp_lk(aggr_mtx);
+
+  stats_updated = false;
+  if (Load128(buf) == kNullSum128)
+    Store128(buf, 0);
+  Add128(buf, pack_sum);
   return true;
 }
 
@@ -117,38 +135,31 @@ bool AggregatorSumD::AggregatePack(unsigned char *buf) {
 
 void AggregatorAvg64::PutAggregatedValue(unsigned char *buf, int64_t v, int64_t factor) {
   stats_updated = false;
-  *((double *)buf) += double(v) * factor;
-  if (!warning_issued && (*((double *)buf) > std::numeric_limits<std::streamsize>::max() ||
-                          *((double *)buf) < std::numeric_limits<std::streamsize>::min())) {
-    common::PushWarning(current_txn_->Thd(), Sql_condition::SL_NOTE, ER_UNKNOWN_ERROR, "Values rounded in average()");
-    warning_issued = true;
-  }
-  *((int64_t *)(buf + sizeof(int64_t))) += factor;
+  Add128(buf, (__int128)v * factor);
+  *((int64_t *)(buf + sizeof(__int128))) += factor;
 }
 
 void AggregatorAvg64::Merge(unsigned char *buf, unsigned char *src_buf) {
-  if (*((int64_t *)(src_buf + sizeof(int64_t))) == 0)
+  if (*((int64_t *)(src_buf + sizeof(__int128))) == 0)
     return;
   stats_updated = false;
-  *((double *)buf) += *((double *)src_buf);
-  if (!warning_issued && (*((double *)buf) > std::numeric_limits<std::streamsize>::max() ||
-                          *((double *)buf) < std::numeric_limits<std::streamsize>::min())) {
-    common::PushWarning(current_txn_->Thd(), Sql_condition::SL_NOTE, ER_UNKNOWN_ERROR, "Values rounded in average()");
-    warning_issued = true;
-  }
-  *((int64_t *)(buf + sizeof(int64_t))) += *((int64_t *)(src_buf + sizeof(int64_t)));
+  Add128(buf, Load128(src_buf));
+  *((int64_t *)(buf + sizeof(__int128))) += *((int64_t *)(src_buf + sizeof(__int128)));
 }
 
 double AggregatorAvg64::GetValueD(unsigned char *buf) {
-  if (*((int64_t *)(buf + sizeof(int64_t))) == 0)
+  int64_t count = *((int64_t *)(buf + sizeof(__int128)));
+  if (count == 0)
     return NULL_VALUE_D;
-  return *((double *)buf) / *((int64_t *)(buf + sizeof(int64_t))) / prec_factor;
+  // the integral part of the quotient is exact, only the remainder is rounded
+  __int128 sum = Load128(buf);
+  return (double(sum / count) + double(sum % count) / count) / prec_factor;
 }
 
 bool AggregatorAvg64::AggregatePack(unsigned char *buf) {
   stats_updated = false;
-  *((double *)buf) += pack_sum;
-  *((int64_t *)(buf + sizeof(int64_t))) += pack_not_nulls;
+  Add128(buf, pack_sum);
+  *((int64_t *)(buf + sizeof(__int128))) += pack_not_nulls;
   return true;
 }
 
@@ -18,6 +18,7 @@
 #define TIANMU_CORE_AGGREGATOR_BASIC_H_
 #pragma once
 
+#include <cstring>
 #include <mutex>
 #include "optimizer/aggregator.h"
 
@@ -35,10 +36,10 @@ namespace core {
 /*!
  * \brief An aggregator for SUM(...) of numerical (int64_t) values.
  *
- * The counter consists of just one 64-bit value:
- *     <cur_sum_64>
- * Start value: common::NULL_VALUE_64.
- * Throws an exception on overflow.
+ * The counter consists of one 128-bit value, so that partial sums may exceed 64 bits:
+ *     <cur_sum_128>
+ * Start value: NULL (the lowest 128-bit value).
+ * Throws an exception if the final sum does not fit in 64 bits.
  */
 class AggregatorSum64 : public TIANMUAggregator {
   using TIANMUAggregator::PutAggregatedValue;
@@ -58,11 +59,11 @@ class AggregatorSum64 : public TIANMUAggregator {
         null_group_found(sec.null_group_found) {}
 
   TIANMUAggregator *Copy() override { return new AggregatorSum64(*this); }
-  int BufferByteSize() override { return 8; }
+  int BufferByteSize() override { return 16; }
   void PutAggregatedValue(unsigned char *buf, int64_t v, int64_t factor) override;
   void Merge(unsigned char *buf, unsigned char *src_buf) override;
-  int64_t GetValue64(unsigned char *buf) override { return *((int64_t *)buf); }
-  void Reset(unsigned char *buf) override { *((int64_t *)buf) = common::NULL_VALUE_64; }
+  int64_t GetValue64(unsigned char *buf) override;
+  void Reset(unsigned char *buf) override;
   // Optimization part
   bool PackAggregationNeedsSum() override { return true; }
   void SetAggregatePackSum(int64_t par1, int64_t factor) override;
@@ -77,11 +78,7 @@ class AggregatorSum64 : public TIANMUAggregator {
     null_group_found = false;
     stats_updated = false;
   }
-  bool UpdateStatistics(unsigned char *buf) override {
-    if (*((int64_t *)buf) == common::NULL_VALUE_64)
-      null_group_found = true;
-    return null_group_found;  // if found, do not search any more
-  }
+  bool UpdateStatistics(unsigned char *buf) override;
   bool PackCannotChangeAggregation() override {
     DEBUG_ASSERT(stats_updated);
     return !null_group_found && pack_min == 0 && pack_max == 0;  // uniform 0 pack - no change for sum
@@ -89,7 +86,7 @@ class AggregatorSum64 : public TIANMUAggregator {
 
  private:
   std::mutex aggr_mtx;
-  int64_t pack_sum;
+  __int128 pack_sum;
   int64_t pack_min;  // min and max are used to check whether a pack may update
                      // sum (i.e. both 0 means "no change")
   int64_t pack_max;
@@ -133,8 +130,8 @@ class AggregatorSumD : public TIANMUAggregator {
 /*!
  * \brief An aggregator for AVG(...) of numerical (int64_t) values.
  *
- * The counter consists of a double sum and counter:
- *     <cur_sum_double><cur_count_64>
+ * The counter consists of an exact 128-bit sum and counter:
+ *     <cur_sum_128><cur_count_64>
  * Start value: 0, but GetValueD will return NULL_VALUE_D.
  */
 class AggregatorAvg64 : public TIANMUAggregator {
@@ -143,7 +140,6 @@ class AggregatorAvg64 : public TIANMUAggregator {
  public:
   AggregatorAvg64(int precision) {
     prec_factor = types::PowOfTen(precision);
-    warning_issued = false;
     pack_not_nulls = 0;
     pack_sum = 0;
   }
@@ -151,10 +147,9 @@ class AggregatorAvg64 : public TIANMUAggregator {
       : TIANMUAggregator(sec),
         pack_sum(sec.pack_sum),
         pack_not_nulls(sec.pack_not_nulls),
-        prec_factor(sec.prec_factor),
-        warning_issued(sec.warning_issued) {}
+        prec_factor(sec.prec_factor) {}
   TIANMUAggregator *Copy() override { return new AggregatorAvg64(*this); }
-  int BufferByteSize() override { return 16; }
+  int BufferByteSize() override { return 24; }
   void PutAggregatedValue(unsigned char *buf, int64_t v, int64_t factor) override;
   void Merge(unsigned char *buf, unsigned char *src_buf) override;
   double GetValueD(unsigned char *buf) override;
@@ -163,25 +158,21 @@ class AggregatorAvg64 : public TIANMUAggregator {
     return *((int64_t *)(&res));
   }
 
-  void Reset(unsigned char *buf) override {
-    *((double *)buf) = 0;
-    *((int64_t *)(buf + 8)) = 0;
-  }
+  void Reset(unsigned char *buf) override { std::memset(buf, 0, 24); }
 
   ///////////// Optimization part /////////////////
   bool PackAggregationNeedsSum() override { return true; }
   bool PackAggregationNeedsNotNulls() override { return true; }
-  void SetAggregatePackSum(int64_t par1, int64_t factor) override { pack_sum = double(par1) * factor; }
+  void SetAggregatePackSum(int64_t par1, int64_t factor) override { pack_sum = (__int128)par1 * factor; }
   void SetAggregatePackNotNulls(int64_t par1) override { pack_not_nulls = par1; }
   bool AggregatePack(unsigned char *buf) override;
 
  private:
-  double pack_sum;
+  __int128 pack_sum;
   int64_t pack_not_nulls;
 
   double prec_factor;  // precision factor: the calculated avg must be divided
                        // by it
-  bool warning_issued;
 };
 
 /*!
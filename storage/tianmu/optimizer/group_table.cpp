@@ -443,31 +443,61 @@ int GroupTable::MemoryBlocksLeft() { return vm_tab->MemoryBlocksLeft(); }
 void GroupTable::Merge(GroupTable &sec, Transaction *m_conn) {
   DEBUG_ASSERT(total_width == sec.total_width);
   sec.vm_tab->Rewind(true);
-  int64_t sec_row;
-  int64_t row;
   not_full = true;  // ensure all the new values will be added
   while (sec.vm_tab->RowValid()) {
     if (m_conn->Killed())
       throw common::KilledException();
 
-    sec_row = sec.vm_tab->GetCurrentRow();
-    if (grouping_and_UTF_width > 0)
-      std::memcpy(input_buffer.data(), sec.vm_tab->GetGroupingRow(sec_row), grouping_and_UTF_width);
-
-    FindCurrentRow(row);  // find the value on another position or add as a new one
-    if (row != common::NULL_VALUE_64) {
-      DEBUG_ASSERT(row != common::NULL_VALUE_64);
-      unsigned char *p1 = vm_tab->GetAggregationRow(row);
-      unsigned char *p2 = sec.vm_tab->GetAggregationRow(sec_row);
-      for (int col = no_grouping_attr; col < no_attr; col++) {
-        aggregator[col]->Merge(p1 + aggregated_col_offset[col], p2 + sec.aggregated_col_offset[col]);
-      }
-    }
+    int64_t sec_row = sec.vm_tab->GetCurrentRow();
+    MergeRow(sec, sec.vm_tab->GetGroupingRow(sec_row), sec.vm_tab->GetAggregationRow(sec_row));
     sec.vm_tab->NextRow();
   }
   sec.vm_tab->Clear();
 }
 
+void GroupTable::PartitionRows(std::vector<std::vector<unsigned char>> &rows_by_partition) {
+  uint64_t partitions = rows_by_partition.size();
+  size_t aggregation_width = total_width - grouping_and_UTF_width;
+  vm_tab->Rewind();
+  while (vm_tab->RowValid()) {
+    int64_t row = vm_tab->GetCurrentRow();
+    // the top bits of the hash, the bottom ones place the row in the hash table of the partition
+    unsigned char *grouping_row = vm_tab->GetGroupingRow(row);
+    auto &rows = rows_by_partition[(HashValue(grouping_row, grouping_buf_width) * partitions) >> 32];
+    rows.insert(rows.end(), grouping_row, grouping_row + grouping_and_UTF_width);
+    unsigned char *aggregation_row = vm_tab->GetAggregationRow(row);
+    rows.insert(rows.end(), aggregation_row, aggregation_row + aggregation_width);
+    vm_tab->NextRow();
+  }
+  // the rows come back through MergeRows(), the statistics stay valid for them
+  not_full = true;
+  vm_tab->Clear();
+}
+
+void GroupTable::MergeRows(std::vector<unsigned char> &rows, Transaction *m_conn) {
+  not_full = true;  // ensure all the new values will be added
+  for (size_t pos = 0; pos < rows.size(); pos += total_width) {
+    if (m_conn->Killed())
+      throw common::KilledException();
+
+    MergeRow(*this, &rows[pos], &rows[pos + grouping_and_UTF_width]);
+  }
+}
+
+void GroupTable::MergeRow(GroupTable &sec, unsigned char *sec_grouping_row, unsigned char *sec_aggregation_row) {
+  if (grouping_and_UTF_width > 0)
+    std::memcpy(input_buffer.data(), sec_grouping_row, grouping_and_UTF_width);
+
+  int64_t row;
+  FindCurrentRow(row);  // find the value on another position or add as a new one
+  if (row != common::NULL_VALUE_64) {
+    unsigned char *p1 = vm_tab->GetAggregationRow(row);
+    for (int col = no_grouping_attr; col < no_attr; col++) {
+      aggregator[col]->Merge(p1 + aggregated_col_offset[col], sec_aggregation_row + sec.aggregated_col_offset[col]);
+    }
+  }
+}
+
 int64_t GroupTable::GetValue64(int col, int64_t row) {
   if (col >= no_grouping_attr) {
     return aggregator[col]->GetValue64(vm_tab->GetAggregationRow(row) + aggregated_col_offset[col]);
@@ -113,6 +113,11 @@ class GroupTable : public mm::TraceableObject {
   void AddCurrentValueToCache(int col, GroupDistinctCache &cache);
   void Merge(GroupTable &sec,
              Transaction *m_conn);  // merge values from another (compatible) GroupTable
+  // Partitioned merge, where every table is the owner of one partition: all rows are copied to
+  // rows_by_partition by the hash of the grouping values, then the table is emptied.
+  void PartitionRows(std::vector<std::vector<unsigned char>> &rows_by_partition);
+  // As Merge(), for the rows copied by PartitionRows() of a table of the same layout.
+  void MergeRows(std::vector<unsigned char> &rows, Transaction *m_conn);
   // Group table output and info
 
   bool IsFull() { return !not_full; }  // no place left or all groups found
@@ -158,6 +163,8 @@ class GroupTable : public mm::TraceableObject {
   mm::TO_TYPE TraceableType() const override { return mm::TO_TYPE::TO_TEMPORARY; }
 
  private:
+  void MergeRow(GroupTable &sec, unsigned char *sec_grouping_row, unsigned char *sec_aggregation_row);
+
   std::vector<unsigned char> input_buffer;
   std::vector<int> aggregated_col_offset;  // a table of byte offsets of
                                            // aggregated column beginnings wrt.
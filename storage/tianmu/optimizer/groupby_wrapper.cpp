@@ -269,14 +269,24 @@ void GroupByWrapper::Initialize(int64_t upper_approx_of_groups, bool parallel_al
 void GroupByWrapper::Merge(GroupByWrapper &sec) {
   int64_t old_groups = gt.GetNoOfGroups();
   gt.Merge(sec.gt, m_conn);
+  MergeStatistics(sec);
+
+  // note that no_groups may be different than gt->..., because it is global
+  no_groups += gt.GetNoOfGroups() - old_groups;
+}
+
+void GroupByWrapper::MergeRows(std::vector<unsigned char> &rows) {
+  int64_t old_groups = gt.GetNoOfGroups();
+  gt.MergeRows(rows, m_conn);
+  no_groups += gt.GetNoOfGroups() - old_groups;
+}
+
+void GroupByWrapper::MergeStatistics(GroupByWrapper &sec) {
   if (tuple_left)
     tuple_left->And(*(sec.tuple_left));
 
   packrows_omitted += sec.packrows_omitted;
   packrows_part_omitted += sec.packrows_part_omitted;
-
-  // note that no_groups may be different than gt->..., because it is global
-  no_groups += gt.GetNoOfGroups() - old_groups;
 }
 
 bool GroupByWrapper::AggregatePackInOneGroup(int attr_no, MIIterator &mit, int64_t uniform_pos, int64_t rows_in_pack,
@@ -152,6 +152,15 @@ class GroupByWrapper final {
   bool IsOnePass() { return gt.IsOnePass(); }
   int MemoryBlocksLeft() { return gt.MemoryBlocksLeft(); }  // no place left for more packs (soft limit)
   void Merge(GroupByWrapper &sec);
+  // Partitioned merge: the groups of all wrappers are split by PartitionRows(), which empties
+  // them, then every wrapper takes the groups of one partition back through MergeRows().
+  // MergeStatistics() is applied to one of them.
+  void PartitionRows(std::vector<std::vector<unsigned char>> &rows_by_partition) {
+    gt.PartitionRows(rows_by_partition);
+    no_groups = 0;
+  }
+  void MergeRows(std::vector<unsigned char> &rows);
+  void MergeStatistics(GroupByWrapper &sec);  // rows left to aggregate and omitted packrows
   // A filter of rows to be aggregated
 
   void InitTupleLeft(int64_t n);
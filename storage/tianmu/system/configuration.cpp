@@ -32,6 +32,11 @@ unsigned int tianmu_sysvar_bg_load_threads;
 unsigned int tianmu_sysvar_cachereleasethreshold;
 unsigned int tianmu_sysvar_cachesizethreshold;
 unsigned int tianmu_sysvar_cachinglevel;
+unsigned int tianmu_sysvar_data_cache_shards;
+unsigned int tianmu_sysvar_prefetch_depth;
+char tianmu_sysvar_pack_mmap;
+unsigned int tianmu_sysvar_pack_patch_max_rows;
+unsigned int tianmu_sysvar_version_checkpoint_interval;
 unsigned int tianmu_sysvar_controlquerylog;
 unsigned int tianmu_sysvar_controltrace;
 unsigned int tianmu_sysvar_disk_usage_threshold;
@@ -45,10 +50,12 @@ unsigned int tianmu_sysvar_insert_wait_ms;
 unsigned int tianmu_sysvar_insert_wait_time;
 unsigned int tianmu_sysvar_knlevel;
 unsigned int tianmu_sysvar_load_threads;
+char tianmu_sysvar_load_parallel_parse;
 unsigned int tianmu_sysvar_max_execution_time;
 unsigned int tianmu_sysvar_mm_hardlimit;
 unsigned int tianmu_sysvar_mm_large_threshold;
 unsigned int tianmu_sysvar_mm_largetempratio;
+unsigned int tianmu_sysvar_mm_thread_cache_size;
 unsigned int tianmu_sysvar_query_threads;
 unsigned int tianmu_sysvar_servermainheapsize;
 unsigned int tianmu_sysvar_sync_buffers;
@@ -58,12 +65,14 @@ unsigned int tianmu_sysvar_join_splitrows;
 unsigned int tianmu_sysvar_delete_or_update_threads;
 unsigned int tianmu_sysvar_merge_rocks_expected_count;
 unsigned int tianmu_sysvar_insert_write_batch_size;
+unsigned int tianmu_sysvar_delta_segment_size;
 unsigned int tianmu_sysvar_log_loop_interval;
 my_bool tianmu_sysvar_compensation_start;
 my_bool tianmu_sysvar_filterevaluation_speedup;
 my_bool tianmu_sysvar_groupby_speedup;
 unsigned int tianmu_sysvar_groupby_parallel_degree;
 unsigned long long tianmu_sysvar_groupby_parallel_rows_minimum;
+char tianmu_sysvar_groupby_partitioned_merge;
 unsigned int tianmu_sysvar_slow_query_record_interval;
 unsigned int tianmu_sysvar_index_cache_size;
 my_bool tianmu_sysvar_index_search;
@@ -81,6 +90,16 @@ char tianmu_sysvar_force_hashjoin;
 unsigned int tianmu_sysvar_start_async;
 char *tianmu_sysvar_async_join;
 char tianmu_sysvar_join_disable_switch_side;
+char tianmu_sysvar_join_radix_partition;
+char tianmu_sysvar_join_runtime_filter;
+char tianmu_sysvar_radix_sort;
+unsigned int tianmu_sysvar_result_batch_rows;
+unsigned int tianmu_sysvar_spill_memory_limit;
+char tianmu_sysvar_index_table_compress;
+unsigned int tianmu_sysvar_string_stats_length;
+char tianmu_sysvar_hll_sketches;
+char tianmu_sysvar_native_expression;
+unsigned int tianmu_sysvar_subquery_memo_size;
 char tianmu_sysvar_enable_histogram_cmap_bloom;
 unsigned int tianmu_sysvar_result_sender_rows;
 
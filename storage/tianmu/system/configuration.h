@@ -45,6 +45,16 @@ extern unsigned int tianmu_sysvar_bg_load_threads;
 extern unsigned int tianmu_sysvar_cachereleasethreshold;
 extern unsigned int tianmu_sysvar_cachesizethreshold;
 extern unsigned int tianmu_sysvar_cachinglevel;
+// Number of independently locked shards of the pack/dictionary cache, 0 is auto
+extern unsigned int tianmu_sysvar_data_cache_shards;
+// Number of packs read ahead by the background loader during a scan, 0 disables
+extern unsigned int tianmu_sysvar_prefetch_depth;
+// Map uncompressed integer packs from the data file instead of reading them
+extern char tianmu_sysvar_pack_mmap;
+// Max rows changed in a pack that are kept in a patch instead of rewriting the pack, 0 disables
+extern unsigned int tianmu_sysvar_pack_patch_max_rows;
+// Commits between full column version manifests, the others only list changed packs. 0 always writes full ones
+extern unsigned int tianmu_sysvar_version_checkpoint_interval;
 extern unsigned int tianmu_sysvar_controlquerylog;
 extern unsigned int tianmu_sysvar_controltrace;
 extern unsigned int tianmu_sysvar_disk_usage_threshold;
@@ -60,11 +70,15 @@ extern unsigned int tianmu_sysvar_join_parallel;
 extern unsigned int tianmu_sysvar_join_splitrows;
 extern unsigned int tianmu_sysvar_knlevel;
 extern unsigned int tianmu_sysvar_load_threads;
+// Locate the rows of a LOAD DATA block on the loading thread and convert their values on the loader threads
+extern char tianmu_sysvar_load_parallel_parse;
 extern unsigned int tianmu_sysvar_lookup_max_size;
 extern unsigned int tianmu_sysvar_max_execution_time;
 extern unsigned int tianmu_sysvar_mm_hardlimit;
 extern unsigned int tianmu_sysvar_mm_large_threshold;
 extern unsigned int tianmu_sysvar_mm_largetempratio;
+// Memory (MB) of freed blocks each thread keeps for reuse without the heap lock, 0 disables
+extern unsigned int tianmu_sysvar_mm_thread_cache_size;
 extern unsigned int tianmu_sysvar_query_threads;
 extern unsigned int tianmu_sysvar_servermainheapsize;
 extern unsigned int tianmu_sysvar_sync_buffers;
@@ -83,6 +97,34 @@ extern char *tianmu_sysvar_async_join;
 // tianmu_sysvar_join_disable_switch_side is the option to avoid this switching
 // process.
 extern char tianmu_sysvar_join_disable_switch_side;
+// Partition both sides of an inner hash join by the key hash and join the
+// partitions independently, each with its own small hash table.
+extern char tianmu_sysvar_join_radix_partition;
+// Build a filter of the hash join keys and use it to omit packs and rows of
+// the matched side before the hash table lookup.
+extern char tianmu_sysvar_join_runtime_filter;
+// Sort large in-memory ORDER BY buffers by a parallel radix sort instead of
+// the one pass quicksort.
+extern char tianmu_sysvar_radix_sort;
+// Rows converted column by column at a time when a materialized result is
+// sent to the client, 0 - convert row by row.
+extern unsigned int tianmu_sysvar_result_batch_rows;
+// Memory in MB a query keeps in hash join partitions, the partitions over it go
+// to the cache folder. 0 - no limit.
+extern unsigned int tianmu_sysvar_spill_memory_limit;
+// Keep the IndexTable blocks swapped out of memory bit-packed, in memory as
+// long as they fit in one buffer.
+extern char tianmu_sysvar_index_table_compress;
+// Bytes of the min and max of every string pack kept in the per-pack string
+// statistics, 0 - not kept. Only for collations compared bytewise.
+extern unsigned int tianmu_sysvar_string_stats_length;
+// Keep a HyperLogLog sketch of every pack of the columns that are not floating point,
+// for tianmu_approx_count_distinct. Packs written while it is off have none.
+extern char tianmu_sysvar_hll_sketches;
+// evaluate integer/decimal expressions a pack at a time with native code
+extern char tianmu_sysvar_native_expression;
+// MB of memoized results of a correlated subquery, keyed by the outer values, 0 - off
+extern unsigned int tianmu_sysvar_subquery_memo_size;
 // enable histogram/cmap/bloom filtering
 extern char tianmu_sysvar_enable_histogram_cmap_bloom;
 // The number of rows to load at a time when processing queries like select xxx
@@ -94,6 +136,8 @@ extern unsigned int tianmu_sysvar_delete_or_update_threads;
 extern unsigned int tianmu_sysvar_merge_rocks_expected_count;
 // Threshold to submit in insert request
 extern unsigned int tianmu_sysvar_insert_write_batch_size;
+// Memory (MB) of the columnar copy of unmerged delta inserts per table, 0 disables it
+extern unsigned int tianmu_sysvar_delta_segment_size;
 
 extern unsigned int tianmu_sysvar_log_loop_interval;
 
@@ -103,6 +147,9 @@ extern unsigned int tianmu_sysvar_groupby_parallel_degree;
 // Threshold for the minimum number of rows
 // that can start executing a multithreaded group by thread
 extern unsigned long long tianmu_sysvar_groupby_parallel_rows_minimum;
+// Merge the per-thread group tables of a parallel aggregation by hash partitions,
+// each partition in its own thread, instead of one after another
+extern char tianmu_sysvar_groupby_partitioned_merge;
 // Slow Query Threshold of recording tianmu logs, in seconds
 extern unsigned int tianmu_sysvar_slow_query_record_interval;
 
@@ -119,4 +166,11 @@ struct async_join_setting {
 
 extern async_join_setting tianmu_sysvar_async_join_setting;
 
+class THD;
+// Session variables, read from the connection running the statement
+// Profile the steps of the session's queries, see INFORMATION_SCHEMA.TIANMU_QUERY_PROFILE
+bool tianmu_session_query_profile(THD *thd);
+// Estimate single column COUNT(DISTINCT) from the HyperLogLog sketches of packs
+bool tianmu_session_approx_count_distinct(THD *thd);
+
 #endif  // TIANMU_SYSTEM_CONFIGURATION_H_
@@ -24,7 +24,11 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <cerrno>
+#include <condition_variable>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
 
 #include "common/assert.h"
@@ -143,6 +147,67 @@ void FlushFileChanges(std::string const &path) {
   fb.Close();
 }
 
+namespace {
+struct FlushGroup {
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::set<std::string> pending;  // files of the next flush
+  uint64_t next_gen = 1;          // the flush the pending files belong to
+  uint64_t done_gen = 0;          // last finished flush
+  bool flushing = false;
+  std::map<uint64_t, std::string> errors;  // failed flushes
+};
+}  // namespace
+
+void FlushFilesGrouped(std::vector<std::string> const &paths) {
+  static FlushGroup g;
+
+  std::unique_lock<std::mutex> lk(g.mtx);
+  g.pending.insert(paths.begin(), paths.end());
+  uint64_t gen = g.next_gen;
+
+  while (g.done_gen < gen) {
+    if (g.flushing) {
+      g.cv.wait(lk);
+      continue;
+    }
+
+    // lead the flush of everything queued so far
+    g.flushing = true;
+    auto batch = std::move(g.pending);
+    g.pending.clear();
+    uint64_t cur = g.next_gen++;
+    lk.unlock();
+
+    std::string error;
+    for (auto &f : batch) {
+      std::string err;
+      try {
+        TianmuFile fb;
+        fb.OpenReadOnly(f);
+        if (fb.Flush() != 0)
+          err = f + ": " + std::strerror(errno);
+      } catch (common::TianmuError &e) {
+        err = e.Message();
+      }
+      if (!err.empty()) {
+        TIANMU_LOG(LogCtl_Level::ERROR, "Failed to flush %s", err.c_str());
+        error = err;
+      }
+    }
+
+    lk.lock();
+    if (!error.empty())
+      g.errors[cur] = error;
+    g.flushing = false;
+    g.done_gen = cur;
+    g.cv.notify_all();
+  }
+
+  if (auto it = g.errors.find(gen); it != g.errors.end())
+    throw common::DatabaseException("Failed to flush " + it->second);
+}
+
 bool IsReadWriteAllowed(std::string const &path) {
   int ret = access(path.c_str(), R_OK | W_OK);
   return (ret == 0);
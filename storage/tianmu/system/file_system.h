@@ -19,6 +19,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace Tianmu {
 namespace system {
@@ -71,6 +72,14 @@ void FlushDirectoryChanges(std::string const &path);
 
 void FlushFileChanges(std::string const &path);
 
+/** \brief Flush files to the disk together with concurrent callers
+ *  \param paths  Files to flush
+ *  Callers arriving while a flush is running queue their files for the next
+ *  one, which flushes each queued file once for all of them.
+ *  Function throws an exception if any of the files could not be flushed
+ */
+void FlushFilesGrouped(std::vector<std::string> const &paths);
+
 /** \brief Check file permissions
  *  \param path  File path
  *  \return True if a process is allowed to read and write a file. False
@@ -0,0 +1,159 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "core/data_cache.h"
+#include "system/configuration.h"
+
+using namespace std;
+using namespace Tianmu;
+
+namespace {
+
+constexpr int kPacks = 4096;  // 16 columns of 256 packs
+constexpr int kLookupsPerThread = 200000;
+
+// Stands in for a pack: the cache only needs a traceable object of the pack type,
+// none of the data of a column.
+class CachedPack final : public mm::TraceableObject {
+ public:
+  explicit CachedPack(const core::PackCoordinate &pc) {
+    m_coord.ID = core::COORD_TYPE::PACK;
+    m_coord.co.pack = pc;
+  }
+  mm::TO_TYPE TraceableType() const override { return mm::TO_TYPE::TO_PACK; }
+  void Release() override {}
+  size_t CompressedBytes() const { return 0; }
+  // the memory manager of the engine with a main heap of 1 GB
+  static mm::MemoryHandling *Manager() { return Instance(0, size_t(1) << 30); }
+};
+
+// A column which creates packs instead of reading them, counting the loads.
+struct Fetcher {
+  std::shared_ptr<CachedPack> Fetch(const core::PackCoordinate &pc) {
+    loads++;
+    return std::make_shared<CachedPack>(pc);
+  }
+  std::atomic<int> loads{0};
+};
+
+core::PackCoordinate Coord(int i) { return core::PackCoordinate(1, i / 256, i % 256); }
+
+class TianmuDataCache : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    tianmu_sysvar_mm_policy = const_cast<char *>("system");
+    tianmu_sysvar_mm_releasepolicy = const_cast<char *>("all");
+    CachedPack::Manager();
+  }
+  void TearDown() override { tianmu_sysvar_data_cache_shards = 0; }
+
+  static void Get(core::DataCache &cache, Fetcher &fetcher, int i) {
+    cache.GetOrFetchObject<CachedPack>(Coord(i), &fetcher)->Unlock();
+  }
+
+  // Milliseconds `threads` workers take to look up kLookupsPerThread random packs of
+  // a cache which holds all of them.
+  static double RunLookups(core::DataCache &cache, Fetcher &fetcher, int threads) {
+    for (int i = 0; i < kPacks; i++) Get(cache, fetcher, i);
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+      workers.emplace_back([&cache, &fetcher, t] {
+        minstd_rand rnd(t);
+        for (int i = 0; i < kLookupsPerThread; i++) Get(cache, fetcher, rnd() % kPacks);
+      });
+    for (auto &w : workers) w.join();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  }
+};
+
+}  // namespace
+
+TEST_F(TianmuDataCache, ShardCountFromSysvar) {
+  tianmu_sysvar_data_cache_shards = 8;
+  EXPECT_EQ(8u, core::DataCache().getShards());
+  tianmu_sysvar_data_cache_shards = 0;
+  unsigned n = core::DataCache().getShards();
+  EXPECT_GE(n, 2 * thread::hardware_concurrency());
+  EXPECT_EQ(0u, n & (n - 1));  // a power of two
+}
+
+TEST_F(TianmuDataCache, CountsHitsAndMissesOverShards) {
+  tianmu_sysvar_data_cache_shards = 16;
+  core::DataCache cache;
+  Fetcher fetcher;
+  for (int i = 0; i < 100; i++) Get(cache, fetcher, i);
+  for (int i = 0; i < 100; i += 2) Get(cache, fetcher, i);
+  EXPECT_EQ(100, fetcher.loads);
+  EXPECT_EQ(100, cache.getPackLoads());
+  EXPECT_EQ(100, cache.getCacheMisses());
+  EXPECT_EQ(50, cache.getCacheHits());
+
+  cache.DropObject(Coord(0));
+  Get(cache, fetcher, 0);
+  EXPECT_EQ(101, fetcher.loads);
+  EXPECT_EQ(1, cache.getReleased());
+  EXPECT_EQ(0, cache.getPackLoadInProgress());
+}
+
+TEST_F(TianmuDataCache, ConcurrentLookupsLoadEachPackOnce) {
+  core::DataCache cache;
+  Fetcher fetcher;
+  vector<thread> workers;
+  for (int t = 0; t < 8; t++)
+    workers.emplace_back([&cache, &fetcher] {
+      for (int i = 0; i < kPacks; i++) Get(cache, fetcher, i);
+    });
+  for (auto &w : workers) w.join();
+  EXPECT_EQ(kPacks, fetcher.loads);
+  EXPECT_EQ(8 * kPacks, cache.getCacheHits() + cache.getCacheMisses());
+  EXPECT_EQ(0, cache.getLoadErrors());
+}
+
+// Not a pass/fail test: prints how the GetOrFetchObject() throughput of a warm cache
+// scales with the number of threads, for one shard (a single cache mutex) and for
+// the default shard count.
+TEST_F(TianmuDataCache, BenchmarkGetOrFetchObject) {
+  unsigned max_threads = max(8u, thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    tianmu_sysvar_data_cache_shards = 1;
+    core::DataCache single;
+    Fetcher f1;
+    double single_ms = RunLookups(single, f1, threads);
+    tianmu_sysvar_data_cache_shards = 0;
+    core::DataCache sharded;
+    Fetcher f2;
+    double sharded_ms = RunLookups(sharded, f2, threads);
+    double ops = 1.0 * kLookupsPerThread * threads;
+    cout << threads << " threads: 1 shard " << ops / single_ms / 1000 << " Mops/s, " << sharded.getShards()
+         << " shards " << ops / sharded_ms / 1000 << " Mops/s (x" << single_ms / sharded_ms << ")" << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "compress/int_codec.h"
+
+using namespace std;
+using namespace Tianmu::compress;
+
+namespace {
+
+constexpr uint kPackRows = 65536;
+
+const vector<IntCodecType> kCodecs{IntCodecType::FOR_BITPACK, IntCodecType::DELTA_BITPACK, IntCodecType::ZSTD,
+                                   IntCodecType::LZ4};
+
+enum class Shape { RANDOM, SMALL_RANGE, ASCENDING, DESCENDING, CONSTANT };
+
+template <class T>
+vector<T> MakeData(Shape shape, uint rows, unsigned seed) {
+  mt19937_64 gen(seed);
+  vector<T> res(rows);
+  T prev = 0;
+  for (uint i = 0; i < rows; i++) {
+    switch (shape) {
+      case Shape::RANDOM:
+        res[i] = static_cast<T>(gen());
+        break;
+      case Shape::SMALL_RANGE:
+        res[i] = static_cast<T>(1000 + gen() % 100);
+        break;
+      case Shape::ASCENDING:
+        res[i] = prev = static_cast<T>(prev + gen() % 4);
+        break;
+      case Shape::DESCENDING:
+        res[i] = prev = static_cast<T>(prev - gen() % 4);
+        break;
+      case Shape::CONSTANT:
+        res[i] = 42;
+        break;
+    }
+  }
+  return res;
+}
+
+template <class T>
+void CheckRoundTrip(IntCodecType type, const vector<T> &data) {
+  IntCodec<T> codec(type);
+  uint len = IntCodec<T>::Bound(type, data.size());
+  vector<char> buf(len);
+  ASSERT_EQ(CprsErr::CPRS_SUCCESS, codec.Compress(buf.data(), len, data.data(), data.size()));
+  ASSERT_LE(len, IntCodec<T>::Bound(type, data.size()));
+  vector<T> out(data.size() + 1, T(0x5a));
+  ASSERT_EQ(CprsErr::CPRS_SUCCESS, codec.Decompress(out.data(), buf.data(), len, data.size()));
+  EXPECT_TRUE(equal(data.begin(), data.end(), out.begin())) << IntCodecName(type) << " width " << sizeof(T);
+  EXPECT_EQ(T(0x5a), out[data.size()]) << "wrote past the end";
+}
+
+template <class T>
+void CheckAllShapes() {
+  for (auto type : kCodecs)
+    for (auto shape : {Shape::RANDOM, Shape::SMALL_RANGE, Shape::ASCENDING, Shape::DESCENDING, Shape::CONSTANT})
+      for (uint rows : {0u, 1u, 127u, 128u, 129u, 1000u, kPackRows}) CheckRoundTrip<T>(type, MakeData<T>(shape, rows, rows));
+}
+
+template <class F>
+double MeasureMs(int rounds, F f) {
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) f();
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / rounds;
+}
+
+}  // namespace
+
+TEST(TianmuIntCodec, RoundTrip8) { CheckAllShapes<unsigned char>(); }
+TEST(TianmuIntCodec, RoundTrip16) { CheckAllShapes<unsigned short>(); }
+TEST(TianmuIntCodec, RoundTrip32) { CheckAllShapes<unsigned int>(); }
+TEST(TianmuIntCodec, RoundTrip64) { CheckAllShapes<uint64_t>(); }
+
+TEST(TianmuIntCodec, CorruptedInput) {
+  auto data = MakeData<unsigned int>(Shape::SMALL_RANGE, 1000, 1);
+  for (auto type : kCodecs) {
+    IntCodec<unsigned int> codec(type);
+    uint len = IntCodec<unsigned int>::Bound(type, data.size());
+    vector<char> buf(len);
+    ASSERT_EQ(CprsErr::CPRS_SUCCESS, codec.Compress(buf.data(), len, data.data(), data.size()));
+    vector<unsigned int> out(data.size());
+    EXPECT_NE(CprsErr::CPRS_SUCCESS, codec.Decompress(out.data(), buf.data(), len / 2, data.size()))
+        << IntCodecName(type);
+  }
+}
+
+// Not a pass/fail test: prints ratio and decompression throughput of each codec per pack.
+TEST(TianmuIntCodec, BenchmarkDecompression) {
+  const int rounds = 20;
+  for (auto shape : {Shape::SMALL_RANGE, Shape::ASCENDING, Shape::RANDOM}) {
+    auto data = MakeData<unsigned int>(shape, kPackRows, 3);
+    cout << "shape " << static_cast<int>(shape) << ":";
+    for (auto type : kCodecs) {
+      IntCodec<unsigned int> codec(type);
+      uint len = IntCodec<unsigned int>::Bound(type, kPackRows);
+      vector<char> buf(len);
+      ASSERT_EQ(CprsErr::CPRS_SUCCESS, codec.Compress(buf.data(), len, data.data(), kPackRows));
+      vector<unsigned int> out(kPackRows);
+      double ms = MeasureMs(rounds, [&] { codec.Decompress(out.data(), buf.data(), len, kPackRows); });
+      cout << " " << IntCodecName(type) << " ratio " << double(kPackRows * sizeof(unsigned int)) / len << " "
+           << kPackRows * sizeof(unsigned int) / ms / 1000 << " MB/s;";
+    }
+    cout << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
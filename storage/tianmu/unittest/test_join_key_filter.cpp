@@ -0,0 +1,171 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "core/join_key_filter.h"
+
+using namespace std;
+using namespace Tianmu::core;
+
+namespace {
+
+// Big-endian, as ColumnBinEncoder::EncoderInt writes the codes.
+void PutKey(uint64_t v, size_t width, unsigned char *buf) {
+  for (size_t i = 0; i < width; i++) buf[width - 1 - i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+}  // namespace
+
+TEST(TianmuJoinKeyFilter, ExactBitmap) {
+  JoinKeyFilter filter(2, 100);
+  ASSERT_TRUE(filter.IsExact());
+  unsigned char buf[2];
+  for (uint64_t v : {0, 5, 63, 64, 4095, 4096, 65535}) {
+    PutKey(v, 2, buf);
+    EXPECT_EQ(v, JoinKeyFilter::KeyCode(buf, 2));
+    filter.Add(buf);
+  }
+  std::unordered_set<uint64_t> added{0, 5, 63, 64, 4095, 4096, 65535};
+  for (uint64_t v = 0; v < 65536; v++) {
+    PutKey(v, 2, buf);
+    ASSERT_EQ(added.count(v) > 0, filter.MayContain(buf)) << v;
+  }
+}
+
+TEST(TianmuJoinKeyFilter, ExactRanges) {
+  mt19937_64 rng(7);
+  JoinKeyFilter filter(3, 1000);
+  vector<bool> added(1 << 24);
+  unsigned char buf[3];
+  for (int i = 0; i < 200; i++) {
+    uint64_t v = rng() % (1 << 24);
+    added[v] = true;
+    PutKey(v, 3, buf);
+    filter.Add(buf);
+  }
+  for (int i = 0; i < 2000; i++) {
+    uint64_t lo = rng() % (1 << 24);
+    uint64_t hi = lo + rng() % (i % 2 ? 100 : 200000);
+    bool expected = false;
+    for (uint64_t v = lo; v <= hi && v < (1 << 24) && !expected; v++) expected = added[v];
+    ASSERT_EQ(expected, filter.MayContainRange(lo, hi)) << lo << ".." << hi;
+  }
+  EXPECT_TRUE(filter.MayContainRange(0, UINT64_MAX));
+  EXPECT_FALSE(filter.MayContainRange(uint64_t(1) << 24, UINT64_MAX));
+}
+
+TEST(TianmuJoinKeyFilter, BloomHasNoFalseNegatives) {
+  const int kKeys = 100000;
+  JoinKeyFilter filter(8, kKeys);
+  ASSERT_FALSE(filter.IsExact());
+  unsigned char buf[8];
+  for (int i = 0; i < kKeys; i++) {
+    PutKey(uint64_t(i) * 7919, 8, buf);
+    filter.Add(buf);
+  }
+  for (int i = 0; i < kKeys; i++) {
+    PutKey(uint64_t(i) * 7919, 8, buf);
+    ASSERT_TRUE(filter.MayContain(buf)) << i;
+  }
+  int false_positives = 0;
+  for (int i = 0; i < kKeys; i++) {
+    PutKey(uint64_t(i) * 7919 + 1, 8, buf);
+    false_positives += filter.MayContain(buf);
+  }
+  EXPECT_LT(false_positives, kKeys / 20);
+  EXPECT_TRUE(filter.MayContainRange(0, 100));  // ranges are not supported by the Bloom filter
+}
+
+TEST(TianmuJoinKeyFilter, ConcurrentAdd) {
+  const int kThreads = 4;
+  const int kKeysPerThread = 50000;
+  JoinKeyFilter exact(3, kThreads * kKeysPerThread);
+  JoinKeyFilter bloom(12, kThreads * kKeysPerThread);
+  vector<thread> workers;
+  for (int t = 0; t < kThreads; t++)
+    workers.emplace_back([&, t] {
+      unsigned char buf[12] = {};
+      for (int i = t; i < kThreads * kKeysPerThread; i += kThreads) {
+        PutKey(i, 3, buf);
+        exact.Add(buf);
+        PutKey(i, 12, buf);
+        bloom.Add(buf);
+      }
+    });
+  for (auto &w : workers) w.join();
+  unsigned char buf[12] = {};
+  for (int i = 0; i < kThreads * kKeysPerThread; i++) {
+    PutKey(i, 3, buf);
+    ASSERT_TRUE(exact.MayContain(buf)) << i;
+    PutKey(i, 12, buf);
+    ASSERT_TRUE(bloom.MayContain(buf)) << i;
+  }
+  EXPECT_TRUE(exact.MayContainRange(0, 0));
+  EXPECT_FALSE(exact.MayContainRange(kThreads * kKeysPerThread, 1 << 24));
+}
+
+// Not a pass/fail test: a star join probe where 0.1% of the fact keys match,
+// with and without the filter in front of the hash table lookup.
+TEST(TianmuJoinKeyFilter, BenchmarkSelectiveProbe) {
+  const int kBuildKeys = 1 << 20;
+  const int kProbeRows = 1 << 23;
+  mt19937_64 rng(11);
+  unordered_set<uint64_t> table;
+  JoinKeyFilter filter(8, kBuildKeys);
+  unsigned char buf[8];
+  for (int i = 0; i < kBuildKeys; i++) {
+    uint64_t v = rng() | 1;
+    table.insert(v);
+    PutKey(v, 8, buf);
+    filter.Add(buf);
+  }
+  vector<uint64_t> probe(kProbeRows);
+  vector<uint64_t> build(table.begin(), table.end());
+  for (int i = 0; i < kProbeRows; i++) probe[i] = (i % 1000 == 0) ? build[rng() % build.size()] : (rng() & ~1ULL);
+
+  auto start = chrono::steady_clock::now();
+  int64_t plain_found = 0;
+  for (uint64_t v : probe) plain_found += table.count(v);
+  double plain_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+  start = chrono::steady_clock::now();
+  int64_t filtered_found = 0;
+  for (uint64_t v : probe) {
+    PutKey(v, 8, buf);
+    if (filter.MayContain(buf))
+      filtered_found += table.count(v);
+  }
+  double filtered_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+  EXPECT_EQ(plain_found, filtered_found);
+  cout << "hash lookup only " << plain_ms << " ms, runtime filter first " << filtered_ms << " ms (x"
+       << plain_ms / filtered_ms << "), filter " << filter.MemorySize() / 1024 << " KB" << endl;
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
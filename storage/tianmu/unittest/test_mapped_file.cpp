@@ -0,0 +1,162 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "util/mapped_file.h"
+
+using namespace std;
+using namespace Tianmu::utils;
+
+namespace {
+
+constexpr size_t kPackRows = 65536;
+constexpr size_t kPacks = 256;
+constexpr size_t kHeader = 100;  // keeps the packs off page boundaries, like packs in a data file
+
+template <typename F>
+double MeasureMs(int rounds, F f) {
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) f();
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / rounds;
+}
+
+off_t PackOffset(size_t pack) { return kHeader + pack * kPackRows * sizeof(uint32_t); }
+
+uint64_t Sum(const uint32_t *vals, size_t n) { return accumulate(vals, vals + n, uint64_t(0)); }
+
+}  // namespace
+
+class TianmuMappedFile : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    char name[] = "/tmp/tianmu_mapped_file_XXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_GE(fd, 0);
+    path_ = name;
+    vector<char> header(kHeader, 'h');
+    ASSERT_EQ(write(fd, header.data(), kHeader), ssize_t(kHeader));
+    vector<uint32_t> pack(kPackRows);
+    for (size_t p = 0; p < kPacks; p++) {
+      iota(pack.begin(), pack.end(), uint32_t(p * kPackRows));
+      ASSERT_EQ(write(fd, pack.data(), pack.size() * sizeof(uint32_t)), ssize_t(pack.size() * sizeof(uint32_t)));
+    }
+    close(fd);
+  }
+  virtual void TearDown() { unlink(path_.c_str()); }
+
+  // The copying path of PackInt: open the data file, read the pack into an owned buffer.
+  uint64_t ReadPack(size_t pack) const {
+    int fd = open(path_.c_str(), O_RDONLY);
+    unique_ptr<uint32_t[]> buf(new uint32_t[kPackRows]);
+    EXPECT_EQ(pread(fd, buf.get(), kPackRows * sizeof(uint32_t), PackOffset(pack)),
+              ssize_t(kPackRows * sizeof(uint32_t)));
+    close(fd);
+    return Sum(buf.get(), kPackRows);
+  }
+
+  uint64_t MapPack(MappedFile &file, size_t pack) const {
+    auto vals = reinterpret_cast<const uint32_t *>(file.Map(PackOffset(pack), kPackRows * sizeof(uint32_t)));
+    EXPECT_NE(nullptr, vals);
+    return Sum(vals, kPackRows);
+  }
+
+  string path_;
+};
+
+TEST_F(TianmuMappedFile, MapsRanges) {
+  MappedFile missing(path_ + ".missing");
+  EXPECT_EQ(nullptr, missing.Map(0, 16));
+
+  MappedFile file(path_);
+  EXPECT_EQ(nullptr, file.Map(0, 0));
+  EXPECT_EQ(nullptr, file.Map(PackOffset(kPacks), 1));  // past the end of the file
+
+  const char *header = file.Map(0, kHeader);
+  ASSERT_NE(nullptr, header);
+  EXPECT_EQ(string(kHeader, 'h'), string(header, kHeader));
+
+  for (size_t p : {size_t(0), size_t(1), kPacks - 1}) {
+    auto vals = reinterpret_cast<const uint32_t *>(file.Map(PackOffset(p), kPackRows * sizeof(uint32_t)));
+    ASSERT_NE(nullptr, vals);
+    EXPECT_EQ(p * kPackRows, vals[0]);
+    EXPECT_EQ((p + 1) * kPackRows - 1, vals[kPackRows - 1]);
+  }
+  EXPECT_EQ(1u, file.Mappings());
+}
+
+TEST_F(TianmuMappedFile, MapsAppendedData) {
+  MappedFile file(path_);
+  const char *header = file.Map(0, kHeader);
+  ASSERT_NE(nullptr, header);
+
+  // an append within the reserved address space is served by the same mapping
+  int fd = open(path_.c_str(), O_WRONLY | O_APPEND);
+  ASSERT_GE(fd, 0);
+  uint32_t tail = 12345;
+  ASSERT_EQ(write(fd, &tail, sizeof(tail)), ssize_t(sizeof(tail)));
+  auto val = reinterpret_cast<const uint32_t *>(file.Map(PackOffset(kPacks), sizeof(tail)));
+  ASSERT_NE(nullptr, val);
+  EXPECT_EQ(tail, *val);
+  EXPECT_EQ(1u, file.Mappings());
+
+  // past the reservation the file is mapped again, the earlier addresses stay valid
+  ASSERT_EQ(ftruncate(fd, 2 * PackOffset(kPacks) + (64 << 20)), 0);
+  close(fd);
+  ASSERT_NE(nullptr, file.Map(PackOffset(kPacks) + (64 << 20), 16));
+  EXPECT_EQ(2u, file.Mappings());
+  EXPECT_EQ(string(kHeader, 'h'), string(header, kHeader));
+}
+
+// Not a pass/fail test: prints the scan throughput of reading packs versus taking them
+// from the mapping of the file.
+TEST_F(TianmuMappedFile, BenchmarkScan) {
+  const int rounds = 5;
+  uint64_t read_sum = 0, map_sum = 0;
+  MappedFile file(path_);
+  auto scan_read = [&] {
+    read_sum = 0;
+    for (size_t p = 0; p < kPacks; p++) read_sum += ReadPack(p);
+  };
+  auto scan_map = [&] {
+    map_sum = 0;
+    for (size_t p = 0; p < kPacks; p++) map_sum += MapPack(file, p);
+  };
+  scan_read();  // the file is in the page cache for both paths
+  scan_map();   // and the page tables of the mapping are filled, as for a column in use
+  double read_ms = MeasureMs(rounds, scan_read);
+  double map_ms = MeasureMs(rounds, scan_map);
+  EXPECT_EQ(read_sum, map_sum);
+
+  double mb = double(kPacks * kPackRows * sizeof(uint32_t)) / (1 << 20);
+  cout << "read+copy " << mb / read_ms * 1000 << " MB/s, mapped " << mb / map_ms * 1000 << " MB/s (x"
+       << read_ms / map_ms << ")" << endl;
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,148 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "util/radix_sort.h"
+
+using namespace std;
+using namespace Tianmu::utils;
+
+namespace {
+
+size_t qsort_key_bytes = 0;
+int CompareKeys(const void *a, const void *b) { return memcmp(a, b, qsort_key_bytes); }
+
+void RunOnThreads(vector<function<void()>> &tasks) {
+  vector<thread> workers;
+  for (auto &t : tasks) workers.emplace_back(t);
+  for (auto &w : workers) w.join();
+}
+
+// Records of total_bytes with a key_bytes prefix; `shared_prefix` leading key
+// bytes are the same everywhere (as the high bytes of small integer codes).
+vector<unsigned char> MakeRecords(size_t rows, size_t key_bytes, size_t total_bytes, size_t shared_prefix,
+                                  int distinct_bytes, unsigned seed) {
+  mt19937 rng(seed);
+  vector<unsigned char> recs(rows * total_bytes);
+  for (size_t i = 0; i < rows; i++) {
+    unsigned char *r = &recs[i * total_bytes];
+    for (size_t j = 0; j < total_bytes; j++)
+      r[j] = (j < shared_prefix) ? 7 : (j < key_bytes ? rng() % distinct_bytes : (i >> (8 * (j % 4))) & 0xff);
+  }
+  return recs;
+}
+
+void ExpectSorted(const vector<unsigned char> &sorted, vector<unsigned char> reference, size_t key_bytes,
+                  size_t total_bytes) {
+  size_t rows = reference.size() / total_bytes;
+  for (size_t i = 1; i < rows; i++)
+    ASSERT_LE(memcmp(&sorted[(i - 1) * total_bytes], &sorted[i * total_bytes], key_bytes), 0) << i;
+  // The same multiset of records: compare with the reference sorted by whole records.
+  vector<unsigned char> got(sorted);
+  qsort_key_bytes = total_bytes;
+  qsort(got.data(), rows, total_bytes, CompareKeys);
+  qsort(reference.data(), rows, total_bytes, CompareKeys);
+  EXPECT_TRUE(got == reference);
+}
+
+struct Layout {
+  size_t key_bytes;
+  size_t total_bytes;
+  size_t shared_prefix;
+  int distinct_bytes;
+};
+const vector<Layout> kLayouts{{1, 5, 0, 3},  {2, 6, 0, 256}, {4, 8, 2, 256},
+                              {8, 16, 3, 256}, {12, 20, 0, 4}, {24, 32, 6, 256}};
+
+}  // namespace
+
+TEST(TianmuRadixSort, SortsRecordsByKeys) {
+  for (auto &l : kLayouts)
+    for (size_t rows : {0, 1, 2, 23, 24, 25, 1000, 70000}) {
+      auto recs = MakeRecords(rows, l.key_bytes, l.total_bytes, l.shared_prefix, l.distinct_bytes, rows);
+      auto reference = recs;
+      vector<unsigned char> tmp(recs.size());
+      RadixSortRecords(recs.data(), tmp.data(), rows, l.key_bytes, l.total_bytes);
+      ExpectSorted(recs, reference, l.key_bytes, l.total_bytes);
+    }
+}
+
+TEST(TianmuRadixSort, ParallelSortsRecordsByKeys) {
+  for (auto &l : kLayouts)
+    for (int parts : {2, 3, 8}) {
+      size_t rows = 100000 + parts;
+      auto recs = MakeRecords(rows, l.key_bytes, l.total_bytes, l.shared_prefix, l.distinct_bytes, parts);
+      auto reference = recs;
+      vector<unsigned char> tmp(recs.size());
+      ParallelRadixSort(recs.data(), tmp.data(), rows, l.key_bytes, l.total_bytes, parts, RunOnThreads);
+      ExpectSorted(recs, reference, l.key_bytes, l.total_bytes);
+    }
+}
+
+TEST(TianmuRadixSort, EqualKeys) {
+  size_t rows = 100000;
+  auto recs = MakeRecords(rows, 6, 10, 6, 1, 1);
+  auto reference = recs;
+  vector<unsigned char> tmp(recs.size());
+  ParallelRadixSort(recs.data(), tmp.data(), rows, 6, 10, 4, RunOnThreads);
+  EXPECT_TRUE(recs == reference);  // nothing to sort, nothing moved
+}
+
+// Not a pass/fail test: prints the sorting time of qsort (comparison sort on
+// the same records, as the one pass quicksort does) and of the radix sorts.
+TEST(TianmuRadixSort, BenchmarkMixedKeyWidths) {
+  const size_t kRows = 2000000;
+  int threads = max(2u, thread::hardware_concurrency());
+  for (auto &l : kLayouts) {
+    auto input = MakeRecords(kRows, l.key_bytes, l.total_bytes, l.shared_prefix, l.distinct_bytes, 42);
+    vector<unsigned char> tmp(input.size());
+
+    auto recs = input;
+    auto start = chrono::steady_clock::now();
+    qsort_key_bytes = l.key_bytes;
+    qsort(recs.data(), kRows, l.total_bytes, CompareKeys);
+    double qsort_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    recs = input;
+    start = chrono::steady_clock::now();
+    RadixSortRecords(recs.data(), tmp.data(), kRows, l.key_bytes, l.total_bytes);
+    double radix_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    recs = input;
+    start = chrono::steady_clock::now();
+    ParallelRadixSort(recs.data(), tmp.data(), kRows, l.key_bytes, l.total_bytes, threads, RunOnThreads);
+    double parallel_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    cout << l.key_bytes << "+" << l.total_bytes - l.key_bytes << " bytes: qsort " << qsort_ms << " ms, radix "
+         << radix_ms << " ms (x" << qsort_ms / radix_ms << "), " << threads << " tasks " << parallel_ms << " ms (x"
+         << qsort_ms / parallel_ms << ")" << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
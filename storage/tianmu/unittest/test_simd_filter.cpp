@@ -0,0 +1,168 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "util/simd_filter.h"
+
+using namespace std;
+using namespace Tianmu::utils;
+
+namespace {
+
+constexpr size_t kPackRows = 65536;
+
+// Mirrors the PackInt value access: a switch on the value width per row.
+struct RowPack {
+  int width;
+  vector<uint8_t> buf;
+
+  RowPack(int w, size_t rows, uint64_t maxv, unsigned seed) : width(w), buf(rows * w) {
+    mt19937_64 gen(seed);
+    for (size_t n = 0; n < rows; n++) {
+      uint64_t v = gen() % (maxv + 1);
+      memcpy(&buf[n * w], &v, w);  // little endian
+    }
+  }
+  size_t rows() const { return buf.size() / width; }
+  uint64_t operator[](size_t n) const {
+    switch (width) {
+      case 8:
+        return reinterpret_cast<const uint64_t *>(buf.data())[n];
+      case 4:
+        return reinterpret_cast<const uint32_t *>(buf.data())[n];
+      case 2:
+        return reinterpret_cast<const uint16_t *>(buf.data())[n];
+      default:
+        return buf[n];
+    }
+  }
+};
+
+uint64_t MaxOfWidth(int w) { return w == 8 ? UINT64_MAX : (uint64_t(1) << (8 * w)) - 1; }
+
+vector<uint64_t> RowByRowBetween(const RowPack &p, uint64_t lo, uint64_t hi) {
+  vector<uint64_t> mask(MaskWords(p.rows()), 0);
+  for (size_t n = 0; n < p.rows(); n++) {
+    uint64_t v = p[n];
+    if (lo <= v && v <= hi)
+      mask[n / 64] |= uint64_t(1) << (n % 64);
+  }
+  return mask;
+}
+
+vector<uint64_t> RowByRowInList(const RowPack &p, const vector<uint64_t> &vals) {
+  vector<uint64_t> mask(MaskWords(p.rows()), 0);
+  for (size_t n = 0; n < p.rows(); n++)
+    for (auto v : vals)
+      if (p[n] == v) {
+        mask[n / 64] |= uint64_t(1) << (n % 64);
+        break;
+      }
+  return mask;
+}
+
+vector<SimdLevel> Levels() {
+  vector<SimdLevel> res{SimdLevel::SCALAR};
+  if (DetectSimdLevel() >= SimdLevel::AVX2)
+    res.push_back(SimdLevel::AVX2);
+  if (DetectSimdLevel() >= SimdLevel::AVX512)
+    res.push_back(SimdLevel::AVX512);
+  return res;
+}
+
+template <typename F>
+double MeasureMs(int rounds, F f) {
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) f();
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / rounds;
+}
+
+}  // namespace
+
+class TianmuSimdFilter : public testing::Test {
+ protected:
+  virtual void SetUp() { cout << "Detected simd level: " << SimdLevelName(DetectSimdLevel()) << endl; };
+};
+
+TEST_F(TianmuSimdFilter, BetweenMatchesRowByRow) {
+  for (int w : {1, 2, 4, 8}) {
+    uint64_t maxv = w == 8 ? (uint64_t(1) << 40) : MaxOfWidth(w);
+    // odd row counts exercise the scalar tail
+    for (size_t rows : {size_t(1), size_t(63), size_t(64), size_t(1000), kPackRows}) {
+      RowPack p(w, rows, maxv, 17 + w);
+      vector<pair<uint64_t, uint64_t>> ranges{{0, maxv}, {0, 0}, {maxv / 3, maxv / 2}, {maxv, maxv}, {5, 4}};
+      if (w < 8)
+        ranges.push_back({maxv / 2, maxv + 100});  // upper bound wider than the pack width
+      for (auto &r : ranges) {
+        auto expected = RowByRowBetween(p, r.first, r.second);
+        for (auto level : Levels()) {
+          vector<uint64_t> mask(MaskWords(rows), ~uint64_t(0));
+          BetweenMask(p.buf.data(), w, rows, r.first, r.second, mask.data(), level);
+          EXPECT_EQ(expected, mask) << "width " << w << " rows " << rows << " level " << SimdLevelName(level);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TianmuSimdFilter, InListMatchesRowByRow) {
+  for (int w : {1, 2, 4, 8}) {
+    uint64_t maxv = w == 1 ? 255 : 5000;
+    for (size_t rows : {size_t(100), kPackRows}) {
+      RowPack p(w, rows, maxv, 31 + w);
+      vector<vector<uint64_t>> lists{{7}, {0, 3, 250, 4999}, {MaxOfWidth(w) + (w < 8 ? 1 : 0)}};
+      for (auto &vals : lists) {
+        auto expected = RowByRowInList(p, vals);
+        for (auto level : Levels()) {
+          vector<uint64_t> mask(MaskWords(rows), ~uint64_t(0));
+          InListMask(p.buf.data(), w, rows, vals.data(), vals.size(), mask.data(), level);
+          EXPECT_EQ(expected, mask) << "width " << w << " rows " << rows << " level " << SimdLevelName(level);
+        }
+      }
+    }
+  }
+}
+
+// Not a pass/fail test: prints the per-pack cost of the row-by-row path and of each kernel.
+TEST_F(TianmuSimdFilter, BenchmarkBetween) {
+  const int rounds = 50;
+  for (int w : {1, 2, 4, 8}) {
+    uint64_t maxv = w == 8 ? (uint64_t(1) << 40) : MaxOfWidth(w);
+    RowPack p(w, kPackRows, maxv, 7);
+    uint64_t lo = maxv / 4, hi = maxv / 2;
+    vector<uint64_t> mask(MaskWords(kPackRows));
+    double row_ms = MeasureMs(rounds, [&] { mask = RowByRowBetween(p, lo, hi); });
+    cout << "width " << w << ": row-by-row " << row_ms << " ms/pack";
+    for (auto level : Levels()) {
+      double ms = MeasureMs(rounds, [&] { BetweenMask(p.buf.data(), w, kPackRows, lo, hi, mask.data(), level); });
+      cout << ", " << SimdLevelName(level) << " " << ms << " ms/pack (x" << row_ms / ms << ")";
+    }
+    cout << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,246 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "mm/thread_cache.h"
+#include "mm/traceable_object.h"
+#include "system/configuration.h"
+
+using namespace std;
+using namespace Tianmu::mm;
+
+namespace {
+
+// pack value buffers (64K rows of 8 and 4 bytes) and a filter block (64K bits)
+const vector<size_t> kChunkSizes{512 << 10, 256 << 10, 8 << 10};
+constexpr int kThreads = 8;
+constexpr int kOpsPerThread = 20000;
+constexpr unsigned kCacheMB = 4;
+// a capacity beyond any cache, trimming to it only adds the counters of the calling thread
+constexpr size_t kNoTrim = SIZE_MAX;
+
+// A temporary buffer owning the blocks of one worker, as scan workers own filter
+// blocks and value buffers.
+class Buffer final : public TraceableObject {
+ public:
+  TO_TYPE TraceableType() const override { return TO_TYPE::TO_TEMPORARY; }
+  void *Get(size_t size) { return alloc(size, BLOCK_TYPE::BLOCK_TEMPORARY); }
+  void Put(void *p) { dealloc(p); }
+  // the memory manager of the engine with a main heap of 1 GB
+  static MemoryHandling *Manager() { return Instance(0, size_t(1) << 30); }
+};
+
+class TianmuThreadCache : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    tianmu_sysvar_mm_policy = const_cast<char *>("system");
+    tianmu_sysvar_mm_releasepolicy = const_cast<char *>("all");
+    mh_ = Buffer::Manager();
+  }
+  void SetUp() override {
+    tianmu_sysvar_mm_thread_cache_size = kCacheMB;
+    mh_->TrimThreadCaches(0);
+  }
+  void TearDown() override { mh_->TrimThreadCaches(0); }
+
+  // bytes taken from the heap and not given back yet
+  static unsigned long HeldBytes() {
+    mh_->TrimThreadCaches(kNoTrim);
+    return mh_->getAllocSize() - mh_->getFreeSize();
+  }
+
+  // Runs `threads` workers which allocate and free blocks, keeping a few alive, and
+  // then wait with their caches filled until `parked` returns.
+  template <typename F>
+  static double RunWorkers(int threads, int ops, F parked) {
+    mutex mtx;
+    condition_variable cv;
+    int done = 0;
+    bool resume = false;
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+      workers.emplace_back([&, t] {
+        {
+          Buffer buf[4];
+          vector<pair<Buffer *, void *>> live;
+          for (int i = 0; i < ops; i++) {
+            Buffer *owner = &buf[i % 4];
+            live.emplace_back(owner, owner->Get(kChunkSizes[(i + t) % kChunkSizes.size()]));
+            if (live.size() > 4) {
+              live.front().first->Put(live.front().second);
+              live.erase(live.begin());
+            }
+          }
+          for (auto &b : live) b.first->Put(b.second);
+        }
+        mh_->TrimThreadCaches(kNoTrim);
+        unique_lock<mutex> lk(mtx);
+        done++;
+        cv.notify_all();
+        cv.wait(lk, [&resume] { return resume; });
+      });
+    double ms;
+    {
+      unique_lock<mutex> lk(mtx);
+      cv.wait(lk, [&done, threads] { return done == threads; });
+      ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+      parked();
+      resume = true;
+      cv.notify_all();
+    }
+    for (auto &w : workers) w.join();
+    return ms;
+  }
+
+  static MemoryHandling *mh_;
+};
+MemoryHandling *TianmuThreadCache::mh_ = nullptr;
+
+}  // namespace
+
+TEST(TianmuThreadCacheClasses, SizeClasses) {
+  EXPECT_EQ(0, ThreadCache::SizeClass(1));
+  EXPECT_EQ(0, ThreadCache::SizeClass(64));
+  EXPECT_EQ(-1, ThreadCache::SizeClass((1 << 20) + 1));
+  EXPECT_EQ(ThreadCache::kNumClasses - 1, ThreadCache::SizeClass(1 << 20));
+  for (size_t size = 1; size <= (1 << 20); size += (size < 4096 ? 1 : 997)) {
+    int cl = ThreadCache::SizeClass(size);
+    ASSERT_GE(cl, 0);
+    ASSERT_LT(cl, ThreadCache::kNumClasses);
+    // the smallest class that fits, at most a quarter larger than the request
+    ASSERT_GE(ThreadCache::ClassSize(cl), size) << size;
+    if (cl > 0) {
+      ASSERT_LT(ThreadCache::ClassSize(cl - 1), size) << size;
+      ASSERT_LE(ThreadCache::ClassSize(cl), size + size / 4 + 1) << size;
+    }
+  }
+  for (int cl = 0; cl < ThreadCache::kNumClasses; cl++)
+    EXPECT_EQ(cl, ThreadCache::SizeClass(ThreadCache::ClassSize(cl)));
+}
+
+TEST(TianmuThreadCacheClasses, KeepsBlocksUpToCapacity) {
+  ThreadCache cache;
+  int cl = ThreadCache::SizeClass(8 << 10);
+  size_t block = ThreadCache::ClassSize(cl);
+  vector<void *> blocks;
+  for (int i = 0; i < 4; i++) blocks.push_back(malloc(block));
+
+  EXPECT_EQ(nullptr, cache.Pop(cl));
+  for (int i = 0; i < 3; i++) EXPECT_TRUE(cache.Push(cl, blocks[i], 3 * block));
+  EXPECT_FALSE(cache.Push(cl, blocks[3], 3 * block));
+  EXPECT_EQ(3 * block, cache.CachedBytes());
+  EXPECT_EQ(blocks[2], cache.Pop(cl));  // last freed, first reused
+  EXPECT_EQ(2u, cache.Length(cl));
+
+  int freed = 0;
+  cache.Trim(block, [&freed, block](void *p, size_t size) {
+    EXPECT_EQ(block, size);
+    free(p);
+    freed++;
+  });
+  EXPECT_EQ(1, freed);
+  EXPECT_EQ(block, cache.CachedBytes());
+  cache.Trim(0, [](void *p, size_t) { free(p); });
+  EXPECT_EQ(0u, cache.CachedBytes());
+  free(blocks[2]);
+  free(blocks[3]);
+}
+
+TEST_F(TianmuThreadCache, CachedBlocksStayAllocated) {
+  size_t block = 8 << 10;
+  int n = ThreadCache::RefillCount(ThreadCache::SizeClass(block));
+  unsigned long held = HeldBytes();
+  unsigned long free_blocks = mh_->getFreeBlocks();
+  {
+    Buffer buf;
+    vector<void *> blocks;
+    // the first miss takes a batch of blocks from the heap, the rest of them are cached
+    for (int i = 0; i < n; i++) blocks.push_back(buf.Get(block));
+    EXPECT_EQ(held + n * block, HeldBytes());
+    for (void *p : blocks) buf.Put(p);
+  }
+  // the freed blocks went to the cache of this thread, not to the heap
+  EXPECT_EQ(held + n * block, HeldBytes());
+  EXPECT_EQ(free_blocks, mh_->getFreeBlocks());
+
+  mh_->TrimThreadCaches(0);
+  EXPECT_EQ(held, HeldBytes());
+  EXPECT_EQ(free_blocks + n, mh_->getFreeBlocks());
+}
+
+TEST_F(TianmuThreadCache, ReleaseMemoryEmptiesAllCaches) {
+  unsigned long held = HeldBytes();
+  RunWorkers(kThreads, 1000, [held] {
+    unsigned long cached = HeldBytes() - held;
+    EXPECT_GT(cached, 0u);
+    EXPECT_LE(cached, kThreads * kCacheMB * (1UL << 20));
+    mh_->ReleaseMemory(0, nullptr);
+    EXPECT_EQ(held, HeldBytes());
+  });
+  EXPECT_EQ(mh_->getAllocBlocks(), mh_->getFreeBlocks());
+}
+
+TEST_F(TianmuThreadCache, LoweredCapacityTrimsCaches) {
+  unsigned long held = HeldBytes();
+  RunWorkers(kThreads, 1000, [held] {
+    // what tianmu_mm_thread_cache_size does when it is lowered
+    tianmu_sysvar_mm_thread_cache_size = 1;
+    mh_->TrimThreadCaches(1UL << 20);
+    EXPECT_LE(HeldBytes() - held, kThreads * (1UL << 20));
+    tianmu_sysvar_mm_thread_cache_size = 0;
+    mh_->TrimThreadCaches(0);
+    EXPECT_EQ(held, HeldBytes());
+  });
+}
+
+TEST_F(TianmuThreadCache, ExitingThreadReturnsItsCache) {
+  unsigned long held = HeldBytes();
+  thread([] {
+    Buffer buf;
+    buf.Put(buf.Get(8 << 10));
+  }).join();
+  EXPECT_EQ(held, HeldBytes());
+}
+
+// Not a pass/fail test: prints the alloc/free throughput of the memory manager with
+// and without the thread caches.
+TEST_F(TianmuThreadCache, BenchmarkAllocFree) {
+  for (int threads : {1, 2, 4, 8}) {
+    tianmu_sysvar_mm_thread_cache_size = 0;
+    double global_ms = RunWorkers(threads, kOpsPerThread, [] {});
+    tianmu_sysvar_mm_thread_cache_size = kCacheMB;
+    double cached_ms = RunWorkers(threads, kOpsPerThread, [] {});
+    mh_->TrimThreadCaches(0);
+    double ops = 2.0 * kOpsPerThread * threads;
+    cout << threads << " threads: heap lock " << ops / global_ms / 1000 << " Mops/s, thread cache "
+         << ops / cached_ms / 1000 << " Mops/s (x" << global_ms / cached_ms << ")" << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
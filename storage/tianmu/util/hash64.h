@@ -117,6 +117,17 @@ class Hash64 final {
 
   int capacity() { return capacity_; }
 
+  // all inserted values, in no particular order
+  std::vector<int64_t> Values() const {
+    std::vector<int64_t> res;
+    if (zero_inserted_)
+      res.push_back(0);
+    for (auto v : table_)
+      if (v != 0)
+        res.push_back(v);
+    return res;
+  }
+
  private:
   int capacity_;
   int64_t address_mask_;
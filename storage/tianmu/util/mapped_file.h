@@ -0,0 +1,91 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_UTIL_MAPPED_FILE_H_
+#define TIANMU_UTIL_MAPPED_FILE_H_
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Tianmu {
+namespace utils {
+
+// A read-only shared mapping of a whole file, which may be appended to meanwhile.
+// The file is mapped once, with address space reserved ahead of its end; only when
+// a range goes beyond the reservation is the file mapped again, into a reservation
+// twice as large. The earlier mappings stay until destruction, so the addresses
+// handed out remain valid. The pages are those of the page cache, the caller must
+// not read a range while it is being rewritten.
+class MappedFile final {
+ public:
+  explicit MappedFile(const std::string &file) : file_(file) {}
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+    for (auto &m : maps_) ::munmap(m.first, m.second);
+    if (fd_ >= 0)
+      ::close(fd_);
+  }
+
+  // The address of the byte range [offset, offset + len) of the file, nullptr if it
+  // is not in the file or can not be mapped, the caller should read it instead.
+  const char *Map(uint64_t offset, uint64_t len) {
+    if (len == 0)
+      return nullptr;
+    std::scoped_lock guard(mtx_);
+    if (offset + len > file_size_) {  // appended since the last look
+      if (fd_ < 0 && (fd_ = ::open(file_.c_str(), O_RDONLY)) < 0)
+        return nullptr;
+      struct stat sb;
+      if (::fstat(fd_, &sb) != 0 || uint64_t(sb.st_size) < offset + len)
+        return nullptr;
+      file_size_ = sb.st_size;
+    }
+    if (maps_.empty() || offset + len > maps_.back().second) {
+      size_t map_len = maps_.empty() ? kMinMapSize : maps_.back().second;
+      while (map_len < file_size_) map_len *= 2;
+      // shared, not private: nothing writes through the mapping, and rows appended to
+      // the file by other threads must be visible through it
+      void *addr = ::mmap(nullptr, map_len, PROT_READ, MAP_SHARED, fd_, 0);
+      if (addr == MAP_FAILED)
+        return nullptr;
+      maps_.emplace_back(addr, map_len);
+    }
+    return static_cast<const char *>(maps_.back().first) + offset;
+  }
+
+  size_t Mappings() const { return maps_.size(); }
+
+ private:
+  static constexpr size_t kMinMapSize = 64UL << 20;
+
+  const std::string file_;
+  int fd_ = -1;
+  uint64_t file_size_ = 0;
+  std::vector<std::pair<void *, size_t>> maps_;  // address and length of every mapping, the last one is used
+  std::mutex mtx_;
+};
+
+}  // namespace utils
+}  // namespace Tianmu
+
+#endif  // TIANMU_UTIL_MAPPED_FILE_H_
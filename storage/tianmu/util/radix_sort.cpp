@@ -0,0 +1,171 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include "util/radix_sort.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+
+namespace Tianmu {
+namespace utils {
+namespace {
+// Buckets smaller than this are finished by insertion sort.
+const size_t kInsertionSortRows = 24;
+// Below this number of rows the parallel sort is not worth the tasks.
+const size_t kParallelSortRows = 1 << 16;
+
+using Histogram = std::array<size_t, 256>;
+
+void InsertionSort(unsigned char *recs, unsigned char *rec_tmp, size_t rows, size_t key_bytes, size_t total_bytes,
+                   size_t byte_pos) {
+  size_t cmp_bytes = key_bytes - byte_pos;
+  for (size_t i = 1; i < rows; i++) {
+    unsigned char *cur = recs + i * total_bytes;
+    if (std::memcmp(cur - total_bytes + byte_pos, cur + byte_pos, cmp_bytes) <= 0)
+      continue;
+    std::memcpy(rec_tmp, cur, total_bytes);
+    unsigned char *pos = cur - total_bytes;
+    while (pos > recs && std::memcmp(pos - total_bytes + byte_pos, rec_tmp + byte_pos, cmp_bytes) > 0)
+      pos -= total_bytes;
+    std::memmove(pos + total_bytes, pos, cur - pos);
+    std::memcpy(pos, rec_tmp, total_bytes);
+  }
+}
+
+void Count(const unsigned char *recs, size_t rows, size_t total_bytes, size_t byte_pos, Histogram &counts) {
+  counts.fill(0);
+  const unsigned char *p = recs + byte_pos;
+  for (size_t i = 0; i < rows; i++, p += total_bytes) counts[*p]++;
+}
+
+void Scatter(const unsigned char *recs, size_t rows, size_t total_bytes, size_t byte_pos, Histogram &offsets,
+             unsigned char *dst) {
+  const unsigned char *p = recs;
+  for (size_t i = 0; i < rows; i++, p += total_bytes)
+    std::memcpy(dst + offsets[p[byte_pos]]++ * total_bytes, p, total_bytes);
+}
+}  // namespace
+
+void RadixSortRecords(unsigned char *recs, unsigned char *tmp, size_t rows, size_t key_bytes, size_t total_bytes,
+                      size_t byte_pos) {
+  Histogram counts;
+  while (true) {
+    if (byte_pos >= key_bytes || rows < 2)
+      return;
+    if (rows < kInsertionSortRows) {
+      InsertionSort(recs, tmp, rows, key_bytes, total_bytes, byte_pos);
+      return;
+    }
+    Count(recs, rows, total_bytes, byte_pos, counts);
+    if (*std::max_element(counts.begin(), counts.end()) < rows)
+      break;
+    byte_pos++;  // the same byte everywhere, go to the next one
+  }
+
+  Histogram offsets;
+  size_t sum = 0;
+  for (int b = 0; b < 256; b++) {
+    offsets[b] = sum;
+    sum += counts[b];
+  }
+  Scatter(recs, rows, total_bytes, byte_pos, offsets, tmp);
+  std::memcpy(recs, tmp, rows * total_bytes);
+
+  size_t start = 0;
+  for (int b = 0; b < 256; start += counts[b], b++)
+    if (counts[b] > 1)
+      RadixSortRecords(recs + start * total_bytes, tmp + start * total_bytes, counts[b], key_bytes, total_bytes,
+                       byte_pos + 1);
+}
+
+void ParallelRadixSort(unsigned char *recs, unsigned char *tmp, size_t rows, size_t key_bytes, size_t total_bytes,
+                       int parts, const TaskRunner &run) {
+  if (parts < 2 || rows < kParallelSortRows) {
+    RadixSortRecords(recs, tmp, rows, key_bytes, total_bytes);
+    return;
+  }
+  size_t chunk = (rows + parts - 1) / parts;
+  std::vector<Histogram> counts(parts);
+  std::vector<std::function<void()>> tasks;
+
+  // The first byte which really splits the data.
+  size_t byte_pos = 0;
+  Histogram total;
+  for (; byte_pos < key_bytes; byte_pos++) {
+    tasks.clear();
+    for (int p = 0; p < parts; p++) {
+      size_t begin = std::min(rows, p * chunk);
+      size_t end = std::min(rows, begin + chunk);
+      tasks.emplace_back(
+          [&, p, begin, end] { Count(recs + begin * total_bytes, end - begin, total_bytes, byte_pos, counts[p]); });
+    }
+    run(tasks);
+    total.fill(0);
+    for (auto &c : counts)
+      for (int b = 0; b < 256; b++) total[b] += c[b];
+    if (*std::max_element(total.begin(), total.end()) < rows)
+      break;
+  }
+  if (byte_pos >= key_bytes)
+    return;  // all keys are equal
+
+  // Each chunk scatters to its own part of every bucket.
+  std::vector<Histogram> offsets(parts);
+  Histogram bucket_start;
+  size_t sum = 0;
+  for (int b = 0; b < 256; b++) {
+    bucket_start[b] = sum;
+    for (int p = 0; p < parts; p++) {
+      offsets[p][b] = sum;
+      sum += counts[p][b];
+    }
+  }
+  tasks.clear();
+  for (int p = 0; p < parts; p++) {
+    size_t begin = std::min(rows, p * chunk);
+    size_t end = std::min(rows, begin + chunk);
+    tasks.emplace_back([&, p, begin, end] {
+      Scatter(recs + begin * total_bytes, end - begin, total_bytes, byte_pos, offsets[p], tmp);
+    });
+  }
+  run(tasks);
+
+  // Buckets are sorted in tmp (with recs as the scratch space) and copied
+  // back, the largest ones first.
+  std::vector<int> order;
+  for (int b = 0; b < 256; b++)
+    if (total[b] > 0)
+      order.push_back(b);
+  std::sort(order.begin(), order.end(), [&total](int a, int b) { return total[a] > total[b]; });
+  std::atomic<size_t> next(0);
+  tasks.clear();
+  for (int p = 0; p < parts; p++)
+    tasks.emplace_back([&] {
+      for (size_t i = next++; i < order.size(); i = next++) {
+        int b = order[i];
+        unsigned char *bucket = tmp + bucket_start[b] * total_bytes;
+        RadixSortRecords(bucket, recs + bucket_start[b] * total_bytes, total[b], key_bytes, total_bytes, byte_pos + 1);
+        std::memcpy(recs + bucket_start[b] * total_bytes, bucket, total[b] * total_bytes);
+      }
+    });
+  run(tasks);
+}
+
+}  // namespace utils
+}  // namespace Tianmu
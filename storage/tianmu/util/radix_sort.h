@@ -0,0 +1,46 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_UTIL_RADIX_SORT_H_
+#define TIANMU_UTIL_RADIX_SORT_H_
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace Tianmu {
+namespace utils {
+
+// MSD radix sort of fixed size records (total_bytes each) by their first
+// key_bytes, compared as by std::memcmp() - i.e. the binary comparable keys
+// made by ColumnBinEncoder. tmp is a scratch buffer of the same size as recs.
+// The first byte_pos bytes of the keys are assumed to be equal.
+void RadixSortRecords(unsigned char *recs, unsigned char *tmp, size_t rows, size_t key_bytes, size_t total_bytes,
+                      size_t byte_pos = 0);
+
+// Runs all the tasks, possibly in parallel, and returns when all of them are done.
+using TaskRunner = std::function<void(std::vector<std::function<void()>> &tasks)>;
+
+// As above, but the first radix pass is split into `parts` chunks and the
+// resulting buckets are sorted by `parts` tasks.
+void ParallelRadixSort(unsigned char *recs, unsigned char *tmp, size_t rows, size_t key_bytes, size_t total_bytes,
+                       int parts, const TaskRunner &run);
+
+}  // namespace utils
+}  // namespace Tianmu
+
+#endif  // TIANMU_UTIL_RADIX_SORT_H_
@@ -0,0 +1,359 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+
+#include "util/simd_filter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define TIANMU_SIMD_X86 1
+#endif
+
+namespace Tianmu {
+namespace utils {
+
+namespace {
+
+// Scalar kernels, also used for the tails of the vector loops.
+// (v - lo) <= (hi - lo) in T arithmetic is a single unsigned range check.
+template <typename T>
+void BetweenScalar(const T *data, size_t from, size_t rows, T lo, T delta, uint64_t *mask) {
+  for (size_t w = from / 64; w * 64 < rows; w++) {
+    uint64_t bits = 0;
+    size_t end = std::min(rows, w * 64 + 64);
+    for (size_t n = w * 64; n < end; n++)
+      bits |= uint64_t(static_cast<T>(data[n] - lo) <= delta) << (n & 63);
+    mask[w] = bits;
+  }
+}
+
+template <typename T>
+void InListScalar(const T *data, size_t from, size_t rows, const T *vals, size_t no_vals, uint64_t *mask) {
+  for (size_t w = from / 64; w * 64 < rows; w++) {
+    uint64_t bits = 0;
+    size_t end = std::min(rows, w * 64 + 64);
+    for (size_t n = w * 64; n < end; n++) {
+      bool hit = false;
+      for (size_t i = 0; i < no_vals; i++) hit |= (data[n] == vals[i]);
+      bits |= uint64_t(hit) << (n & 63);
+    }
+    mask[w] = bits;
+  }
+}
+
+#ifdef TIANMU_SIMD_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+template <typename T>
+struct Avx2Ops;
+
+template <>
+struct Avx2Ops<uint8_t> {
+  static constexpr int kLanes = 32;
+  static __m256i Set1(uint8_t v) { return _mm256_set1_epi8(static_cast<char>(v)); }
+  static __m256i Sub(__m256i a, __m256i b) { return _mm256_sub_epi8(a, b); }
+  static __m256i Le(__m256i a, __m256i b) { return _mm256_cmpeq_epi8(_mm256_max_epu8(a, b), b); }
+  static __m256i Eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi8(a, b); }
+  static uint64_t Bits(const __m256i *m) {
+    return uint64_t(uint32_t(_mm256_movemask_epi8(m[0]))) | (uint64_t(uint32_t(_mm256_movemask_epi8(m[1]))) << 32);
+  }
+};
+
+template <>
+struct Avx2Ops<uint16_t> {
+  static constexpr int kLanes = 16;
+  static __m256i Set1(uint16_t v) { return _mm256_set1_epi16(static_cast<short>(v)); }
+  static __m256i Sub(__m256i a, __m256i b) { return _mm256_sub_epi16(a, b); }
+  static __m256i Le(__m256i a, __m256i b) { return _mm256_cmpeq_epi16(_mm256_max_epu16(a, b), b); }
+  static __m256i Eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi16(a, b); }
+  static uint64_t Bits(const __m256i *m) {
+    // packs interleaves 128-bit lanes, the permute restores row order
+    uint64_t res = 0;
+    for (int i = 0; i < 2; i++) {
+      __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi16(m[2 * i], m[2 * i + 1]), 0xD8);
+      res |= uint64_t(uint32_t(_mm256_movemask_epi8(p))) << (32 * i);
+    }
+    return res;
+  }
+};
+
+template <>
+struct Avx2Ops<uint32_t> {
+  static constexpr int kLanes = 8;
+  static __m256i Set1(uint32_t v) { return _mm256_set1_epi32(static_cast<int>(v)); }
+  static __m256i Sub(__m256i a, __m256i b) { return _mm256_sub_epi32(a, b); }
+  static __m256i Le(__m256i a, __m256i b) { return _mm256_cmpeq_epi32(_mm256_max_epu32(a, b), b); }
+  static __m256i Eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi32(a, b); }
+  static uint64_t Bits(const __m256i *m) {
+    uint64_t res = 0;
+    for (int i = 0; i < 8; i++) res |= uint64_t(_mm256_movemask_ps(_mm256_castsi256_ps(m[i]))) << (8 * i);
+    return res;
+  }
+};
+
+template <>
+struct Avx2Ops<uint64_t> {
+  static constexpr int kLanes = 4;
+  static __m256i Set1(uint64_t v) { return _mm256_set1_epi64x(static_cast<long long>(v)); }
+  static __m256i Sub(__m256i a, __m256i b) { return _mm256_sub_epi64(a, b); }
+  static __m256i Le(__m256i a, __m256i b) {
+    // no unsigned 64-bit compare in AVX2: flip the sign bits and compare signed
+    const __m256i sign = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+    __m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+    return _mm256_xor_si256(gt, _mm256_set1_epi64x(-1));
+  }
+  static __m256i Eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi64(a, b); }
+  static uint64_t Bits(const __m256i *m) {
+    uint64_t res = 0;
+    for (int i = 0; i < 16; i++) res |= uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(m[i]))) << (4 * i);
+    return res;
+  }
+};
+
+template <typename T>
+size_t BetweenAvx2(const T *data, size_t rows, T lo, T delta, uint64_t *mask) {
+  using Ops = Avx2Ops<T>;
+  constexpr int kVecs = 64 / Ops::kLanes;
+  const __m256i vlo = Ops::Set1(lo);
+  const __m256i vdelta = Ops::Set1(delta);
+  size_t words = rows / 64;
+  for (size_t w = 0; w < words; w++) {
+    __m256i m[kVecs];
+    const T *p = data + w * 64;
+    for (int i = 0; i < kVecs; i++) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i * Ops::kLanes));
+      m[i] = Ops::Le(Ops::Sub(v, vlo), vdelta);
+    }
+    mask[w] = Ops::Bits(m);
+  }
+  return words * 64;
+}
+
+template <typename T>
+size_t InListAvx2(const T *data, size_t rows, const T *vals, size_t no_vals, uint64_t *mask) {
+  using Ops = Avx2Ops<T>;
+  constexpr int kVecs = 64 / Ops::kLanes;
+  size_t words = rows / 64;
+  for (size_t w = 0; w < words; w++) {
+    __m256i m[kVecs];
+    const T *p = data + w * 64;
+    for (int i = 0; i < kVecs; i++) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i * Ops::kLanes));
+      __m256i hit = _mm256_setzero_si256();
+      for (size_t k = 0; k < no_vals; k++) hit = _mm256_or_si256(hit, Ops::Eq(v, Ops::Set1(vals[k])));
+      m[i] = hit;
+    }
+    mask[w] = Ops::Bits(m);
+  }
+  return words * 64;
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+
+template <typename T>
+struct Avx512Ops;
+
+template <>
+struct Avx512Ops<uint8_t> {
+  static constexpr int kLanes = 64;
+  static __m512i Set1(uint8_t v) { return _mm512_set1_epi8(static_cast<char>(v)); }
+  static __m512i Sub(__m512i a, __m512i b) { return _mm512_sub_epi8(a, b); }
+  static uint64_t Le(__m512i a, __m512i b) { return _mm512_cmple_epu8_mask(a, b); }
+  static uint64_t Eq(__m512i a, __m512i b) { return _mm512_cmpeq_epi8_mask(a, b); }
+};
+
+template <>
+struct Avx512Ops<uint16_t> {
+  static constexpr int kLanes = 32;
+  static __m512i Set1(uint16_t v) { return _mm512_set1_epi16(static_cast<short>(v)); }
+  static __m512i Sub(__m512i a, __m512i b) { return _mm512_sub_epi16(a, b); }
+  static uint64_t Le(__m512i a, __m512i b) { return _mm512_cmple_epu16_mask(a, b); }
+  static uint64_t Eq(__m512i a, __m512i b) { return _mm512_cmpeq_epi16_mask(a, b); }
+};
+
+template <>
+struct Avx512Ops<uint32_t> {
+  static constexpr int kLanes = 16;
+  static __m512i Set1(uint32_t v) { return _mm512_set1_epi32(static_cast<int>(v)); }
+  static __m512i Sub(__m512i a, __m512i b) { return _mm512_sub_epi32(a, b); }
+  static uint64_t Le(__m512i a, __m512i b) { return _mm512_cmple_epu32_mask(a, b); }
+  static uint64_t Eq(__m512i a, __m512i b) { return _mm512_cmpeq_epi32_mask(a, b); }
+};
+
+template <>
+struct Avx512Ops<uint64_t> {
+  static constexpr int kLanes = 8;
+  static __m512i Set1(uint64_t v) { return _mm512_set1_epi64(static_cast<long long>(v)); }
+  static __m512i Sub(__m512i a, __m512i b) { return _mm512_sub_epi64(a, b); }
+  static uint64_t Le(__m512i a, __m512i b) { return _mm512_cmple_epu64_mask(a, b); }
+  static uint64_t Eq(__m512i a, __m512i b) { return _mm512_cmpeq_epi64_mask(a, b); }
+};
+
+template <typename T>
+size_t BetweenAvx512(const T *data, size_t rows, T lo, T delta, uint64_t *mask) {
+  using Ops = Avx512Ops<T>;
+  constexpr int kVecs = 64 / Ops::kLanes;
+  const __m512i vlo = Ops::Set1(lo);
+  const __m512i vdelta = Ops::Set1(delta);
+  size_t words = rows / 64;
+  for (size_t w = 0; w < words; w++) {
+    uint64_t bits = 0;
+    const T *p = data + w * 64;
+    for (int i = 0; i < kVecs; i++) {
+      __m512i v = _mm512_loadu_si512(p + i * Ops::kLanes);
+      bits |= Ops::Le(Ops::Sub(v, vlo), vdelta) << (i * Ops::kLanes);
+    }
+    mask[w] = bits;
+  }
+  return words * 64;
+}
+
+template <typename T>
+size_t InListAvx512(const T *data, size_t rows, const T *vals, size_t no_vals, uint64_t *mask) {
+  using Ops = Avx512Ops<T>;
+  constexpr int kVecs = 64 / Ops::kLanes;
+  size_t words = rows / 64;
+  for (size_t w = 0; w < words; w++) {
+    uint64_t bits = 0;
+    const T *p = data + w * 64;
+    for (int i = 0; i < kVecs; i++) {
+      __m512i v = _mm512_loadu_si512(p + i * Ops::kLanes);
+      uint64_t hit = 0;
+      for (size_t k = 0; k < no_vals; k++) hit |= Ops::Eq(v, Ops::Set1(vals[k]));
+      bits |= hit << (i * Ops::kLanes);
+    }
+    mask[w] = bits;
+  }
+  return words * 64;
+}
+
+#pragma GCC pop_options
+
+#endif  // TIANMU_SIMD_X86
+
+template <typename T>
+void BetweenTyped(const T *data, size_t rows, uint64_t lo, uint64_t hi, uint64_t *mask, SimdLevel level) {
+  if (lo > hi || lo > std::numeric_limits<T>::max()) {
+    std::memset(mask, 0, MaskWords(rows) * sizeof(uint64_t));
+    return;
+  }
+  if (hi > std::numeric_limits<T>::max())
+    hi = std::numeric_limits<T>::max();
+  T tlo = static_cast<T>(lo);
+  T delta = static_cast<T>(hi - lo);
+  size_t done = 0;
+#ifdef TIANMU_SIMD_X86
+  if (level == SimdLevel::AVX512)
+    done = BetweenAvx512<T>(data, rows, tlo, delta, mask);
+  else if (level == SimdLevel::AVX2)
+    done = BetweenAvx2<T>(data, rows, tlo, delta, mask);
+#endif
+  BetweenScalar<T>(data, done, rows, tlo, delta, mask);
+}
+
+template <typename T>
+void InListTyped(const T *data, size_t rows, const uint64_t *vals, size_t no_vals, uint64_t *mask,
+                 SimdLevel level) {
+  std::vector<T> tvals;
+  tvals.reserve(no_vals);
+  for (size_t i = 0; i < no_vals; i++)
+    if (vals[i] <= std::numeric_limits<T>::max())
+      tvals.push_back(static_cast<T>(vals[i]));
+  if (tvals.empty()) {
+    std::memset(mask, 0, MaskWords(rows) * sizeof(uint64_t));
+    return;
+  }
+  size_t done = 0;
+#ifdef TIANMU_SIMD_X86
+  if (level == SimdLevel::AVX512)
+    done = InListAvx512<T>(data, rows, tvals.data(), tvals.size(), mask);
+  else if (level == SimdLevel::AVX2)
+    done = InListAvx2<T>(data, rows, tvals.data(), tvals.size(), mask);
+#endif
+  InListScalar<T>(data, done, rows, tvals.data(), tvals.size(), mask);
+}
+
+}  // namespace
+
+SimdLevel DetectSimdLevel() {
+  static const SimdLevel level = [] {
+#ifdef TIANMU_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+      return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+      return SimdLevel::AVX2;
+#endif
+    return SimdLevel::SCALAR;
+  }();
+  return level;
+}
+
+const char *SimdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::AVX512:
+      return "avx512";
+    case SimdLevel::AVX2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+
+void BetweenMask(const void *data, int width, size_t rows, uint64_t lo, uint64_t hi, uint64_t *mask,
+                 SimdLevel level) {
+  if (level > DetectSimdLevel())
+    level = DetectSimdLevel();
+  switch (width) {
+    case 8:
+      return BetweenTyped(static_cast<const uint64_t *>(data), rows, lo, hi, mask, level);
+    case 4:
+      return BetweenTyped(static_cast<const uint32_t *>(data), rows, lo, hi, mask, level);
+    case 2:
+      return BetweenTyped(static_cast<const uint16_t *>(data), rows, lo, hi, mask, level);
+    default:
+      return BetweenTyped(static_cast<const uint8_t *>(data), rows, lo, hi, mask, level);
+  }
+}
+
+void InListMask(const void *data, int width, size_t rows, const uint64_t *vals, size_t no_vals, uint64_t *mask,
+                SimdLevel level) {
+  if (level > DetectSimdLevel())
+    level = DetectSimdLevel();
+  switch (width) {
+    case 8:
+      return InListTyped(static_cast<const uint64_t *>(data), rows, vals, no_vals, mask, level);
+    case 4:
+      return InListTyped(static_cast<const uint32_t *>(data), rows, vals, no_vals, mask, level);
+    case 2:
+      return InListTyped(static_cast<const uint16_t *>(data), rows, vals, no_vals, mask, level);
+    default:
+      return InListTyped(static_cast<const uint8_t *>(data), rows, vals, no_vals, mask, level);
+  }
+}
+
+}  // namespace utils
+}  // namespace Tianmu
@@ -0,0 +1,50 @@
+/* Copyright (c) 2022 StoneAtom, Inc. All rights reserved.
+   Use is subject to license terms
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1335 USA
+*/
+#ifndef TIANMU_UTIL_SIMD_FILTER_H_
+#define TIANMU_UTIL_SIMD_FILTER_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tianmu {
+namespace utils {
+
+// Batch predicate kernels over an array of unsigned 1/2/4/8-byte values
+// (e.g. the level-2 encoded data of PackInt). Results are written as a bitmap,
+// 64 rows per word, bit n set iff row n matches. Words past the last row are
+// zero-padded up to the end of the last used word only.
+enum class SimdLevel { SCALAR = 0, AVX2 = 1, AVX512 = 2 };
+
+// Best level supported by the running CPU (detected once).
+SimdLevel DetectSimdLevel();
+const char *SimdLevelName(SimdLevel level);
+
+// lo <= v <= hi (unsigned). Bounds wider than `width` are clamped.
+void BetweenMask(const void *data, int width, size_t rows, uint64_t lo, uint64_t hi, uint64_t *mask,
+                 SimdLevel level = DetectSimdLevel());
+
+// v is equal to one of vals[0..no_vals).
+void InListMask(const void *data, int width, size_t rows, const uint64_t *vals, size_t no_vals, uint64_t *mask,
+                SimdLevel level = DetectSimdLevel());
+
+inline size_t MaskWords(size_t rows) { return (rows + 63) / 64; }
+
+}  // namespace utils
+}  // namespace Tianmu
+
+#endif  // TIANMU_UTIL_SIMD_FILTER_H_
@@ -17,15 +17,23 @@
 #include <iostream>
 
 #include "common/common_definitions.h"
+#include "core/engine.h"
 #include "core/transaction.h"
 #include "sorter3.h"
 #include "system/fet.h"
 #include "system/tianmu_system.h"
 #include "util/bin_tools.h"
+#include "util/radix_sort.h"
+#include "util/thread_pool.h"
 #include "util/tools.h"
 
 namespace Tianmu {
 namespace core {
+namespace {
+// Below this number of rows the quicksort is good enough.
+const int64_t kRadixSortMinRows = 65536;
+}  // namespace
+
 // A static function to create a proper sorter
 Sorter3 *Sorter3::CreateSorter(int64_t size, uint key_bytes, uint total_bytes, int64_t limit, int mem_modifier) {
   // Determine the sorting algorithm
@@ -43,6 +51,9 @@ Sorter3 *Sorter3::CreateSorter(int64_t size, uint key_bytes, uint total_bytes, i
     if (max_no_rows > size * 2 &&  // two buffers needed for counting sort
         ((key_bytes == 1 && size > 1024) || (key_bytes == 2 && size > 256000)))
       return new SorterCounting((uint)size, key_bytes, total_bytes);
+    else if (tianmu_sysvar_radix_sort && max_no_rows > size * 2 &&  // two buffers needed for radix sort
+             key_bytes > 0 && size >= kRadixSortMinRows)
+      return new SorterRadix((uint)size, key_bytes, total_bytes);
     else
       return new SorterOnePass((uint)size, key_bytes, total_bytes);
   }
@@ -222,6 +233,54 @@ void SorterOnePass::BubbleSort(unsigned char *s1,
   } while (j != nullptr);
 }
 
+SorterRadix::SorterRadix(uint _size, uint _key_bytes, uint _total_bytes)
+    : SorterOnePass(_size, _key_bytes, _total_bytes) {
+  buf_scratch = nullptr;
+  if (size > 0) {
+    buf_scratch = (unsigned char *)alloc(size * total_bytes, mm::BLOCK_TYPE::BLOCK_TEMPORARY, true);
+    if (buf_scratch == nullptr)
+      throw common::OutOfMemoryException();
+  }
+}
+
+SorterRadix::~SorterRadix() {
+  if (buf_scratch)
+    dealloc(buf_scratch);
+}
+
+unsigned char *SorterRadix::GetNextValue() {
+  if (!already_sorted) {
+    RadixSort();
+    already_sorted = true;
+  }
+  if (buf_output_pos == buf_input_pos)
+    return nullptr;
+  unsigned char *res = buf_output_pos;
+  buf_output_pos += total_bytes;
+  return res;
+}
+
+void SorterRadix::RadixSort() {
+#ifdef FUNCTIONS_EXECUTION_TIMES
+  FETOperator feto("SorterRadix::RadixSort(...)");
+#endif
+  size_t rows = (buf_input_pos - buf) / total_bytes;
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  int parts = tianmu_sysvar_query_threads ? tianmu_sysvar_query_threads : std::thread::hardware_concurrency();
+  // Tasks of a pool thread must not wait for the same pool.
+  if (eng == nullptr || eng->query_thread_pool.is_owner())
+    parts = 1;
+
+  utils::ParallelRadixSort(buf, buf_scratch, rows, key_bytes, total_bytes, parts,
+                           [this, eng](std::vector<std::function<void()>> &tasks) {
+                             utils::result_set<void> res;
+                             for (auto &task : tasks) res.insert(eng->query_thread_pool.add_task(task));
+                             res.get_all_with_except();
+                             if (conn->Killed())
+                               throw common::KilledException();
+                           });
+}
+
 SorterMultiPass::SorterMultiPass(uint _size, uint _key_bytes, uint _total_bytes)
     : SorterOnePass(_size, _key_bytes, _total_bytes), system::CacheableItem("JW", "SR3") {
   no_blocks = 0;
@@ -59,6 +59,12 @@ class Sorter3 : public mm::TraceableObject {
   */
 
   virtual void Rewind() = 0;
+  /*
+        The key of the worst row which may still be in the result, if known
+        (i.e. the limit is reached), or nullptr. Rows with greater keys may be
+        omitted.
+  */
+  virtual const unsigned char *LimitThreshold() const { return nullptr; }
   /*
         Memory management
         For internal use only.
@@ -120,6 +126,22 @@ class SorterOnePass : public Sorter3 {
   bool already_sorted;  // false if sorting was not performed yet
 };
 
+// parallel MSD radix sort on one memory buffer; needs two buffers
+
+class SorterRadix : public SorterOnePass {
+ public:
+  SorterRadix(uint _size, uint _key_bytes, uint _total_bytes);
+  ~SorterRadix();
+
+  unsigned char *GetNextValue() override;
+  const char *Name() const override { return "Radix Sort"; }
+
+ private:
+  void RadixSort();
+
+  unsigned char *buf_scratch;  // a buffer for radix passes
+};
+
 // multipass quicksort with merging (many buffers needed for merging)
 
 class SorterMultiPass : public SorterOnePass, private system::CacheableItem {
@@ -216,6 +238,10 @@ class SorterLimit : public SorterOnePass {
   bool PutValue(unsigned char *buf) override;
   bool PutValue(Sorter3 *s) override;
   const char *Name() const override { return "Heap Sort"; }
+  // the top of the heap
+  const unsigned char *LimitThreshold() const override {
+    return (key_bytes > 0 && size > 0 && no_obj == size) ? buf : nullptr;
+  }
 
  private:
   // see SoretrOnePass for more fields
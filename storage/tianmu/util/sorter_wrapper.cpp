@@ -236,6 +236,13 @@ bool SorterWrapper::InitPackrow(MIIterator &mit)  // return true if the packrow
       int64_t local_max = (asc ? common::PLUS_INF_64 : vc->GetMaxInt64(mit));
       if (scol[rough_sort_by].ImpossibleValues(local_min, local_max))
         return true;  // exclude
+      // The best value of the packrow is worse than the worst one kept by the
+      // limit sorter (rough_sort_by is the first key, at offset 0).
+      const unsigned char *threshold = s->LimitThreshold();
+      if (threshold != nullptr &&
+          scol[rough_sort_by].PutValue64(input_buf, asc ? local_min : local_max, false) &&
+          std::memcmp(input_buf, threshold, scol[rough_sort_by].GetPrimarySize()) > 0)
+        return true;  // exclude
     }
   }
 
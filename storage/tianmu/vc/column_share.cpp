@@ -21,6 +21,7 @@
 
 #include "common/exception.h"
 #include "core/engine.h"
+#include "data/pack_patch.h"
 #include "system/tianmu_file.h"
 #include "system/tianmu_system.h"
 #include "vc/column_share.h"
@@ -95,6 +96,15 @@ void ColumnShare::map_dpn() {
   start = static_cast<DPN *>(addr);
 }
 
+void ColumnShare::reset_dpn(common::PACK_INDEX i) {
+  // the patch of a version that is not current any more, e.g. of an aborted transaction
+  if (start[i].patched) {
+    std::error_code ec;
+    fs::remove(PackPatch::File(m_path, i), ec);
+  }
+  start[i].reset();
+}
+
 void ColumnShare::read_meta() {
   auto fname = m_path / common::COL_META_FILE;
   system::TianmuFile file;
@@ -124,21 +134,54 @@ void ColumnShare::read_meta() {
 
   if (pt == common::PackType::INT) {
     has_filter_hist = true;
+
+    // reals are compared by value, so the bit patterns of e.g. 0.0 and -0.0 cannot be keys
+    if (ct.HasFilter() && !ATI::IsRealType(type))
+      has_filter_bloom = true;
+    has_filter_hll = tianmu_sysvar_hll_sketches && !ATI::IsRealType(type);
   } else {
-    if (!types::RequiresUTFConversions(ct.GetCollation()))
+    if (!types::RequiresUTFConversions(ct.GetCollation())) {
       has_filter_cmap = true;
+      has_filter_strstats = true;
+      has_filter_hll = tianmu_sysvar_hll_sketches;
+    }
 
     if (ct.HasFilter())
       has_filter_bloom = true;
   }
 }
 
-void ColumnShare::scan_dpn(common::TX_ID xid) {
-  COL_VER_HDR hdr{};
+void ColumnShare::ReadVersion(const fs::path &col_dir, common::TX_ID xid, COL_VER_HDR &hdr,
+                              std::vector<common::PACK_INDEX> &idx, std::vector<common::TX_ID> *chain) {
   system::TianmuFile fv;
-  fv.OpenReadOnly(m_path / common::COL_VERSION_DIR / xid.ToString());
+  fv.OpenReadOnly(col_dir / common::COL_VERSION_DIR / xid.ToString());
   fv.ReadExact(&hdr, sizeof(hdr));
 
+  if (hdr.delta_magic != COL_VER_DELTA_MAGIC) {
+    idx.resize(hdr.numOfPacks);
+    fv.ReadExact(idx.data(), sizeof(common::PACK_INDEX) * hdr.numOfPacks);
+    return;
+  }
+
+  COL_VER_HDR base_hdr{};
+  ReadVersion(col_dir, common::TX_ID(hdr.delta_base), base_hdr, idx, chain);
+  if (chain != nullptr)
+    chain->push_back(common::TX_ID(hdr.delta_base));
+
+  idx.resize(hdr.numOfPacks);
+  std::vector<COL_VER_DELTA_ENTRY> entries(hdr.delta_count);
+  fv.ReadExact(entries.data(), sizeof(COL_VER_DELTA_ENTRY) * hdr.delta_count);
+  for (auto &e : entries) {
+    ASSERT(e.pos < hdr.numOfPacks, "bad delta manifest, txnid:" + xid.ToString());
+    idx[e.pos] = e.dpn_idx;
+  }
+}
+
+void ColumnShare::scan_dpn(common::TX_ID xid) {
+  COL_VER_HDR hdr{};
+  std::vector<common::PACK_INDEX> idx;
+  ReadVersion(m_path, xid, hdr, idx);
+
   ASSERT(hdr.numOfPacks <= capacity, "bad dpn index, txnid:" + xid.ToString());
 
   // get column saved auto inc
@@ -146,19 +189,19 @@ void ColumnShare::scan_dpn(common::TX_ID xid) {
 
   if (hdr.numOfPacks == 0) {
     for (uint32_t i = 0; i < capacity; i++) {
-      start[i].reset();
+      reset_dpn(i);
     }
     return;
   }
 
-  auto arr = std::make_unique<common::PACK_INDEX[]>(hdr.numOfPacks);
-  fv.ReadExact(arr.get(), hdr.numOfPacks * sizeof(common::PACK_INDEX));
-  auto end = arr.get() + hdr.numOfPacks;
+  std::vector<bool> in_use(capacity);
+  for (auto i : idx)
+    if (i < capacity)
+      in_use[i] = true;
 
   for (uint32_t i = 0; i < capacity; i++) {
-    auto found = std::find(arr.get(), end, i);
-    if (found == end) {
-      start[i].reset();
+    if (!in_use[i]) {
+      reset_dpn(i);
     } else {
       start[i].SetRefCount(0);
       start[i].used = 1;
@@ -235,6 +278,7 @@ int ColumnShare::alloc_dpn(common::TX_ID xid, const DPN *from) {
       eng->cache.DropObject(PackCoordinate(owner->TabID(), col_id, i));
       // Remove the space pointer from the discarded pack
       segs.remove_if([i](const auto &s) { return s.idx == i; });
+      reset_dpn(i);
     }
     init_dpn(start[i], xid, from);
     return i;
@@ -270,6 +314,14 @@ void ColumnShare::alloc_seg(DPN *dpn) {
   dpn->dataAddress = prev;
 }
 
+void ColumnShare::move_seg(common::PACK_INDEX from, common::PACK_INDEX to) {
+  for (auto &s : segs)
+    if (s.idx == from) {
+      s.idx = to;
+      return;
+    }
+}
+
 void ColumnShare::sync_dpns() {
   int ret = ::msync(start, COL_DN_FILE_SIZE, MS_SYNC);
   if (ret != 0)
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <list>
+#include <vector>
 
 #include "common/assert.h"
 #include "common/common_definitions.h"
@@ -26,6 +27,7 @@
 #include "common/mysql_gate.h"
 #include "data/dpn.h"
 #include "util/fs.h"
+#include "util/mapped_file.h"
 #include "vc/column_type.h"
 
 namespace Tianmu {
@@ -67,9 +69,22 @@ struct alignas(128) COL_VER_HDR_V3 {
   uint32_t unique_updated : 1;
   uint64_t natural_size;
   uint64_t compressed_size;
+  // set in a delta manifest, which lists only the packs changed since the version it is based on
+  uint32_t delta_magic;
+  uint32_t delta_depth;  // number of delta manifests since the last full one
+  uint64_t delta_base;   // version this one is based on
+  uint64_t delta_count;  // number of DELTA_ENTRY following the header
 };
 
 using COL_VER_HDR = COL_VER_HDR_V3;
+static_assert(sizeof(COL_VER_HDR) == 128, "Bad struct size of COL_VER_HDR");
+
+constexpr uint32_t COL_VER_DELTA_MAGIC = 0x544c4544;  // "DELT"
+
+struct COL_VER_DELTA_ENTRY {
+  uint32_t pos;               // position in the pack index array
+  common::PACK_INDEX dpn_idx;  // DPN of the pack at that position
+};
 
 class ColumnShare final {
   friend class TianmuAttr;
@@ -80,7 +95,11 @@ class ColumnShare final {
   ColumnShare(ColumnShare const &) = delete;
   void operator=(ColumnShare const &x) = delete;
   ColumnShare(TableShare *owner_, common::TX_ID xid_, uint32_t col_id_, const fs::path &path_, const Field *field_)
-      : owner(owner_), m_path(path_), col_id(col_id_), field_name_(field_->field_name) {
+      : owner(owner_),
+        m_path(path_),
+        col_id(col_id_),
+        field_name_(field_->field_name),
+        data_map_(path_ / common::COL_DATA_FILE) {
     ct.SetCollation({field_->charset(), field_->derivation()});
     ct.SetAutoInc(field_->flags & AUTO_INCREMENT_FLAG);
     ct.SetUnsigned(field_->flags & UNSIGNED_FLAG);
@@ -100,9 +119,20 @@ class ColumnShare final {
   void init_dpn(DPN &dpn, const common::TX_ID xid, const DPN *from);
   void sync_dpns();
   void alloc_seg(DPN *dpn);
+  // hand the data space of a pack over to the pack patched on top of it
+  void move_seg(common::PACK_INDEX from, common::PACK_INDEX to);
+  void reset_dpn(common::PACK_INDEX i);  // frees the DPN and the patch file it may have
+
+  // Read a column version manifest, resolving delta manifests against their bases.
+  // The versions the manifest depends on are appended to 'chain' if given.
+  static void ReadVersion(const fs::path &col_dir, common::TX_ID xid, COL_VER_HDR &hdr,
+                          std::vector<common::PACK_INDEX> &idx, std::vector<common::TX_ID> *chain = nullptr);
 
   const ColumnType &ColType() const { return ct; }
   std::string DataFile() const { return m_path / common::COL_DATA_FILE; }
+  // Address of a byte range of the data file, which is mapped once for the column.
+  // nullptr if it can not be mapped and has to be read.
+  const char *MapData(uint64_t offset, uint64_t len) { return data_map_.Map(offset, len); }
   uint8_t pss;
   common::PACK_INDEX GetPackIndex(DPN *dpn) const {
     auto i = std::distance(start, dpn);
@@ -129,6 +159,7 @@ class ColumnShare final {
   uint32_t col_id;
   std::string field_name_;
   std::atomic<uint64_t> auto_inc_{0};
+  utils::MappedFile data_map_;
   struct seg {
     uint64_t offset;
     uint64_t len;
@@ -139,6 +170,8 @@ class ColumnShare final {
   bool has_filter_cmap = false;
   bool has_filter_hist = false;
   bool has_filter_bloom = false;
+  bool has_filter_strstats = false;
+  bool has_filter_hll = false;
 };
 
 }  // namespace core
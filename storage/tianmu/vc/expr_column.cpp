@@ -18,6 +18,7 @@
 #include "expr_column.h"
 #include <mutex>
 #include "core/mysql_expression.h"
+#include "core/native_expression.h"
 #include "optimizer/compile/compiled_query.h"
 #include "vc/tianmu_attr.h"
 
@@ -80,6 +81,29 @@ ExpressionColumn::ExpressionColumn(core::MysqlExpression *expr, core::TempTable
 
     // if expr calculate base on user value set the value use_usr_val_ true
     use_usr_var_ = expr_->BaseOnUserValue();
+
+    if (tianmu_sysvar_native_expression && deterministic_ && !use_usr_var_ && dim_ >= 0 && params_.empty()) {
+      // the native result is what Evaluate() returns, i.e. a decimal at the scale of the item
+      Item *item = expr_->GetItem();
+      bool same_scale = core::ATI::IsIntegerType(TypeName()) ||
+                        (TypeName() == common::ColumnType::NUM && int(ct.GetScale()) == int(item->decimals));
+      std::shared_ptr<const core::NativeExpression> native;
+      if (same_scale)
+        native = core::NativeExpression::Compile(*expr_, var_types_);
+      for (size_t i = 0; native && i < native->GetVars().size(); i++) {
+        auto it = std::find_if(var_map_.begin(), var_map_.end(),
+                               [&native, i](const VarMap &m) { return m.var_id == native->GetVars()[i]; });
+        // only the columns of one physical table, a pack of rows is read directly from it
+        if (it == var_map_.end() || it->GetTabPtr()->TableType() != core::TType::TABLE ||
+            it->GetTabPtr() != var_map_[0].GetTabPtr())
+          native.reset();
+        else
+          native_args_.push_back(int(it - var_map_.begin()));
+      }
+      native_ = native;
+      if (!native_)
+        native_args_.clear();
+    }
   } else {
     DEBUG_ASSERT(!"unexpected!!");
   }
@@ -91,7 +115,9 @@ ExpressionColumn::ExpressionColumn(const ExpressionColumn &ec)
       vars_(ec.vars_),
       var_types_(ec.var_types_),
       var_buf_(ec.var_buf_),
-      deterministic_(ec.deterministic_) {
+      deterministic_(ec.deterministic_),
+      native_(ec.native_),
+      native_args_(ec.native_args_) {
   var_map_ = ec.var_map_;
   use_usr_var_ = ec.use_usr_var_;
 }
@@ -135,7 +161,42 @@ bool ExpressionColumn::FeedArguments(const core::MIIterator &mit) {
   return (diff || !deterministic_);
 }
 
+bool ExpressionColumn::NativeValue(const core::MIIterator &mit, int64_t &v) {
+  if (!native_ || mit.Type() == core::MIIterator::MIIteratorType::MII_LOOKUP)
+    return false;
+  int64_t row = mit[dim_];
+  if (row == common::NULL_VALUE_64)
+    return false;
+
+  std::scoped_lock lock(native_mutex_);
+  auto t = var_map_[native_args_[0]].GetTabPtr();
+  uint32_t pss = t->Getpackpower();
+  int64_t start = (row >> pss) << pss;
+  if (native_pack_ != (row >> pss)) {
+    // the whole pack at once, the pack of the current row is locked by LockSourcePacks()
+    size_t n = size_t(std::min(int64_t(1) << pss, t->NumOfObj() - start));
+    std::vector<std::vector<int64_t>> cols(native_args_.size(), std::vector<int64_t>(n));
+    std::vector<const int64_t *> args;
+    for (size_t a = 0; a < native_args_.size(); a++) {
+      int col_ndx = var_map_[native_args_[a]].col_ndx;
+      for (size_t i = 0; i < n; i++) cols[a][i] = t->GetTable64(start + i, col_ndx);
+      args.push_back(cols[a].data());
+    }
+    native_vals_.resize(n);
+    native_pack_ok_ = native_->Evaluate(args, n, native_vals_.data());
+    native_pack_ = row >> pss;
+  }
+  if (!native_pack_ok_ || size_t(row - start) >= native_vals_.size())
+    return false;
+  v = native_vals_[row - start];
+  return true;
+}
+
 int64_t ExpressionColumn::GetValueInt64Impl(const core::MIIterator &mit) {
+  int64_t native_val;
+  if (NativeValue(mit, native_val))
+    return native_val;
+
   static std::mutex scp_mutex;
   std::scoped_lock lock(scp_mutex);
 
@@ -172,6 +233,10 @@ bool ExpressionColumn::IsNullImpl(const core::MIIterator &mit) {
     }
   }
 
+  int64_t native_val;
+  if (NativeValue(mit, native_val))
+    return native_val == common::NULL_VALUE_64;
+
   if (FeedArguments(mit))
     last_val_ = expr_->Evaluate();
 
@@ -194,6 +259,13 @@ void ExpressionColumn::GetValueStringImpl(types::BString &s, const core::MIItera
 
 double ExpressionColumn::GetValueDoubleImpl(const core::MIIterator &mit) {
   double val = 0;
+  int64_t native_val;
+  if (NativeValue(mit, native_val)) {
+    if (native_val == common::NULL_VALUE_64)
+      return NULL_VALUE_D;
+    return core::ATI::IsIntegerType(TypeName()) ? double(native_val)
+                                                : double(native_val) / types::PowOfTen(ct.GetScale());
+  }
   if (FeedArguments(mit))
     last_val_ = expr_->Evaluate();
   if (last_val_->IsNull())
@@ -26,6 +26,7 @@
 
 namespace Tianmu {
 namespace core {
+class NativeExpression;
 class TempTable;
 }
 namespace vcolumn {
@@ -129,6 +130,13 @@ class ExpressionColumn : public VirtualColumn {
    */
   bool FeedArguments(const core::MIIterator &mit);
 
+  /*! \brief Value of the row from the natively evaluated pack of rows.
+   *
+   * \return false if the expression is not compiled or the pack cannot be evaluated natively
+   * (e.g. an overflow), the caller falls back to the MySQL items then.
+   */
+  bool NativeValue(const core::MIIterator &mit, int64_t &v);
+
   // if ExpressionColumn ExpressionColumn encapsulates an expression these sets
   // are used to interface with core::MysqlExpression
   core::MysqlExpression::SetOfVars vars_;
@@ -139,6 +147,14 @@ class ExpressionColumn : public VirtualColumn {
   //! deterministic
   bool deterministic_;
   bool use_usr_var_;
+
+  // compiled expression, see tianmu_native_expression; shared by the copies
+  std::shared_ptr<const core::NativeExpression> native_;
+  std::vector<int> native_args_;  // var_map_ index of every variable of native_
+  std::mutex native_mutex_;
+  int64_t native_pack_ = -1;   // pack evaluated into native_vals_
+  bool native_pack_ok_ = false;
+  std::vector<int64_t> native_vals_;
 };
 }  // namespace vcolumn
 }  // namespace Tianmu
@@ -186,6 +186,10 @@ class PhysicalColumn : public Column {
                                                       // non-null values, if possible, or
                                                       // common::NULL_VALUE_64
 
+  // estimate of the number of diff. non-null values from distinct value
+  // sketches, or common::NULL_VALUE_64 if there are none
+  virtual uint64_t SketchDistinctVals([[maybe_unused]] Filter *f) { return common::NULL_VALUE_64; }
+
   virtual size_t MaxStringSize(Filter *f = nullptr) = 0;  // maximal byte string length in column
 
   // Are all the values unique?
@@ -154,6 +154,8 @@ int64_t SingleColumn::GetApproxDistValsImpl(bool incl_nulls, core::RoughMultiInd
 
 int64_t SingleColumn::GetExactDistVals() { return col_->ExactDistinctVals(multi_index_->GetFilter(dim_)); }
 
+int64_t SingleColumn::GetSketchDistVals() { return col_->SketchDistinctVals(multi_index_->GetFilter(dim_)); }
+
 double SingleColumn::RoughSelectivity() { return col_->RoughSelectivity(); }
 
 std::vector<int64_t> SingleColumn::GetListOfDistinctValues(core::MIIterator const &mit) {
@@ -124,6 +124,7 @@ class SingleColumn : public VirtualColumn {
   }
   int64_t GetApproxDistValsImpl(bool incl_nulls, core::RoughMultiIndex *rough_mind) override;
   int64_t GetExactDistVals() override;
+  int64_t GetSketchDistVals() override;
   size_t MaxStringSizeImpl() override;  // maximal byte string length in column
   core::PackOntologicalStatus GetPackOntologicalStatusImpl(const core::MIIterator &mit) override;
   common::RoughSetValue RoughCheckImpl(const core::MIIterator &it, core::Descriptor &d) override;
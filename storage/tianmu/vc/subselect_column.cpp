@@ -20,6 +20,7 @@
 #include "core/mysql_expression.h"
 #include "core/value_set.h"
 #include "optimizer/compile/compiled_query.h"
+#include "system/configuration.h"
 #include "vc/const_column.h"
 #include "vc/tianmu_attr.h"
 
@@ -362,6 +363,8 @@ std::unique_ptr<MultiValColumn::IteratorInterface> SubSelectColumn::EndImpl(core
 }
 
 void SubSelectColumn::RequestEval(const core::MIIterator &mit, const int tta) {
+  memo_.clear();
+  memo_bytes_ = 0;
   first_eval_ = true;
   if_first_eval_for_rough_ = true;
   for (uint i = 0; i < tmp_tab_subq_ptr_->NumOfVirtColumns(); i++)
@@ -439,15 +442,82 @@ bool SubSelectColumn::IsCorrelated() const {
   return false;
 }
 
+const SubSelectColumn::MemoEntry *SubSelectColumn::Memoized(const core::MIIterator &mit, bool exists_only) {
+  // parameters from further outer queries are not part of the key
+  if (tianmu_sysvar_subquery_memo_size == 0 || var_map_.empty() || !params_.empty() ||
+      mit.Type() == core::MIIterator::MIIteratorType::MII_LOOKUP)
+    return nullptr;
+
+  std::string key;
+  for (auto &iter : var_map_) {
+    core::ValueOrNull v = iter.GetTabPtr()->GetComplexValue(mit[iter.dim], iter.col_ndx);
+    key.push_back(v.IsNull() ? 0 : (v.IsString() ? 1 : 2));
+    if (v.IsString()) {
+      types::BString s;
+      v.GetBString(s);
+      uint32_t len = s.size();
+      key.append(reinterpret_cast<const char *>(&len), sizeof(len));
+      key.append(s.GetDataBytesPointer(), len);
+    } else if (v.NotNull()) {
+      int64_t x = v.Get64();
+      key.append(reinterpret_cast<const char *>(&x), sizeof(x));
+    }
+  }
+
+  auto it = memo_.find(key);
+  if (it != memo_.end() && (exists_only ? it->second.exists >= 0 : it->second.no_obj >= 0))
+    return &it->second;
+
+  PrepareSubqResult(mit, exists_only);
+  MemoEntry entry = (it != memo_.end() ? it->second : MemoEntry());
+  if (exists_only) {
+    entry.exists = tmp_tab_subq_ptr_->NumOfObj() > 0;
+  } else {
+    entry.no_obj = tmp_tab_subq_ptr_->NumOfObj();
+    entry.exists = entry.no_obj > 0;
+    if (entry.no_obj > 0) {
+      entry.null = tmp_tab_subq_ptr_->IsNull(0, col_idx_);
+      entry.value64 = tmp_tab_subq_ptr_->GetTable64(0, col_idx_);
+      entry.value = tmp_tab_subq_ptr_->GetValueObject(0, col_idx_);
+      if (Type().IsString()) {
+        types::BString s;
+        tmp_tab_subq_ptr_->GetTable_S(s, 0, col_idx_);
+        entry.str.PersistentCopy(s);
+        if (entry.value.GetValueType() == types::ValueTypeEnum::STRING_TYPE)
+          static_cast<types::BString *>(entry.value.Get())->MakePersistent();
+      }
+    }
+  }
+
+  if (it != memo_.end()) {
+    it->second = entry;
+    return &it->second;
+  }
+  size_t bytes = sizeof(MemoEntry) + key.size() + 2 * entry.str.size() + 64;  // 64: hash node overhead
+  if (memo_bytes_ + bytes > size_t(tianmu_sysvar_subquery_memo_size) << 20) {
+    memo_overflow_ = entry;
+    return &memo_overflow_;
+  }
+  memo_bytes_ += bytes;
+  return &memo_.emplace(std::move(key), std::move(entry)).first->second;
+}
+
 bool SubSelectColumn::IsNullImpl(const core::MIIterator &mit) {
+  if (auto memo = Memoized(mit, false))
+    return memo->no_obj == 0 || memo->null;
   PrepareSubqResult(mit, false);
   return tmp_tab_subq_ptr_->IsNull(0, col_idx_);
 }
 
 types::TianmuValueObject SubSelectColumn::GetValueImpl(const core::MIIterator &mit,
                                                        [[maybe_unused]] bool lookup_to_num) {
-  PrepareSubqResult(mit, false);
-  types::TianmuValueObject val = tmp_tab_subq_ptr_->GetValueObject(0, col_idx_);
+  types::TianmuValueObject val;
+  if (auto memo = Memoized(mit, false)) {
+    val = memo->value;
+  } else {
+    PrepareSubqResult(mit, false);
+    val = tmp_tab_subq_ptr_->GetValueObject(0, col_idx_);
+  }
   if (expected_type_.IsString())
     return val.ToBString();
   if (expected_type_.IsNumeric() && core::ATI::IsStringType(val.Type())) {
@@ -459,6 +529,8 @@ types::TianmuValueObject SubSelectColumn::GetValueImpl(const core::MIIterator &m
 }
 
 int64_t SubSelectColumn::GetValueInt64Impl(const core::MIIterator &mit) {
+  if (auto memo = Memoized(mit, false))
+    return memo->value64;
   PrepareSubqResult(mit, false);
   return tmp_tab_subq_ptr_->GetTable64(0, col_idx_);
 }
@@ -469,12 +541,23 @@ core::RoughValue SubSelectColumn::RoughGetValue(const core::MIIterator &mit, cor
 }
 
 double SubSelectColumn::GetValueDoubleImpl(const core::MIIterator &mit) {
-  PrepareSubqResult(mit, false);
-  int64_t v = tmp_tab_subq_ptr_->GetTable64(0, col_idx_);
+  int64_t v;
+  if (auto memo = Memoized(mit, false)) {
+    v = memo->value64;
+  } else {
+    PrepareSubqResult(mit, false);
+    v = tmp_tab_subq_ptr_->GetTable64(0, col_idx_);
+  }
   return *((double *)(&v));
 }
 
 void SubSelectColumn::GetValueStringImpl(types::BString &s, core::MIIterator const &mit) {
+  if (Type().IsString()) {
+    if (auto memo = Memoized(mit, false)) {
+      s = memo->no_obj > 0 ? memo->str : types::BString();
+      return;
+    }
+  }
   PrepareSubqResult(mit, false);
   tmp_tab_subq_ptr_->GetTable_S(s, 0, col_idx_);
 }
@@ -494,11 +577,15 @@ types::TianmuValueObject SubSelectColumn::GetSetMaxImpl(core::MIIterator const &
   return max_;
 }
 bool SubSelectColumn::CheckExists(core::MIIterator const &mit) {
+  if (auto memo = Memoized(mit, true))
+    return memo->exists;
   PrepareSubqResult(mit, true);  // true: exists_only
   return tmp_tab_subq_ptr_->NumOfObj() > 0;
 }
 
 bool SubSelectColumn::IsEmptyImpl(core::MIIterator const &mit) {
+  if (auto memo = Memoized(mit, false))
+    return memo->no_obj == 0;
   PrepareSubqResult(mit, false);
   return tmp_tab_subq_ptr_->NumOfObj() == 0;
 }
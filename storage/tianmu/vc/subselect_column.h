@@ -18,6 +18,8 @@
 #define TIANMU_VC_SUBSELECT_COLUMN_H_
 #pragma once
 
+#include <unordered_map>
+
 #include "core/rough_value.h"
 #include "core/temp_table.h"
 #include "data/pack_guardian.h"
@@ -212,6 +214,26 @@ class SubSelectColumn : public MultiValColumn {
   void RoughPrepareSubqCopy(const core::MIIterator &mit, core::SubSelectOptimizationType sot);
   bool MakeParallelReady();
 
+  // first row, row count and EXISTS of a correlated subquery for one set of outer values
+  struct MemoEntry {
+    int64_t no_obj = -1;  // -1: not computed yet
+    int exists = -1;      // -1: not computed yet
+    bool null = true;
+    int64_t value64 = common::NULL_VALUE_64;
+    types::BString str;  // persistent, string results only
+    types::TianmuValueObject value;
+  };
+  /*! \brief The memoized result of the subquery for the outer values of \e mit.
+   *
+   * Computes and memoizes the result on a miss.
+   * \return nullptr if memoization is off or not applicable, the caller evaluates the subquery then.
+   */
+  const MemoEntry *Memoized(const core::MIIterator &mit, bool exists_only);
+
+  std::unordered_map<std::string, MemoEntry> memo_;  // key: the encoded outer values
+  size_t memo_bytes_ = 0;
+  MemoEntry memo_overflow_;  // the last result not stored because memo_ was full
+
   core::MysqlExpression::TypOfVars var_types_;
   mutable core::MysqlExpression::var_buf_t var_buf_for_exact_;
   mutable core::MysqlExpression::var_buf_t var_buf_for_rough_;
@@ -61,12 +61,23 @@ TianmuAttr::TianmuAttr(Transaction *tx, common::TX_ID xid, int a_num, int t_num,
         return std::make_shared<RSIndex_Hist>(Path() / common::COL_FILTER_DIR, v);
       case FilterType::BLOOM:
         return std::make_shared<RSIndex_Bloom>(Path() / common::COL_FILTER_DIR, v);
+      case FilterType::STRSTATS:
+        return std::make_shared<RSIndex_StrStats>(Path() / common::COL_FILTER_DIR, v,
+                                                  tianmu_sysvar_string_stats_length);
+      case FilterType::HLL:
+        return std::make_shared<RSIndex_HLL>(Path() / common::COL_FILTER_DIR, v);
       default:
         TIANMU_ERROR("bad type");
     }
   };
 }
 
+TianmuAttr::~TianmuAttr() {
+  // background read-ahead uses this object as the pack fetcher
+  std::unique_lock<std::mutex> guard(prefetch_mutex_);
+  prefetch_done_.wait(guard, [this]() { return prefetch_in_flight_ == 0; });
+}
+
 void TianmuAttr::Create(const fs::path &dir, const AttributeTypeInfo &ati, uint8_t pss, size_t no_rows,
                         uint64_t auto_inc_value) {
   uint32_t no_pack = common::rows2packs(no_rows, pss);
@@ -101,6 +112,10 @@ void TianmuAttr::Create(const fs::path &dir, const AttributeTypeInfo &ati, uint8
       0,        // is unique_updated?
       0,        // natural size
       0,        // compressed size
+      0,        // not a delta manifest
+      0,        // delta depth
+      0,        // delta base
+      0,        // no of delta entries
   };
 
   if (ati.Lookup()) {
@@ -159,13 +174,14 @@ void TianmuAttr::Create(const fs::path &dir, const AttributeTypeInfo &ati, uint8
   fs::create_directory(dir / common::COL_FILTER_DIR / common::COL_FILTER_BLOOM_DIR);
   fs::create_directory(dir / common::COL_FILTER_DIR / common::COL_FILTER_CMAP_DIR);
   fs::create_directory(dir / common::COL_FILTER_DIR / common::COL_FILTER_HIST_DIR);
+  fs::create_directory(dir / common::COL_FILTER_DIR / common::COL_FILTER_STRSTATS_DIR);
+  fs::create_directory(dir / common::COL_FILTER_DIR / common::COL_FILTER_HLL_DIR);
+  fs::create_directory(dir / common::COL_PATCH_DIR);
 }
 
 void TianmuAttr::LoadVersion(common::TX_ID xid) {
-  auto fname = Path() / common::COL_VERSION_DIR / xid.ToString();
-  system::TianmuFile fattr;
-  fattr.OpenReadOnly(fname);
-  fattr.ReadExact(&hdr, sizeof(hdr));
+  version_chain_.clear();
+  ColumnShare::ReadVersion(Path(), xid, hdr, m_idx, &version_chain_);
 
   SetUnique(hdr.unique);
   SetUniqueUpdated(hdr.unique_updated);
@@ -175,9 +191,6 @@ void TianmuAttr::LoadVersion(common::TX_ID xid) {
     assert(eng);
     m_dict = eng->cache.GetOrFetchObject<FTree>(FTreeCoordinate(m_tid, m_cid, hdr.dict_ver), this);
   }
-
-  m_idx.resize(hdr.numOfPacks);
-  fattr.ReadExact(&m_idx[0], sizeof(common::PACK_INDEX) * hdr.numOfPacks);
 }
 
 void TianmuAttr::Truncate() {
@@ -262,6 +275,16 @@ void TianmuAttr::SaveFilters() {
     filter_bloom->SaveToFile(m_tx->GetID());
     filter_bloom.reset();
   }
+
+  if (filter_strstats) {
+    filter_strstats->SaveToFile(m_tx->GetID());
+    filter_strstats.reset();
+  }
+
+  if (filter_hll) {
+    filter_hll->SaveToFile(m_tx->GetID());
+    filter_hll.reset();
+  }
 }
 
 // Save all modified data (pack, filter, dictionary, etc) to disk.
@@ -279,8 +302,11 @@ bool TianmuAttr::SaveVersion() {
       no_change = false;
       RefreshFilter(i);
       auto &dpn(get_dpn(i));
-      if (dpn.Trivial() || dpn.synced) {
+      // a copy of a patched pack has no data of its own even when unchanged
+      auto patch = patches_.find(i);
+      if (dpn.Trivial() || (dpn.synced && !dpn.patched)) {
         // trivial or already saved to disk
+        dpn.patched = 0;
         if (auto p = get_pack(i); p != nullptr) {
           p->Unlock();
           eng->cache.DropObject(get_pc(i));
@@ -289,6 +315,21 @@ bool TianmuAttr::SaveVersion() {
         continue;
       }
 
+      if (patch != patches_.end() && patch->second->NumOfRows() <= tianmu_sysvar_pack_patch_max_rows &&
+          dpn.numOfRecords == patch->second->Base().numOfRecords) {
+        // keep the base data, only the changed rows are written
+        patch->second->Save(PackPatch::File(Path(), m_idx[i]));
+        dpn.patched = 1;
+        dpn.synced = 1;
+        dpn.dataAddress = patch->second->Base().dataAddress;
+        dpn.dataLength = patch->second->Base().dataLength;
+        get_pack(i)->Unlock();
+        dpn.SetRefCount(0);
+        continue;
+      }
+
+      // too many changes, or rows were appended: fold the patch into a full pack
+      dpn.patched = 0;
       get_pack(i)->Save();
       get_pack(i)->Unlock();  // now it can be released by MM
       dpn.SetRefCount(0);
@@ -319,16 +360,32 @@ bool TianmuAttr::SaveVersion() {
     });
   }
 
+  // a delta manifest lists only the packs written by this transaction
+  std::vector<COL_VER_DELTA_ENTRY> delta;
+  uint32_t depth = hdr.delta_magic == COL_VER_DELTA_MAGIC ? hdr.delta_depth : 0;
+  if (tianmu_sysvar_version_checkpoint_interval > 0 && depth + 1 < tianmu_sysvar_version_checkpoint_interval) {
+    for (size_t i = 0; i < m_idx.size(); i++)
+      if (get_dpn(i).IsLocal())
+        delta.push_back({uint32_t(i), m_idx[i]});
+  }
+  // otherwise, or if most of the packs changed anyway, write a full manifest as a checkpoint
+  bool is_delta = !delta.empty() && delta.size() < m_idx.size() / 2;
+  hdr.delta_magic = is_delta ? COL_VER_DELTA_MAGIC : 0;
+  hdr.delta_depth = is_delta ? depth + 1 : 0;
+  hdr.delta_base = is_delta ? m_version.v : 0;
+  hdr.delta_count = is_delta ? delta.size() : 0;
+
   // save attr transaction version
   auto fname = Path() / common::COL_VERSION_DIR / m_tx->GetID().ToString();
   system::TianmuFile fattr;
   fattr.OpenCreate(fname);
   fattr.WriteExact(&hdr, sizeof(hdr));
-  fattr.WriteExact(&m_idx[0], sizeof(decltype(m_idx)::value_type) * hdr.numOfPacks);
-
-  if (tianmu_sysvar_sync_buffers)
-    fattr.Flush();
+  if (is_delta)
+    fattr.WriteExact(delta.data(), sizeof(COL_VER_DELTA_ENTRY) * delta.size());
+  else
+    fattr.WriteExact(&m_idx[0], sizeof(decltype(m_idx)::value_type) * hdr.numOfPacks);
 
+  // flushed together with the other files of the commit by TianmuTable::CommitVersion
   return true;
 }
 
@@ -341,21 +398,38 @@ void TianmuAttr::PostCommit() {
       auto &dpn = get_dpn(i);
       if (dpn.IsLocal()) {
         dpn.SetLocal(false);
-        if (dpn.base != common::INVALID_PACK_INDEX)
+        if (dpn.base != common::INVALID_PACK_INDEX) {
           m_share->get_dpn_ptr(dpn.base)->xmax = eng->MaxXID();
+          // the data of the base pack now belongs to the patched one
+          if (dpn.patched)
+            m_share->move_seg(dpn.base, m_idx[i]);
+        }
       }
     }
 
-    eng->DeferRemove(Path() / common::COL_VERSION_DIR / m_version.ToString(), m_tid);
+    // a delta manifest keeps the versions it is based on
+    if (hdr.delta_magic == COL_VER_DELTA_MAGIC) {
+      version_chain_.push_back(m_version);
+    } else {
+      for (auto &v : version_chain_) eng->DeferRemove(Path() / common::COL_VERSION_DIR / v.ToString(), m_tid);
+      version_chain_.clear();
+      eng->DeferRemove(Path() / common::COL_VERSION_DIR / m_version.ToString(), m_tid);
+    }
     if (m_share->has_filter_bloom)
       eng->DeferRemove(Path() / common::COL_FILTER_DIR / common::COL_FILTER_BLOOM_DIR / m_version.ToString(), m_tid);
     if (m_share->has_filter_cmap)
       eng->DeferRemove(Path() / common::COL_FILTER_DIR / common::COL_FILTER_CMAP_DIR / m_version.ToString(), m_tid);
     if (m_share->has_filter_hist)
       eng->DeferRemove(Path() / common::COL_FILTER_DIR / common::COL_FILTER_HIST_DIR / m_version.ToString(), m_tid);
+    if (m_share->has_filter_strstats)
+      eng->DeferRemove(Path() / common::COL_FILTER_DIR / common::COL_FILTER_STRSTATS_DIR / m_version.ToString(),
+                       m_tid);
+    if (m_share->has_filter_hll)
+      eng->DeferRemove(Path() / common::COL_FILTER_DIR / common::COL_FILTER_HLL_DIR / m_version.ToString(), m_tid);
 
     m_version = m_tx->GetID();
   }
+  patches_.clear();
   m_tx = nullptr;
 }
 
@@ -364,12 +438,12 @@ void TianmuAttr::Rollback() {
   assert(eng);
 
   for (size_t i = 0; i < m_idx.size(); i++) {
-    auto &dpn(get_dpn(i));
-    if (dpn.IsLocal()) {
+    if (get_dpn(i).IsLocal()) {
       eng->cache.DropObject(get_pc(i));
-      dpn.reset();
+      m_share->reset_dpn(m_idx[i]);
     }
   }
+  patches_.clear();
   m_tx = nullptr;
 }
 
@@ -858,6 +932,57 @@ void TianmuAttr::LockPackForUse(common::PACK_INDEX pn) {
   }
 }
 
+void TianmuAttr::PrefetchPack(common::PACK_INDEX pn) {
+  if (tianmu_sysvar_prefetch_depth == 0 || pn >= m_idx.size())
+    return;
+
+  // a local pack is private to a write session and is always in memory
+  auto dpn = &get_dpn(pn);
+  if (dpn->IsLocal() || dpn->Trivial())
+    return;
+
+  // already in use or being loaded by a scan
+  if (dpn->GetRefCount() != 0)
+    return;
+
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  assert(eng);
+  if (eng->bg_load_thread_pool.is_owner())
+    return;
+
+  {
+    std::scoped_lock guard(prefetch_mutex_);
+    prefetch_in_flight_++;
+  }
+  auto done = [this]() {
+    std::scoped_lock guard(prefetch_mutex_);
+    if (--prefetch_in_flight_ == 0)
+      prefetch_done_.notify_all();
+  };
+  try {
+    eng->bg_load_thread_pool.add_task([this, eng, pn, done]() {
+      // the loading reference is taken the same way as in LockPackForUse, so a
+      // scan reaching this pack meanwhile waits for the load instead of racing it
+      auto dpn = &get_dpn(pn);
+      uint64_t v = 0;
+      if (!dpn->IsLocal() && !dpn->Trivial() && dpn->CAS(v, loading_flag)) {
+        try {
+          eng->cache.PrefetchObject<Pack>(get_pc(pn), this);
+        } catch (std::exception &e) {
+          // a failed read-ahead is retried and reported by the scan itself
+          TIANMU_LOG(LogCtl_Level::DEBUG, "Pack prefetch failed: %s", e.what());
+        } catch (...) {
+          TIANMU_LOG(LogCtl_Level::DEBUG, "Pack prefetch failed");
+        }
+        dpn->SetRefCount(0);
+      }
+      done();
+    });
+  } catch (...) {
+    done();
+  }
+}
+
 void TianmuAttr::UnlockPackFromUse(common::PACK_INDEX pn) {
   if (m_idx.empty()) {  // in case table not insert data
     return;
@@ -907,11 +1032,35 @@ void TianmuAttr::Release() { Collapse(); }
 
 std::shared_ptr<Pack> TianmuAttr::Fetch(const PackCoordinate &pc) {
   auto dpn = m_share->get_dpn_ptr(pc_dp(pc));
+  if (dpn->patched)
+    return FetchPatched(pc, dpn);
   if (GetPackType() == common::PackType::STR)
     return std::make_shared<PackStr>(dpn, pc, m_share);
   return std::make_shared<PackInt>(dpn, pc, m_share);
 }
 
+// Decode the shared data with the DPN it was written with, apply the row
+// changes, then hand the pack over to its own DPN.
+std::shared_ptr<Pack> TianmuAttr::FetchPatched(const PackCoordinate &pc, DPN *dpn) {
+  // a pack just copied for write still reads the patch of the pack it was copied from
+  auto pi = dpn->IsLocal() ? dpn->base : pc_dp(pc);
+  PackPatch patch;
+  patch.Load(PackPatch::File(Path(), pi));
+
+  DPN base(patch.Base());
+  std::shared_ptr<Pack> sp;
+  if (GetPackType() == common::PackType::STR)
+    sp = std::make_shared<PackStr>(&base, pc, m_share);
+  else
+    sp = std::make_shared<PackInt>(&base, pc, m_share);
+  patch.ApplyTo(*sp);
+  DEBUG_ASSERT(base.numOfNulls == dpn->numOfNulls && base.numOfDeleted == dpn->numOfDeleted);
+  DEBUG_ASSERT(GetPackType() == common::PackType::STR || ATI::IsRealType(TypeName()) || dpn->NullOnly() ||
+               (base.min_i == dpn->min_i && base.max_i == dpn->max_i));
+  sp->SetDPN(dpn);
+  return sp;
+}
+
 std::shared_ptr<FTree> TianmuAttr::Fetch([[maybe_unused]] const FTreeCoordinate &coord) {
   auto sp = std::make_shared<FTree>();
   sp->LoadData(Path() / common::COL_DICT_DIR / std::to_string(hdr.dict_ver));
@@ -1148,6 +1297,7 @@ void TianmuAttr::UpdateData(uint64_t row, Value &old_v, Value &new_v) {
   }
 
   get_pack(pn)->UpdateValue(row2offset(row), new_v);
+  PatchUpdate(pn, row, new_v);
   dpn.synced = false;
 
   // update global data
@@ -1205,6 +1355,7 @@ void TianmuAttr::UpdateBatchData(core::Transaction *tx,
         row_val->SetInt(code);
       }
       get_pack(pn)->UpdateValue(row2offset(row_id), *row_val);
+      PatchUpdate(pn, row_id, *row_val);
     }
 
     dpn.synced = false;
@@ -1248,6 +1399,7 @@ void TianmuAttr::DeleteData(uint64_t row) {
   auto &dpn = get_dpn(pn);
   auto dpn_save = dpn;
   get_pack(pn)->DeleteByRow(row2offset(row));
+  PatchDelete(pn, row);
 
   // update global data
   hdr.numOfNulls -= dpn_save.numOfNulls;
@@ -1279,6 +1431,7 @@ void TianmuAttr::DeleteBatchData(core::Transaction *tx, const std::vector<uint64
 
     for (const auto &row_id : pack.second) {
       get_pack(pn)->DeleteByRow(row2offset(row_id));
+      PatchDelete(pn, row_id);
     }
     // update global data
     hdr.numOfNulls -= dpn_save.numOfNulls;
@@ -1327,6 +1480,15 @@ void TianmuAttr::CopyPackForWrite(common::PACK_INDEX pi) {
 
   auto &old_dpn(get_dpn(pi));  // save a ref to the old dpn
 
+  // track the row changes, a patched pack must carry its patch over
+  if (old_dpn.patched && !old_dpn.IsLocal()) {
+    auto patch = std::make_unique<PackPatch>();
+    patch->Load(PackPatch::File(Path(), m_idx[pi]));
+    patches_[pi] = std::move(patch);
+  } else if (tianmu_sysvar_pack_patch_max_rows > 0) {
+    patches_[pi] = std::make_unique<PackPatch>(old_dpn);
+  }
+
   auto pos = m_share->alloc_dpn(m_tx->GetID(), &old_dpn);
 
   // update current view
@@ -1353,6 +1515,16 @@ void TianmuAttr::CopyPackForWrite(common::PACK_INDEX pi) {
   dpn.SetRefCount(reinterpret_cast<unsigned long>(new_pack.get()) + tag_one);
 }
 
+void TianmuAttr::PatchUpdate(common::PACK_INDEX pi, uint64_t row, const Value &v) {
+  if (auto it = patches_.find(pi); it != patches_.end())
+    it->second->Update(row2offset(row), v);
+}
+
+void TianmuAttr::PatchDelete(common::PACK_INDEX pi, uint64_t row) {
+  if (auto it = patches_.find(pi); it != patches_.end())
+    it->second->Delete(row2offset(row));
+}
+
 void TianmuAttr::CompareAndSetCurrentMin(const types::BString &tstmp, types::BString &min, bool set) {
   bool res;
   if (types::RequiresUTFConversions(Type().GetCollation())) {
@@ -1485,11 +1657,39 @@ void TianmuAttr::UpdateRSI_Bloom(common::PACK_INDEX pi) {
   if (GetPackOntologicalStatus(pi) == PackOntologicalStatus::NULLS_ONLY)
     return;
 
-  filter_bloom->Update(pi, get_dpn(pi), get_packS(pi));
+  if (GetPackType() == common::PackType::INT)
+    filter_bloom->Update(pi, get_dpn(pi), get_packN(pi));
+  else
+    filter_bloom->Update(pi, get_dpn(pi), get_packS(pi));
+}
+
+void TianmuAttr::UpdateRSI_StrStats(common::PACK_INDEX pi) {
+  if (GetPackType() != common::PackType::STR || NumOfObj() == 0)
+    return;
+
+  if (!GetFilter_StrStats())
+    return;
+
+  filter_strstats->Update(pi, get_dpn(pi), get_packS(pi));
+}
+
+void TianmuAttr::UpdateRSI_HLL(common::PACK_INDEX pi) {
+  if (NumOfObj() == 0)
+    return;
+
+  if (!GetFilter_HLL())
+    return;
+
+  if (GetPackType() == common::PackType::INT)
+    filter_hll->Update(pi, get_dpn(pi), get_packN(pi));
+  else
+    filter_hll->Update(pi, get_dpn(pi), get_packS(pi));
 }
 
 void TianmuAttr::RefreshFilter(common::PACK_INDEX pi) {
   UpdateRSI_Bloom(pi);
+  UpdateRSI_StrStats(pi);
+  UpdateRSI_HLL(pi);
   UpdateRSI_CMap(pi);
   UpdateRSI_Hist(pi);
 }
@@ -1563,6 +1763,44 @@ std::shared_ptr<RSIndex_Bloom> TianmuAttr::GetFilter_Bloom() {
       FilterCoordinate(m_tid, m_cid, (int)FilterType::BLOOM, m_version.v1, m_version.v2), filter_creator));
 }
 
+std::shared_ptr<RSIndex_StrStats> TianmuAttr::GetFilter_StrStats() {
+  if (tianmu_sysvar_string_stats_length == 0)
+    return nullptr;
+
+  if (!m_share->has_filter_strstats)
+    return nullptr;
+
+  if (m_tx != nullptr) {
+    if (!filter_strstats)
+      filter_strstats = std::make_shared<RSIndex_StrStats>(Path() / common::COL_FILTER_DIR, m_version,
+                                                           tianmu_sysvar_string_stats_length);
+    return filter_strstats;
+  }
+
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  assert(eng);
+
+  return std::static_pointer_cast<RSIndex_StrStats>(eng->filter_cache.Get(
+      FilterCoordinate(m_tid, m_cid, (int)FilterType::STRSTATS, m_version.v1, m_version.v2), filter_creator));
+}
+
+std::shared_ptr<RSIndex_HLL> TianmuAttr::GetFilter_HLL() {
+  if (!m_share->has_filter_hll)
+    return nullptr;
+
+  if (m_tx != nullptr) {
+    if (!filter_hll)
+      filter_hll = std::make_shared<RSIndex_HLL>(Path() / common::COL_FILTER_DIR, m_version);
+    return filter_hll;
+  }
+
+  core::Engine *eng = reinterpret_cast<core::Engine *>(tianmu_hton->data);
+  assert(eng);
+
+  return std::static_pointer_cast<RSIndex_HLL>(eng->filter_cache.Get(
+      FilterCoordinate(m_tid, m_cid, (int)FilterType::HLL, m_version.v1, m_version.v2), filter_creator));
+}
+
 common::ErrorCode TianmuAttr::UpdateIfIndex(core::Transaction *tx, uint64_t row, uint64_t col, const Value &old_v,
                                             const Value &new_v) {
   DBUG_ENTER("TianmuAttr::UpdateIfIndex");
@@ -18,6 +18,8 @@
 #define TIANMU_CORE_TIANMU_ATTR_H_
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 
 #include "common/assert.h"
@@ -25,10 +27,13 @@
 #include "core/ftree.h"
 #include "data/dpn.h"
 #include "data/pack.h"
+#include "data/pack_patch.h"
 #include "index/rough_multi_index.h"
 #include "index/rsi_bloom.h"
 #include "index/rsi_cmap.h"
 #include "index/rsi_histogram.h"
+#include "index/rsi_hll.h"
+#include "index/rsi_strstats.h"
 #include "loader/value_cache.h"
 #include "mm/traceable_object.h"
 #include "system/file_system.h"
@@ -85,7 +90,7 @@ class TianmuAttr final : public mm::TraceableObject, public PhysicalColumn, publ
   TianmuAttr() = delete;
   TianmuAttr(const TianmuAttr &) = delete;
   TianmuAttr &operator=(const TianmuAttr &) = delete;
-  ~TianmuAttr() = default;
+  ~TianmuAttr();
 
   static void Create(const fs::path &path, const AttributeTypeInfo &ati, uint8_t pss, size_t no_rows,
                      uint64_t auto_inc_value = 0);
@@ -206,8 +211,14 @@ class TianmuAttr final : public mm::TraceableObject, public PhysicalColumn, publ
 
   void LockPackForUse(common::PACK_INDEX pi);
   void UnlockPackFromUse(common::PACK_INDEX pi);
+  // asynchronously load a pack which is going to be locked soon
+  void PrefetchPack(common::PACK_INDEX pi);
 
   void CopyPackForWrite(common::PACK_INDEX pi);
+  // record a row change in the patch of a pack copied by this write session, if any
+  void PatchUpdate(common::PACK_INDEX pi, uint64_t row, const Value &v);
+  void PatchDelete(common::PACK_INDEX pi, uint64_t row);
+  std::shared_ptr<Pack> FetchPatched(const PackCoordinate &pc, DPN *dpn);
 
   void Release() override;
 
@@ -320,6 +331,10 @@ class TianmuAttr final : public mm::TraceableObject, public PhysicalColumn, publ
   // common::NULL_VALUE_64
   uint64_t ExactDistinctVals(Filter *f) override;
 
+  // HyperLogLog estimate of the number of diff. non-null values, or
+  // common::NULL_VALUE_64 if the sketches are off
+  uint64_t SketchDistinctVals(Filter *f) override;
+
   // provide the most probable approximation of number of objects matching the
   // condition
   uint64_t ApproxAnswerSize(Descriptor &d) override;
@@ -376,6 +391,8 @@ class TianmuAttr final : public mm::TraceableObject, public PhysicalColumn, publ
   void UpdateRSI_Hist(common::PACK_INDEX pi);
   void UpdateRSI_CMap(common::PACK_INDEX pi);
   void UpdateRSI_Bloom(common::PACK_INDEX pi);
+  void UpdateRSI_StrStats(common::PACK_INDEX pi);
+  void UpdateRSI_HLL(common::PACK_INDEX pi);
   void LoadDataPackN(size_t i, loader::ValueCache *nvs);
   void LoadDataPackS(size_t i, loader::ValueCache *nvs);
 
@@ -430,6 +447,8 @@ class TianmuAttr final : public mm::TraceableObject, public PhysicalColumn, publ
  private:
   COL_VER_HDR hdr{};
   common::TX_ID m_version;  // the read-from version
+  // older versions the delta manifest of m_version is based on
+  std::vector<common::TX_ID> version_chain_;
   Transaction *m_tx;
   int m_tid;
   int m_cid;
@@ -437,18 +456,29 @@ class TianmuAttr final : public mm::TraceableObject, public PhysicalColumn, publ
 
   std::shared_ptr<FTree> m_dict;
   std::vector<common::PACK_INDEX> m_idx;
+  // row changes of packs copied for write, saved instead of the pack if small enough
+  std::unordered_map<common::PACK_INDEX, std::unique_ptr<PackPatch>> patches_;
 
   bool no_change = true;
   uint64_t backup_auto_inc_next_{0};
 
+  // number of read-ahead tasks still referring to this object
+  int prefetch_in_flight_ = 0;
+  std::mutex prefetch_mutex_;
+  std::condition_variable prefetch_done_;
+
   // local filters for write session
   std::shared_ptr<RSIndex_Hist> filter_hist;
   std::shared_ptr<RSIndex_CMap> filter_cmap;
   std::shared_ptr<RSIndex_Bloom> filter_bloom;
+  std::shared_ptr<RSIndex_StrStats> filter_strstats;
+  std::shared_ptr<RSIndex_HLL> filter_hll;
 
   std::shared_ptr<RSIndex_Hist> GetFilter_Hist();
   std::shared_ptr<RSIndex_CMap> GetFilter_CMap();
   std::shared_ptr<RSIndex_Bloom> GetFilter_Bloom();
+  std::shared_ptr<RSIndex_StrStats> GetFilter_StrStats();
+  std::shared_ptr<RSIndex_HLL> GetFilter_HLL();
   uint8_t pss;
   common::PackType pack_type;
   double rough_selectivity = -1;  // a probability that simple condition "c = 100" needs to open a data
@@ -20,6 +20,7 @@
 #include "core/value_set.h"
 #include "data/pack.h"
 #include "data/pack_guardian.h"
+#include "data/pack_str.h"
 #include "optimizer/compile/cq_term.h"
 #include "types/text_stat.h"
 #include "vc/multi_value_column.h"
@@ -143,6 +144,19 @@ common::RoughSetValue TianmuAttr::RoughCheck(int pack, Descriptor &d, bool addit
           else
             res = common::RoughSetValue::RS_NONE;  // prefix and pattern are different
         }
+
+        if (res == common::RoughSetValue::RS_SOME) {
+          if (auto sp = GetFilter_StrStats()) {
+            uint literal_prefix = 0;  // an escaped character ends the literal part
+            while (literal_prefix < pattern_fixed_prefix && pat[literal_prefix] != d.like_esc) literal_prefix++;
+            if (literal_prefix > 0) {
+              res = sp->IsPrefix(types::BString(pat.GetDataBytesPointer(), literal_prefix), pack);
+              if (res == common::RoughSetValue::RS_ALL &&
+                  !(literal_prefix + 1 == pat.len_ && pat[literal_prefix] == '%'))
+                res = common::RoughSetValue::RS_SOME;
+            }
+          }
+        }
       }
 
       if (res == common::RoughSetValue::RS_SOME && std::min(pattern_prefix, pack_prefix) < pat.len_ &&
@@ -272,8 +286,10 @@ common::RoughSetValue TianmuAttr::RoughCheck(int pack, Descriptor &d, bool addit
               v = it->GetInt64();
             if (!v_rounded) {
               auto sp = GetFilter_Hist();
-              if ((!sp && v <= dpn.max_i && v >= dpn.min_i) ||
-                  (sp && sp->IsValue(v, v, pack, dpn.min_i, dpn.max_i) != common::RoughSetValue::RS_NONE)) {
+              auto bloom = GetFilter_Bloom();
+              if (((!sp && v <= dpn.max_i && v >= dpn.min_i) ||
+                   (sp && sp->IsValue(v, v, pack, dpn.min_i, dpn.max_i) != common::RoughSetValue::RS_NONE)) &&
+                  (!bloom || bloom->IsValue(v, pack) != common::RoughSetValue::RS_NONE)) {
                 // suspected, if any value is possible
                 res = common::RoughSetValue::RS_SOME;  // note: v_rounded means that this real
                                                        // value could not match this pack
@@ -331,6 +347,14 @@ common::RoughSetValue TianmuAttr::RoughCheck(int pack, Descriptor &d, bool addit
           res = common::RoughSetValue::RS_NONE;
       }
 
+      if (res == common::RoughSetValue::RS_SOME && !types::RequiresUTFConversions(d.GetCollation())) {
+        if (auto sp = GetFilter_StrStats()) {
+          res = sp->IsValue(vmin, vmax, pack);
+          if (d.sharp && res == common::RoughSetValue::RS_ALL)
+            res = common::RoughSetValue::RS_SOME;
+        }
+      }
+
       if (res == common::RoughSetValue::RS_SOME && vmin.len_ >= pack_prefix && vmax.len_ >= pack_prefix &&
           !types::RequiresUTFConversions(d.GetCollation())) {
         vmin += pack_prefix;  // redefine - shift by a common prefix
@@ -592,14 +616,9 @@ common::RoughSetValue TianmuAttr::RoughCheckBetween(int pack, int64_t v1, int64_
     if (auto sp = GetFilter_Hist())
       res = sp->IsValue(v1, v2, pack, dpn.min_i, dpn.max_i);
 
-    if (res == common::RoughSetValue::RS_SOME) {
-      if (auto sp = GetFilter_Bloom()) {
-        auto vmin = std::to_string(v1);
-        auto vmax = std::to_string(v2);
-        types::BString keymin(vmin.c_str(), vmin.length());
-        types::BString keymax(vmax.c_str(), vmax.length());
-        res = sp->IsValue(keymin, keymax, pack);
-      }
+    if (res == common::RoughSetValue::RS_SOME && v1 == v2) {
+      if (auto sp = GetFilter_Bloom())
+        res = sp->IsValue(v1, pack);
     }
   }
   if (dpn.numOfNulls != 0 && res == common::RoughSetValue::RS_ALL) {
@@ -795,8 +814,23 @@ uint64_t TianmuAttr::ApproxDistinctVals(bool incl_nulls, Filter *f, common::Roug
       if (f == nullptr || !f->IsEmpty(p))
         max_len = std::max(max_len, GetActualSize(p));
     }
+    uint64_t pack_dist = 0;  // sum of the per-pack distinct counts, if all are known
+    if (auto sp = GetFilter_StrStats()) {
+      for (uint p = 0; p < SizeOfPack(); p++) {
+        if ((f != nullptr && f->IsEmpty(p)) || GetPackOntologicalStatus(p) == PackOntologicalStatus::NULLS_ONLY)
+          continue;
+        uint64_t d = sp->NumOfDistinct(p);
+        if (d == 0) {
+          pack_dist = 0;
+          break;
+        }
+        pack_dist += d;
+      }
+    }
     if (max_len > 0 && max_len < 6)
       no_dist += int64_t(256) << ((max_len - 1) * 8);
+    else if (max_len > 0 && pack_dist > 0)
+      no_dist += pack_dist;
     else if (max_len > 0)
       no_dist = max_obj;  // default
     else if (max_len == 0 && max_obj)
@@ -875,6 +909,39 @@ uint64_t TianmuAttr::ExactDistinctVals(Filter *f)  // provide the exact number o
   return common::NULL_VALUE_64;
 }
 
+uint64_t TianmuAttr::SketchDistinctVals(Filter *f) {
+  if (f == nullptr || f->NumOfBlocks() != SizeOfPack())
+    return common::NULL_VALUE_64;
+  auto sp = GetFilter_HLL();
+  if (!sp)
+    return common::NULL_VALUE_64;
+  LoadPackInfo();
+
+  std::vector<uint8_t> regs(RSIndex_HLL::REGISTERS);
+  for (uint p = 0; p < SizeOfPack(); p++) {
+    if (f->IsEmpty(p) || (f->IsFull(p) && sp->Merge(p, regs.data())))
+      continue;
+    // partially selected pack or no sketch yet: hash the selected values
+    auto const &dpn(get_dpn(p));
+    if (dpn.NullOnly())
+      continue;
+    FunctionExecutor fe([this, p]() { LockPackForUse(p); }, [this, p]() { UnlockPackFromUse(p); });
+    for (uint i = 0; i < dpn.numOfRecords; i++) {
+      if (!f->Get(p, i))
+        continue;
+      if (GetPackType() == common::PackType::INT) {
+        int64_t v = GetValueInt64((uint64_t(p) << pss) + i);
+        if (v != common::NULL_VALUE_64)
+          RSIndex_HLL::Add(regs.data(), RSIndex_HLL::Hash(v));
+      } else if (!get_packS(p)->IsNull(i)) {
+        types::BString v = get_packS(p)->GetValueBinary(i);
+        RSIndex_HLL::Add(regs.data(), RSIndex_HLL::Hash(v.GetDataBytesPointer(), v.len_));
+      }
+    }
+  }
+  return uint64_t(std::llround(RSIndex_HLL::Estimate(regs)));
+}
+
 double TianmuAttr::RoughSelectivity() {
   if (rough_selectivity == -1) {
     LoadPackInfo();
@@ -27,6 +27,7 @@
 #include "data/pack_str.h"
 #include "optimizer/compile/cq_term.h"
 #include "util/hash64.h"
+#include "util/simd_filter.h"
 #include "util/tools.h"
 #include "vc/const_column.h"
 #include "vc/in_set_column.h"
@@ -672,6 +673,7 @@ void TianmuAttr::EvaluatePack_InNum(MIUpdatingIterator &mit, int dim, Descriptor
   int arraysize = 0;
   if (d.val1.cond_numvalue != nullptr)
     arraysize = d.val1.cond_numvalue->capacity();
+  auto filter = mit.GetMultiIndex()->GetFilter(dim);
   if (local_min == local_max) {
     if (GetPackOntologicalStatus(pack) == PackOntologicalStatus::NULLS_ONLY) {
       mit.ResetCurrentPack();
@@ -703,6 +705,19 @@ void TianmuAttr::EvaluatePack_InNum(MIUpdatingIterator &mit, int dim, Descriptor
         ++mit;
       } while (mit.IsValid() && !mit.PackrowStarted());
     }
+  } else if (arraysize > 0 && arraysize < 100 && p->IsFixed() && tianmu_sysvar_filterevaluation_speedup && filter &&
+             filter->NumOfOnes(pack) > static_cast<uint>(1 << (mit.GetPower() - 1))) {
+    // small constant list on a nearly full pack: batch evaluation, as in EvaluatePack_BetweenInt
+    std::vector<uint64_t> vals;
+    for (auto v : d.val1.cond_numvalue->Values())
+      if (v >= local_min && v <= local_max)
+        vals.push_back(v - local_min);
+    std::vector<uint64_t> mask(utils::MaskWords(dpn.numOfRecords), 0);
+    p->InListMask(vals, mask.data());
+    if (not_in)
+      p->NegateMask(mask.data());
+    filter->AndMask(pack, mask.data());
+    mit.NextPackrow();
   } else {
     do {
       if (mit[dim] == common::NULL_VALUE_64 || p->IsNull(mit.GetCurInpack(dim)))
@@ -913,28 +928,13 @@ void TianmuAttr::EvaluatePack_BetweenInt(MIUpdatingIterator &mit, int dim, Descr
     // Loop without it when packs are nearly full
     if (tianmu_sysvar_filterevaluation_speedup && filter &&
         filter->NumOfOnes(pack) > static_cast<uint>(1 << (mit.GetPower() - 1))) {
-      if (d.op == common::Operator::O_BETWEEN && !mit.NullsPossibleInPack(dim) && dpn.numOfNulls == 0) {
-        // easy and fast case - no "if"s
-        for (uint32_t n = 0; n < dpn.numOfRecords; n++) {
-          uint64_t v = p->GetValInt(n);
-          if ((pv2 < local_min) || v < upv1 || v > upv2)
-            filter->Reset(pack, n);
-        }
-      } else {
-        // more general case
-        for (uint32_t n = 0; n < dpn.numOfRecords; n++) {
-          if (unlikely(p->IsNull(n)))
-            filter->Reset(pack, n);
-          else {
-            uint64_t v = p->GetValInt(n);
-            bool res = (pv2 < local_min) ? false : (upv1 <= v && v <= upv2);
-            if (d.op == common::Operator::O_NOT_BETWEEN)
-              res = !res;
-            if (!res)
-              filter->Reset(pack, n);
-          }
-        }
-      }
+      // evaluate the whole pack at once and apply the result to the filter 64 rows at a time
+      std::vector<uint64_t> mask(utils::MaskWords(dpn.numOfRecords), 0);
+      if (pv2 >= local_min)
+        p->BetweenMask(upv1, upv2, mask.data());
+      if (d.op == common::Operator::O_NOT_BETWEEN)
+        p->NegateMask(mask.data());
+      filter->AndMask(pack, mask.data());
       mit.NextPackrow();
     } else {
       if (d.op == common::Operator::O_BETWEEN && !mit.NullsPossibleInPack(dim) && dpn.numOfNulls == 0) {
@@ -122,6 +122,7 @@ class AttributeTypeInfo {
   CHARSET_INFO *CharsetInfo() const { return const_cast<CHARSET_INFO *>(this->collation_.collation); }
   const types::TianmuDataType &ValuePrototype() const;
   common::PackFmt Fmt() const { return fmt_; }
+  void SetFmt(common::PackFmt fmt) { fmt_ = fmt; }
   bool Lookup() const { return fmt_ == common::PackFmt::LOOKUP; }
   unsigned char Flag() const { return flag_.to_ulong(); }
   void SetFlag(unsigned char v) { flag_ = std::bitset<std::numeric_limits<unsigned char>::digits>(v); }
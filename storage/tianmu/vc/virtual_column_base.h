@@ -280,6 +280,11 @@ class VirtualColumnBase : public core::Column {
    * without nulls. If the exact number is unsure, return common::NULL_VALUE_64.
    */
   virtual int64_t GetExactDistVals() { return common::NULL_VALUE_64; }
+  /*! \brief Return an estimate of the number of distinct values of the whole
+   * column, without nulls, from distinct value sketches (see tianmu_approx_count_distinct).
+   * If there are no sketches, return common::NULL_VALUE_64.
+   */
+  virtual int64_t GetSketchDistVals() { return common::NULL_VALUE_64; }
   /*! \brief Return the upper approximation of text size the column may return.
    *  May depend on the current multiindex state, e.g. KNs.
    *  Used e.g. to prepare buffers for text values.